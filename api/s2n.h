@@ -99,6 +99,7 @@ extern int s2n_cert_chain_and_key_load_pem(struct s2n_cert_chain_and_key *chain_
 extern int s2n_cert_chain_and_key_free(struct s2n_cert_chain_and_key *cert_and_key);
 extern int s2n_cert_chain_and_key_set_ctx(struct s2n_cert_chain_and_key *cert_and_key, void *ctx);
 extern void *s2n_cert_chain_and_key_get_ctx(struct s2n_cert_chain_and_key *cert_and_key);
+extern int s2n_cert_chain_and_key_set_private_key_copies(struct s2n_cert_chain_and_key *chain_and_key, uint8_t copies);
 
 typedef struct s2n_cert_chain_and_key* (*s2n_cert_tiebreak_callback) (struct s2n_cert_chain_and_key *cert1, struct s2n_cert_chain_and_key *cert2, uint8_t *name, uint32_t name_len);
 extern int s2n_config_set_cert_tiebreak_callback(struct s2n_config *config, s2n_cert_tiebreak_callback cert_tiebreak_cb);
@@ -121,6 +122,10 @@ extern int s2n_config_disable_x509_verification(struct s2n_config *config);
 extern int s2n_config_set_max_cert_chain_depth(struct s2n_config *config, uint16_t max_depth);
 
 extern int s2n_config_add_dhparams(struct s2n_config *config, const char *dhparams_pem);
+extern int s2n_config_set_ephemeral_key_pool_size(struct s2n_config *config, uint32_t size);
+extern int s2n_config_refill_ephemeral_key_pool(struct s2n_config *config);
+extern int s2n_config_get_ephemeral_key_pool_stats(struct s2n_config *config, uint64_t *hits, uint64_t *misses);
+extern int s2n_config_get_ephemeral_key_pool_kem_stats(struct s2n_config *config, const char *kem_name, uint32_t *depth, uint64_t *misses);
 extern int s2n_config_set_cipher_preferences(struct s2n_config *config, const char *version);
 extern int s2n_config_set_protocol_preferences(struct s2n_config *config, const char * const *protocols, int protocol_count);
 typedef enum { S2N_STATUS_REQUEST_NONE = 0, S2N_STATUS_REQUEST_OCSP = 1 } s2n_status_request_type;
@@ -132,6 +137,7 @@ extern int s2n_config_set_alert_behavior(struct s2n_config *config, s2n_alert_be
 extern int s2n_config_set_extension_data(struct s2n_config *config, s2n_tls_extension_type type, const uint8_t *data, uint32_t length);
 extern int s2n_config_send_max_fragment_length(struct s2n_config *config, s2n_max_frag_len mfl_code);
 extern int s2n_config_accept_max_fragment_length(struct s2n_config *config);
+extern int s2n_config_set_record_size_limit(struct s2n_config *config, uint16_t limit);
 
 extern int s2n_config_set_session_state_lifetime(struct s2n_config *config, uint64_t lifetime_in_secs);
 
@@ -163,11 +169,20 @@ extern ssize_t s2n_client_hello_get_extensions_length(struct s2n_client_hello *c
 extern ssize_t s2n_client_hello_get_extensions(struct s2n_client_hello *ch, uint8_t *out, uint32_t max_length);
 extern ssize_t s2n_client_hello_get_extension_length(struct s2n_client_hello *ch, s2n_tls_extension_type extension_type);
 extern ssize_t s2n_client_hello_get_extension_by_id(struct s2n_client_hello *ch, s2n_tls_extension_type extension_type, uint8_t *out, uint32_t max_length);
+extern ssize_t s2n_client_hello_get_extension_ptr(struct s2n_client_hello *ch, s2n_tls_extension_type extension_type, const uint8_t **out);
 
 extern int s2n_connection_set_fd(struct s2n_connection *conn, int fd);
 extern int s2n_connection_set_read_fd(struct s2n_connection *conn, int readfd);
 extern int s2n_connection_set_write_fd(struct s2n_connection *conn, int writefd);
 extern int s2n_connection_use_corked_io(struct s2n_connection *conn);
+extern int s2n_connection_use_msg_more_io(struct s2n_connection *conn);
+
+struct s2n_io_uring;
+extern struct s2n_io_uring *s2n_io_uring_new(uint32_t max_connections);
+extern int s2n_io_uring_free(struct s2n_io_uring *ring);
+extern int s2n_connection_set_io_uring(struct s2n_connection *conn, struct s2n_io_uring *ring, int fd);
+extern int s2n_connection_io_uring_pending(struct s2n_connection *conn);
+extern int s2n_io_uring_submit(struct s2n_io_uring *ring, uint32_t min_complete, struct s2n_connection **ready, uint32_t max_ready);
 
 typedef int s2n_recv_fn(void *io_context, uint8_t *buf, uint32_t len);
 typedef int s2n_send_fn(void *io_context, const uint8_t *buf, uint32_t len);
@@ -180,6 +195,19 @@ extern int s2n_connection_prefer_throughput(struct s2n_connection *conn);
 extern int s2n_connection_prefer_low_latency(struct s2n_connection *conn);
 extern int s2n_connection_set_dynamic_record_threshold(struct s2n_connection *conn, uint32_t resize_threshold, uint16_t timeout_threshold);
 
+struct s2n_tcp_info {
+    /* Congestion window and unacknowledged data, in segments */
+    uint32_t snd_cwnd;
+    uint32_t unacked;
+    /* Sender maximum segment size, in bytes */
+    uint32_t snd_mss;
+    /* Smoothed round trip time, in microseconds */
+    uint32_t rtt;
+};
+typedef int s2n_tcp_info_fn(struct s2n_connection *conn, void *ctx, struct s2n_tcp_info *info);
+extern int s2n_connection_use_congestion_window_record_sizing(struct s2n_connection *conn);
+extern int s2n_connection_set_tcp_info_cb(struct s2n_connection *conn, s2n_tcp_info_fn *tcp_info_cb, void *ctx);
+
 /* If you don't want to use the configuration wide callback, you can set this per connection and it will be honored. */
 extern int s2n_connection_set_verify_host_callback(struct s2n_connection *config, s2n_verify_host_fn host_fn, void *data);
 
@@ -199,10 +227,24 @@ typedef enum { S2N_NOT_BLOCKED = 0, S2N_BLOCKED_ON_READ, S2N_BLOCKED_ON_WRITE }
 extern int s2n_negotiate(struct s2n_connection *conn, s2n_blocked_status *blocked);
 extern ssize_t s2n_send(struct s2n_connection *conn, const void *buf, ssize_t size, s2n_blocked_status *blocked);
 extern ssize_t s2n_recv(struct s2n_connection *conn,  void *buf, ssize_t size, s2n_blocked_status *blocked);
+extern ssize_t s2n_recv_all(struct s2n_connection *conn,  void *buf, ssize_t size, s2n_blocked_status *blocked);
 extern uint32_t s2n_peek(struct s2n_connection *conn);
 
+struct s2n_connection_group;
+extern struct s2n_connection_group *s2n_connection_group_new(void);
+extern int s2n_connection_group_free(struct s2n_connection_group *group);
+extern int s2n_connection_group_add(struct s2n_connection_group *group, struct s2n_connection *conn);
+extern int s2n_connection_group_remove(struct s2n_connection_group *group, struct s2n_connection *conn);
+extern int s2n_connection_group_send(struct s2n_connection_group *group, struct s2n_connection *conn, const void *buf, ssize_t size);
+extern int s2n_connection_group_flush(struct s2n_connection_group *group, uint32_t *blocked, struct s2n_connection **failed);
+
 extern int s2n_connection_free_handshake(struct s2n_connection *conn);
 extern int s2n_connection_release_buffers(struct s2n_connection *conn);
+extern int s2n_connection_hibernate(struct s2n_connection *conn);
+extern int s2n_connection_wake(struct s2n_connection *conn);
+extern int s2n_connection_get_serialized_length(struct s2n_connection *conn);
+extern int s2n_connection_serialize(struct s2n_connection *conn, uint8_t *buffer, size_t max_length);
+extern int s2n_connection_deserialize(struct s2n_connection *conn, const uint8_t *buffer, size_t length);
 extern int s2n_connection_wipe(struct s2n_connection *conn);
 extern int s2n_connection_free(struct s2n_connection *conn);
 extern int s2n_shutdown(struct s2n_connection *conn, s2n_blocked_status *blocked);
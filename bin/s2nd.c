@@ -13,6 +13,9 @@
  * permissions and limitations under the License.
  */
 
+/* SO_REUSEPORT is not part of POSIX */
+#define _DEFAULT_SOURCE
+
 #include <netinet/tcp.h>
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -21,6 +24,11 @@
 #include <sys/mman.h>
 #include <poll.h>
 #include <netdb.h>
+#include <pthread.h>
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#endif
 
 #include <stdlib.h>
 #include <signal.h>
@@ -159,7 +167,10 @@ struct session_cache_entry {
 
 struct session_cache_entry session_cache[256];
 
-int cache_store_callback(struct s2n_connection *conn, void *ctx, uint64_t ttl, const void *key, uint64_t key_size, const void *value, uint64_t value_size)
+/* The workers of --workers share the session cache */
+static pthread_mutex_t session_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int cache_store(struct s2n_connection *conn, void *ctx, uint64_t ttl, const void *key, uint64_t key_size, const void *value, uint64_t value_size)
 {
     struct session_cache_entry *cache = ctx;
 
@@ -181,7 +192,7 @@ int cache_store_callback(struct s2n_connection *conn, void *ctx, uint64_t ttl, c
     return 0;
 }
 
-int cache_retrieve_callback(struct s2n_connection *conn, void *ctx, const void *key, uint64_t key_size, void *value, uint64_t * value_size)
+static int cache_retrieve(struct s2n_connection *conn, void *ctx, const void *key, uint64_t key_size, void *value, uint64_t * value_size)
 {
     struct session_cache_entry *cache = ctx;
 
@@ -214,7 +225,7 @@ int cache_retrieve_callback(struct s2n_connection *conn, void *ctx, const void *
     return 0;
 }
 
-int cache_delete_callback(struct s2n_connection *conn, void *ctx, const void *key, uint64_t key_size)
+static int cache_delete(struct s2n_connection *conn, void *ctx, const void *key, uint64_t key_size)
 {
     struct session_cache_entry *cache = ctx;
 
@@ -238,6 +249,33 @@ int cache_delete_callback(struct s2n_connection *conn, void *ctx, const void *ke
     return 0;
 }
 
+int cache_store_callback(struct s2n_connection *conn, void *ctx, uint64_t ttl, const void *key, uint64_t key_size, const void *value, uint64_t value_size)
+{
+    pthread_mutex_lock(&session_cache_mutex);
+    int rc = cache_store(conn, ctx, ttl, key, key_size, value, value_size);
+    pthread_mutex_unlock(&session_cache_mutex);
+
+    return rc;
+}
+
+int cache_retrieve_callback(struct s2n_connection *conn, void *ctx, const void *key, uint64_t key_size, void *value, uint64_t * value_size)
+{
+    pthread_mutex_lock(&session_cache_mutex);
+    int rc = cache_retrieve(conn, ctx, key, key_size, value, value_size);
+    pthread_mutex_unlock(&session_cache_mutex);
+
+    return rc;
+}
+
+int cache_delete_callback(struct s2n_connection *conn, void *ctx, const void *key, uint64_t key_size)
+{
+    pthread_mutex_lock(&session_cache_mutex);
+    int rc = cache_delete(conn, ctx, key, key_size);
+    pthread_mutex_unlock(&session_cache_mutex);
+
+    return rc;
+}
+
 /*
  * Since this is a server, and the mechanism for hostname verification is not defined for this use-case,
  * allow any hostname through. If you are writing something with mutual auth and you have a scheme for verifying
@@ -347,6 +385,9 @@ void usage()
     fprintf(stderr, "    Disable session ticket for resumption.\n");
     fprintf(stderr, "  -C,--corked-io\n");
     fprintf(stderr, "    Turn on corked io\n");
+    fprintf(stderr, "  -w,--workers [count]\n");
+    fprintf(stderr, "    Serve connections from count threads, each with its own SO_REUSEPORT listener and an epoll loop driving many non-blocking connections at once.\n");
+    fprintf(stderr, "    All threads share one configuration and session cache. Data received from a client is sent back to it. Only available on Linux.\n");
     fprintf(stderr, "  -h,--help\n");
     fprintf(stderr, "    Display this message and quit.\n");
 
@@ -368,46 +409,41 @@ struct conn_settings {
     int use_corked_io;
 };
 
-int handle_connection(int fd, struct s2n_config *config, struct conn_settings settings)
+static int setup_connection(struct s2n_connection *conn, int fd, struct s2n_config *config, const struct conn_settings *settings)
 {
-    struct s2n_connection *conn = s2n_connection_new(S2N_SERVER);
-    if (!conn) {
-        print_s2n_error("Error getting new s2n connection");
-        return -1;
-    }
-
-    if (settings.self_service_blinding) {
+    if (settings->self_service_blinding) {
         s2n_connection_set_blinding(conn, S2N_SELF_SERVICE_BLINDING);
     }
 
-    if (settings.mutual_auth) {
-        GUARD_RETURN(s2n_config_set_client_auth_type(config, S2N_CERT_AUTH_REQUIRED), "Error setting client auth type");
-
-        if (settings.ca_dir || settings.ca_file) {
-            GUARD_RETURN(s2n_config_set_verification_ca_location(config, settings.ca_file, settings.ca_dir), "Error adding verify location");
-        }
-
-        if (settings.insecure) {
-            GUARD_RETURN(s2n_config_disable_x509_verification(config), "Error disabling X.509 validation");
-        }
-    }
-
     GUARD_RETURN(s2n_connection_set_config(conn, config), "Error setting configuration");
 
-    if (settings.prefer_throughput) {
+    if (settings->prefer_throughput) {
         GUARD_RETURN(s2n_connection_prefer_throughput(conn), "Error setting prefer throughput");
     }
 
-    if (settings.prefer_low_latency) {
+    if (settings->prefer_low_latency) {
         GUARD_RETURN(s2n_connection_prefer_low_latency(conn), "Error setting prefer low latency");
     }
 
     GUARD_RETURN(s2n_connection_set_fd(conn, fd), "Error setting file descriptor");
 
-    if (settings.use_corked_io) {
+    if (settings->use_corked_io) {
         GUARD_RETURN(s2n_connection_use_corked_io(conn), "Error setting corked io");
     }
 
+    return 0;
+}
+
+int handle_connection(int fd, struct s2n_config *config, struct conn_settings settings)
+{
+    struct s2n_connection *conn = s2n_connection_new(S2N_SERVER);
+    if (!conn) {
+        print_s2n_error("Error getting new s2n connection");
+        return -1;
+    }
+
+    GUARD_RETURN(setup_connection(conn, fd, config, &settings), "Error setting up connection");
+
     negotiate(conn);
 
     if (settings.mutual_auth) {
@@ -431,6 +467,316 @@ int handle_connection(int fd, struct s2n_config *config, struct conn_settings se
     return 0;
 }
 
+static int create_listener(struct addrinfo *ai, int reuse_port, int backlog)
+{
+    int sockfd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (sockfd == -1) {
+        fprintf(stderr, "socket error: %s\n", strerror(errno));
+        exit(1);
+    }
+
+    int r = 1;
+    if (setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &r, sizeof(int)) < 0) {
+        fprintf(stderr, "setsockopt error: %s\n", strerror(errno));
+        exit(1);
+    }
+
+#if defined(SO_REUSEPORT)
+    if (reuse_port && setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &r, sizeof(int)) < 0) {
+        fprintf(stderr, "setsockopt error: %s\n", strerror(errno));
+        exit(1);
+    }
+#endif
+
+    if (bind(sockfd, ai->ai_addr, ai->ai_addrlen) < 0) {
+        fprintf(stderr, "bind error: %s\n", strerror(errno));
+        exit(1);
+    }
+
+    if (listen(sockfd, backlog) == -1) {
+        fprintf(stderr, "listen error: %s\n", strerror(errno));
+        exit(1);
+    }
+
+    return sockfd;
+}
+
+#if defined(__linux__)
+
+#define WORKER_MAX_EVENTS 256
+#define WORKER_BUFFER_SIZE 16384
+
+enum worker_conn_state {
+    WORKER_HANDSHAKING,
+    WORKER_ECHOING,
+    WORKER_SHUTTING_DOWN,
+    WORKER_BLINDING,
+};
+
+struct worker_conn {
+    struct s2n_connection *conn;
+    struct worker_conn *next_free;
+    enum worker_conn_state state;
+    int fd;
+    int timer_fd;
+    uint32_t events;
+    uint32_t pending_offset;
+    uint32_t pending_length;
+    uint8_t buffer[WORKER_BUFFER_SIZE];
+};
+
+struct worker {
+    pthread_t thread;
+    int listen_fd;
+    int epoll_fd;
+    struct s2n_config *config;
+    const struct conn_settings *settings;
+    struct worker_conn *free_conns;
+};
+
+static int worker_wait(struct worker *worker, struct worker_conn *wconn, s2n_blocked_status blocked)
+{
+    uint32_t events = blocked == S2N_BLOCKED_ON_READ ? EPOLLIN : EPOLLOUT;
+    if (wconn->events == events) {
+        return 0;
+    }
+
+    struct epoll_event event = { .events = events, .data.ptr = wconn };
+    if (epoll_ctl(worker->epoll_fd, EPOLL_CTL_MOD, wconn->fd, &event) < 0) {
+        fprintf(stderr, "epoll_ctl error: %s\n", strerror(errno));
+        return -1;
+    }
+    wconn->events = events;
+
+    return 0;
+}
+
+/* Closes the socket and keeps the connection for the next client */
+static int worker_close(struct worker *worker, struct worker_conn *wconn)
+{
+    close(wconn->fd);
+    if (wconn->timer_fd >= 0) {
+        close(wconn->timer_fd);
+    }
+
+    GUARD_RETURN(s2n_connection_wipe(wconn->conn), "Error wiping connection");
+
+    wconn->next_free = worker->free_conns;
+    worker->free_conns = wconn;
+
+    return 0;
+}
+
+/* Holds a failed connection open until its blinding delay has passed. The delay is waited for with a timer, so the
+ * worker carries on serving its other connections meanwhile. */
+static int worker_fail(struct worker *worker, struct worker_conn *wconn)
+{
+    uint64_t delay = s2n_connection_get_delay(wconn->conn);
+    if (delay == 0 || worker->settings->self_service_blinding) {
+        return worker_close(worker, wconn);
+    }
+
+    if (epoll_ctl(worker->epoll_fd, EPOLL_CTL_DEL, wconn->fd, NULL) < 0) {
+        fprintf(stderr, "epoll_ctl error: %s\n", strerror(errno));
+        return -1;
+    }
+
+    struct itimerspec timeout = { .it_value = { .tv_sec = delay / 1000000000, .tv_nsec = delay % 1000000000 } };
+    struct epoll_event event = { .events = EPOLLIN, .data.ptr = wconn };
+    if ((wconn->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK)) < 0
+            || timerfd_settime(wconn->timer_fd, 0, &timeout, NULL) < 0
+            || epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, wconn->timer_fd, &event) < 0) {
+        fprintf(stderr, "Error setting blinding timer: %s\n", strerror(errno));
+        return -1;
+    }
+    wconn->state = WORKER_BLINDING;
+
+    return 0;
+}
+
+/* Moves a connection through its states until it blocks or is closed */
+static int worker_drive(struct worker *worker, struct worker_conn *wconn)
+{
+    const struct conn_settings *settings = worker->settings;
+    s2n_blocked_status blocked;
+    ssize_t r;
+
+    while (1) {
+        switch (wconn->state) {
+        case WORKER_HANDSHAKING:
+            if (s2n_negotiate(wconn->conn, &blocked) < 0) {
+                if (s2n_error_get_type(s2n_errno) == S2N_ERR_T_BLOCKED) {
+                    return worker_wait(worker, wconn, blocked);
+                }
+                return worker_fail(worker, wconn);
+            }
+
+            if (settings->mutual_auth && !s2n_connection_client_cert_used(wconn->conn)) {
+                print_s2n_error("Error: Mutual Auth was required, but not negotiatied");
+                return worker_close(worker, wconn);
+            }
+
+            wconn->state = settings->only_negotiate ? WORKER_SHUTTING_DOWN : WORKER_ECHOING;
+            break;
+        case WORKER_ECHOING:
+            while (wconn->pending_offset < wconn->pending_length) {
+                r = s2n_send(wconn->conn, wconn->buffer + wconn->pending_offset, wconn->pending_length - wconn->pending_offset, &blocked);
+                if (r < 0) {
+                    if (s2n_error_get_type(s2n_errno) == S2N_ERR_T_BLOCKED) {
+                        return worker_wait(worker, wconn, blocked);
+                    }
+                    return worker_fail(worker, wconn);
+                }
+                wconn->pending_offset += r;
+            }
+
+            r = s2n_recv(wconn->conn, wconn->buffer, sizeof(wconn->buffer), &blocked);
+            if (r == 0) {
+                wconn->state = WORKER_SHUTTING_DOWN;
+            } else if (r < 0) {
+                if (s2n_error_get_type(s2n_errno) == S2N_ERR_T_BLOCKED) {
+                    return worker_wait(worker, wconn, blocked);
+                }
+                return worker_fail(worker, wconn);
+            } else {
+                wconn->pending_offset = 0;
+                wconn->pending_length = r;
+            }
+            break;
+        case WORKER_SHUTTING_DOWN:
+            if (s2n_shutdown(wconn->conn, &blocked) < 0 && s2n_error_get_type(s2n_errno) == S2N_ERR_T_BLOCKED) {
+                return worker_wait(worker, wconn, blocked);
+            }
+            return worker_close(worker, wconn);
+        case WORKER_BLINDING:
+            /* The blinding timer has fired */
+            return worker_close(worker, wconn);
+        }
+    }
+}
+
+static int worker_accept(struct worker *worker)
+{
+    while (1) {
+        int fd = accept(worker->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return 0;
+            }
+            fprintf(stderr, "accept error: %s\n", strerror(errno));
+            /* Out of file descriptors: leave the client in the backlog until a connection closes */
+            return (errno == EMFILE || errno == ENFILE) ? 0 : -1;
+        }
+
+        if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) < 0) {
+            fprintf(stderr, "fcntl error: %s\n", strerror(errno));
+            close(fd);
+            continue;
+        }
+
+        struct worker_conn *wconn = worker->free_conns;
+        if (wconn) {
+            worker->free_conns = wconn->next_free;
+        } else {
+            wconn = calloc(1, sizeof(struct worker_conn));
+            if (wconn == NULL || (wconn->conn = s2n_connection_new(S2N_SERVER)) == NULL) {
+                print_s2n_error("Error getting new s2n connection");
+                return -1;
+            }
+        }
+
+        GUARD_RETURN(setup_connection(wconn->conn, fd, worker->config, worker->settings), "Error setting up connection");
+        /* Blinding is enforced by worker_fail() instead of sleeping in the worker */
+        GUARD_RETURN(s2n_connection_set_blinding(wconn->conn, S2N_SELF_SERVICE_BLINDING), "Error setting blinding");
+
+        wconn->fd = fd;
+        wconn->timer_fd = -1;
+        wconn->state = WORKER_HANDSHAKING;
+        wconn->pending_offset = 0;
+        wconn->pending_length = 0;
+        wconn->events = EPOLLIN;
+
+        struct epoll_event event = { .events = EPOLLIN, .data.ptr = wconn };
+        if (epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            fprintf(stderr, "epoll_ctl error: %s\n", strerror(errno));
+            return -1;
+        }
+
+        GUARD_RETURN(worker_drive(worker, wconn), "Error handling connection");
+    }
+}
+
+static void *worker_main(void *arg)
+{
+    struct worker *worker = arg;
+    struct epoll_event events[WORKER_MAX_EVENTS];
+
+    while (1) {
+        int ready = epoll_wait(worker->epoll_fd, events, WORKER_MAX_EVENTS, -1);
+        if (ready < 0 && errno != EINTR) {
+            fprintf(stderr, "epoll_wait error: %s\n", strerror(errno));
+            exit(1);
+        }
+
+        for (int i = 0; i < ready; i++) {
+            /* The listener is registered without a connection */
+            int rc = events[i].data.ptr ? worker_drive(worker, events[i].data.ptr) : worker_accept(worker);
+            if (rc < 0) {
+                exit(1);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static int run_workers(struct addrinfo *ai, struct s2n_config *config, const struct conn_settings *settings, int count)
+{
+    struct worker *workers = calloc(count, sizeof(struct worker));
+    if (workers == NULL) {
+        fprintf(stderr, "Error allocating memory\n");
+        return -1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        struct worker *worker = &workers[i];
+        worker->config = config;
+        worker->settings = settings;
+
+        /* The kernel spreads new connections over the listeners bound to the port */
+        worker->listen_fd = create_listener(ai, 1, SOMAXCONN);
+        if (fcntl(worker->listen_fd, F_SETFL, fcntl(worker->listen_fd, F_GETFL, 0) | O_NONBLOCK) < 0) {
+            fprintf(stderr, "fcntl error: %s\n", strerror(errno));
+            return -1;
+        }
+
+        struct epoll_event event = { .events = EPOLLIN, .data.ptr = NULL };
+        if ((worker->epoll_fd = epoll_create1(0)) < 0 || epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, worker->listen_fd, &event) < 0) {
+            fprintf(stderr, "epoll error: %s\n", strerror(errno));
+            return -1;
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]) != 0) {
+            fprintf(stderr, "Error creating worker thread\n");
+            return -1;
+        }
+    }
+
+    /* Workers only return by exiting the process */
+    for (int i = 0; i < count; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    return 0;
+}
+
+#endif
+
 int main(int argc, char *const *argv)
 {
     struct addrinfo hints, *ai;
@@ -456,6 +802,7 @@ int main(int argc, char *const *argv)
     struct conn_settings conn_settings = { 0 };
     int fips_mode = 0;
     int parallelize = 0;
+    int workers = 0;
     conn_settings.session_ticket = 1;
 
     struct option long_options[] = {
@@ -478,12 +825,13 @@ int main(int argc, char *const *argv)
         {"stk-file", required_argument, 0, 'a'},
         {"no-session-ticket", no_argument, 0, 'T'},
         {"corked-io", no_argument, 0, 'C'},
+        {"workers", required_argument, 0, 'w'},
         /* Per getopt(3) the last element of the array has to be filled with all zeros */
         { 0 },
     };
     while (1) {
         int option_index = 0;
-        int c = getopt_long(argc, argv, "c:hmnst:d:i:TC", long_options, &option_index);
+        int c = getopt_long(argc, argv, "c:hmnst:d:i:TCw:", long_options, &option_index);
         if (c == -1) {
             break;
         }
@@ -556,6 +904,9 @@ int main(int argc, char *const *argv)
         case 'T':
             conn_settings.session_ticket = 0;
             break;
+        case 'w':
+            workers = atoi(optarg);
+            break;
         case '?':
         default:
             fprintf(stdout, "getopt_long returned: %d", c);
@@ -569,6 +920,18 @@ int main(int argc, char *const *argv)
         exit(1);
     }
 
+    if (workers < 0 || (workers && parallelize)) {
+        fprintf(stderr, "workers must be positive, and the workers and parallelize options are mutually exclusive\n");
+        exit(1);
+    }
+
+#if !defined(__linux__)
+    if (workers) {
+        fprintf(stderr, "The workers option is only available on Linux\n");
+        exit(1);
+    }
+#endif
+
     if (optind < argc) {
         host = argv[optind++];
     }
@@ -607,25 +970,9 @@ int main(int argc, char *const *argv)
         exit(1);
     }
 
-    if ((sockfd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol)) == -1) {
-        fprintf(stderr, "socket error: %s\n", strerror(errno));
-        exit(1);
-    }
-
-    r = 1;
-    if (setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &r, sizeof(int)) < 0) {
-        fprintf(stderr, "setsockopt error: %s\n", strerror(errno));
-        exit(1);
-    }
-
-    if (bind(sockfd, ai->ai_addr, ai->ai_addrlen) < 0) {
-        fprintf(stderr, "bind error: %s\n", strerror(errno));
-        exit(1);
-    }
-
-    if (listen(sockfd, 1) == -1) {
-        fprintf(stderr, "listen error: %s\n", strerror(errno));
-        exit(1);
+    /* Each worker creates its own listener */
+    if (!workers) {
+        sockfd = create_listener(ai, 0, 1);
     }
 
     if (fips_mode) {
@@ -706,6 +1053,18 @@ int main(int argc, char *const *argv)
 
     GUARD_EXIT(s2n_config_set_cache_delete_callback(config, cache_delete_callback, session_cache), "Error setting cache retrieve callback");
 
+    if (conn_settings.mutual_auth) {
+        GUARD_EXIT(s2n_config_set_client_auth_type(config, S2N_CERT_AUTH_REQUIRED), "Error setting client auth type");
+
+        if (conn_settings.ca_dir || conn_settings.ca_file) {
+            GUARD_EXIT(s2n_config_set_verification_ca_location(config, conn_settings.ca_file, conn_settings.ca_dir), "Error adding verify location");
+        }
+
+        if (conn_settings.insecure) {
+            GUARD_EXIT(s2n_config_disable_x509_verification(config), "Error disabling X.509 validation");
+        }
+    }
+
     if (conn_settings.enable_mfl) {
         GUARD_EXIT(s2n_config_accept_max_fragment_length(config), "Error enabling TLS maximum fragment length extension in server");
     }
@@ -755,6 +1114,12 @@ int main(int argc, char *const *argv)
         sigaction(SIGCHLD, &sa, NULL);
     }
 
+#if defined(__linux__)
+    if (workers) {
+        GUARD_EXIT(run_workers(ai, config, &conn_settings, workers), "Error running workers");
+    }
+#endif
+
     int fd;
     while ((fd = accept(sockfd, ai->ai_addr, &ai->ai_addrlen)) > 0) {
 
@@ -0,0 +1,940 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/param.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <signal.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <getopt.h>
+#include <errno.h>
+
+#include <s2n.h>
+#include "common.h"
+
+#define S2N_LOAD_MAX_EVENTS 256
+#define S2N_LOAD_RECV_BUFFER_SIZE 16384
+#define S2N_LOAD_MAX_WAIT_MS 100
+
+/* Latencies are counted in buckets of 1/16th of a power of two, so percentiles are within 6.25% */
+#define S2N_LOAD_SUB_BUCKET_BITS 4
+#define S2N_LOAD_SUB_BUCKETS (1 << S2N_LOAD_SUB_BUCKET_BITS)
+#define S2N_LOAD_BUCKETS ((64 - S2N_LOAD_SUB_BUCKET_BITS + 1) * S2N_LOAD_SUB_BUCKETS)
+
+extern void print_s2n_error(const char *app_error);
+
+static volatile sig_atomic_t stopping = 0;
+
+struct load_settings {
+    struct addrinfo *address;
+    const char *server_name;
+    uint32_t connections;
+    uint32_t threads;
+    double handshake_rate;
+    uint32_t resume_percent;
+    uint32_t request_size;
+    uint32_t response_size;
+    uint32_t requests;
+    uint32_t think_ms;
+};
+
+struct load_histogram {
+    uint64_t counts[S2N_LOAD_BUCKETS];
+    uint64_t total;
+    uint64_t max_ns;
+};
+
+struct load_stats {
+    struct load_histogram full_handshakes;
+    struct load_histogram resumed_handshakes;
+    struct load_histogram requests;
+    uint64_t resumptions_offered;
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+    uint64_t connect_errors;
+    uint64_t handshake_errors;
+    uint64_t transfer_errors;
+    int connect_error;
+    const char *handshake_error;
+    const char *transfer_error;
+};
+
+enum load_state {
+    LOAD_IDLE,
+    LOAD_CONNECTING,
+    LOAD_HANDSHAKING,
+    LOAD_SENDING,
+    LOAD_RECEIVING,
+    LOAD_THINKING,
+    LOAD_CLOSING,
+};
+
+struct load_worker;
+
+struct load_conn {
+    struct load_worker *worker;
+    struct s2n_connection *conn;
+    struct load_conn *prev;
+    struct load_conn *next;
+    enum load_state state;
+    int fd;
+    uint32_t events;
+    uint8_t *session;
+    uint32_t session_length;
+    uint32_t session_size;
+    uint32_t requests_done;
+    uint32_t offset;
+    uint64_t started_ns;
+    uint64_t wake_ns;
+};
+
+/* Connections are queued in the order they became ready, which is also the order they are due in */
+struct load_queue {
+    struct load_conn *head;
+    struct load_conn *tail;
+};
+
+struct load_worker {
+    pthread_t thread;
+    const struct load_settings *settings;
+    int epoll_fd;
+    struct load_conn *conns;
+    uint32_t conn_count;
+    struct load_queue idle;
+    struct load_queue thinking;
+    uint64_t start_interval_ns;
+    uint64_t next_start_ns;
+    uint64_t end_ns;
+    unsigned int seed;
+    uint8_t *request;
+    uint8_t recv_buffer[S2N_LOAD_RECV_BUFFER_SIZE];
+    struct load_stats stats;
+    int rc;
+};
+
+void usage()
+{
+    fprintf(stderr, "usage: s2nload [options] host [port]\n");
+    fprintf(stderr, " host: hostname or IP address to connect to\n");
+    fprintf(stderr, " port: port to connect to\n");
+    fprintf(stderr, "\n Options:\n\n");
+    fprintf(stderr, "  -c [version_string]\n");
+    fprintf(stderr, "  --ciphers [version_string]\n");
+    fprintf(stderr, "    Set the cipher preference version string. Defaults to \"default\". See USAGE-GUIDE.md\n");
+    fprintf(stderr, "  -n,--connections [count]\n");
+    fprintf(stderr, "    Number of concurrent connections to hold open. Defaults to 100.\n");
+    fprintf(stderr, "  -t,--threads [count]\n");
+    fprintf(stderr, "    Number of threads the connections are spread over. Defaults to 1.\n");
+    fprintf(stderr, "  -d,--duration [seconds]\n");
+    fprintf(stderr, "    How long to generate load for. Defaults to 10.\n");
+    fprintf(stderr, "  -r,--rate [handshakes per second]\n");
+    fprintf(stderr, "    Limit the rate new connections are started at. Defaults to no limit.\n");
+    fprintf(stderr, "  -R,--resume [percent]\n");
+    fprintf(stderr, "    Percentage of handshakes that offer the session of the connection's previous handshake. Defaults to 0.\n");
+    fprintf(stderr, "  -T,--no-session-ticket\n");
+    fprintf(stderr, "    Disable session tickets, so that sessions are resumed from their session ID.\n");
+    fprintf(stderr, "  -q,--request-size [bytes]\n");
+    fprintf(stderr, "    Bytes each request sends to the server. The last byte is a newline.\n");
+    fprintf(stderr, "  -s,--response-size [bytes]\n");
+    fprintf(stderr, "    Bytes each request waits to receive from the server.\n");
+    fprintf(stderr, "  -N,--requests [count]\n");
+    fprintf(stderr, "    Requests made on each connection before it is closed. Defaults to 1 if -q or -s is set, otherwise 0.\n");
+    fprintf(stderr, "  -k,--think-time [milliseconds]\n");
+    fprintf(stderr, "    Pause between the requests of a connection. Defaults to 0.\n");
+    fprintf(stderr, "  -a,--name [server name]\n");
+    fprintf(stderr, "    Sets the SNI server name header. If not specified, the host value is used.\n");
+    fprintf(stderr, "  -f,--ca-file [file path]\n");
+    fprintf(stderr, "    Location of trust store CA file (PEM format). If neither -f or -D are specified. System defaults will be used.\n");
+    fprintf(stderr, "  -D,--ca-dir [directory path]\n");
+    fprintf(stderr, "    Directory containing hashed trusted certs. If neither -f or -D are specified. System defaults will be used.\n");
+    fprintf(stderr, "  -i,--insecure\n");
+    fprintf(stderr, "    Turns off certification validation altogether.\n");
+    fprintf(stderr, "  -h,--help\n");
+    fprintf(stderr, "    Display this message and quit.\n");
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+static uint64_t load_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void load_stop(int signum)
+{
+    stopping = 1;
+}
+
+static uint32_t load_bucket(uint64_t ns)
+{
+    if (ns < S2N_LOAD_SUB_BUCKETS) {
+        return ns;
+    }
+
+    uint32_t exponent = 63 - __builtin_clzll(ns);
+    uint32_t shift = exponent - S2N_LOAD_SUB_BUCKET_BITS;
+    return (shift + 1) * S2N_LOAD_SUB_BUCKETS + ((ns >> shift) & (S2N_LOAD_SUB_BUCKETS - 1));
+}
+
+/* The largest latency counted in a bucket */
+static uint64_t load_bucket_limit(uint32_t bucket)
+{
+    if (bucket < S2N_LOAD_SUB_BUCKETS) {
+        return bucket;
+    }
+
+    uint32_t shift = bucket / S2N_LOAD_SUB_BUCKETS - 1;
+    uint64_t lowest = (uint64_t) (S2N_LOAD_SUB_BUCKETS + bucket % S2N_LOAD_SUB_BUCKETS) << shift;
+    return lowest + (1ULL << shift) - 1;
+}
+
+static void load_histogram_add(struct load_histogram *histogram, uint64_t ns)
+{
+    histogram->counts[load_bucket(ns)]++;
+    histogram->total++;
+    histogram->max_ns = MAX(histogram->max_ns, ns);
+}
+
+static void load_histogram_merge(struct load_histogram *into, const struct load_histogram *from)
+{
+    for (int i = 0; i < S2N_LOAD_BUCKETS; i++) {
+        into->counts[i] += from->counts[i];
+    }
+    into->total += from->total;
+    into->max_ns = MAX(into->max_ns, from->max_ns);
+}
+
+static void load_print_latency(const char *name, const struct load_histogram *histogram)
+{
+    const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+
+    if (histogram->total == 0) {
+        return;
+    }
+
+    printf("  %-10s", name);
+    uint64_t seen = 0;
+    uint32_t bucket = 0;
+    for (int i = 0; i < sizeof(quantiles) / sizeof(quantiles[0]); i++) {
+        /* Find the bucket holding the operation at this rank, counting from 0 */
+        uint64_t rank = quantiles[i] * histogram->total;
+        while (seen + histogram->counts[bucket] <= rank) {
+            seen += histogram->counts[bucket++];
+        }
+        printf(" %10.3f", MIN(load_bucket_limit(bucket), histogram->max_ns) / 1e6);
+    }
+    printf(" %10.3f\n", histogram->max_ns / 1e6);
+}
+
+static void load_queue_push(struct load_queue *queue, struct load_conn *conn)
+{
+    conn->prev = queue->tail;
+    conn->next = NULL;
+    if (queue->tail) {
+        queue->tail->next = conn;
+    } else {
+        queue->head = conn;
+    }
+    queue->tail = conn;
+}
+
+static void load_queue_remove(struct load_queue *queue, struct load_conn *conn)
+{
+    if (conn->prev) {
+        conn->prev->next = conn->next;
+    } else {
+        queue->head = conn->next;
+    }
+    if (conn->next) {
+        conn->next->prev = conn->prev;
+    } else {
+        queue->tail = conn->prev;
+    }
+    conn->prev = NULL;
+    conn->next = NULL;
+}
+
+static struct load_conn *load_queue_pop(struct load_queue *queue)
+{
+    struct load_conn *conn = queue->head;
+    load_queue_remove(queue, conn);
+    return conn;
+}
+
+static int load_wait(struct load_conn *conn, uint32_t events)
+{
+    if (conn->events == events) {
+        return 0;
+    }
+
+    struct epoll_event event = { .events = events, .data.ptr = conn };
+    if (epoll_ctl(conn->worker->epoll_fd, EPOLL_CTL_MOD, conn->fd, &event) < 0) {
+        return -1;
+    }
+    conn->events = events;
+    return 0;
+}
+
+static int load_wait_blocked(struct load_conn *conn, s2n_blocked_status blocked)
+{
+    return load_wait(conn, blocked == S2N_BLOCKED_ON_READ ? EPOLLIN : EPOLLOUT);
+}
+
+/* Closes the socket and puts the connection back in line for its next handshake */
+static int load_close(struct load_conn *conn)
+{
+    close(conn->fd);
+    conn->fd = -1;
+    conn->state = LOAD_IDLE;
+    load_queue_push(&conn->worker->idle, conn);
+
+    GUARD_RETURN(s2n_connection_wipe(conn->conn), "Error wiping connection");
+    return 0;
+}
+
+static int load_connect_failed(struct load_conn *conn, int error)
+{
+    conn->worker->stats.connect_errors++;
+    conn->worker->stats.connect_error = error;
+    return load_close(conn);
+}
+
+static int load_handshake_failed(struct load_conn *conn)
+{
+    conn->worker->stats.handshake_errors++;
+    conn->worker->stats.handshake_error = s2n_strerror(s2n_errno, "EN");
+    return load_close(conn);
+}
+
+static int load_transfer_failed(struct load_conn *conn, const char *error)
+{
+    conn->worker->stats.transfer_errors++;
+    conn->worker->stats.transfer_error = error;
+    return load_close(conn);
+}
+
+static void load_start_request(struct load_conn *conn, uint64_t now_ns)
+{
+    conn->state = conn->worker->settings->request_size ? LOAD_SENDING : LOAD_RECEIVING;
+    conn->offset = 0;
+    conn->started_ns = now_ns;
+}
+
+static int load_save_session(struct load_conn *conn)
+{
+    int length = s2n_connection_get_session_length(conn->conn);
+    GUARD_RETURN(length, "Error getting session length");
+
+    if (length > conn->session_size) {
+        uint8_t *session = realloc(conn->session, length);
+        if (session == NULL) {
+            fprintf(stderr, "Error allocating memory\n");
+            return -1;
+        }
+        conn->session = session;
+        conn->session_size = length;
+    }
+
+    conn->session_length = s2n_connection_get_session(conn->conn, conn->session, conn->session_size);
+    GUARD_RETURN(conn->session_length, "Error getting serialized session state");
+    return 0;
+}
+
+static int load_handshake_done(struct load_conn *conn, uint64_t now_ns)
+{
+    struct load_worker *worker = conn->worker;
+    const struct load_settings *settings = worker->settings;
+
+    if (s2n_connection_is_session_resumed(conn->conn)) {
+        load_histogram_add(&worker->stats.resumed_handshakes, now_ns - conn->started_ns);
+    } else {
+        load_histogram_add(&worker->stats.full_handshakes, now_ns - conn->started_ns);
+    }
+
+    if (settings->resume_percent > 0) {
+        GUARD_RETURN(load_save_session(conn), "Error saving session");
+    }
+
+    conn->requests_done = 0;
+    if (settings->requests == 0) {
+        conn->state = LOAD_CLOSING;
+    } else {
+        load_start_request(conn, now_ns);
+    }
+    return 0;
+}
+
+static int load_request_done(struct load_conn *conn, uint64_t now_ns)
+{
+    struct load_worker *worker = conn->worker;
+    const struct load_settings *settings = worker->settings;
+
+    load_histogram_add(&worker->stats.requests, now_ns - conn->started_ns);
+    conn->requests_done++;
+
+    if (conn->requests_done == settings->requests) {
+        conn->state = LOAD_CLOSING;
+    } else if (settings->think_ms) {
+        /* Hangups and errors are still reported while the connection thinks */
+        conn->state = LOAD_THINKING;
+        conn->wake_ns = now_ns + settings->think_ms * 1000000ULL;
+        load_queue_push(&worker->thinking, conn);
+        GUARD_RETURN(load_wait(conn, 0), "Error waiting for connection");
+    } else {
+        load_start_request(conn, now_ns);
+    }
+    return 0;
+}
+
+/* Moves a connection through its states until it blocks on I/O, starts thinking or is closed. Called when the
+ * connection's socket has an event, or when it wakes up from thinking. */
+static int load_drive(struct load_conn *conn)
+{
+    struct load_worker *worker = conn->worker;
+    const struct load_settings *settings = worker->settings;
+    s2n_blocked_status blocked;
+    ssize_t r;
+
+    /* Thinking connections only have events for a hangup or an error */
+    if (conn->state == LOAD_THINKING) {
+        load_queue_remove(&worker->thinking, conn);
+        return load_transfer_failed(conn, "Connection closed while thinking");
+    }
+
+    if (conn->state == LOAD_CONNECTING) {
+        int error = 0;
+        socklen_t error_length = sizeof(error);
+        if (getsockopt(conn->fd, SOL_SOCKET, SO_ERROR, &error, &error_length) < 0) {
+            error = errno;
+        }
+        if (error) {
+            return load_connect_failed(conn, error);
+        }
+        conn->state = LOAD_HANDSHAKING;
+    }
+
+    while (1) {
+        switch (conn->state) {
+        case LOAD_HANDSHAKING:
+            if (s2n_negotiate(conn->conn, &blocked) < 0) {
+                if (s2n_error_get_type(s2n_errno) == S2N_ERR_T_BLOCKED) {
+                    return load_wait_blocked(conn, blocked);
+                }
+                return load_handshake_failed(conn);
+            }
+            GUARD_RETURN(load_handshake_done(conn, load_now_ns()), "Error completing handshake");
+            break;
+        case LOAD_SENDING:
+            r = s2n_send(conn->conn, worker->request + conn->offset, settings->request_size - conn->offset, &blocked);
+            if (r < 0 && s2n_error_get_type(s2n_errno) != S2N_ERR_T_BLOCKED) {
+                return load_transfer_failed(conn, s2n_strerror(s2n_errno, "EN"));
+            }
+            if (r > 0) {
+                conn->offset += r;
+                worker->stats.bytes_sent += r;
+            }
+            if (conn->offset < settings->request_size) {
+                return load_wait_blocked(conn, blocked);
+            }
+            if (settings->response_size) {
+                conn->state = LOAD_RECEIVING;
+                conn->offset = 0;
+            } else {
+                GUARD_RETURN(load_request_done(conn, load_now_ns()), "Error completing request");
+            }
+            break;
+        case LOAD_RECEIVING:
+            r = s2n_recv(conn->conn, worker->recv_buffer, MIN(sizeof(worker->recv_buffer), settings->response_size - conn->offset), &blocked);
+            if (r == 0) {
+                return load_transfer_failed(conn, "Connection closed before the response was received");
+            }
+            if (r < 0) {
+                if (s2n_error_get_type(s2n_errno) == S2N_ERR_T_BLOCKED) {
+                    return load_wait_blocked(conn, blocked);
+                }
+                return load_transfer_failed(conn, s2n_strerror(s2n_errno, "EN"));
+            }
+            conn->offset += r;
+            worker->stats.bytes_received += r;
+            if (conn->offset == settings->response_size) {
+                GUARD_RETURN(load_request_done(conn, load_now_ns()), "Error completing request");
+            }
+            break;
+        case LOAD_CLOSING:
+            /* Send our close_notify, but don't hold the connection open waiting for the server's */
+            if (s2n_shutdown(conn->conn, &blocked) < 0 && s2n_error_get_type(s2n_errno) == S2N_ERR_T_BLOCKED
+                    && blocked == S2N_BLOCKED_ON_WRITE) {
+                return load_wait_blocked(conn, blocked);
+            }
+            return load_close(conn);
+        default:
+            return 0;
+        }
+    }
+}
+
+static int load_start(struct load_conn *conn, uint64_t now_ns)
+{
+    struct load_worker *worker = conn->worker;
+    const struct load_settings *settings = worker->settings;
+    struct addrinfo *address = settings->address;
+
+    conn->started_ns = now_ns;
+    conn->fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (conn->fd < 0) {
+        /* Out of file descriptors: count it against the connection and put it back in line */
+        conn->state = LOAD_IDLE;
+        worker->stats.connect_errors++;
+        worker->stats.connect_error = errno;
+        load_queue_push(&worker->idle, conn);
+        return 0;
+    }
+
+    if (fcntl(conn->fd, F_SETFL, fcntl(conn->fd, F_GETFL, 0) | O_NONBLOCK) < 0) {
+        return load_connect_failed(conn, errno);
+    }
+
+    GUARD_RETURN(s2n_connection_set_fd(conn->conn, conn->fd), "Error setting file descriptor");
+    GUARD_RETURN(s2n_set_server_name(conn->conn, settings->server_name), "Error setting server name");
+    /* Failed handshakes are closed straight away rather than sleeping the whole worker */
+    GUARD_RETURN(s2n_connection_set_blinding(conn->conn, S2N_SELF_SERVICE_BLINDING), "Error setting blinding");
+
+    if (conn->session_length > 0 && rand_r(&worker->seed) % 100 < settings->resume_percent) {
+        GUARD_RETURN(s2n_connection_set_session(conn->conn, conn->session, conn->session_length), "Error setting session state in connection");
+        worker->stats.resumptions_offered++;
+    }
+
+    conn->state = LOAD_CONNECTING;
+    conn->events = EPOLLOUT;
+    struct epoll_event event = { .events = EPOLLOUT, .data.ptr = conn };
+    if (epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, conn->fd, &event) < 0) {
+        return load_connect_failed(conn, errno);
+    }
+
+    if (connect(conn->fd, address->ai_addr, address->ai_addrlen) < 0 && errno != EINPROGRESS) {
+        return load_connect_failed(conn, errno);
+    }
+
+    /* A connection in progress is driven once the socket becomes writable */
+    return 0;
+}
+
+static int load_wait_ms(struct load_worker *worker, uint64_t now_ns)
+{
+    uint64_t wake_ns = MIN(worker->end_ns, now_ns + S2N_LOAD_MAX_WAIT_MS * 1000000ULL);
+
+    if (worker->idle.head) {
+        wake_ns = MIN(wake_ns, worker->next_start_ns);
+    }
+    if (worker->thinking.head) {
+        wake_ns = MIN(wake_ns, worker->thinking.head->wake_ns);
+    }
+    if (wake_ns <= now_ns) {
+        return 0;
+    }
+
+    return (wake_ns - now_ns + 999999) / 1000000;
+}
+
+static int load_run(struct load_worker *worker)
+{
+    struct epoll_event events[S2N_LOAD_MAX_EVENTS];
+
+    for (uint64_t now_ns = load_now_ns(); now_ns < worker->end_ns && !stopping; now_ns = load_now_ns()) {
+        /* Start new handshakes as the rate allows. Each connection is started at most once per pass, so a
+         * server that refuses every connection can't keep us here. */
+        for (uint32_t started = 0; started < worker->conn_count && worker->idle.head && worker->next_start_ns <= now_ns; started++) {
+            GUARD_RETURN(load_start(load_queue_pop(&worker->idle), now_ns), "Error starting connection");
+            worker->next_start_ns += worker->start_interval_ns;
+        }
+
+        /* An unused start isn't saved up for later, so the rate never bursts above its limit */
+        if (worker->idle.head == NULL && worker->next_start_ns < now_ns) {
+            worker->next_start_ns = now_ns;
+        }
+
+        while (worker->thinking.head && worker->thinking.head->wake_ns <= now_ns) {
+            struct load_conn *conn = load_queue_pop(&worker->thinking);
+            load_start_request(conn, now_ns);
+            GUARD_RETURN(load_drive(conn), "Error driving connection");
+        }
+
+        int ready = epoll_wait(worker->epoll_fd, events, S2N_LOAD_MAX_EVENTS, load_wait_ms(worker, now_ns));
+        if (ready < 0 && errno != EINTR) {
+            perror("Error waiting for connections");
+            return -1;
+        }
+
+        for (int i = 0; i < ready; i++) {
+            GUARD_RETURN(load_drive(events[i].data.ptr), "Error driving connection");
+        }
+    }
+
+    return 0;
+}
+
+static void *load_worker_main(void *arg)
+{
+    struct load_worker *worker = arg;
+
+    worker->rc = load_run(worker);
+    return NULL;
+}
+
+static int load_worker_init(struct load_worker *worker, const struct load_settings *settings, struct s2n_config *config,
+        uint32_t conn_count, uint64_t start_ns, uint64_t end_ns)
+{
+    worker->settings = settings;
+    worker->conn_count = conn_count;
+    worker->next_start_ns = start_ns;
+    worker->end_ns = end_ns;
+    worker->seed = (unsigned int) (start_ns ^ (uintptr_t) worker);
+    if (settings->handshake_rate > 0) {
+        worker->start_interval_ns = settings->threads * 1e9 / settings->handshake_rate;
+    }
+
+    if ((worker->epoll_fd = epoll_create1(0)) < 0) {
+        perror("Error creating epoll instance");
+        return -1;
+    }
+
+    worker->request = malloc(MAX(settings->request_size, 1));
+    worker->conns = calloc(conn_count, sizeof(struct load_conn));
+    if (worker->request == NULL || worker->conns == NULL) {
+        fprintf(stderr, "Error allocating memory\n");
+        return -1;
+    }
+
+    /* A newline lets line based servers, such as openssl s_server -rev, answer each request */
+    memset(worker->request, 'A', settings->request_size);
+    if (settings->request_size) {
+        worker->request[settings->request_size - 1] = '\n';
+    }
+
+    for (uint32_t i = 0; i < conn_count; i++) {
+        struct load_conn *conn = &worker->conns[i];
+        conn->worker = worker;
+        conn->fd = -1;
+        conn->conn = s2n_connection_new(S2N_CLIENT);
+        if (conn->conn == NULL) {
+            print_s2n_error("Error getting new connection");
+            return -1;
+        }
+        GUARD_RETURN(s2n_connection_set_config(conn->conn, config), "Error setting configuration");
+        load_queue_push(&worker->idle, conn);
+    }
+
+    return 0;
+}
+
+static void load_worker_free(struct load_worker *worker)
+{
+    for (uint32_t i = 0; worker->conns && i < worker->conn_count; i++) {
+        struct load_conn *conn = &worker->conns[i];
+        if (conn->fd >= 0) {
+            close(conn->fd);
+        }
+        if (conn->conn) {
+            s2n_connection_free(conn->conn);
+        }
+        free(conn->session);
+    }
+    free(worker->conns);
+    free(worker->request);
+    if (worker->epoll_fd >= 0) {
+        close(worker->epoll_fd);
+    }
+}
+
+static void load_report(const struct load_settings *settings, struct load_worker *workers, double seconds)
+{
+    struct load_stats *total = calloc(1, sizeof(struct load_stats));
+    if (total == NULL) {
+        fprintf(stderr, "Error allocating memory\n");
+        exit(1);
+    }
+
+    for (uint32_t i = 0; i < settings->threads; i++) {
+        struct load_stats *stats = &workers[i].stats;
+        load_histogram_merge(&total->full_handshakes, &stats->full_handshakes);
+        load_histogram_merge(&total->resumed_handshakes, &stats->resumed_handshakes);
+        load_histogram_merge(&total->requests, &stats->requests);
+        total->resumptions_offered += stats->resumptions_offered;
+        total->bytes_sent += stats->bytes_sent;
+        total->bytes_received += stats->bytes_received;
+        total->connect_errors += stats->connect_errors;
+        total->handshake_errors += stats->handshake_errors;
+        total->transfer_errors += stats->transfer_errors;
+        total->connect_error = stats->connect_error ? stats->connect_error : total->connect_error;
+        total->handshake_error = stats->handshake_error ? stats->handshake_error : total->handshake_error;
+        total->transfer_error = stats->transfer_error ? stats->transfer_error : total->transfer_error;
+    }
+
+    uint64_t handshakes = total->full_handshakes.total + total->resumed_handshakes.total;
+    printf("Ran for %.2fs with %u connections on %u threads\n", seconds, settings->connections, settings->threads);
+    printf("Handshakes: %llu (%.1f/s), %llu full, %llu resumed, %llu resumptions offered\n",
+            (unsigned long long) handshakes, handshakes / seconds,
+            (unsigned long long) total->full_handshakes.total, (unsigned long long) total->resumed_handshakes.total,
+            (unsigned long long) total->resumptions_offered);
+    if (settings->requests) {
+        printf("Requests: %llu (%.1f/s)\n", (unsigned long long) total->requests.total, total->requests.total / seconds);
+        printf("Throughput: %.2f MB/s sent, %.2f MB/s received\n",
+                total->bytes_sent / seconds / 1e6, total->bytes_received / seconds / 1e6);
+    }
+
+    printf("Latency (ms)         p50        p90        p99      p99.9        max\n");
+    load_print_latency("full", &total->full_handshakes);
+    load_print_latency("resumed", &total->resumed_handshakes);
+    load_print_latency("request", &total->requests);
+
+    printf("Errors: %llu connect, %llu handshake, %llu transfer\n", (unsigned long long) total->connect_errors,
+            (unsigned long long) total->handshake_errors, (unsigned long long) total->transfer_errors);
+    if (total->connect_error) {
+        printf("  last connect error: '%s'\n", strerror(total->connect_error));
+    }
+    if (total->handshake_error) {
+        printf("  last handshake error: '%s'\n", total->handshake_error);
+    }
+    if (total->transfer_error) {
+        printf("  last transfer error: '%s'\n", total->transfer_error);
+    }
+
+    free(total);
+}
+
+int main(int argc, char *const *argv)
+{
+    struct addrinfo hints, *ai_list;
+    struct load_settings settings = { .connections = 100, .threads = 1 };
+    const char *cipher_prefs = "default";
+    const char *host = NULL;
+    const char *port = "443";
+    const char *ca_file = NULL;
+    const char *ca_dir = NULL;
+    uint8_t insecure = 0;
+    uint8_t session_ticket = 1;
+    uint32_t duration = 10;
+    int requests = -1;
+    int r;
+
+    static struct option long_options[] = {
+        {"ciphers", required_argument, 0, 'c'},
+        {"connections", required_argument, 0, 'n'},
+        {"threads", required_argument, 0, 't'},
+        {"duration", required_argument, 0, 'd'},
+        {"rate", required_argument, 0, 'r'},
+        {"resume", required_argument, 0, 'R'},
+        {"no-session-ticket", no_argument, 0, 'T'},
+        {"request-size", required_argument, 0, 'q'},
+        {"response-size", required_argument, 0, 's'},
+        {"requests", required_argument, 0, 'N'},
+        {"think-time", required_argument, 0, 'k'},
+        {"name", required_argument, 0, 'a'},
+        {"ca-file", required_argument, 0, 'f'},
+        {"ca-dir", required_argument, 0, 'D'},
+        {"insecure", no_argument, 0, 'i'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0},
+    };
+
+    while (1) {
+        int option_index = 0;
+        int c = getopt_long(argc, argv, "c:n:t:d:r:R:Tq:s:N:k:a:f:D:ih", long_options, &option_index);
+        if (c == -1) {
+            break;
+        }
+        switch (c) {
+        case 'c':
+            cipher_prefs = optarg;
+            break;
+        case 'n':
+            settings.connections = strtoul(optarg, 0, 10);
+            break;
+        case 't':
+            settings.threads = strtoul(optarg, 0, 10);
+            break;
+        case 'd':
+            duration = strtoul(optarg, 0, 10);
+            break;
+        case 'r':
+            settings.handshake_rate = strtod(optarg, 0);
+            break;
+        case 'R':
+            settings.resume_percent = MIN(100, strtoul(optarg, 0, 10));
+            break;
+        case 'T':
+            session_ticket = 0;
+            break;
+        case 'q':
+            settings.request_size = strtoul(optarg, 0, 10);
+            break;
+        case 's':
+            settings.response_size = strtoul(optarg, 0, 10);
+            break;
+        case 'N':
+            requests = atoi(optarg);
+            break;
+        case 'k':
+            settings.think_ms = strtoul(optarg, 0, 10);
+            break;
+        case 'a':
+            settings.server_name = optarg;
+            break;
+        case 'f':
+            ca_file = optarg;
+            break;
+        case 'D':
+            ca_dir = optarg;
+            break;
+        case 'i':
+            insecure = 1;
+            break;
+        case 'h':
+        case '?':
+        default:
+            usage();
+            break;
+        }
+    }
+
+    if (optind < argc) {
+        host = argv[optind++];
+    }
+
+    /* cppcheck-suppress duplicateCondition */
+    if (optind < argc) {
+        port = argv[optind++];
+    }
+
+    if (!host || settings.connections == 0 || settings.threads == 0 || duration == 0) {
+        usage();
+    }
+
+    if (requests < 0) {
+        requests = (settings.request_size || settings.response_size) ? 1 : 0;
+    }
+    if (requests > 0 && !settings.request_size && !settings.response_size) {
+        fprintf(stderr, "Requests need a request size (-q) or a response size (-s)\n");
+        exit(1);
+    }
+    settings.requests = requests;
+    settings.threads = MIN(settings.threads, settings.connections);
+
+    if (!settings.server_name) {
+        settings.server_name = host;
+    }
+
+    if (signal(SIGPIPE, SIG_IGN) == SIG_ERR) {
+        fprintf(stderr, "Error disabling SIGPIPE\n");
+        exit(1);
+    }
+    if (signal(SIGINT, load_stop) == SIG_ERR) {
+        fprintf(stderr, "Error setting SIGINT handler\n");
+        exit(1);
+    }
+
+    /* Every connection needs a file descriptor */
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < settings.connections + 64) {
+        limit.rlim_cur = MIN(limit.rlim_max, settings.connections + 64);
+        if (setrlimit(RLIMIT_NOFILE, &limit) < 0 || limit.rlim_cur < settings.connections + 64) {
+            fprintf(stderr, "Warning: only %llu file descriptors are available\n", (unsigned long long) limit.rlim_cur);
+        }
+    }
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if ((r = getaddrinfo(host, port, &hints, &ai_list)) != 0) {
+        fprintf(stderr, "error: %s\n", gai_strerror(r));
+        exit(1);
+    }
+    settings.address = ai_list;
+
+    GUARD_EXIT(s2n_init(), "Error running s2n_init()");
+
+    struct s2n_config *config = s2n_config_new();
+    if (config == NULL) {
+        print_s2n_error("Error getting new config");
+        exit(1);
+    }
+
+    GUARD_EXIT(s2n_config_set_cipher_preferences(config, cipher_prefs), "Error setting cipher prefs");
+    GUARD_EXIT(s2n_config_set_session_tickets_onoff(config, session_ticket), "Error setting session tickets");
+
+    if (ca_file || ca_dir) {
+        GUARD_EXIT(s2n_config_set_verification_ca_location(config, ca_file, ca_dir), "Error setting CA file for trust store.");
+    } else if (insecure) {
+        GUARD_EXIT(s2n_config_disable_x509_verification(config), "Error disabling X.509 validation");
+    }
+
+    struct load_worker *workers = calloc(settings.threads, sizeof(struct load_worker));
+    if (workers == NULL) {
+        fprintf(stderr, "Error allocating memory\n");
+        exit(1);
+    }
+
+    uint64_t start_ns = load_now_ns();
+    uint64_t end_ns = start_ns + duration * 1000000000ULL;
+    for (uint32_t i = 0; i < settings.threads; i++) {
+        /* Spread the connections as evenly as they go */
+        uint32_t conn_count = settings.connections / settings.threads + (i < settings.connections % settings.threads);
+        workers[i].epoll_fd = -1;
+        if (load_worker_init(&workers[i], &settings, config, conn_count, start_ns, end_ns) < 0) {
+            exit(1);
+        }
+    }
+
+    for (uint32_t i = 0; i < settings.threads; i++) {
+        if (pthread_create(&workers[i].thread, NULL, load_worker_main, &workers[i]) != 0) {
+            fprintf(stderr, "Error creating thread\n");
+            exit(1);
+        }
+    }
+
+    int failed = 0;
+    for (uint32_t i = 0; i < settings.threads; i++) {
+        pthread_join(workers[i].thread, NULL);
+        failed |= workers[i].rc;
+    }
+    double seconds = (load_now_ns() - start_ns) / 1e9;
+
+    load_report(&settings, workers, seconds);
+
+    for (uint32_t i = 0; i < settings.threads; i++) {
+        load_worker_free(&workers[i]);
+    }
+    free(workers);
+
+    GUARD_EXIT(s2n_config_free(config), "Error freeing configuration");
+    GUARD_EXIT(s2n_cleanup(), "Error running s2n_cleanup()");
+
+    freeaddrinfo(ai_list);
+    return failed ? 1 : 0;
+}
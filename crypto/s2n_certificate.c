@@ -33,6 +33,13 @@ static const s2n_authentication_method cert_type_to_auth_method[] = {
     [S2N_CERT_TYPE_ECDSA_SIGN] = S2N_AUTHENTICATION_ECDSA,
 };
 
+/* Each thread is given a slot the first time it uses a private key, and always
+ * uses the same copy of a given key from then on.
+ */
+static uint32_t s2n_private_key_next_thread_slot = 0;
+static __thread uint32_t s2n_private_key_thread_slot = 0;
+static __thread uint8_t s2n_private_key_thread_slot_assigned = 0;
+
 int s2n_cert_public_key_set_rsa_from_openssl(s2n_cert_public_key *public_key, RSA *openssl_rsa)
 {
     notnull_check(openssl_rsa);
@@ -175,6 +182,8 @@ struct s2n_cert_chain_and_key *s2n_cert_chain_and_key_new(void)
 
     chain_and_key->cert_chain->head = NULL;
     GUARD_PTR(s2n_pkey_zero_init(chain_and_key->private_key));
+    chain_and_key->private_key_copies = NULL;
+    chain_and_key->private_key_copies_count = 0;
     memset(&chain_and_key->ocsp_status, 0, sizeof(chain_and_key->ocsp_status));
     memset(&chain_and_key->sct_list, 0, sizeof(chain_and_key->sct_list));
     chain_and_key->cn_names = s2n_array_new(sizeof(struct s2n_blob));
@@ -339,6 +348,80 @@ int s2n_cert_chain_and_key_load_pem(struct s2n_cert_chain_and_key *chain_and_key
     return 0;
 }
 
+static int s2n_cert_chain_and_key_free_private_key_copies(struct s2n_cert_chain_and_key *chain_and_key)
+{
+    if (chain_and_key->private_key_copies == NULL) {
+        return 0;
+    }
+
+    for (int i = 0; i < chain_and_key->private_key_copies_count; i++) {
+        GUARD(s2n_pkey_free(&chain_and_key->private_key_copies[i]));
+    }
+
+    struct s2n_blob copies_mem = {0};
+    copies_mem.data = (uint8_t *) chain_and_key->private_key_copies;
+    copies_mem.size = chain_and_key->private_key_copies_count * sizeof(s2n_cert_private_key);
+    GUARD(s2n_free(&copies_mem));
+
+    chain_and_key->private_key_copies = NULL;
+    chain_and_key->private_key_copies_count = 0;
+
+    return 0;
+}
+
+int s2n_cert_chain_and_key_set_private_key_copies(struct s2n_cert_chain_and_key *chain_and_key, uint8_t copies)
+{
+    notnull_check(chain_and_key);
+    notnull_check(chain_and_key->private_key);
+
+    GUARD(s2n_cert_chain_and_key_free_private_key_copies(chain_and_key));
+
+    if (copies == 0) {
+        return 0;
+    }
+
+    GUARD(s2n_pkey_check_key_exists(chain_and_key->private_key));
+
+    struct s2n_blob copies_mem = {0};
+    GUARD(s2n_alloc(&copies_mem, copies * sizeof(s2n_cert_private_key)));
+    GUARD(s2n_blob_zero(&copies_mem));
+
+    chain_and_key->private_key_copies = (s2n_cert_private_key *)(void *) copies_mem.data;
+    chain_and_key->private_key_copies_count = copies;
+
+    for (int i = 0; i < copies; i++) {
+        if (s2n_pkey_dup(chain_and_key->private_key, &chain_and_key->private_key_copies[i]) < 0) {
+            /* s2n_errno is already set by the failed copy */
+            GUARD(s2n_cert_chain_and_key_free_private_key_copies(chain_and_key));
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+s2n_cert_private_key *s2n_cert_chain_and_key_get_private_key(struct s2n_cert_chain_and_key *chain_and_key)
+{
+    notnull_check_ptr(chain_and_key);
+
+    if (chain_and_key->private_key_copies_count == 0) {
+        return chain_and_key->private_key;
+    }
+
+    if (!s2n_private_key_thread_slot_assigned) {
+        s2n_private_key_thread_slot = __sync_fetch_and_add(&s2n_private_key_next_thread_slot, 1);
+        s2n_private_key_thread_slot_assigned = 1;
+    }
+
+    /* Slot 0 is the original key, the rest index into the copies */
+    uint32_t slot = s2n_private_key_thread_slot % (chain_and_key->private_key_copies_count + 1);
+    if (slot == 0) {
+        return chain_and_key->private_key;
+    }
+
+    return &chain_and_key->private_key_copies[slot - 1];
+}
+
 int s2n_cert_chain_and_key_free(struct s2n_cert_chain_and_key *cert_and_key)
 {
     if (cert_and_key == NULL) {
@@ -361,6 +444,8 @@ int s2n_cert_chain_and_key_free(struct s2n_cert_chain_and_key *cert_and_key)
         GUARD(s2n_free_object((uint8_t **)&cert_and_key->cert_chain, sizeof(struct s2n_cert_chain)));
     }
 
+    GUARD(s2n_cert_chain_and_key_free_private_key_copies(cert_and_key));
+
     if (cert_and_key->private_key) {
         GUARD(s2n_pkey_free(cert_and_key->private_key));
         GUARD(s2n_free_object((uint8_t **)&cert_and_key->private_key, sizeof(s2n_cert_private_key)));
@@ -38,6 +38,11 @@ struct s2n_cert_chain {
 struct s2n_cert_chain_and_key {
     struct s2n_cert_chain *cert_chain;
     s2n_cert_private_key *private_key;
+    /* Independent copies of private_key. Threads are spread across private_key
+     * and its copies so they don't all contend on one libcrypto key object.
+     */
+    s2n_cert_private_key *private_key_copies;
+    uint8_t private_key_copies_count;
     struct s2n_blob ocsp_status;
     struct s2n_blob sct_list;
     /* DNS type SubjectAlternative names from the leaf certificate to match
@@ -76,5 +81,6 @@ int s2n_send_cert_chain(struct s2n_stuffer *out, struct s2n_cert_chain *chain);
 int s2n_send_empty_cert_chain(struct s2n_stuffer *out);
 int s2n_create_cert_chain_from_stuffer(struct s2n_cert_chain *cert_chain_out, struct s2n_stuffer *chain_in_stuffer);
 
+s2n_cert_private_key *s2n_cert_chain_and_key_get_private_key(struct s2n_cert_chain_and_key *chain_and_key);
 s2n_authentication_method s2n_cert_chain_and_key_get_auth_method(struct s2n_cert_chain_and_key *chain_and_key);
 
@@ -24,6 +24,8 @@
 
 #include "crypto/s2n_crypto.h"
 
+#include "stuffer/s2n_stuffer.h"
+
 #include "utils/s2n_blob.h"
 
 struct s2n_session_key {
@@ -59,6 +61,11 @@ struct s2n_composite_cipher {
     int (*set_mac_write_key) (struct s2n_session_key *key, uint8_t *mac_key, uint32_t mac_size);
     int (*initial_hmac) (struct s2n_session_key *key, uint8_t *sequence_number, uint8_t content_type, uint16_t protocol_version,
                          uint16_t payload_and_eiv_len, int *extra);
+    /* Encrypts several of the *records full records in "in" in one pass, or returns 0 if libcrypto can't.
+     * On success *records is set to the number of records libcrypto interleaved.
+     */
+    int (*multiblock_encrypt) (struct s2n_session_key *key, uint8_t *sequence_number, uint8_t content_type, uint16_t protocol_version,
+                               uint8_t *records, struct s2n_blob *in, struct s2n_stuffer *out);
 };
 
 struct s2n_cipher {
@@ -135,6 +135,76 @@ static int s2n_composite_cipher_aes_sha_initial_hmac(struct s2n_session_key *key
     return 0;
 }
 
+static int s2n_composite_cipher_aes_sha_multiblock_encrypt(struct s2n_session_key *key, uint8_t *sequence_number, uint8_t content_type,
+                                                          uint16_t protocol_version, uint8_t *records, struct s2n_blob *in, struct s2n_stuffer *out)
+{
+    /* libcrypto draws the explicit IVs itself with RAND_bytes, and the multi-block API has no way
+     * to pass them in. Only interleave when RAND_bytes is served by s2n's DRBG, see s2n_rand_init.
+     */
+#if defined(EVP_CTRL_TLS1_1_MULTIBLOCK_AAD) && !defined(OPENSSL_NO_MULTIBLOCK) && S2N_LIBCRYPTO_SUPPORTS_CUSTOM_RAND
+    /* Only the AES-NI implementations interleave records. See
+     * https://github.com/openssl/openssl/blob/OpenSSL_1_1_1/crypto/evp/e_aes_cbc_hmac_sha1.c#L831
+     */
+    if (!(EVP_CIPHER_flags(EVP_CIPHER_CTX_cipher(key->evp_cipher_ctx)) & EVP_CIPH_FLAG_TLS1_1_MULTIBLOCK)) {
+        return 0;
+    }
+
+    uint8_t ctrl_buf[S2N_TLS12_AAD_LEN];
+    struct s2n_blob ctrl_blob = { .data = ctrl_buf, .size = S2N_TLS12_AAD_LEN };
+    struct s2n_stuffer ctrl_stuffer = {0};
+    GUARD(s2n_stuffer_init(&ctrl_stuffer, &ctrl_blob));
+
+    /* The sequence number is the first record's. A non-zero length lets libcrypto choose the
+     * interleave itself (eight records from 8192 bytes on AVX2 machines), so ask with a zero
+     * length, which takes the interleave from the parameters instead.
+     * See https://github.com/openssl/openssl/blob/OpenSSL_1_1_1/crypto/evp/e_aes_cbc_hmac_sha1.c#L836
+     */
+    GUARD(s2n_stuffer_write_bytes(&ctrl_stuffer, sequence_number, S2N_TLS_SEQUENCE_NUM_LEN));
+    GUARD(s2n_stuffer_write_uint8(&ctrl_stuffer, content_type));
+    GUARD(s2n_stuffer_write_uint8(&ctrl_stuffer, protocol_version / 10));
+    GUARD(s2n_stuffer_write_uint8(&ctrl_stuffer, protocol_version % 10));
+    GUARD(s2n_stuffer_write_uint16(&ctrl_stuffer, 0));
+
+    /* Query the largest interleave libcrypto will use for the records we have */
+    eq_check(in->size % *records, 0);
+    uint32_t record_size = in->size / *records;
+    EVP_CTRL_TLS1_1_MULTIBLOCK_PARAM param = {0};
+    int packed_len = 0;
+    for (uint8_t interleave = 8; interleave >= 4; interleave -= 4) {
+        if (interleave > *records) {
+            continue;
+        }
+
+        param.out = NULL;
+        param.inp = ctrl_buf;
+        param.len = interleave * record_size;
+        param.interleave = interleave;
+        packed_len = EVP_CIPHER_CTX_ctrl(key->evp_cipher_ctx, EVP_CTRL_TLS1_1_MULTIBLOCK_AAD, sizeof(param), &param);
+        if (packed_len > 0 && param.interleave == interleave) {
+            break;
+        }
+        packed_len = 0;
+    }
+    if (packed_len <= 0) {
+        return 0;
+    }
+
+    /* libcrypto writes the record headers, the explicit IVs, the MACs and the padding */
+    param.out = s2n_stuffer_raw_write(out, packed_len);
+    notnull_check(param.out);
+    param.inp = in->data;
+
+    int written = EVP_CIPHER_CTX_ctrl(key->evp_cipher_ctx, EVP_CTRL_TLS1_1_MULTIBLOCK_ENCRYPT, sizeof(param), &param);
+    S2N_ERROR_IF(written <= 0 || written > packed_len, S2N_ERR_ENCRYPT);
+    GUARD(s2n_stuffer_wipe_n(out, packed_len - written));
+
+    *records = param.interleave;
+    return written;
+#else
+    return 0;
+#endif
+}
+
 static int s2n_composite_cipher_aes_sha_encrypt(struct s2n_session_key *key, struct s2n_blob *iv, struct s2n_blob *in, struct s2n_blob *out)
 {
     eq_check(out->size, in->size);
@@ -278,7 +348,8 @@ struct s2n_cipher s2n_aes128_sha = {
                 .decrypt = s2n_composite_cipher_aes_sha_decrypt,
                 .encrypt = s2n_composite_cipher_aes_sha_encrypt,
                 .set_mac_write_key = s2n_composite_cipher_aes_sha_set_mac_write_key,
-                .initial_hmac = s2n_composite_cipher_aes_sha_initial_hmac },
+                .initial_hmac = s2n_composite_cipher_aes_sha_initial_hmac,
+                .multiblock_encrypt = s2n_composite_cipher_aes_sha_multiblock_encrypt },
     .is_available = s2n_composite_cipher_aes128_sha_available,
     .init = s2n_composite_cipher_aes_sha_init,
     .set_encryption_key = s2n_composite_cipher_aes128_sha_set_encryption_key,
@@ -296,7 +367,8 @@ struct s2n_cipher s2n_aes256_sha = {
                 .decrypt = s2n_composite_cipher_aes_sha_decrypt,
                 .encrypt = s2n_composite_cipher_aes_sha_encrypt,
                 .set_mac_write_key = s2n_composite_cipher_aes_sha_set_mac_write_key,
-                .initial_hmac = s2n_composite_cipher_aes_sha_initial_hmac },
+                .initial_hmac = s2n_composite_cipher_aes_sha_initial_hmac,
+                .multiblock_encrypt = s2n_composite_cipher_aes_sha_multiblock_encrypt },
     .is_available = s2n_composite_cipher_aes256_sha_available,
     .init = s2n_composite_cipher_aes_sha_init,
     .set_encryption_key = s2n_composite_cipher_aes256_sha_set_encryption_key,
@@ -314,7 +386,8 @@ struct s2n_cipher s2n_aes128_sha256 = {
                 .decrypt = s2n_composite_cipher_aes_sha_decrypt,
                 .encrypt = s2n_composite_cipher_aes_sha_encrypt,
                 .set_mac_write_key = s2n_composite_cipher_aes_sha256_set_mac_write_key,
-                .initial_hmac = s2n_composite_cipher_aes_sha_initial_hmac },
+                .initial_hmac = s2n_composite_cipher_aes_sha_initial_hmac,
+                .multiblock_encrypt = s2n_composite_cipher_aes_sha_multiblock_encrypt },
     .is_available = s2n_composite_cipher_aes128_sha256_available,
     .init = s2n_composite_cipher_aes_sha_init,
     .set_encryption_key = s2n_composite_cipher_aes128_sha256_set_encryption_key,
@@ -332,7 +405,8 @@ struct s2n_cipher s2n_aes256_sha256 = {
                 .decrypt = s2n_composite_cipher_aes_sha_decrypt,
                 .encrypt = s2n_composite_cipher_aes_sha_encrypt,
                 .set_mac_write_key = s2n_composite_cipher_aes_sha256_set_mac_write_key,
-                .initial_hmac = s2n_composite_cipher_aes_sha_initial_hmac },
+                .initial_hmac = s2n_composite_cipher_aes_sha_initial_hmac,
+                .multiblock_encrypt = s2n_composite_cipher_aes_sha_multiblock_encrypt },
     .is_available = s2n_composite_cipher_aes256_sha256_available,
     .init = s2n_composite_cipher_aes_sha_init,
     .set_encryption_key = s2n_composite_cipher_aes256_sha256_set_encryption_key,
@@ -18,9 +18,11 @@
 #include <openssl/ec.h>
 #include <openssl/bn.h>
 #include <openssl/ecdh.h>
+#include <openssl/evp.h>
 #include <openssl/obj_mac.h>
 #include <stdint.h>
 
+#include "crypto/s2n_openssl_evp.h"
 #include "tls/s2n_tls_parameters.h"
 #include "tls/s2n_kex.h"
 #include "utils/s2n_safety.h"
@@ -30,24 +32,40 @@
 
 /* IANA values can be found here: https://tools.ietf.org/html/rfc8446#appendix-B.3.1.4 */
 /* Share sizes are described here: https://tools.ietf.org/html/rfc8446#section-4.2.8.2
- * and include the extra "legacy_form" byte */
-const struct s2n_ecc_named_curve s2n_ecc_supported_curves[2] = {
+ * and include the extra "legacy_form" byte for the NIST curves. X25519 shares are the
+ * fixed width 32 byte u-coordinate from https://tools.ietf.org/html/rfc7748#section-6.1 */
+const struct s2n_ecc_named_curve s2n_ecc_supported_curves[S2N_ECC_SUPPORTED_CURVES_COUNT] = {
+#if S2N_ECC_X25519_SUPPORTED
+    {.iana_id = TLS_EC_CURVE_ECDH_X25519, .libcrypto_nid = NID_X25519, .name = "x25519", .share_size = S2N_ECC_X25519_POINT_LEN },
+#endif
     {.iana_id = TLS_EC_CURVE_SECP_256_R1, .libcrypto_nid = NID_X9_62_prime256v1, .name = "secp256r1", .share_size = ( 32 * 2 ) + 1 },
     {.iana_id = TLS_EC_CURVE_SECP_384_R1, .libcrypto_nid = NID_secp384r1, .name= "secp384r1", .share_size = ( 48 * 2 ) + 1 },
 };
 
-static EC_KEY *s2n_ecc_generate_own_key(const struct s2n_ecc_named_curve *named_curve);
-static EC_POINT *s2n_ecc_blob_to_point(struct s2n_blob *blob, const EC_KEY * ec_key);
-static int s2n_ecc_calculate_point_length(const EC_POINT * point, const EC_GROUP * group, uint8_t * length);
-static int s2n_ecc_write_point_data_snug(const EC_POINT * point, const EC_GROUP * group, struct s2n_blob *out);
-static int s2n_ecc_write_point(const EC_POINT * point, const EC_GROUP * group, struct s2n_stuffer *out);
-static int s2n_ecc_compute_shared_secret(EC_KEY * own_key, const EC_POINT * peer_public, struct s2n_blob *shared_secret);
+#if S2N_OPENSSL_VERSION_AT_LEAST(1,1,0) && !defined(LIBRESSL_VERSION_NUMBER)
+#define s2n_evp_pkey_get0_ec_key(pkey) EVP_PKEY_get0_EC_KEY(pkey)
+#else
+#define s2n_evp_pkey_get0_ec_key(pkey) ((const EC_KEY *) EVP_PKEY_get0(pkey))
+#endif
+
+static int s2n_ecc_generate_own_key(const struct s2n_ecc_named_curve *named_curve, EVP_PKEY **evp_pkey);
+static int s2n_ecc_parse_point(const struct s2n_ecc_named_curve *named_curve, struct s2n_blob *point_blob, EVP_PKEY **evp_pkey);
+static int s2n_ecc_write_point(EVP_PKEY *evp_pkey, const struct s2n_ecc_named_curve *named_curve, struct s2n_stuffer *out);
+static int s2n_ecc_compute_shared_secret(EVP_PKEY *own_key, EVP_PKEY *peer_public, struct s2n_blob *shared_secret);
+
+static int s2n_ecc_is_x25519(const struct s2n_ecc_named_curve *named_curve)
+{
+#if S2N_ECC_X25519_SUPPORTED
+    return named_curve->libcrypto_nid == NID_X25519;
+#else
+    return 0;
+#endif
+}
 
 int s2n_ecc_generate_ephemeral_key(struct s2n_ecc_params *server_ecc_params)
 {
     notnull_check(server_ecc_params->negotiated_curve);
-    server_ecc_params->ec_key = s2n_ecc_generate_own_key(server_ecc_params->negotiated_curve);
-    S2N_ERROR_IF(server_ecc_params->ec_key == NULL, S2N_ERR_ECDHE_GEN_KEY);
+    S2N_ERROR_IF(s2n_ecc_generate_own_key(server_ecc_params->negotiated_curve, &server_ecc_params->evp_pkey) < 0, S2N_ERR_ECDHE_GEN_KEY);
     return 0;
 }
 
@@ -55,7 +73,7 @@ int s2n_ecc_write_ecc_params(struct s2n_ecc_params *server_ecc_params, struct s2
 {
     notnull_check(server_ecc_params);
     notnull_check(server_ecc_params->negotiated_curve);
-    notnull_check(server_ecc_params->ec_key);
+    notnull_check(server_ecc_params->evp_pkey);
     notnull_check(out);
     notnull_check(written);
 
@@ -80,13 +98,11 @@ int s2n_ecc_write_ecc_params(struct s2n_ecc_params *server_ecc_params, struct s2
 int s2n_ecc_write_ecc_params_point(struct s2n_ecc_params *ecc_params, struct s2n_stuffer *out)
 {
     notnull_check(ecc_params);
-    notnull_check(ecc_params->ec_key);
+    notnull_check(ecc_params->negotiated_curve);
+    notnull_check(ecc_params->evp_pkey);
     notnull_check(out);
 
-    GUARD(s2n_ecc_write_point(
-            EC_KEY_get0_public_key(ecc_params->ec_key),
-            EC_KEY_get0_group(ecc_params->ec_key),
-            out));
+    GUARD(s2n_ecc_write_point(ecc_params->evp_pkey, ecc_params->negotiated_curve, out));
 
     return 0;
 }
@@ -145,20 +161,7 @@ int s2n_ecc_parse_ecc_params_point(struct s2n_ecc_params *ecc_params, struct s2n
     notnull_check(ecc_params);
     notnull_check(ecc_params->negotiated_curve);
 
-    /* Create a key to store the point */
-    ecc_params->ec_key = EC_KEY_new_by_curve_name(ecc_params->negotiated_curve->libcrypto_nid);
-    S2N_ERROR_IF(ecc_params->ec_key == NULL, S2N_ERR_ECDHE_UNSUPPORTED_CURVE);
-
-    /* Parse and store the server public point */
-    EC_POINT *point = s2n_ecc_blob_to_point(point_blob, ecc_params->ec_key);
-    S2N_ERROR_IF(point == NULL, S2N_ERR_BAD_MESSAGE);
-
-    /* Set the point as the public key */
-    int success = EC_KEY_set_public_key(ecc_params->ec_key, point);
-    EC_POINT_free(point);
-
-    /* EC_KEY_set_public_key returns 1 on success, 0 on failure */
-    S2N_ERROR_IF(success == 0, S2N_ERR_BAD_MESSAGE);
+    S2N_ERROR_IF(s2n_ecc_parse_point(ecc_params->negotiated_curve, point_blob, &ecc_params->evp_pkey) < 0, S2N_ERR_BAD_MESSAGE);
 
     return 0;
 }
@@ -167,8 +170,9 @@ int s2n_ecc_compute_shared_secret_as_server(struct s2n_ecc_params *server_ecc_pa
 {
     uint8_t client_public_len;
     struct s2n_blob client_public_blob = {0};
-    EC_POINT *client_public;
-    int rc;
+
+    notnull_check(server_ecc_params->negotiated_curve);
+    notnull_check(server_ecc_params->evp_pkey);
 
     GUARD(s2n_stuffer_read_uint8(Yc_in, &client_public_len));
     client_public_blob.size = client_public_len;
@@ -176,122 +180,173 @@ int s2n_ecc_compute_shared_secret_as_server(struct s2n_ecc_params *server_ecc_pa
     notnull_check(client_public_blob.data);
 
     /* Parse the client public */
-    client_public = s2n_ecc_blob_to_point(&client_public_blob, server_ecc_params->ec_key);
-    S2N_ERROR_IF(client_public == NULL, S2N_ERR_BAD_MESSAGE);
+    DEFER_CLEANUP(EVP_PKEY *client_public = NULL, EVP_PKEY_free_pointer);
+    S2N_ERROR_IF(s2n_ecc_parse_point(server_ecc_params->negotiated_curve, &client_public_blob, &client_public) < 0, S2N_ERR_BAD_MESSAGE);
 
-    /* Compute the key and free the point */
-    rc = s2n_ecc_compute_shared_secret(server_ecc_params->ec_key, client_public, shared_key);
-    EC_POINT_free(client_public);
-    return rc;
+    return s2n_ecc_compute_shared_secret(server_ecc_params->evp_pkey, client_public, shared_key);
 }
 
 int s2n_ecc_compute_shared_secret_as_client(struct s2n_ecc_params *server_ecc_params, struct s2n_stuffer *Yc_out, struct s2n_blob *shared_key)
 {
-    EC_KEY *client_key;
-
-    /* Generate the client key. Don't forget to free it. */
     notnull_check(server_ecc_params->negotiated_curve);
-    client_key = s2n_ecc_generate_own_key(server_ecc_params->negotiated_curve);
-    S2N_ERROR_IF(client_key == NULL, S2N_ERR_ECDHE_GEN_KEY);
+    notnull_check(server_ecc_params->evp_pkey);
+
+    /* Generate the client key */
+    DEFER_CLEANUP(EVP_PKEY *client_key = NULL, EVP_PKEY_free_pointer);
+    S2N_ERROR_IF(s2n_ecc_generate_own_key(server_ecc_params->negotiated_curve, &client_key) < 0, S2N_ERR_ECDHE_GEN_KEY);
 
     /* Compute the shared secret */
-    if (s2n_ecc_compute_shared_secret(client_key, EC_KEY_get0_public_key(server_ecc_params->ec_key), shared_key) != 0) {
-        EC_KEY_free(client_key);
-        S2N_ERROR(S2N_ERR_ECDHE_SHARED_SECRET);
-    }
+    S2N_ERROR_IF(s2n_ecc_compute_shared_secret(client_key, server_ecc_params->evp_pkey, shared_key) < 0, S2N_ERR_ECDHE_SHARED_SECRET);
 
     GUARD(s2n_stuffer_write_uint8(Yc_out, server_ecc_params->negotiated_curve->share_size));
 
     /* Write the client public to Yc */
-    if (s2n_ecc_write_point(EC_KEY_get0_public_key(client_key), EC_KEY_get0_group(client_key), Yc_out) != 0) {
-        EC_KEY_free(client_key);
-        S2N_ERROR(S2N_ERR_ECDHE_SERIALIZING);
-    }
-    EC_KEY_free(client_key);
+    S2N_ERROR_IF(s2n_ecc_write_point(client_key, server_ecc_params->negotiated_curve, Yc_out) < 0, S2N_ERR_ECDHE_SERIALIZING);
 
     return 0;
 }
 
 int s2n_ecc_params_free(struct s2n_ecc_params *server_ecc_params)
 {
-    if (server_ecc_params->ec_key != NULL) {
-        EC_KEY_free(server_ecc_params->ec_key);
-        server_ecc_params->ec_key = NULL;
+    if (server_ecc_params->evp_pkey != NULL) {
+        EVP_PKEY_free(server_ecc_params->evp_pkey);
+        server_ecc_params->evp_pkey = NULL;
     }
     return 0;
 }
 
-static EC_KEY *s2n_ecc_generate_own_key(const struct s2n_ecc_named_curve *named_curve)
+static int s2n_ecc_generate_x25519_key(EVP_PKEY **evp_pkey)
 {
-    EC_KEY *key = EC_KEY_new_by_curve_name(named_curve->libcrypto_nid);
-    if (key == NULL) {
-        S2N_ERROR_PTR(S2N_ERR_ECDHE_GEN_KEY);
+#if S2N_ECC_X25519_SUPPORTED
+    DEFER_CLEANUP(EVP_PKEY_CTX *pctx = EVP_PKEY_CTX_new_id(NID_X25519, NULL), EVP_PKEY_CTX_free_pointer);
+    S2N_ERROR_IF(pctx == NULL, S2N_ERR_ECDHE_GEN_KEY);
+
+    /* EVP_PKEY_keygen reuses a non-NULL *ppkey, so always start from a fresh key */
+    EVP_PKEY *pkey = NULL;
+    GUARD_OSSL(EVP_PKEY_keygen_init(pctx), S2N_ERR_ECDHE_GEN_KEY);
+    GUARD_OSSL(EVP_PKEY_keygen(pctx, &pkey), S2N_ERR_ECDHE_GEN_KEY);
+    S2N_ERROR_IF(pkey == NULL, S2N_ERR_ECDHE_GEN_KEY);
+
+    *evp_pkey = pkey;
+    return 0;
+#else
+    S2N_ERROR(S2N_ERR_ECDHE_UNSUPPORTED_CURVE);
+#endif
+}
+
+static int s2n_ecc_wrap_ec_key(EC_KEY *ec_key, EVP_PKEY **evp_pkey)
+{
+    /* Takes ownership of ec_key, even on failure */
+    EVP_PKEY *pkey = EVP_PKEY_new();
+    if (pkey == NULL || EVP_PKEY_assign_EC_KEY(pkey, ec_key) != 1) {
+        EVP_PKEY_free(pkey);
+        EC_KEY_free(ec_key);
+        S2N_ERROR(S2N_ERR_KEY_INIT);
+    }
+
+    *evp_pkey = pkey;
+    return 0;
+}
+
+static int s2n_ecc_generate_own_key(const struct s2n_ecc_named_curve *named_curve, EVP_PKEY **evp_pkey)
+{
+    if (s2n_ecc_is_x25519(named_curve)) {
+        return s2n_ecc_generate_x25519_key(evp_pkey);
     }
+
+    EC_KEY *key = EC_KEY_new_by_curve_name(named_curve->libcrypto_nid);
+    S2N_ERROR_IF(key == NULL, S2N_ERR_ECDHE_GEN_KEY);
     if (EC_KEY_generate_key(key) != 1) {
         EC_KEY_free(key);
-        S2N_ERROR_PTR(S2N_ERR_ECDHE_GEN_KEY);
+        S2N_ERROR(S2N_ERR_ECDHE_GEN_KEY);
     }
-    return key;
+
+    return s2n_ecc_wrap_ec_key(key, evp_pkey);
 }
 
-static EC_POINT *s2n_ecc_blob_to_point(struct s2n_blob *blob, const EC_KEY * ec_key)
+static int s2n_ecc_parse_point(const struct s2n_ecc_named_curve *named_curve, struct s2n_blob *point_blob, EVP_PKEY **evp_pkey)
 {
+    if (s2n_ecc_is_x25519(named_curve)) {
+#if S2N_ECC_X25519_SUPPORTED
+        /* X25519 public keys are a fixed width little endian u-coordinate */
+        S2N_ERROR_IF(point_blob->size != S2N_ECC_X25519_POINT_LEN, S2N_ERR_BAD_MESSAGE);
+        *evp_pkey = EVP_PKEY_new_raw_public_key(NID_X25519, NULL, point_blob->data, point_blob->size);
+        S2N_ERROR_IF(*evp_pkey == NULL, S2N_ERR_BAD_MESSAGE);
+        return 0;
+#endif
+    }
+
+    /* Create a key to store the point */
+    EC_KEY *ec_key = EC_KEY_new_by_curve_name(named_curve->libcrypto_nid);
+    S2N_ERROR_IF(ec_key == NULL, S2N_ERR_ECDHE_UNSUPPORTED_CURVE);
+
     const EC_GROUP *group = EC_KEY_get0_group(ec_key);
     EC_POINT *point = EC_POINT_new(group);
     if (point == NULL) {
-        S2N_ERROR_PTR(S2N_ERR_ECDHE_UNSUPPORTED_CURVE);
+        EC_KEY_free(ec_key);
+        S2N_ERROR(S2N_ERR_ECDHE_UNSUPPORTED_CURVE);
     }
-    if (EC_POINT_oct2point(group, point, blob->data, blob->size, NULL) != 1) {
-        EC_POINT_free(point);
-        S2N_ERROR_PTR(S2N_ERR_BAD_MESSAGE);
+
+    /* Parse the point and set it as the public key. Both calls return 1 on success */
+    int success = EC_POINT_oct2point(group, point, point_blob->data, point_blob->size, NULL) == 1
+            && EC_KEY_set_public_key(ec_key, point) == 1;
+    EC_POINT_free(point);
+    if (!success) {
+        EC_KEY_free(ec_key);
+        S2N_ERROR(S2N_ERR_BAD_MESSAGE);
     }
-    return point;
-}
 
-static int s2n_ecc_calculate_point_length(const EC_POINT * point, const EC_GROUP * group, uint8_t * length)
-{
-    size_t ret = EC_POINT_point2oct(group, point, POINT_CONVERSION_UNCOMPRESSED, NULL, 0, NULL);
-    S2N_ERROR_IF(ret == 0, S2N_ERR_ECDHE_SERIALIZING);
-    S2N_ERROR_IF(ret > UINT8_MAX, S2N_ERR_ECDHE_SERIALIZING);
-    *length = (uint8_t) ret;
-    return 0;
+    return s2n_ecc_wrap_ec_key(ec_key, evp_pkey);
 }
 
-static int s2n_ecc_write_point_data_snug(const EC_POINT * point, const EC_GROUP * group, struct s2n_blob *out)
+static int s2n_ecc_write_point(EVP_PKEY *evp_pkey, const struct s2n_ecc_named_curve *named_curve, struct s2n_stuffer *out)
 {
-    size_t ret = EC_POINT_point2oct(group, point, POINT_CONVERSION_UNCOMPRESSED, out->data, out->size, NULL);
-    S2N_ERROR_IF(ret != out->size, S2N_ERR_ECDHE_SERIALIZING);
-    return 0;
-}
+    if (s2n_ecc_is_x25519(named_curve)) {
+#if S2N_ECC_X25519_SUPPORTED
+        /* Fixed width, so the length is known without asking libcrypto */
+        size_t point_len = S2N_ECC_X25519_POINT_LEN;
+        uint8_t *point = s2n_stuffer_raw_write(out, point_len);
+        notnull_check(point);
+
+        GUARD_OSSL(EVP_PKEY_get_raw_public_key(evp_pkey, point, &point_len), S2N_ERR_ECDHE_SERIALIZING);
+        S2N_ERROR_IF(point_len != S2N_ECC_X25519_POINT_LEN, S2N_ERR_ECDHE_SERIALIZING);
+        return 0;
+#endif
+    }
 
-static int s2n_ecc_write_point(const EC_POINT * point, const EC_GROUP * group, struct s2n_stuffer *out)
-{
-    uint8_t point_len;
-    struct s2n_blob point_blob = {0};
+    const EC_KEY *ec_key = s2n_evp_pkey_get0_ec_key(evp_pkey);
+    notnull_check(ec_key);
+    const EC_GROUP *group = EC_KEY_get0_group(ec_key);
+    const EC_POINT *public_key = EC_KEY_get0_public_key(ec_key);
 
-    GUARD(s2n_ecc_calculate_point_length(point, group, &point_len));
+    size_t point_len = EC_POINT_point2oct(group, public_key, POINT_CONVERSION_UNCOMPRESSED, NULL, 0, NULL);
+    S2N_ERROR_IF(point_len == 0, S2N_ERR_ECDHE_SERIALIZING);
+    S2N_ERROR_IF(point_len > UINT8_MAX, S2N_ERR_ECDHE_SERIALIZING);
 
-    point_blob.data = s2n_stuffer_raw_write(out, point_len);
-    point_blob.size = point_len;
-    notnull_check(point_blob.data);
+    uint8_t *point = s2n_stuffer_raw_write(out, point_len);
+    notnull_check(point);
 
-    GUARD(s2n_ecc_write_point_data_snug(point, group, &point_blob));
+    size_t ret = EC_POINT_point2oct(group, public_key, POINT_CONVERSION_UNCOMPRESSED, point, point_len, NULL);
+    S2N_ERROR_IF(ret != point_len, S2N_ERR_ECDHE_SERIALIZING);
 
     return 0;
 }
 
-static int s2n_ecc_compute_shared_secret(EC_KEY * own_key, const EC_POINT * peer_public, struct s2n_blob *shared_secret)
+static int s2n_ecc_compute_shared_secret(EVP_PKEY *own_key, EVP_PKEY *peer_public, struct s2n_blob *shared_secret)
 {
-    int field_degree;
-    int shared_secret_size;
+    size_t shared_secret_size;
+
+    DEFER_CLEANUP(EVP_PKEY_CTX *pctx = EVP_PKEY_CTX_new(own_key, NULL), EVP_PKEY_CTX_free_pointer);
+    S2N_ERROR_IF(pctx == NULL, S2N_ERR_ECDHE_SHARED_SECRET);
 
-    field_degree = EC_GROUP_get_degree(EC_KEY_get0_group(own_key));
-    S2N_ERROR_IF(field_degree <= 0, S2N_ERR_ECDHE_SHARED_SECRET);
+    GUARD_OSSL(EVP_PKEY_derive_init(pctx), S2N_ERR_ECDHE_SHARED_SECRET);
+    GUARD_OSSL(EVP_PKEY_derive_set_peer(pctx, peer_public), S2N_ERR_ECDHE_SHARED_SECRET);
+    GUARD_OSSL(EVP_PKEY_derive(pctx, NULL, &shared_secret_size), S2N_ERR_ECDHE_SHARED_SECRET);
 
-    shared_secret_size = (field_degree + 7) / 8;
     GUARD(s2n_alloc(shared_secret, shared_secret_size));
 
-    if (ECDH_compute_key(shared_secret->data, shared_secret_size, peer_public, own_key, NULL) != shared_secret_size) {
+    /* X25519 derivation also fails here if the shared secret is all zeros */
+    if (EVP_PKEY_derive(pctx, shared_secret->data, &shared_secret_size) != 1 || shared_secret_size != shared_secret->size) {
         GUARD(s2n_free(shared_secret));
         S2N_ERROR(S2N_ERR_ECDHE_SHARED_SECRET);
     }
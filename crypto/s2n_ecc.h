@@ -16,12 +16,23 @@
 #pragma once
 
 #include <openssl/ec.h>
+#include <openssl/evp.h>
 
 #include "tls/s2n_kex_data.h"
 #include "stuffer/s2n_stuffer.h"
 #include "crypto/s2n_hash.h"
+#include "crypto/s2n_openssl.h"
 
+/* X25519 is used through the EVP_PKEY raw key APIs, which were added in Openssl 1.1.1 */
+#if S2N_OPENSSL_VERSION_AT_LEAST(1,1,1) && !defined(LIBRESSL_VERSION_NUMBER)
+#define S2N_ECC_X25519_SUPPORTED 1
+#define S2N_ECC_SUPPORTED_CURVES_COUNT 3
+#else
+#define S2N_ECC_X25519_SUPPORTED 0
 #define S2N_ECC_SUPPORTED_CURVES_COUNT 2
+#endif
+
+#define S2N_ECC_X25519_POINT_LEN 32
 
 struct s2n_ecc_named_curve {
     /* See https://www.iana.org/assignments/tls-parameters/tls-parameters.xhtml#tls-parameters-8 */
@@ -39,7 +50,7 @@ struct s2n_ecc_params {
     /* Negotiated named curve from s2n_ecc_supported_curves, or NULL if ECC can't be used */
     const struct s2n_ecc_named_curve *negotiated_curve;
     /* The ephemeral key or NULL if ECC is not used. Stores only the server public key in the client mode. */
-    EC_KEY *ec_key;
+    EVP_PKEY *evp_pkey;
 };
 
 int s2n_ecc_generate_ephemeral_key(struct s2n_ecc_params *server_ecc_params);
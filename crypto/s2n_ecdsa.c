@@ -124,6 +124,19 @@ static int s2n_ecdsa_check_key_exists(const struct s2n_pkey *pkey)
     return 0;
 }
 
+static int s2n_ecdsa_key_dup(const struct s2n_pkey *pkey, struct s2n_pkey *copy)
+{
+    const struct s2n_ecdsa_key *ecdsa_key = &pkey->key.ecdsa_key;
+    notnull_check(ecdsa_key->ec_key);
+
+    EC_KEY *ec_key = EC_KEY_dup(ecdsa_key->ec_key);
+    S2N_ERROR_IF(ec_key == NULL, S2N_ERR_KEY_INIT);
+
+    GUARD(s2n_ecdsa_pkey_init(copy));
+    copy->key.ecdsa_key.ec_key = ec_key;
+    return 0;
+}
+
 int s2n_evp_pkey_to_ecdsa_private_key(s2n_ecdsa_private_key *ecdsa_key, EVP_PKEY *evp_private_key)
 {
     EC_KEY *ec_key = EVP_PKEY_get1_EC_KEY(evp_private_key);
@@ -151,5 +164,6 @@ int s2n_ecdsa_pkey_init(struct s2n_pkey *pkey) {
     pkey->match = &s2n_ecdsa_keys_match;
     pkey->free = &s2n_ecdsa_key_free;
     pkey->check_key = &s2n_ecdsa_check_key_exists;
+    pkey->dup = &s2n_ecdsa_key_dup;
     return 0;
 }
@@ -33,6 +33,7 @@ int s2n_pkey_zero_init(struct s2n_pkey *pkey)
     pkey->match = NULL;
     pkey->free = NULL;
     pkey->check_key = NULL;
+    pkey->dup = NULL;
     return 0;
 }
 
@@ -109,6 +110,16 @@ int s2n_pkey_free(struct s2n_pkey *pkey)
     return pkey->free(pkey);
 }
 
+int s2n_pkey_dup(const struct s2n_pkey *pkey, struct s2n_pkey *copy)
+{
+    notnull_check(pkey->dup);
+    GUARD(s2n_pkey_check_key_exists(pkey));
+
+    GUARD(s2n_pkey_zero_init(copy));
+
+    return pkey->dup(pkey, copy);
+}
+
 int s2n_asn1der_to_private_key(struct s2n_pkey *priv_key, struct s2n_blob *asn1der)
 {
     uint8_t *key_to_parse = asn1der->data;
@@ -36,6 +36,7 @@ struct s2n_pkey {
     int (*match)(const struct s2n_pkey *pub_key, const struct s2n_pkey *priv_key); 
     int (*free)(struct s2n_pkey *key);
     int (*check_key)(const struct s2n_pkey *key);
+    int (*dup)(const struct s2n_pkey *key, struct s2n_pkey *copy);
 };
 
 extern int s2n_pkey_zero_init(struct s2n_pkey *pkey);
@@ -49,6 +50,7 @@ extern int s2n_pkey_encrypt(const struct s2n_pkey *pkey, struct s2n_blob *in, st
 extern int s2n_pkey_decrypt(const struct s2n_pkey *pkey, struct s2n_blob *in, struct s2n_blob *out);
 extern int s2n_pkey_match(const struct s2n_pkey *pub_key, const struct s2n_pkey *priv_key);
 extern int s2n_pkey_free(struct s2n_pkey *pkey);
+extern int s2n_pkey_dup(const struct s2n_pkey *pkey, struct s2n_pkey *copy);
 
 extern int s2n_asn1der_to_private_key(struct s2n_pkey *priv_key, struct s2n_blob *asn1der);
 extern int s2n_asn1der_to_public_key_and_type(struct s2n_pkey *pub_key, s2n_cert_type *cert_type, struct s2n_blob *asn1der);
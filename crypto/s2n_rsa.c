@@ -189,6 +189,20 @@ static int s2n_rsa_check_key_exists(const struct s2n_pkey *pkey)
     return 0;
 }
 
+static int s2n_rsa_key_dup(const struct s2n_pkey *pkey, struct s2n_pkey *copy)
+{
+    const struct s2n_rsa_key *rsa_key = &pkey->key.rsa_key;
+    notnull_check(rsa_key->rsa);
+
+    /* A deep copy, so the copy has its own blinding and Montgomery caches and locks */
+    RSA *rsa = RSAPrivateKey_dup(rsa_key->rsa);
+    S2N_ERROR_IF(rsa == NULL, S2N_ERR_KEY_INIT);
+
+    GUARD(s2n_rsa_pkey_init(copy));
+    copy->key.rsa_key.rsa = rsa;
+    return 0;
+}
+
 int s2n_evp_pkey_to_rsa_public_key(s2n_rsa_public_key *rsa_key, EVP_PKEY *evp_public_key)
 {
     RSA *rsa = EVP_PKEY_get1_RSA(evp_public_key);
@@ -218,6 +232,7 @@ int s2n_rsa_pkey_init(struct s2n_pkey *pkey)
     pkey->match = &s2n_rsa_keys_match;
     pkey->free = &s2n_rsa_key_free;
     pkey->check_key = &s2n_rsa_check_key_exists;
+    pkey->dup = &s2n_rsa_key_dup;
     return 0;
 }
 
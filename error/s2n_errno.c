@@ -147,6 +147,9 @@ struct s2n_error_translation S2N_ERROR_EN[] = {
     {S2N_ERR_CANCELLED, "handshake was cancelled"},
     {S2N_ERR_INVALID_MAX_FRAG_LEN, "invalid Maximum Fragmentation Length encountered"},
     {S2N_ERR_MAX_FRAG_LEN_MISMATCH, "Negotiated Maximum Fragmentation Length from server does not match the requested length by client"},
+    {S2N_ERR_ENCRYPT_THEN_MAC_NOT_CBC, "Encrypt-then-MAC can only be negotiated for a CBC cipher suite"},
+    {S2N_ERR_INVALID_RECORD_SIZE_LIMIT, "invalid Record Size Limit encountered"},
+    {S2N_ERR_RECORD_SIZE_LIMIT_EXCEEDED, "Received a record larger than the negotiated Record Size Limit"},
     {S2N_ERR_INVALID_SERIALIZED_SESSION_STATE, "Serialized session state is not in valid format"},
     {S2N_ERR_SERIALIZED_SESSION_STATE_TOO_LONG, "Serialized session state is too long"},
     {S2N_ERR_SESSION_ID_TOO_LONG, "Session id is too long"},
@@ -162,6 +165,24 @@ struct s2n_error_translation S2N_ERROR_EN[] = {
     {S2N_ERR_INVALID_DYNAMIC_THRESHOLD, "invalid dynamic record threshold"},
     {S2N_ERR_INVALID_ARGUMENT, "invalid argument provided into a function call"},
     {S2N_ERR_NOT_IN_UNIT_TEST, "Illegal configuration, can only be used during unit tests"},
+    {S2N_ERR_HANDSHAKE_NOT_COMPLETE, "Operation is only allowed after the handshake is complete"},
+    {S2N_ERR_HIBERNATE_UNSUPPORTED_CIPHER, "Connections using stream ciphers or TLS1.3 cannot hibernate"},
+    {S2N_ERR_HIBERNATE_PENDING_DATA, "Cannot hibernate a connection with buffered data"},
+    {S2N_ERR_SERIALIZE_UNSUPPORTED_CIPHER, "Connections using stream ciphers or TLS1.3 cannot be serialized"},
+    {S2N_ERR_SERIALIZE_PENDING_DATA, "Cannot serialize a connection with unsent data"},
+    {S2N_ERR_SERIALIZED_CONNECTION_TOO_LONG, "Serialized connection is longer than the provided buffer"},
+    {S2N_ERR_INVALID_SERIALIZED_CONNECTION, "Serialized connection is not in valid format"},
+    {S2N_ERR_DESERIALIZE_INTO_USED_CONNECTION, "Serialized connections can only be loaded into a new connection"},
+    {S2N_ERR_LOCK, "error acquiring or releasing a lock"},
+    {S2N_ERR_EPHEMERAL_KEY_POOL_DISABLED, "Ephemeral key pool is not enabled on this config"},
+    {S2N_ERR_NOT_IN_CONNECTION_GROUP, "Connection is not a member of this connection group"},
+    {S2N_ERR_ALREADY_IN_CONNECTION_GROUP, "Connection already belongs to a connection group"},
+    {S2N_ERR_IO_URING_UNSUPPORTED, "io_uring is not supported by this platform or kernel"},
+    {S2N_ERR_IO_URING_SIZE, "Invalid number of connections for an io_uring"},
+    {S2N_ERR_IO_URING_FULL, "No room left in the io_uring"},
+    {S2N_ERR_IO_URING_MANAGED_IO, "Connection already uses file descriptors set by s2n_connection_set_fd"},
+    {S2N_ERR_IO_URING_NOT_SET, "Connection does not use an io_uring"},
+    {S2N_ERR_MSG_MORE_SET_ON_UNMANAGED, "Attempt to send with MSG_MORE on unmanaged IO"},
 };
 
 const char *s2n_strerror(int error, const char *lang)
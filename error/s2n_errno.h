@@ -90,6 +90,9 @@ typedef enum {
     S2N_ERR_CERT_TYPE_UNSUPPORTED,
     S2N_ERR_INVALID_MAX_FRAG_LEN,
     S2N_ERR_MAX_FRAG_LEN_MISMATCH,
+    S2N_ERR_ENCRYPT_THEN_MAC_NOT_CBC,
+    S2N_ERR_INVALID_RECORD_SIZE_LIMIT,
+    S2N_ERR_RECORD_SIZE_LIMIT_EXCEEDED,
     /* S2N_ERR_T_INTERNAL */
     S2N_ERR_MADVISE = S2N_ERR_T_INTERNAL_START,
     S2N_ERR_ALLOC,
@@ -138,6 +141,7 @@ typedef enum {
     S2N_ERR_UNIMPLEMENTED,
     S2N_ERR_READ,
     S2N_ERR_WRITE,
+    S2N_ERR_LOCK,
     /* S2N_ERR_T_USAGE */
     S2N_ERR_NO_ALERT = S2N_ERR_T_USAGE_START,
     S2N_ERR_CLIENT_MODE,
@@ -179,6 +183,23 @@ typedef enum {
     S2N_ERR_INVALID_DYNAMIC_THRESHOLD,
     S2N_ERR_INVALID_ARGUMENT,
     S2N_ERR_NOT_IN_UNIT_TEST,
+    S2N_ERR_HANDSHAKE_NOT_COMPLETE,
+    S2N_ERR_HIBERNATE_UNSUPPORTED_CIPHER,
+    S2N_ERR_HIBERNATE_PENDING_DATA,
+    S2N_ERR_SERIALIZE_UNSUPPORTED_CIPHER,
+    S2N_ERR_SERIALIZE_PENDING_DATA,
+    S2N_ERR_SERIALIZED_CONNECTION_TOO_LONG,
+    S2N_ERR_INVALID_SERIALIZED_CONNECTION,
+    S2N_ERR_DESERIALIZE_INTO_USED_CONNECTION,
+    S2N_ERR_EPHEMERAL_KEY_POOL_DISABLED,
+    S2N_ERR_NOT_IN_CONNECTION_GROUP,
+    S2N_ERR_ALREADY_IN_CONNECTION_GROUP,
+    S2N_ERR_IO_URING_UNSUPPORTED,
+    S2N_ERR_IO_URING_SIZE,
+    S2N_ERR_IO_URING_FULL,
+    S2N_ERR_IO_URING_MANAGED_IO,
+    S2N_ERR_IO_URING_NOT_SET,
+    S2N_ERR_MSG_MORE_SET_ON_UNMANAGED,
 } s2n_error;
 
 #define S2N_DEBUG_STR_LEN 128
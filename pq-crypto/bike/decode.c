@@ -19,6 +19,7 @@
 
 #include <string.h>
 #include "decode.h"
+#include "decode_internal.h"
 #include "utilities.h"
 #include "gf2x.h"
 
@@ -26,17 +27,7 @@
 #define MAX_IT 4
 
 ////////////////////////////////////////////////////////////////////////////////
-// Defined in decode.S file
-EXTERNC void compute_counter_of_unsat(OUT uint8_t upc[N_BITS],
-                                      IN const uint8_t s[N_BITS],
-                                      IN const compressed_idx_dv_t *inv_h0_compressed,
-                                      IN const compressed_idx_dv_t *inv_h1_compressed);
-
-EXTERNC void recompute(OUT syndrome_t *s,
-                       IN const uint32_t num_positions,
-                       IN const uint32_t positions[R_BITS],
-                       IN const compressed_idx_dv_t *h_compressed);
-
+// Defined in converts_portable.c
 EXTERNC void convert_to_redundant_rep(OUT uint8_t *out,
                                       IN const uint8_t  *in,
                                       IN const uint64_t len);
@@ -52,8 +43,41 @@ typedef ALIGN(16) struct decode_ctx_s
     e_t gray_e;
     int delta;
     uint32_t threshold;
+
+    const decode_kernels_t *kernels;
 } decode_ctx_t;
 
+static const decode_kernels_t *select_kernels(void)
+{
+#if DECODE_AVX512_AVAILABLE
+    if(decode_avx512_supported())
+    {
+        return &decode_kernels_avx512;
+    }
+#endif
+#if DECODE_AVX2_AVAILABLE
+    if(decode_avx2_supported())
+    {
+        return &decode_kernels_avx2;
+    }
+#endif
+    return &decode_kernels_portable;
+}
+
+const decode_kernels_t *decode_kernels(void)
+{
+    // Racing threads all store the same value
+    static const decode_kernels_t *kernels = NULL;
+    const decode_kernels_t *selected = __atomic_load_n(&kernels, __ATOMIC_RELAXED);
+    if(selected == NULL)
+    {
+        selected = select_kernels();
+        __atomic_store_n(&kernels, selected, __ATOMIC_RELAXED);
+    }
+
+    return selected;
+}
+
 void split_e(OUT split_e_t *split_e_, IN const e_t *e)
 {
     // Copy lower bytes (e0)
@@ -76,17 +100,6 @@ void split_e(OUT split_e_t *split_e_, IN const e_t *e)
     PTRV(split_e_)[1].raw[R_SIZE - 1] &= LAST_R_BYTE_MASK;
 }
 
-// Transpose a row into a column
-_INLINE_ void transpose(OUT red_r_t *col,
-                        IN const red_r_t *row)
-{
-    col->raw[0] = row->raw[0];
-    for (uint64_t i = 1; i < R_BITS ; ++i)
-    {
-        col->raw[i] = row->raw[(R_BITS) - i];
-    }
-}
-
 ret_t compute_syndrome(OUT syndrome_t *syndrome,
                        IN const ct_t *ct,
                        IN const sk_t *sk)
@@ -109,7 +122,7 @@ ret_t compute_syndrome(OUT syndrome_t *syndrome,
     // Converting to redunandt representation and then transposing the value
     red_r_t s_tmp_bytes = {0};
     convert_to_redundant_rep(s_tmp_bytes.raw, VAL(pad_s[0]).raw, sizeof(s_tmp_bytes));
-    transpose(&PTR(syndrome).dup1, &s_tmp_bytes);
+    decode_kernels()->transpose(&PTR(syndrome).dup1, &s_tmp_bytes);
 
     PTR(syndrome).dup2 = PTR(syndrome).dup1;
 
@@ -150,31 +163,16 @@ ret_t recompute_syndrome(OUT syndrome_t *syndrome,
     return SUCCESS;
 }
 
-///////////////////////////////////////////////////////////
-// Find_error1/2 are defined in ASM files
-//////////////////////////////////////////////////////////
-EXTERNC void find_error1(IN OUT e_t *e,
-                         OUT e_t *black_e,
-                         OUT e_t *gray_e,
-                         IN const uint8_t *upc,
-                         IN const uint32_t black_th,
-                         IN const uint32_t gray_th);
-
-EXTERNC void find_error2(IN OUT e_t *e,
-                         OUT e_t *pos_e,
-                         IN const uint8_t *upc,
-                         IN const uint32_t threshold);
-
 _INLINE_ ret_t fix_error1(IN OUT syndrome_t *s,
                           IN OUT e_t *e,
                           IN OUT decode_ctx_t *ctx,
                           IN const sk_t *sk,
                           IN const ct_t *ct)
 {
-    find_error1(e, &ctx->black_e, &ctx->gray_e,
-                ctx->upc,
-                ctx->threshold,
-                ctx->threshold - ctx->delta + 1);
+    ctx->kernels->find_error1(e, &ctx->black_e, &ctx->gray_e,
+                              ctx->upc,
+                              ctx->threshold,
+                              ctx->threshold - ctx->delta + 1);
 
     GUARD(recompute_syndrome(s, ct, sk, e));
 
@@ -187,7 +185,7 @@ _INLINE_ ret_t fix_black_error(IN OUT syndrome_t *s,
                                IN const sk_t *sk,
                                IN const ct_t *ct)
 {
-    find_error2(e, &ctx->black_e, ctx->upc, ((DV+1)/2)+1);
+    ctx->kernels->find_error2(e, &ctx->black_e, ctx->upc, ((DV+1)/2)+1);
     GUARD(recompute_syndrome(s, ct, sk, e));
 
     return SUCCESS;
@@ -199,7 +197,7 @@ _INLINE_ ret_t fix_gray_error(IN OUT syndrome_t *s,
                               IN const sk_t *sk,
                               IN const ct_t *ct)
 {
-    find_error2(e, &ctx->gray_e, ctx->upc, ((DV+1)/2)+1);
+    ctx->kernels->find_error2(e, &ctx->gray_e, ctx->upc, ((DV+1)/2)+1);
     GUARD(recompute_syndrome(s, ct, sk, e));
 
     return SUCCESS;
@@ -235,6 +233,7 @@ ret_t decode(OUT e_t *e,
 
     PTR(s).dup1 = PTR(original_s).dup1;
     ctx.delta = MAX_DELTA;
+    ctx.kernels = decode_kernels();
 
     // Reset the error
     memset(e, 0, sizeof(*e));
@@ -249,7 +248,7 @@ ret_t decode(OUT e_t *e,
         DMSG("    Weight of e: %lu\n", count_ones(e->raw, sizeof(*e)));
         DMSG("    Weight of syndrome: %lu\n", count_ones(PTR(s).dup1.raw, sizeof(PTR(s).dup1)));
 
-        compute_counter_of_unsat(ctx.upc, s->u.raw, &inv_h_compressed[0], &inv_h_compressed[1]);
+        ctx.kernels->compute_counter_of_unsat(ctx.upc, s->u.raw, &inv_h_compressed[0], &inv_h_compressed[1]);
 
         ctx.threshold = get_threshold(&PTR(s).dup1);
         GUARD(fix_error1(s, e, &ctx, sk, ct));
@@ -258,7 +257,7 @@ ret_t decode(OUT e_t *e,
         DMSG("    Weight of syndrome: %lu\n", count_ones(PTR(s).dup1.raw, sizeof(PTR(s).dup1)));
 
         // Recompute the UPC
-        compute_counter_of_unsat(ctx.upc, s->u.raw, &inv_h_compressed[0], &inv_h_compressed[1]);
+        ctx.kernels->compute_counter_of_unsat(ctx.upc, s->u.raw, &inv_h_compressed[0], &inv_h_compressed[1]);
 
         // Decoding Step II: Unflip positions that still have high number of UPC associated
         GUARD(fix_black_error(s, e, &ctx, sk, ct));
@@ -267,7 +266,7 @@ ret_t decode(OUT e_t *e,
         DMSG("    Weight of syndrome: %lu\n", count_ones(PTR(s).dup1.raw, sizeof(PTR(s).dup1)));
 
         // Recompute UPC
-        compute_counter_of_unsat(ctx.upc, s->u.raw, &inv_h_compressed[0], &inv_h_compressed[1]);
+        ctx.kernels->compute_counter_of_unsat(ctx.upc, s->u.raw, &inv_h_compressed[0], &inv_h_compressed[1]);
 
         // Decoding Step III: Flip all gray positions associated to high number of UPC
         GUARD(fix_gray_error(s, e, &ctx, sk, ct));
@@ -0,0 +1,115 @@
+/***************************************************************************
+* Additional implementation of "BIKE: Bit Flipping Key Encapsulation".
+* Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Written by Nir Drucker and Shay Gueron
+* AWS Cryptographic Algorithms Group
+* (ndrucker@amazon.com, gueron@amazon.com)
+*
+* The license is detailed in the file LICENSE.md, and applies to this file.
+* ***************************************************************************/
+
+#pragma once
+
+#include "types.h"
+#include "utilities.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  #define DECODE_AVX2_AVAILABLE 1
+#else
+  #define DECODE_AVX2_AVAILABLE 0
+#endif
+
+// AVX512BW intrinsics and target attributes need GCC 6 or clang
+#if DECODE_AVX2_AVAILABLE && (defined(__clang__) || (__GNUC__ >= 6))
+  #define DECODE_AVX512_AVAILABLE 1
+#else
+  #define DECODE_AVX512_AVAILABLE 0
+#endif
+
+// The vectorised kernels count the UPC in byte lanes
+bike_static_assert((FAKE_DV < 255), fake_dv_fits_in_a_byte);
+
+// The vectorised kernels join the two halves of e themselves
+bike_static_assert((N0 == 2), n0_is_two);
+bike_static_assert((LAST_R_BYTE_LEAD != 0), r_bits_not_byte_aligned);
+
+// The steps of the decoder that are implemented per instruction set.
+// All of them run in constant time.
+typedef struct decode_kernels_s
+{
+    // upc[i] = the number of unsatisfied parity-checks of bit i of e
+    void (*compute_counter_of_unsat)(OUT uint8_t upc[N_BITS],
+                                     IN const uint8_t s[N_BITS],
+                                     IN const compressed_idx_dv_t *inv_h0_compressed,
+                                     IN const compressed_idx_dv_t *inv_h1_compressed);
+
+    // Transpose a row into a column (col[i] = row[-i mod r])
+    void (*transpose)(OUT red_r_t *col, IN const red_r_t *row);
+
+    // Flip the bits of e whose UPC is at least black_th and record them in
+    // black_e. Record the bits whose UPC is at least gray_th in gray_e.
+    void (*find_error1)(IN OUT e_t *e,
+                        OUT e_t *black_e,
+                        OUT e_t *gray_e,
+                        IN const uint8_t *upc,
+                        IN const uint32_t black_th,
+                        IN const uint32_t gray_th);
+
+    // Flip the bits of pos_e whose UPC is at least threshold
+    void (*find_error2)(IN OUT e_t *e,
+                        IN e_t *pos_e,
+                        IN const uint8_t *upc,
+                        IN const uint32_t threshold);
+} decode_kernels_t;
+
+extern const decode_kernels_t decode_kernels_portable;
+
+#if DECODE_AVX2_AVAILABLE
+extern const decode_kernels_t decode_kernels_avx2;
+
+//Returns 1 if the CPU and the OS support AVX2
+int decode_avx2_supported(void);
+#endif
+
+#if DECODE_AVX512_AVAILABLE
+extern const decode_kernels_t decode_kernels_avx512;
+
+//Returns 1 if the CPU and the OS support AVX512F and AVX512BW
+int decode_avx512_supported(void);
+#endif
+
+//Returns the fastest kernels the CPU supports
+const decode_kernels_t *decode_kernels(void);
+
+// The vectorised thresholds compare bytes, and a UPC never exceeds FAKE_DV
+_INLINE_ uint8_t decode_byte_threshold(IN const uint32_t threshold)
+{
+    return (uint8_t)(threshold | secure_l32_mask(threshold, 0xff));
+}
+
+// Write the bit-per-position masks of the two (transposed) halves of e
+// as a single N_BITS value, in the bit order of e.
+_INLINE_ void decode_join_halves(OUT uint8_t out[N_SIZE],
+                                 IN const uint8_t half0[R_SIZE],
+                                 IN const uint8_t half1[R_SIZE])
+{
+    uint32_t i;
+
+    for(i = 0; i < R_SIZE - 1; i++)
+    {
+        out[i] = half0[i];
+    }
+    out[R_SIZE - 1] = half0[R_SIZE - 1] & LAST_R_BYTE_MASK;
+
+    for(i = 0; i < R_SIZE; i++)
+    {
+        const uint8_t val = (i == R_SIZE - 1) ? (half1[i] & LAST_R_BYTE_MASK) : half1[i];
+
+        out[R_SIZE - 1 + i] |= (uint8_t)(val << LAST_R_BYTE_LEAD);
+        if(R_SIZE + i < N_SIZE)
+        {
+            out[R_SIZE + i] = val >> LAST_R_BYTE_TRAIL;
+        }
+    }
+}
@@ -13,23 +13,23 @@
 
 #include "types.h"
 
-#include "openssl_utils.h"
-
 //res = a*b mod (x^r - 1)
+//a and b are R_PADDED_QW long, only their first R_BITS bits are read.
 //the caller must allocate twice the size of res!
-_INLINE_ ret_t gf2x_mod_mul(OUT uint64_t *res,
-                            IN const uint64_t *a, 
-                            IN const uint64_t *b)
-{
-    return cyclic_product((uint8_t*)res, (const uint8_t*)a, (const uint8_t*)b);
-}
+ret_t gf2x_mod_mul(OUT uint64_t *res,
+                   IN const uint64_t *a, 
+                   IN const uint64_t *b);
 
-//A wrapper for other gf2x_add implementations.
+//res = a + b, size is in bytes
 _INLINE_ ret_t gf2x_add(OUT uint8_t *res, 
                         IN const uint8_t *a, 
                         IN const uint8_t *b, 
                         IN const uint64_t size)
 {
-    BIKE_UNUSED(size);
-    return ossl_add((uint8_t*)res, a, b);
+    for(uint64_t i = 0; i < size; i++)
+    {
+        res[i] = a[i] ^ b[i];
+    }
+
+    return SUCCESS;
 }
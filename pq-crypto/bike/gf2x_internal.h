@@ -0,0 +1,45 @@
+/***************************************************************************
+* Additional implementation of "BIKE: Bit Flipping Key Encapsulation". 
+* Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Written by Nir Drucker and Shay Gueron
+* AWS Cryptographic Algorithms Group
+* (ndrucker@amazon.com, gueron@amazon.com)
+*
+* The license is detailed in the file LICENSE.md, and applies to this file.
+* ***************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "bike_defs.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  #define GF2X_PCLMUL_AVAILABLE 1
+#else
+  #define GF2X_PCLMUL_AVAILABLE 0
+#endif
+
+//The Karatsuba recursion stops at operands of GF2X_BASE_QW qwords
+#define GF2X_BASE_QW 4
+
+//c = a*b, where a and b are GF2X_BASE_QW qwords and c is twice that.
+//All variants run in constant time.
+typedef void (*gf2x_mul_base_t)(OUT uint64_t *c, IN const uint64_t *a, IN const uint64_t *b);
+
+void gf2x_mul_base_portable(OUT uint64_t *c, IN const uint64_t *a, IN const uint64_t *b);
+
+#if GF2X_PCLMUL_AVAILABLE
+void gf2x_mul_base_pclmul(OUT uint64_t *c, IN const uint64_t *a, IN const uint64_t *b);
+
+//Returns 1 if the CPU supports the PCLMULQDQ instruction
+int gf2x_pclmul_supported(void);
+#endif
+
+//res = a*b mod (x^r - 1) using the given base multiplication.
+//gf2x_mod_mul selects the fastest one the CPU supports.
+void gf2x_mod_mul_with_base(OUT uint64_t *res,
+                            IN const uint64_t *a,
+                            IN const uint64_t *b,
+                            IN gf2x_mul_base_t mul_base);
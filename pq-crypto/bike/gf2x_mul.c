@@ -0,0 +1,137 @@
+/***************************************************************************
+* Additional implementation of "BIKE: Bit Flipping Key Encapsulation". 
+* Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Written by Nir Drucker and Shay Gueron
+* AWS Cryptographic Algorithms Group
+* (ndrucker@amazon.com, gueron@amazon.com)
+*
+* The license is detailed in the file LICENSE.md, and applies to this file.
+* ***************************************************************************/
+
+#include <string.h>
+
+#include "cleanup.h"
+#include "gf2x.h"
+#include "gf2x_internal.h"
+
+// Karatsuba halves the operands down to GF2X_BASE_QW, so R_PADDED_QW must be a power of two multiple of it
+bike_static_assert((R_PADDED_QW & (R_PADDED_QW - 1)) == 0, r_padded_qw_is_a_power_of_two);
+bike_static_assert(R_PADDED_QW >= GF2X_BASE_QW, r_padded_qw_is_at_least_the_base_size);
+
+// reduce() shifts by LAST_R_QW_TRAIL, which must be less than 64
+bike_static_assert(LAST_R_QW_LEAD != 0, r_bits_is_not_a_multiple_of_64);
+
+// Scratch space needed by karatsuba() for n qwords: 2n + 2(n/2) + ... < 4n
+#define KARATSUBA_SCRATCH_QW (4 * R_PADDED_QW)
+
+// c = a*b, where a and b are n qwords long and c is 2n qwords long.
+// The recursion only depends on n, so the run time does not depend on the operands.
+static void karatsuba(OUT uint64_t *c,
+                      IN const uint64_t *a,
+                      IN const uint64_t *b,
+                      IN const uint32_t n,
+                      IN OUT uint64_t *scratch,
+                      IN gf2x_mul_base_t mul_base)
+{
+    if(n == GF2X_BASE_QW)
+    {
+        mul_base(c, a, b);
+        return;
+    }
+
+    const uint32_t half = n / 2;
+    uint64_t *a_sum = scratch;
+    uint64_t *b_sum = scratch + half;
+    uint64_t *mid = scratch + n;
+
+    // c = a0*b0 + a1*b1*x^(2*half)
+    karatsuba(c, a, b, half, scratch, mul_base);
+    karatsuba(c + n, a + half, b + half, half, scratch, mul_base);
+
+    // mid = (a0 + a1)*(b0 + b1) - a0*b0 - a1*b1
+    for(uint32_t i = 0; i < half; i++)
+    {
+        a_sum[i] = a[i] ^ a[half + i];
+        b_sum[i] = b[i] ^ b[half + i];
+    }
+    karatsuba(mid, a_sum, b_sum, half, scratch + (2 * n), mul_base);
+
+    for(uint32_t i = 0; i < n; i++)
+    {
+        mid[i] ^= c[i] ^ c[n + i];
+    }
+
+    for(uint32_t i = 0; i < n; i++)
+    {
+        c[half + i] ^= mid[i];
+    }
+}
+
+// res = t mod (x^r - 1), where t has fewer than 2r bits.
+// Since x^r = 1, the bits of t from position r up are added back at position 0.
+_INLINE_ void reduce(OUT uint64_t *res, IN const uint64_t *t)
+{
+    const uint32_t shift_qw = R_BITS / 64;
+
+    for(uint32_t i = 0; i < R_QW; i++)
+    {
+        const uint64_t high = (t[shift_qw + i] >> LAST_R_QW_LEAD) |
+                              (t[shift_qw + i + 1] << LAST_R_QW_TRAIL);
+        res[i] = t[i] ^ high;
+    }
+
+    res[R_QW - 1] &= LAST_R_QW_MASK;
+}
+
+void gf2x_mod_mul_with_base(OUT uint64_t *res,
+                            IN const uint64_t *a,
+                            IN const uint64_t *b,
+                            IN gf2x_mul_base_t mul_base)
+{
+    // The callers' padding is not guaranteed to be zero, so only R_SIZE bytes are copied
+    padded_r_t pad_a = {0};
+    padded_r_t pad_b = {0};
+    uint64_t t[2 * R_PADDED_QW];
+    uint64_t scratch[KARATSUBA_SCRATCH_QW];
+
+    memcpy(pad_a.u.raw, a, R_SIZE);
+    memcpy(pad_b.u.raw, b, R_SIZE);
+
+    karatsuba(t, pad_a.u.qw, pad_b.u.qw, R_PADDED_QW, scratch, mul_base);
+    reduce(res, t);
+
+    secure_clean(pad_a.u.raw, sizeof(pad_a));
+    secure_clean(pad_b.u.raw, sizeof(pad_b));
+    secure_clean((uint8_t *)t, sizeof(t));
+    secure_clean((uint8_t *)scratch, sizeof(scratch));
+}
+
+static gf2x_mul_base_t select_mul_base(void)
+{
+#if GF2X_PCLMUL_AVAILABLE
+    if(gf2x_pclmul_supported())
+    {
+        return gf2x_mul_base_pclmul;
+    }
+#endif
+    return gf2x_mul_base_portable;
+}
+
+ret_t gf2x_mod_mul(OUT uint64_t *res,
+                   IN const uint64_t *a,
+                   IN const uint64_t *b)
+{
+    // Racing threads all store the same value
+    static gf2x_mul_base_t mul_base = NULL;
+    gf2x_mul_base_t selected = __atomic_load_n(&mul_base, __ATOMIC_RELAXED);
+    if(selected == NULL)
+    {
+        selected = select_mul_base();
+        __atomic_store_n(&mul_base, selected, __ATOMIC_RELAXED);
+    }
+
+    gf2x_mod_mul_with_base(res, a, b, selected);
+
+    return SUCCESS;
+}
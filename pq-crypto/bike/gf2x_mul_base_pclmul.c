@@ -0,0 +1,80 @@
+/***************************************************************************
+* Additional implementation of "BIKE: Bit Flipping Key Encapsulation". 
+* Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Written by Nir Drucker and Shay Gueron
+* AWS Cryptographic Algorithms Group
+* (ndrucker@amazon.com, gueron@amazon.com)
+*
+* The license is detailed in the file LICENSE.md, and applies to this file.
+* ***************************************************************************/
+
+#include "gf2x_internal.h"
+
+#if GF2X_PCLMUL_AVAILABLE
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+// The rest of the library is built without -mpclmul, so the instruction is
+// only enabled for these functions, which are only called after a CPUID check.
+#define PCLMUL_TARGET __attribute__((target("pclmul,sse2")))
+
+#define LOAD(p)     _mm_loadu_si128((const __m128i *)(const void *)(p))
+#define STORE(p, v) _mm_storeu_si128((__m128i *)(void *)(p), (v))
+
+// 128x128 bit multiplication with three PCLMULQDQ (Karatsuba)
+PCLMUL_TARGET _INLINE_ void mul_2x2(OUT uint64_t c[4], IN const uint64_t a[2], IN const uint64_t b[2])
+{
+    const __m128i va = LOAD(a);
+    const __m128i vb = LOAD(b);
+
+    __m128i lo = _mm_clmulepi64_si128(va, vb, 0x00);
+    __m128i hi = _mm_clmulepi64_si128(va, vb, 0x11);
+
+    // The low qword of x ^ (x >> 64) is x[0] ^ x[1]
+    const __m128i a_sum = _mm_xor_si128(va, _mm_srli_si128(va, 8));
+    const __m128i b_sum = _mm_xor_si128(vb, _mm_srli_si128(vb, 8));
+    __m128i mid = _mm_clmulepi64_si128(a_sum, b_sum, 0x00);
+
+    mid = _mm_xor_si128(mid, _mm_xor_si128(lo, hi));
+    lo = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+    hi = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+
+    STORE(c, lo);
+    STORE(c + 2, hi);
+}
+
+PCLMUL_TARGET void gf2x_mul_base_pclmul(OUT uint64_t *c, IN const uint64_t *a, IN const uint64_t *b)
+{
+    const uint64_t a_sum[2] = {a[0] ^ a[2], a[1] ^ a[3]};
+    const uint64_t b_sum[2] = {b[0] ^ b[2], b[1] ^ b[3]};
+    uint64_t mid[4];
+
+    mul_2x2(c, a, b);
+    mul_2x2(c + 4, a + 2, b + 2);
+    mul_2x2(mid, a_sum, b_sum);
+
+    for(uint32_t i = 0; i < 4; i++)
+    {
+        mid[i] ^= c[i] ^ c[4 + i];
+    }
+    for(uint32_t i = 0; i < 4; i++)
+    {
+        c[2 + i] ^= mid[i];
+    }
+}
+
+int gf2x_pclmul_supported(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    {
+        return 0;
+    }
+
+    return (ecx & bit_PCLMUL) != 0;
+}
+
+#endif
@@ -0,0 +1,95 @@
+/***************************************************************************
+* Additional implementation of "BIKE: Bit Flipping Key Encapsulation". 
+* Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Written by Nir Drucker and Shay Gueron
+* AWS Cryptographic Algorithms Group
+* (ndrucker@amazon.com, gueron@amazon.com)
+*
+* The license is detailed in the file LICENSE.md, and applies to this file.
+* ***************************************************************************/
+
+#include "gf2x_internal.h"
+
+#define LSB3(x) ((x) & 7)
+
+// 64x64 bit carry-less multiplication using a 3 bit window.
+// The table holds the 8 multiples of b (without its top 3 bits) and is
+// 64 bytes long and aligned, so that every lookup touches the same cache line.
+// The top 3 bits of b are multiplied separately with masks.
+_INLINE_ void mul_1x1(OUT uint64_t c[2], IN const uint64_t a, IN const uint64_t b)
+{
+    ALIGN(64) uint64_t u[8];
+    const uint64_t b_low = b & MASK(61);
+    uint64_t l;
+    uint64_t h;
+
+    u[0] = 0;
+    u[1] = b_low;
+    u[2] = u[1] << 1;
+    u[3] = u[2] ^ b_low;
+    u[4] = u[2] << 1;
+    u[5] = u[4] ^ b_low;
+    u[6] = u[3] << 1;
+    u[7] = u[6] ^ b_low;
+
+    // Every table entry has at most 63 bits, so the window at bit i
+    // contributes (g << i) to the low word and (g >> (64 - i)) to the high word
+    l = u[LSB3(a)] ^ (u[LSB3(a >> 3)] << 3);
+    h = u[LSB3(a >> 3)] >> 61;
+
+    for(uint32_t i = 6; i < 64; i += 6)
+    {
+        const uint64_t g1 = u[LSB3(a >> i)];
+        const uint64_t g2 = u[LSB3(a >> (i + 3))];
+
+        l ^= (g1 << i) ^ (g2 << (i + 3));
+        h ^= (g1 >> (64 - i)) ^ (g2 >> (64 - (i + 3)));
+    }
+
+    // Add a * x^i for each of the top 3 bits of b
+    for(uint32_t i = 61; i < 64; i++)
+    {
+        const uint64_t mask = 0 - ((b >> i) & 1);
+        l ^= (a << i) & mask;
+        h ^= (a >> (64 - i)) & mask;
+    }
+
+    c[0] = l;
+    c[1] = h;
+}
+
+// One Karatsuba step: 128x128 bits out of three 64x64 bit products
+_INLINE_ void mul_2x2(OUT uint64_t c[4], IN const uint64_t a[2], IN const uint64_t b[2])
+{
+    uint64_t mid[2];
+
+    mul_1x1(c, a[0], b[0]);
+    mul_1x1(c + 2, a[1], b[1]);
+    mul_1x1(mid, a[0] ^ a[1], b[0] ^ b[1]);
+
+    mid[0] ^= c[0] ^ c[2];
+    mid[1] ^= c[1] ^ c[3];
+    c[1] ^= mid[0];
+    c[2] ^= mid[1];
+}
+
+void gf2x_mul_base_portable(OUT uint64_t *c, IN const uint64_t *a, IN const uint64_t *b)
+{
+    const uint64_t a_sum[2] = {a[0] ^ a[2], a[1] ^ a[3]};
+    const uint64_t b_sum[2] = {b[0] ^ b[2], b[1] ^ b[3]};
+    uint64_t mid[4];
+
+    mul_2x2(c, a, b);
+    mul_2x2(c + 4, a + 2, b + 2);
+    mul_2x2(mid, a_sum, b_sum);
+
+    for(uint32_t i = 0; i < 4; i++)
+    {
+        mid[i] ^= c[i] ^ c[4 + i];
+    }
+    for(uint32_t i = 0; i < 4; i++)
+    {
+        c[2 + i] ^= mid[i];
+    }
+}
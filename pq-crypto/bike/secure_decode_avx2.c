@@ -0,0 +1,224 @@
+/***************************************************************************
+* Additional implementation of "BIKE: Bit Flipping Key Encapsulation".
+* Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Written by Nir Drucker and Shay Gueron
+* AWS Cryptographic Algorithms Group
+* (ndrucker@amazon.com, gueron@amazon.com)
+*
+* The license is detailed in the file LICENSE.md, and applies to this file.
+*
+* The optimizations are based on the description developed in the paper:
+* N. Drucker, S. Gueron,
+* "A toolbox for software optimization of QC-MDPC code-based cryptosystems",
+* ePrint (2017).
+*
+* ***************************************************************************/
+
+#include "decode_internal.h"
+
+#if DECODE_AVX2_AVAILABLE
+
+#include <string.h>
+#include <immintrin.h>
+
+// The rest of the library is built without -mavx2, so the instructions are
+// only enabled for these functions, which are only called after a CPUID check.
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+#define LOAD(p)     _mm256_loadu_si256((const __m256i *)(const void *)(p))
+#define STORE(p, v) _mm256_storeu_si256((__m256i *)(void *)(p), (v))
+
+// Positions handled by the vector loops, the remaining ones are handled one by one
+#define R_VEC_BITS (R_BITS - (R_BITS % YMM_SIZE))
+
+// Reverse the order of the 32 bytes of v
+AVX2_TARGET _INLINE_ __m256i reverse_bytes(IN const __m256i v)
+{
+    const __m256i idx = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                         15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+
+    return _mm256_permute4x64_epi64(_mm256_shuffle_epi8(v, idx), 0x4e);
+}
+
+// Bit i is set if byte i of v is at least th (unsigned)
+AVX2_TARGET _INLINE_ uint32_t ge_mask(IN const __m256i v, IN const __m256i th)
+{
+    return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(v, th), v));
+}
+
+// Each position accumulates all FAKE_DV rotations in a register, instead of
+// updating the whole counter array once per rotation.
+AVX2_TARGET static void compute_counter_of_unsat_avx2(OUT uint8_t upc[N_BITS],
+                                                      IN const uint8_t s[N_BITS],
+                                                      IN const compressed_idx_dv_t *inv_h0_compressed,
+                                                      IN const compressed_idx_dv_t *inv_h1_compressed)
+{
+    const compressed_idx_dv_t *inv_h[N0] = {inv_h0_compressed, inv_h1_compressed};
+    __m256i mask[FAKE_DV];
+    uint32_t pos[FAKE_DV];
+
+    for(uint32_t k = 0; k < N0; k++)
+    {
+        uint8_t *out = &upc[k * R_BITS];
+        uint32_t i;
+
+        for(uint32_t j = 0; j < FAKE_DV; j++)
+        {
+            mask[j] = _mm256_set1_epi8((char)inv_h[k]->val[j].used);
+            pos[j] = inv_h[k]->val[j].val;
+        }
+
+        for(i = 0; i < R_VEC_BITS; i += YMM_SIZE)
+        {
+            __m256i acc = _mm256_setzero_si256();
+            for(uint32_t j = 0; j < FAKE_DV; j++)
+            {
+                acc = _mm256_add_epi8(acc, _mm256_and_si256(LOAD(&s[i + pos[j]]), mask[j]));
+            }
+            STORE(&out[i], acc);
+        }
+
+        for(; i < R_BITS; i++)
+        {
+            uint8_t acc = 0;
+            for(uint32_t j = 0; j < FAKE_DV; j++)
+            {
+                acc += (s[i + pos[j]] & (uint8_t)inv_h[k]->val[j].used);
+            }
+            out[i] = acc;
+        }
+    }
+}
+
+AVX2_TARGET static void transpose_avx2(OUT red_r_t *col,
+                                       IN const red_r_t *row)
+{
+    uint32_t i;
+
+    col->raw[0] = row->raw[0];
+
+    // col[i..i+31] = row[r-i-31..r-i] in reverse order
+    for(i = 1; i + YMM_SIZE <= R_BITS; i += YMM_SIZE)
+    {
+        STORE(&col->raw[i], reverse_bytes(LOAD(&row->raw[R_BITS - i - (YMM_SIZE - 1)])));
+    }
+
+    for(; i < R_BITS; i++)
+    {
+        col->raw[i] = row->raw[R_BITS - i];
+    }
+}
+
+AVX2_TARGET static void find_error1_avx2(IN OUT e_t *e,
+                                         OUT e_t *black_e,
+                                         OUT e_t *gray_e,
+                                         IN const uint8_t *upc,
+                                         IN const uint32_t black_th,
+                                         IN const uint32_t gray_th)
+{
+    const __m256i black_th_vec = _mm256_set1_epi8((char)decode_byte_threshold(black_th));
+    const __m256i gray_th_vec = _mm256_set1_epi8((char)decode_byte_threshold(gray_th));
+    uint8_t black[N0][R_SIZE] = {{0}};
+    uint8_t gray[N0][R_SIZE] = {{0}};
+    red_r_t col;
+
+    for(uint32_t k = 0; k < N0; k++)
+    {
+        uint32_t i;
+
+        transpose_avx2(&col, (const red_r_t *)&upc[k * R_BITS]);
+
+        for(i = 0; i < R_VEC_BITS; i += YMM_SIZE)
+        {
+            const __m256i val = LOAD(&col.raw[i]);
+            const __m256i black_mask = _mm256_cmpeq_epi8(_mm256_max_epu8(val, black_th_vec), val);
+
+            // Update the gray list only if not in the black list
+            const uint32_t black_bits = (uint32_t)_mm256_movemask_epi8(black_mask);
+            const uint32_t gray_bits = ge_mask(_mm256_andnot_si256(black_mask, val), gray_th_vec);
+
+            memcpy(&black[k][i / 8], &black_bits, sizeof(black_bits));
+            memcpy(&gray[k][i / 8], &gray_bits, sizeof(gray_bits));
+        }
+
+        for(; i < R_BITS; i++)
+        {
+            uint8_t val = col.raw[i];
+            uint8_t mask = secure_l32_mask(val, black_th);
+            black[k][i / 8] |= (mask & 1) << (i % 8);
+
+            val &= (~mask);
+            mask = secure_l32_mask(val, gray_th);
+            gray[k][i / 8] |= (mask & 1) << (i % 8);
+        }
+    }
+
+    decode_join_halves(black_e->raw, black[0], black[1]);
+    decode_join_halves(gray_e->raw, gray[0], gray[1]);
+
+    for(uint32_t i = 0; i < N_SIZE; i++)
+    {
+        e->raw[i] ^= black_e->raw[i];
+    }
+
+    secure_clean(col.raw, sizeof(col));
+    secure_clean(black[0], sizeof(black));
+    secure_clean(gray[0], sizeof(gray));
+}
+
+AVX2_TARGET static void find_error2_avx2(IN OUT e_t *e,
+                                         IN e_t *pos_e,
+                                         IN const uint8_t *upc,
+                                         IN const uint32_t threshold)
+{
+    const __m256i th_vec = _mm256_set1_epi8((char)decode_byte_threshold(threshold));
+    uint8_t pos[N0][R_SIZE] = {{0}};
+    e_t pos_mask;
+    red_r_t col;
+
+    for(uint32_t k = 0; k < N0; k++)
+    {
+        uint32_t i;
+
+        transpose_avx2(&col, (const red_r_t *)&upc[k * R_BITS]);
+
+        for(i = 0; i < R_VEC_BITS; i += YMM_SIZE)
+        {
+            const uint32_t bits = ge_mask(LOAD(&col.raw[i]), th_vec);
+            memcpy(&pos[k][i / 8], &bits, sizeof(bits));
+        }
+
+        for(; i < R_BITS; i++)
+        {
+            const uint8_t mask = secure_l32_mask(col.raw[i], threshold);
+            pos[k][i / 8] |= (mask & 1) << (i % 8);
+        }
+    }
+
+    decode_join_halves(pos_mask.raw, pos[0], pos[1]);
+
+    for(uint32_t i = 0; i < N_SIZE; i++)
+    {
+        e->raw[i] ^= (pos_e->raw[i] & pos_mask.raw[i]);
+    }
+
+    secure_clean(col.raw, sizeof(col));
+    secure_clean(pos[0], sizeof(pos));
+    secure_clean(pos_mask.raw, sizeof(pos_mask));
+}
+
+const decode_kernels_t decode_kernels_avx2 = {
+    .compute_counter_of_unsat = compute_counter_of_unsat_avx2,
+    .transpose = transpose_avx2,
+    .find_error1 = find_error1_avx2,
+    .find_error2 = find_error2_avx2,
+};
+
+int decode_avx2_supported(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+#endif
@@ -0,0 +1,220 @@
+/***************************************************************************
+* Additional implementation of "BIKE: Bit Flipping Key Encapsulation".
+* Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Written by Nir Drucker and Shay Gueron
+* AWS Cryptographic Algorithms Group
+* (ndrucker@amazon.com, gueron@amazon.com)
+*
+* The license is detailed in the file LICENSE.md, and applies to this file.
+*
+* The optimizations are based on the description developed in the paper:
+* N. Drucker, S. Gueron,
+* "A toolbox for software optimization of QC-MDPC code-based cryptosystems",
+* ePrint (2017).
+*
+* ***************************************************************************/
+
+#include "decode_internal.h"
+
+#if DECODE_AVX512_AVAILABLE
+
+#include <string.h>
+#include <immintrin.h>
+
+// The rest of the library is built without -mavx512*, so the instructions are
+// only enabled for these functions, which are only called after a CPUID check.
+#define AVX512_TARGET __attribute__((target("avx512f,avx512bw")))
+
+#define LOAD(p)     _mm512_loadu_si512((const void *)(p))
+#define STORE(p, v) _mm512_storeu_si512((void *)(p), (v))
+
+// Positions handled by the vector loops, the remaining ones are handled one by one
+#define R_VEC_BITS (R_BITS - (R_BITS % ZMM_SIZE))
+
+// Reverse the order of the 64 bytes of v
+AVX512_TARGET _INLINE_ __m512i reverse_bytes(IN const __m512i v)
+{
+    const __m512i idx = _mm512_broadcast_i32x4(_mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8,
+                                                             7, 6, 5, 4, 3, 2, 1, 0));
+
+    // Reverse the bytes of each 128-bit lane and then the order of the lanes
+    const __m512i lanes = _mm512_shuffle_epi8(v, idx);
+    return _mm512_shuffle_i64x2(lanes, lanes, 0x1b);
+}
+
+// Each position accumulates all FAKE_DV rotations in a register, instead of
+// updating the whole counter array once per rotation.
+AVX512_TARGET static void compute_counter_of_unsat_avx512(OUT uint8_t upc[N_BITS],
+                                                          IN const uint8_t s[N_BITS],
+                                                          IN const compressed_idx_dv_t *inv_h0_compressed,
+                                                          IN const compressed_idx_dv_t *inv_h1_compressed)
+{
+    const compressed_idx_dv_t *inv_h[N0] = {inv_h0_compressed, inv_h1_compressed};
+    __mmask64 mask[FAKE_DV];
+    uint32_t pos[FAKE_DV];
+
+    for(uint32_t k = 0; k < N0; k++)
+    {
+        uint8_t *out = &upc[k * R_BITS];
+        uint32_t i;
+
+        for(uint32_t j = 0; j < FAKE_DV; j++)
+        {
+            // used is either 0 or all ones
+            mask[j] = (__mmask64)(0 - (uint64_t)(inv_h[k]->val[j].used & 1));
+            pos[j] = inv_h[k]->val[j].val;
+        }
+
+        for(i = 0; i < R_VEC_BITS; i += ZMM_SIZE)
+        {
+            __m512i acc = _mm512_setzero_si512();
+            for(uint32_t j = 0; j < FAKE_DV; j++)
+            {
+                acc = _mm512_mask_add_epi8(acc, mask[j], acc, LOAD(&s[i + pos[j]]));
+            }
+            STORE(&out[i], acc);
+        }
+
+        for(; i < R_BITS; i++)
+        {
+            uint8_t acc = 0;
+            for(uint32_t j = 0; j < FAKE_DV; j++)
+            {
+                acc += (s[i + pos[j]] & (uint8_t)inv_h[k]->val[j].used);
+            }
+            out[i] = acc;
+        }
+    }
+}
+
+AVX512_TARGET static void transpose_avx512(OUT red_r_t *col,
+                                           IN const red_r_t *row)
+{
+    uint32_t i;
+
+    col->raw[0] = row->raw[0];
+
+    // col[i..i+63] = row[r-i-63..r-i] in reverse order
+    for(i = 1; i + ZMM_SIZE <= R_BITS; i += ZMM_SIZE)
+    {
+        STORE(&col->raw[i], reverse_bytes(LOAD(&row->raw[R_BITS - i - (ZMM_SIZE - 1)])));
+    }
+
+    for(; i < R_BITS; i++)
+    {
+        col->raw[i] = row->raw[R_BITS - i];
+    }
+}
+
+AVX512_TARGET static void find_error1_avx512(IN OUT e_t *e,
+                                             OUT e_t *black_e,
+                                             OUT e_t *gray_e,
+                                             IN const uint8_t *upc,
+                                             IN const uint32_t black_th,
+                                             IN const uint32_t gray_th)
+{
+    const __m512i black_th_vec = _mm512_set1_epi8((char)decode_byte_threshold(black_th));
+    const __m512i gray_th_vec = _mm512_set1_epi8((char)decode_byte_threshold(gray_th));
+    uint8_t black[N0][R_SIZE] = {{0}};
+    uint8_t gray[N0][R_SIZE] = {{0}};
+    red_r_t col;
+
+    for(uint32_t k = 0; k < N0; k++)
+    {
+        uint32_t i;
+
+        transpose_avx512(&col, (const red_r_t *)&upc[k * R_BITS]);
+
+        for(i = 0; i < R_VEC_BITS; i += ZMM_SIZE)
+        {
+            const __m512i val = LOAD(&col.raw[i]);
+            const uint64_t black_bits = _mm512_cmpge_epu8_mask(val, black_th_vec);
+
+            // Update the gray list only if not in the black list
+            const uint64_t gray_bits = _mm512_cmpge_epu8_mask(_mm512_maskz_mov_epi8(~black_bits, val), gray_th_vec);
+
+            memcpy(&black[k][i / 8], &black_bits, sizeof(black_bits));
+            memcpy(&gray[k][i / 8], &gray_bits, sizeof(gray_bits));
+        }
+
+        for(; i < R_BITS; i++)
+        {
+            uint8_t val = col.raw[i];
+            uint8_t mask = secure_l32_mask(val, black_th);
+            black[k][i / 8] |= (mask & 1) << (i % 8);
+
+            val &= (~mask);
+            mask = secure_l32_mask(val, gray_th);
+            gray[k][i / 8] |= (mask & 1) << (i % 8);
+        }
+    }
+
+    decode_join_halves(black_e->raw, black[0], black[1]);
+    decode_join_halves(gray_e->raw, gray[0], gray[1]);
+
+    for(uint32_t i = 0; i < N_SIZE; i++)
+    {
+        e->raw[i] ^= black_e->raw[i];
+    }
+
+    secure_clean(col.raw, sizeof(col));
+    secure_clean(black[0], sizeof(black));
+    secure_clean(gray[0], sizeof(gray));
+}
+
+AVX512_TARGET static void find_error2_avx512(IN OUT e_t *e,
+                                             IN e_t *pos_e,
+                                             IN const uint8_t *upc,
+                                             IN const uint32_t threshold)
+{
+    const __m512i th_vec = _mm512_set1_epi8((char)decode_byte_threshold(threshold));
+    uint8_t pos[N0][R_SIZE] = {{0}};
+    e_t pos_mask;
+    red_r_t col;
+
+    for(uint32_t k = 0; k < N0; k++)
+    {
+        uint32_t i;
+
+        transpose_avx512(&col, (const red_r_t *)&upc[k * R_BITS]);
+
+        for(i = 0; i < R_VEC_BITS; i += ZMM_SIZE)
+        {
+            const uint64_t bits = _mm512_cmpge_epu8_mask(LOAD(&col.raw[i]), th_vec);
+            memcpy(&pos[k][i / 8], &bits, sizeof(bits));
+        }
+
+        for(; i < R_BITS; i++)
+        {
+            const uint8_t mask = secure_l32_mask(col.raw[i], threshold);
+            pos[k][i / 8] |= (mask & 1) << (i % 8);
+        }
+    }
+
+    decode_join_halves(pos_mask.raw, pos[0], pos[1]);
+
+    for(uint32_t i = 0; i < N_SIZE; i++)
+    {
+        e->raw[i] ^= (pos_e->raw[i] & pos_mask.raw[i]);
+    }
+
+    secure_clean(col.raw, sizeof(col));
+    secure_clean(pos[0], sizeof(pos));
+    secure_clean(pos_mask.raw, sizeof(pos_mask));
+}
+
+const decode_kernels_t decode_kernels_avx512 = {
+    .compute_counter_of_unsat = compute_counter_of_unsat_avx512,
+    .transpose = transpose_avx512,
+    .find_error1 = find_error1_avx512,
+    .find_error2 = find_error2_avx512,
+};
+
+int decode_avx512_supported(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+}
+
+#endif
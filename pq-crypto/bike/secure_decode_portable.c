@@ -17,14 +17,13 @@
 *
 * ***************************************************************************/
 
-#include "decode.h"
-#include "utilities.h"
+#include "decode_internal.h"
 #include <string.h>
 
-EXTERNC void compute_counter_of_unsat(OUT uint8_t upc[N_BITS],
-                                      IN const uint8_t s[N_BITS],
-                                      IN const compressed_idx_dv_t* inv_h0_compressed,
-                                      IN const compressed_idx_dv_t* inv_h1_compressed)
+static void compute_counter_of_unsat_portable(OUT uint8_t upc[N_BITS],
+                                              IN const uint8_t s[N_BITS],
+                                              IN const compressed_idx_dv_t* inv_h0_compressed,
+                                              IN const compressed_idx_dv_t* inv_h1_compressed)
 {
     uint32_t i=0, j=0, mask[2]={0}, pos[2]={0};
     
@@ -45,12 +44,22 @@ EXTERNC void compute_counter_of_unsat(OUT uint8_t upc[N_BITS],
     }
 }
 
-EXTERNC void find_error1(IN OUT e_t* e,
-                         OUT e_t* black_e,
-                         OUT e_t* gray_e,
-                         IN const uint8_t* upc,
-                         IN const uint32_t black_th,
-                         IN const uint32_t gray_th)
+static void transpose_portable(OUT red_r_t *col,
+                               IN const red_r_t *row)
+{
+    col->raw[0] = row->raw[0];
+    for (uint64_t i = 1; i < R_BITS ; ++i)
+    {
+        col->raw[i] = row->raw[(R_BITS) - i];
+    }
+}
+
+static void find_error1_portable(IN OUT e_t* e,
+                                 OUT e_t* black_e,
+                                 OUT e_t* gray_e,
+                                 IN const uint8_t* upc,
+                                 IN const uint32_t black_th,
+                                 IN const uint32_t gray_th)
 {
     uint8_t bit = 1, black_acc = 0, gray_acc = 0;
     uint8_t val = 0, mask = 0;
@@ -103,10 +112,10 @@ EXTERNC void find_error1(IN OUT e_t* e,
     gray_e->raw[byte_itr] = gray_acc;
 }
 
-EXTERNC void find_error2(IN OUT e_t* e,
-                         IN e_t* pos_e,
-                         IN const uint8_t* upc,
-                         IN const uint32_t threshold)
+static void find_error2_portable(IN OUT e_t* e,
+                                 IN e_t* pos_e,
+                                 IN const uint8_t* upc,
+                                 IN const uint32_t threshold)
 {
     uint8_t bit = 1;
     uint8_t pos_acc = 0;
@@ -139,3 +148,10 @@ EXTERNC void find_error2(IN OUT e_t* e,
     //Final byte
     e->raw[byte_itr] ^= (pos_e->raw[byte_itr] & pos_acc);
 }
+
+const decode_kernels_t decode_kernels_portable = {
+    .compute_counter_of_unsat = compute_counter_of_unsat_portable,
+    .transpose = transpose_portable,
+    .find_error1 = find_error1_portable,
+    .find_error2 = find_error2_portable,
+};
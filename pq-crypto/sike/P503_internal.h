@@ -151,11 +151,20 @@ void fpcorrection503(digit_t* a);
 
 // 503-bit Montgomery reduction, c = a mod p
 void rdc_mont(const digit_t* a, digit_t* c);
+
+#if defined(SIKE_P503_X64)
+// 503-bit multiplication and Montgomery reduction with 64x64->128-bit products
+void mul503_x64(const digit_t* a, const digit_t* b, digit_t* c);
+void rdc503_x64(const digit_t* ma, digit_t* mc);
+
+// Returns 1 if the CPU supports MULX (BMI2) and ADCX/ADOX (ADX), which mul503_asm and rdc503_asm require
+int fp_x64_mulx_supported(void);
+#endif
             
 // Field multiplication using Montgomery arithmetic, c = a*b*R^-1 mod p503, where R=2^768
 void fpmul503_mont(const felm_t a, const felm_t b, felm_t c);
 void mul503_asm(const felm_t a, const felm_t b, dfelm_t c);
-void rdc503_asm(const dfelm_t ma, dfelm_t mc);
+void rdc503_asm(const dfelm_t ma, felm_t mc);
    
 // Field squaring using Montgomery arithmetic, c = a*b*R^-1 mod p503, where R=2^768
 void fpsqr503_mont(const felm_t ma, felm_t mc);
@@ -61,6 +61,14 @@
 #define RADIX64             64
 
 
+// x64 field arithmetic: fp_x64.c replaces the portable multiplication, Montgomery reduction,
+// addition and subtraction of fp_generic.c, and selects MULX/ADX code at runtime
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    #define SIKE_P503_X64
+#endif
+
+
 // Selection of implementation: optimized_generic
 
 #if defined(_OPTIMIZED_GENERIC_)                      
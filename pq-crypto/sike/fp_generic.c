@@ -12,6 +12,7 @@ extern const uint64_t p503[NWORDS_FIELD];
 extern const uint64_t p503p1[NWORDS_FIELD]; 
 extern const uint64_t p503x2[NWORDS_FIELD]; 
 
+#if !defined(SIKE_P503_X64)
 void fpadd503(const digit_t* a, const digit_t* b, digit_t* c)
 { // Modular addition, c = a+b mod p503.
   // Inputs: a, b in [0, 2*p503-1] 
@@ -53,6 +54,7 @@ void fpsub503(const digit_t* a, const digit_t* b, digit_t* c)
         ADDC(borrow, c[i], ((const digit_t*)p503x2)[i] & mask, borrow, c[i]); 
     }
 }
+#endif
 
 
 void fpneg503(digit_t* a)
@@ -133,6 +135,7 @@ void digit_x_digit(const digit_t a, const digit_t b, digit_t* c)
 }
 
 
+#if !defined(SIKE_P503_X64)
 void mp_mul(const digit_t* a, const digit_t* b, digit_t* c, const unsigned int nwords)
 { // Multiprecision comba multiply, c = a*b, where lng(a) = lng(b) = nwords.   
     unsigned int i, j;
@@ -221,3 +224,4 @@ void rdc_mont(const dfelm_t ma, felm_t mc)
     ADDC(0, v, ma[2*NWORDS_FIELD-1], carry, v); 
     mc[NWORDS_FIELD-1] = v;
 }
+#endif
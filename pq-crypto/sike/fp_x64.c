@@ -0,0 +1,373 @@
+/********************************************************************************************
+* Supersingular Isogeny Key Encapsulation Library
+*
+* Abstract: modular arithmetic optimized for x64 platforms for P503
+*********************************************************************************************/
+
+#include "P503_internal.h"
+
+#if defined(SIKE_P503_X64)
+
+#include <cpuid.h>
+#include <x86intrin.h>
+
+// Global constants
+extern const uint64_t p503[NWORDS_FIELD];
+extern const uint64_t p503p1[NWORDS_FIELD];
+extern const uint64_t p503x2[NWORDS_FIELD];
+
+__extension__ typedef unsigned __int128 uint128_x64_t;
+
+typedef unsigned long long int ull_t;    // Operand type of the carry intrinsics
+
+
+void fpadd503(const digit_t* a, const digit_t* b, digit_t* c)
+{ // Modular addition, c = a+b mod p503.
+  // Inputs: a, b in [0, 2*p503-1]
+  // Output: c in [0, 2*p503-1]
+    unsigned int i;
+    unsigned char carry = 0;
+    ull_t t[NWORDS_FIELD];
+    digit_t mask;
+
+    for (i = 0; i < NWORDS_FIELD; i++) {
+        carry = _addcarry_u64(carry, a[i], b[i], &t[i]);
+    }
+
+    carry = 0;
+    for (i = 0; i < NWORDS_FIELD; i++) {
+        carry = _subborrow_u64(carry, t[i], p503x2[i], &t[i]);
+    }
+    mask = 0 - (digit_t)carry;
+
+    carry = 0;
+    for (i = 0; i < NWORDS_FIELD; i++) {
+        carry = _addcarry_u64(carry, t[i], p503x2[i] & mask, &t[i]);
+        c[i] = t[i];
+    }
+}
+
+
+void fpsub503(const digit_t* a, const digit_t* b, digit_t* c)
+{ // Modular subtraction, c = a-b mod p503.
+  // Inputs: a, b in [0, 2*p503-1]
+  // Output: c in [0, 2*p503-1]
+    unsigned int i;
+    unsigned char borrow = 0;
+    ull_t t[NWORDS_FIELD];
+    digit_t mask;
+
+    for (i = 0; i < NWORDS_FIELD; i++) {
+        borrow = _subborrow_u64(borrow, a[i], b[i], &t[i]);
+    }
+    mask = 0 - (digit_t)borrow;
+
+    borrow = 0;
+    for (i = 0; i < NWORDS_FIELD; i++) {
+        borrow = _addcarry_u64(borrow, t[i], p503x2[i] & mask, &t[i]);
+        c[i] = t[i];
+    }
+}
+
+
+static void mp_mul_x64(const digit_t* a, const digit_t* b, digit_t* c, const unsigned int nwords)
+{ // Multiprecision schoolbook multiply with 64x64->128-bit products, c = a*b, where lng(a) = lng(b) = nwords.
+  // Each step computes a[i]*b[j] + c[i+j] + carry < 2^128, so no carry is lost.
+    unsigned int i, j;
+    uint128_x64_t t;
+    digit_t carry;
+
+    for (i = 0; i < 2*nwords; i++) {
+        c[i] = 0;
+    }
+
+    for (i = 0; i < nwords; i++) {
+        carry = 0;
+        for (j = 0; j < nwords; j++) {
+            t = (uint128_x64_t)a[i]*b[j] + c[i+j] + carry;
+            c[i+j] = (digit_t)t;
+            carry = (digit_t)(t >> 64);
+        }
+        c[i+nwords] = carry;
+    }
+}
+
+
+void mul503_x64(const digit_t* a, const digit_t* b, digit_t* c)
+{ // 503-bit multiplication with 64x64->128-bit products, c = a*b.
+    mp_mul_x64(a, b, c, NWORDS_FIELD);
+}
+
+
+void rdc503_x64(const digit_t* ma, digit_t* mc)
+{ // Montgomery reduction with 64x64->128-bit products exploiting the special form of the prime p503.
+  // mc = ma*R^-1 mod p503x2, where R = 2^512.
+  // If ma < 2^512*p503, the output mc is in the range [0, 2*p503-1].
+  // Since p503 = -1 mod 2^64, the quotient digit of each step is the current low digit, and
+  // adding q*p503 = q*(p503+1) - q clears that digit exactly. The low p503_ZERO_WORDS digits
+  // of p503+1 are zero, so only the remaining ones are multiplied.
+    unsigned int i, j;
+    uint128_x64_t t;
+    digit_t tt[2*NWORDS_FIELD], q, carry, overflow = 0;
+
+    for (i = 0; i < 2*NWORDS_FIELD; i++) {
+        tt[i] = ma[i];
+    }
+
+    for (i = 0; i < NWORDS_FIELD; i++) {
+        q = tt[i];
+        carry = 0;
+        for (j = p503_ZERO_WORDS; j < NWORDS_FIELD; j++) {
+            t = (uint128_x64_t)q*p503p1[j] + tt[i+j] + carry;
+            tt[i+j] = (digit_t)t;
+            carry = (digit_t)(t >> 64);
+        }
+        // The carry out of digit i+NWORDS_FIELD is added with the next step's
+        t = (uint128_x64_t)tt[i+NWORDS_FIELD] + carry + overflow;
+        tt[i+NWORDS_FIELD] = (digit_t)t;
+        overflow = (digit_t)(t >> 64);
+    }
+
+    for (i = 0; i < NWORDS_FIELD; i++) {
+        mc[i] = tt[i+NWORDS_FIELD];
+    }
+}
+
+
+// MULX (BMI2) multiplies without touching the flags, and ADCX/ADOX (ADX) propagate two
+// independent carry chains through CF and OF. Each row of the products below adds the low
+// halves of a[i]*b[j] on the CF chain and the high halves on the OF chain.
+// The instructions are assembled regardless of the compiler's -m flags, and these
+// functions are only called after a CPUID check.
+
+// Accumulate rdx*b[j], where b[j] is at OFF(%rdi), into T0 (low half) and T1 (high half)
+#define MULADD(OFF, T0, T1)                                                   \
+    "mulx " OFF "(%%rdi), %%rax, %%rbx\n\t"                                   \
+    "adcx %%rax, " T0 "\n\t"                                                  \
+    "adox %%rbx, " T1 "\n\t"
+
+// Row i of the multiplication: T1..T8 += a[i]*b, then c[i] = T0 and T8 becomes the new top digit
+#define MUL_ROW(AOFF, COFF, T0, T1, T2, T3, T4, T5, T6, T7, T8)              \
+    "xor " T8 ", " T8 "\n\t"                                                  \
+    "movq " AOFF "(%%rdi), %%rdx\n\t"                                         \
+    MULADD("64", T0, T1)                                                      \
+    MULADD("72", T1, T2)                                                      \
+    MULADD("80", T2, T3)                                                      \
+    MULADD("88", T3, T4)                                                      \
+    MULADD("96", T4, T5)                                                      \
+    MULADD("104", T5, T6)                                                     \
+    MULADD("112", T6, T7)                                                     \
+    MULADD("120", T7, T8)                                                     \
+    "movq $0, %%rax\n\t"                                                      \
+    "adcx %%rax, " T8 "\n\t"                                                  \
+    "movq " T0 ", " COFF "(%%rdi)\n\t"
+
+#define R0 "%%rcx"
+#define R1 "%%rsi"
+#define R2 "%%r8"
+#define R3 "%%r9"
+#define R4 "%%r10"
+#define R5 "%%r11"
+#define R6 "%%r12"
+#define R7 "%%r13"
+#define R8 "%%r14"
+
+void mul503_asm(const felm_t a, const felm_t b, dfelm_t c)
+{ // 503-bit multiplication using MULX and ADCX/ADOX, c = a*b.
+    unsigned int i;
+    // a, b and c are laid out next to each other so that a single register addresses them
+    digit_t abc[4*NWORDS_FIELD];
+
+    for (i = 0; i < NWORDS_FIELD; i++) {
+        abc[i] = a[i];
+        abc[NWORDS_FIELD + i] = b[i];
+    }
+
+    __asm__ __volatile__(
+        "xor " R0 ", " R0 "\n\t"
+        "xor " R1 ", " R1 "\n\t"
+        "xor " R2 ", " R2 "\n\t"
+        "xor " R3 ", " R3 "\n\t"
+        "xor " R4 ", " R4 "\n\t"
+        "xor " R5 ", " R5 "\n\t"
+        "xor " R6 ", " R6 "\n\t"
+        "xor " R7 ", " R7 "\n\t"
+        MUL_ROW("0",  "128", R0, R1, R2, R3, R4, R5, R6, R7, R8)
+        MUL_ROW("8",  "136", R1, R2, R3, R4, R5, R6, R7, R8, R0)
+        MUL_ROW("16", "144", R2, R3, R4, R5, R6, R7, R8, R0, R1)
+        MUL_ROW("24", "152", R3, R4, R5, R6, R7, R8, R0, R1, R2)
+        MUL_ROW("32", "160", R4, R5, R6, R7, R8, R0, R1, R2, R3)
+        MUL_ROW("40", "168", R5, R6, R7, R8, R0, R1, R2, R3, R4)
+        MUL_ROW("48", "176", R6, R7, R8, R0, R1, R2, R3, R4, R5)
+        MUL_ROW("56", "184", R7, R8, R0, R1, R2, R3, R4, R5, R6)
+        "movq " R8 ", 192(%%rdi)\n\t"
+        "movq " R0 ", 200(%%rdi)\n\t"
+        "movq " R1 ", 208(%%rdi)\n\t"
+        "movq " R2 ", 216(%%rdi)\n\t"
+        "movq " R3 ", 224(%%rdi)\n\t"
+        "movq " R4 ", 232(%%rdi)\n\t"
+        "movq " R5 ", 240(%%rdi)\n\t"
+        "movq " R6 ", 248(%%rdi)\n\t"
+        :
+        : "D" (abc)
+        : "rax", "rbx", "rcx", "rdx", "rsi", "r8", "r9", "r10", "r11", "r12", "r13", "r14", "cc", "memory");
+
+    for (i = 0; i < 2*NWORDS_FIELD; i++) {
+        c[i] = abc[2*NWORDS_FIELD + i];
+    }
+}
+
+
+// Accumulate rdx*(p503+1)[j], where (p503+1)[j] is at OFF(%rdi), into T0 (low half) and T1 (high half)
+#define RDC_MULADD(OFF, T0, T1)                                               \
+    "mulx " OFF "(%%rdi), %%rax, %%rbx\n\t"                                   \
+    "adcx %%rax, " T0 "\n\t"                                                  \
+    "adox %%rbx, " T1 "\n\t"
+
+// Step i of the reduction, with T0..T8 holding digits i..i+8 of the running value:
+// T3..T8 += T0*(p503+1), adding the carries left by the previous step (in rcx) to T8 and
+// leaving the carries out of T8 in rcx. T0 is then reloaded with digit i+9 when there is one.
+#define RDC_STEP(T0, T1, T2, T3, T4, T5, T6, T7, T8, NEXT)                    \
+    "movq " T0 ", %%rdx\n\t"                                                  \
+    "xor %%rax, %%rax\n\t"                                                    \
+    RDC_MULADD("128", T3, T4)                                                 \
+    RDC_MULADD("136", T4, T5)                                                 \
+    RDC_MULADD("144", T5, T6)                                                 \
+    RDC_MULADD("152", T6, T7)                                                 \
+    RDC_MULADD("160", T7, T8)                                                 \
+    "adcx %%rcx, " T8 "\n\t"                                                  \
+    "movq $0, %%rax\n\t"                                                      \
+    "movq $0, %%rcx\n\t"                                                      \
+    "adcx %%rax, %%rcx\n\t"                                                   \
+    "adox %%rax, %%rcx\n\t"                                                   \
+    NEXT
+
+#define RDC_LOAD(OFF, T) "movq " OFF "(%%rdi), " T "\n\t"
+
+#define W0 "%%rsi"
+#define W1 "%%r8"
+#define W2 "%%r9"
+#define W3 "%%r10"
+#define W4 "%%r11"
+#define W5 "%%r12"
+#define W6 "%%r13"
+#define W7 "%%r14"
+#define W8 "%%r15"
+
+void rdc503_asm(const dfelm_t ma, felm_t mc)
+{ // Montgomery reduction using MULX and ADCX/ADOX, exploiting the special form of the prime p503.
+  // mc = ma*R^-1 mod p503x2, where R = 2^512.
+  // If ma < 2^512*p503, the output mc is in the range [0, 2*p503-1].
+  // See rdc503_x64 for the algorithm.
+    unsigned int i;
+    // ma is followed by the non-zero digits of p503+1 so that a single register addresses them
+    digit_t t[2*NWORDS_FIELD + NWORDS_FIELD - p503_ZERO_WORDS];
+
+    for (i = 0; i < 2*NWORDS_FIELD; i++) {
+        t[i] = ma[i];
+    }
+    for (i = p503_ZERO_WORDS; i < NWORDS_FIELD; i++) {
+        t[2*NWORDS_FIELD + i - p503_ZERO_WORDS] = p503p1[i];
+    }
+
+    __asm__ __volatile__(
+        "xor %%rcx, %%rcx\n\t"
+        RDC_LOAD("0",  W0)
+        RDC_LOAD("8",  W1)
+        RDC_LOAD("16", W2)
+        RDC_LOAD("24", W3)
+        RDC_LOAD("32", W4)
+        RDC_LOAD("40", W5)
+        RDC_LOAD("48", W6)
+        RDC_LOAD("56", W7)
+        RDC_LOAD("64", W8)
+        RDC_STEP(W0, W1, W2, W3, W4, W5, W6, W7, W8, RDC_LOAD("72",  W0))
+        RDC_STEP(W1, W2, W3, W4, W5, W6, W7, W8, W0, RDC_LOAD("80",  W1))
+        RDC_STEP(W2, W3, W4, W5, W6, W7, W8, W0, W1, RDC_LOAD("88",  W2))
+        RDC_STEP(W3, W4, W5, W6, W7, W8, W0, W1, W2, RDC_LOAD("96",  W3))
+        RDC_STEP(W4, W5, W6, W7, W8, W0, W1, W2, W3, RDC_LOAD("104", W4))
+        RDC_STEP(W5, W6, W7, W8, W0, W1, W2, W3, W4, RDC_LOAD("112", W5))
+        RDC_STEP(W6, W7, W8, W0, W1, W2, W3, W4, W5, RDC_LOAD("120", W6))
+        RDC_STEP(W7, W8, W0, W1, W2, W3, W4, W5, W6, "")
+        "movq " W8 ", 0(%%rdi)\n\t"
+        "movq " W0 ", 8(%%rdi)\n\t"
+        "movq " W1 ", 16(%%rdi)\n\t"
+        "movq " W2 ", 24(%%rdi)\n\t"
+        "movq " W3 ", 32(%%rdi)\n\t"
+        "movq " W4 ", 40(%%rdi)\n\t"
+        "movq " W5 ", 48(%%rdi)\n\t"
+        "movq " W6 ", 56(%%rdi)\n\t"
+        :
+        : "D" (t)
+        : "rax", "rbx", "rcx", "rdx", "rsi", "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15", "cc", "memory");
+
+    for (i = 0; i < NWORDS_FIELD; i++) {
+        mc[i] = t[i];
+    }
+}
+
+
+int fp_x64_mulx_supported(void)
+{ // Returns 1 if the CPU supports MULX (BMI2) and ADCX/ADOX (ADX).
+    unsigned int eax, ebx, ecx, edx;
+
+    if (__get_cpuid_max(0, NULL) < 7) {
+        return 0;
+    }
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+
+    return (ebx & bit_BMI2) && (ebx & bit_ADX);
+}
+
+
+typedef void (*mul503_t)(const digit_t* a, const digit_t* b, digit_t* c);
+typedef void (*rdc503_t)(const digit_t* ma, digit_t* mc);
+
+static mul503_t mul503_impl = NULL;
+static rdc503_t rdc503_impl = NULL;
+
+static void fp_x64_select(void)
+{ // Select the fastest implementations the CPU supports. Racing threads all store the same values.
+    mul503_t mul = mul503_x64;
+    rdc503_t rdc = rdc503_x64;
+
+    if (fp_x64_mulx_supported()) {
+        mul = mul503_asm;
+        rdc = rdc503_asm;
+    }
+
+    __atomic_store_n(&rdc503_impl, rdc, __ATOMIC_RELAXED);
+    __atomic_store_n(&mul503_impl, mul, __ATOMIC_RELAXED);
+}
+
+
+void mp_mul(const digit_t* a, const digit_t* b, digit_t* c, const unsigned int nwords)
+{ // Multiprecision multiply, c = a*b, where lng(a) = lng(b) = nwords.
+    if (nwords != NWORDS_FIELD) {
+        mp_mul_x64(a, b, c, nwords);
+        return;
+    }
+
+    mul503_t mul = __atomic_load_n(&mul503_impl, __ATOMIC_RELAXED);
+    if (mul == NULL) {
+        fp_x64_select();
+        mul = __atomic_load_n(&mul503_impl, __ATOMIC_RELAXED);
+    }
+    mul(a, b, c);
+}
+
+
+void rdc_mont(const digit_t* ma, digit_t* mc)
+{ // Montgomery reduction exploiting the special form of the prime p503.
+  // mc = ma*R^-1 mod p503x2, where R = 2^512.
+  // If ma < 2^512*p503, the output mc is in the range [0, 2*p503-1].
+  // ma is assumed to be in Montgomery representation.
+    rdc503_t rdc = __atomic_load_n(&rdc503_impl, __ATOMIC_RELAXED);
+    if (rdc == NULL) {
+        fp_x64_select();
+        rdc = __atomic_load_n(&rdc503_impl, __ATOMIC_RELAXED);
+    }
+    rdc(ma, mc);
+}
+
+#endif
@@ -0,0 +1,518 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+/* Define _GNU_SOURCE to get RTLD_NEXT definition from dlfcn.h */
+#define _GNU_SOURCE
+
+#include "s2n_benchmark.h"
+
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include <time.h>
+
+#include <openssl/opensslv.h>
+
+#include <s2n.h>
+
+#include "utils/s2n_random.h"
+#include "utils/s2n_safety.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define S2N_BENCH_HAVE_TSC 1
+#else
+#define S2N_BENCH_HAVE_TSC 0
+#endif
+
+#define NS_PER_MS 1000000ULL
+#define NS_PER_SEC 1000000000ULL
+
+/* Latencies are counted in buckets of 1/16th of a power of two, so percentiles are within 6.25% */
+#define S2N_BENCH_SUB_BUCKET_BITS 4
+#define S2N_BENCH_SUB_BUCKETS (1 << S2N_BENCH_SUB_BUCKET_BITS)
+#define S2N_BENCH_BUCKETS ((64 - S2N_BENCH_SUB_BUCKET_BITS + 1) * S2N_BENCH_SUB_BUCKETS)
+
+static FILE *output;
+static const char *name_filter;
+static uint64_t min_time_ns;
+static uint32_t threads = 1;
+static int results_written;
+static int failures;
+
+static uint64_t s2n_bench_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * NS_PER_SEC + now.tv_nsec;
+}
+
+/* The time stamp counter ticks at a constant rate, which is the nominal
+ * frequency on current CPUs rather than the actual core clock.
+ */
+static uint64_t s2n_bench_cycles(void)
+{
+#if S2N_BENCH_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/* Overriding the allocator works only if RTLD_NEXT is defined */
+#ifdef RTLD_NEXT
+#define S2N_BENCH_HAVE_ALLOCATIONS 1
+
+/* s2n_alloc allocates with realloc, or with posix_memalign when the memory is mlocked.
+ * Counting those two counts s2n's own allocations; libcrypto mostly uses malloc.
+ */
+static uint64_t allocations;
+
+typedef int (*posix_memalign_fn)(void **memptr, size_t alignment, size_t size);
+typedef void *(*realloc_fn)(void *ptr, size_t size);
+
+static posix_memalign_fn orig_posix_memalign;
+static realloc_fn orig_realloc;
+
+int posix_memalign(void **memptr, size_t alignment, size_t size)
+{
+    posix_memalign_fn fn = __atomic_load_n(&orig_posix_memalign, __ATOMIC_RELAXED);
+    if (fn == NULL) {
+        /* See tests/LD_PRELOAD/allocator_overrides.c for why the result is assigned this way.
+         * Racing threads all store the same value. */
+        *(void **) &fn = dlsym(RTLD_NEXT, "posix_memalign");
+        __atomic_store_n(&orig_posix_memalign, fn, __ATOMIC_RELAXED);
+    }
+
+    __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+    return fn(memptr, alignment, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    realloc_fn fn = __atomic_load_n(&orig_realloc, __ATOMIC_RELAXED);
+    if (fn == NULL) {
+        *(void **) &fn = dlsym(RTLD_NEXT, "realloc");
+        __atomic_store_n(&orig_realloc, fn, __ATOMIC_RELAXED);
+    }
+
+    __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+    return fn(ptr, size);
+}
+
+static uint64_t s2n_bench_allocations(void)
+{
+    return __atomic_load_n(&allocations, __ATOMIC_RELAXED);
+}
+#else
+#define S2N_BENCH_HAVE_ALLOCATIONS 0
+
+static uint64_t s2n_bench_allocations(void)
+{
+    return 0;
+}
+#endif
+
+static void s2n_bench_write_string(const char *str)
+{
+    fputc('"', output);
+    for (const char *c = str; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(output, "\\%c", *c);
+        } else if ((unsigned char) *c < 0x20) {
+            fprintf(output, "\\u%04x", (unsigned char) *c);
+        } else {
+            fputc(*c, output);
+        }
+    }
+    fputc('"', output);
+}
+
+static void s2n_bench_next_result(const char *name)
+{
+    fprintf(output, "%s\n    { \"name\": ", results_written ? "," : "");
+    s2n_bench_write_string(name);
+    results_written++;
+}
+
+static int s2n_bench_selected(const char *name)
+{
+    return name_filter == NULL || strstr(name, name_filter) != NULL;
+}
+
+int s2n_bench_begin(int argc, char **argv, const char *suite)
+{
+    output = stdout;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            notnull_check(output = fopen(argv[++i], "w"));
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            threads = strtoul(argv[++i], NULL, 10);
+            S2N_ERROR_IF(threads == 0, S2N_ERR_INVALID_ARGUMENT);
+        } else {
+            name_filter = argv[i];
+        }
+    }
+
+    const char *min_time_env = getenv("S2N_BENCH_MIN_TIME_MS");
+    uint64_t min_time_ms = min_time_env ? strtoull(min_time_env, NULL, 10) : 0;
+    min_time_ns = (min_time_ms ? min_time_ms : S2N_BENCH_DEFAULT_MIN_TIME_MS) * NS_PER_MS;
+
+    /* As in the unit tests, the default locked memory limit is too small for many connections */
+    GUARD(setenv("S2N_DONT_MLOCK", "1", 0));
+    GUARD(s2n_init());
+
+    fprintf(output, "{\n  \"suite\": ");
+    s2n_bench_write_string(suite);
+    fprintf(output, ",\n  \"libcrypto\": ");
+    s2n_bench_write_string(OPENSSL_VERSION_TEXT);
+    fprintf(output, ",\n  \"min_time_ms\": %llu", (unsigned long long) (min_time_ns / NS_PER_MS));
+    fprintf(output, ",\n  \"cycle_counter\": %s", S2N_BENCH_HAVE_TSC ? "\"tsc\"" : "null");
+    fprintf(output, ",\n  \"threads\": %u", threads);
+    fprintf(output, ",\n  \"results\": [");
+
+    return 0;
+}
+
+int s2n_bench_run(const char *name, uint32_t bytes_per_op, s2n_bench_op op, void *ctx)
+{
+    notnull_check(name);
+    notnull_check(op);
+
+    if (!s2n_bench_selected(name)) {
+        return 0;
+    }
+
+    /* The untimed first call warms up caches and any lazily initialized state */
+    int rc = op(ctx);
+
+    /* Grow the batch until a single batch runs for at least the minimum time */
+    uint64_t iterations = 1, elapsed_ns = 0, cycles = 0, allocs = 0;
+    while (rc == 0) {
+        uint64_t start_allocs = s2n_bench_allocations();
+        uint64_t start_ns = s2n_bench_now_ns();
+        uint64_t start_cycles = s2n_bench_cycles();
+        for (uint64_t i = 0; i < iterations && rc == 0; i++) {
+            rc = op(ctx);
+        }
+        cycles = s2n_bench_cycles() - start_cycles;
+        elapsed_ns = s2n_bench_now_ns() - start_ns;
+        allocs = s2n_bench_allocations() - start_allocs;
+
+        if (elapsed_ns >= min_time_ns) {
+            break;
+        }
+
+        /* Aim a little past the minimum, but grow by at most 100x per round */
+        uint64_t next = elapsed_ns ? iterations * min_time_ns / elapsed_ns * 6 / 5 : iterations * 100;
+        next = MIN(next, iterations * 100);
+        iterations = MAX(next, iterations + 1);
+    }
+
+    if (rc != 0) {
+        return s2n_bench_error(name);
+    }
+
+    s2n_bench_next_result(name);
+
+    double ns_per_op = (double) elapsed_ns / iterations;
+    double ops_per_sec = NS_PER_SEC / ns_per_op;
+
+    fprintf(output, ", \"bytes_per_op\": %u, \"iterations\": %llu, \"ns_per_op\": %.1f, \"ops_per_sec\": %.1f",
+            bytes_per_op, (unsigned long long) iterations, ns_per_op, ops_per_sec);
+    if (bytes_per_op) {
+        fprintf(output, ", \"mb_per_sec\": %.2f", ops_per_sec * bytes_per_op / 1e6);
+    }
+    if (S2N_BENCH_HAVE_ALLOCATIONS) {
+        fprintf(output, ", \"allocs_per_op\": %.2f", (double) allocs / iterations);
+    }
+    if (S2N_BENCH_HAVE_TSC) {
+        double cycles_per_op = (double) cycles / iterations;
+        fprintf(output, ", \"cycles_per_op\": %.1f", cycles_per_op);
+        if (bytes_per_op) {
+            fprintf(output, ", \"cycles_per_byte\": %.3f", cycles_per_op / bytes_per_op);
+        }
+    }
+    fprintf(output, " }");
+
+    fprintf(stderr, "%-60s %14.1f ops/sec\n", name, ops_per_sec);
+
+    return 0;
+}
+
+struct s2n_bench_concurrent {
+    void *arg;
+    s2n_bench_setup setup;
+    s2n_bench_op op;
+    s2n_bench_teardown teardown;
+
+    /* Threads wait for each other to finish setup, so every thread is measured over the same period */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t ready;
+    int started;
+    uint64_t deadline_ns;
+};
+
+struct s2n_bench_thread {
+    struct s2n_bench_concurrent *run;
+    pthread_t thread;
+    void *ctx;
+    int rc;
+    int error;
+
+    uint64_t ops;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t end_ns;
+    uint64_t histogram[S2N_BENCH_BUCKETS];
+};
+
+static uint32_t s2n_bench_bucket(uint64_t ns)
+{
+    if (ns < S2N_BENCH_SUB_BUCKETS) {
+        return ns;
+    }
+
+    uint32_t exponent = 63 - __builtin_clzll(ns);
+    uint32_t shift = exponent - S2N_BENCH_SUB_BUCKET_BITS;
+    return (shift + 1) * S2N_BENCH_SUB_BUCKETS + ((ns >> shift) & (S2N_BENCH_SUB_BUCKETS - 1));
+}
+
+/* The largest latency counted in a bucket */
+static uint64_t s2n_bench_bucket_limit(uint32_t bucket)
+{
+    if (bucket < S2N_BENCH_SUB_BUCKETS) {
+        return bucket;
+    }
+
+    uint32_t shift = bucket / S2N_BENCH_SUB_BUCKETS - 1;
+    uint64_t lowest = (uint64_t) (S2N_BENCH_SUB_BUCKETS + bucket % S2N_BENCH_SUB_BUCKETS) << shift;
+    return lowest + (1ULL << shift) - 1;
+}
+
+static void *s2n_bench_thread_main(void *arg)
+{
+    struct s2n_bench_thread *thread = arg;
+    struct s2n_bench_concurrent *run = thread->run;
+
+    thread->rc = run->setup(run->arg, &thread->ctx);
+
+    /* The untimed first call warms up caches and any lazily initialized state */
+    if (thread->rc == 0) {
+        thread->rc = run->op(thread->ctx);
+    }
+
+    pthread_mutex_lock(&run->lock);
+    run->ready++;
+    pthread_cond_broadcast(&run->cond);
+    while (!run->started) {
+        pthread_cond_wait(&run->cond, &run->lock);
+    }
+    uint64_t deadline_ns = run->deadline_ns;
+    pthread_mutex_unlock(&run->lock);
+
+    uint64_t now_ns = s2n_bench_now_ns();
+    while (thread->rc == 0 && now_ns < deadline_ns) {
+        uint64_t start_ns = now_ns;
+        thread->rc = run->op(thread->ctx);
+        now_ns = s2n_bench_now_ns();
+
+        uint64_t latency_ns = now_ns - start_ns;
+        thread->histogram[s2n_bench_bucket(latency_ns)]++;
+        thread->total_ns += latency_ns;
+        thread->max_ns = MAX(thread->max_ns, latency_ns);
+        thread->ops++;
+    }
+    thread->end_ns = now_ns;
+    thread->error = s2n_errno;
+
+    if (thread->ctx && run->teardown(thread->ctx) < 0 && thread->rc == 0) {
+        thread->rc = -1;
+        thread->error = s2n_errno;
+    }
+    s2n_rand_cleanup_thread();
+
+    return NULL;
+}
+
+static void s2n_bench_write_latencies(const uint64_t *histogram, uint64_t ops, uint64_t max_ns)
+{
+    static const struct {
+        const char *name;
+        double quantile;
+    } percentiles[] = { { "p50", 0.5 }, { "p90", 0.9 }, { "p99", 0.99 }, { "p999", 0.999 } };
+
+    fprintf(output, ", \"latency_ns\": {");
+    uint64_t seen = 0;
+    uint32_t bucket = 0;
+    for (uint32_t i = 0; i < s2n_array_len(percentiles); i++) {
+        /* Find the bucket holding the operation at this rank, counting from 0 */
+        uint64_t rank = percentiles[i].quantile * ops;
+        while (seen + histogram[bucket] <= rank) {
+            seen += histogram[bucket++];
+        }
+        uint64_t limit = MIN(s2n_bench_bucket_limit(bucket), max_ns);
+        fprintf(output, "%s\"%s\": %llu", i ? ", " : " ", percentiles[i].name, (unsigned long long) limit);
+    }
+    fprintf(output, ", \"max\": %llu }", (unsigned long long) max_ns);
+
+    /* Only the buckets that were hit, as [largest latency in the bucket, count] */
+    fprintf(output, ", \"histogram\": [");
+    int written = 0;
+    for (uint32_t i = 0; i < S2N_BENCH_BUCKETS; i++) {
+        if (histogram[i]) {
+            fprintf(output, "%s[%llu, %llu]", written++ ? ", " : "",
+                    (unsigned long long) s2n_bench_bucket_limit(i), (unsigned long long) histogram[i]);
+        }
+    }
+    fprintf(output, "]");
+}
+
+int s2n_bench_run_concurrent(const char *name, uint32_t bytes_per_op, void *arg,
+                             s2n_bench_setup setup, s2n_bench_op op, s2n_bench_teardown teardown)
+{
+    notnull_check(name);
+    notnull_check(setup);
+    notnull_check(op);
+    notnull_check(teardown);
+
+    if (!s2n_bench_selected(name)) {
+        return 0;
+    }
+
+    struct s2n_bench_concurrent run = { .arg = arg, .setup = setup, .op = op, .teardown = teardown };
+    GUARD(pthread_mutex_init(&run.lock, NULL));
+    GUARD(pthread_cond_init(&run.cond, NULL));
+
+    struct s2n_bench_thread *thread_state = calloc(threads, sizeof(struct s2n_bench_thread));
+    notnull_check(thread_state);
+
+    uint32_t started_threads = 0;
+    while (started_threads < threads) {
+        struct s2n_bench_thread *thread = &thread_state[started_threads];
+        thread->run = &run;
+        if (pthread_create(&thread->thread, NULL, s2n_bench_thread_main, thread)) {
+            break;
+        }
+        started_threads++;
+    }
+
+    pthread_mutex_lock(&run.lock);
+    while (run.ready < started_threads) {
+        pthread_cond_wait(&run.cond, &run.lock);
+    }
+    uint64_t start_allocs = s2n_bench_allocations();
+    uint64_t start_ns = s2n_bench_now_ns();
+    run.deadline_ns = start_ns + min_time_ns;
+    run.started = 1;
+    pthread_cond_broadcast(&run.cond);
+    pthread_mutex_unlock(&run.lock);
+
+    for (uint32_t i = 0; i < started_threads; i++) {
+        pthread_join(thread_state[i].thread, NULL);
+    }
+    /* This includes teardown, which frees rather than allocates */
+    uint64_t allocs = s2n_bench_allocations() - start_allocs;
+
+    pthread_cond_destroy(&run.cond);
+    pthread_mutex_destroy(&run.lock);
+
+    /* Merge the threads' results into the first one */
+    struct s2n_bench_thread *total = &thread_state[0];
+    int rc = started_threads == threads ? 0 : -1;
+    int error = S2N_ERR_ALLOC;
+    for (uint32_t i = 0; i < started_threads; i++) {
+        struct s2n_bench_thread *thread = &thread_state[i];
+        if (thread->rc != 0) {
+            rc = thread->rc;
+            error = thread->error;
+        }
+        if (thread == total) {
+            continue;
+        }
+        for (uint32_t bucket = 0; bucket < S2N_BENCH_BUCKETS; bucket++) {
+            total->histogram[bucket] += thread->histogram[bucket];
+        }
+        total->ops += thread->ops;
+        total->total_ns += thread->total_ns;
+        total->max_ns = MAX(total->max_ns, thread->max_ns);
+        total->end_ns = MAX(total->end_ns, thread->end_ns);
+    }
+
+    if (rc != 0 || total->ops == 0) {
+        free(thread_state);
+        s2n_errno = error;
+        return s2n_bench_error(name);
+    }
+
+    s2n_bench_next_result(name);
+
+    double ops_per_sec = (double) total->ops * NS_PER_SEC / (total->end_ns - start_ns);
+
+    fprintf(output, ", \"bytes_per_op\": %u, \"threads\": %u, \"iterations\": %llu, \"ns_per_op\": %.1f, \"ops_per_sec\": %.1f",
+            bytes_per_op, threads, (unsigned long long) total->ops, (double) total->total_ns / total->ops, ops_per_sec);
+    if (bytes_per_op) {
+        fprintf(output, ", \"mb_per_sec\": %.2f", ops_per_sec * bytes_per_op / 1e6);
+    }
+    if (S2N_BENCH_HAVE_ALLOCATIONS) {
+        fprintf(output, ", \"allocs_per_op\": %.2f", (double) allocs / total->ops);
+    }
+    s2n_bench_write_latencies(total->histogram, total->ops, total->max_ns);
+    fprintf(output, " }");
+
+    fprintf(stderr, "%-60s %14.1f ops/sec\n", name, ops_per_sec);
+
+    free(thread_state);
+
+    return 0;
+}
+
+int s2n_bench_error(const char *name)
+{
+    notnull_check(name);
+
+    if (!s2n_bench_selected(name)) {
+        return 0;
+    }
+
+    const char *error = s2n_strerror(s2n_errno, "EN");
+
+    s2n_bench_next_result(name);
+    fprintf(output, ", \"error\": ");
+    s2n_bench_write_string(error);
+    fprintf(output, " }");
+
+    fprintf(stderr, "%-60s FAILED: %s\n", name, error);
+    failures++;
+
+    return 0;
+}
+
+int s2n_bench_end(void)
+{
+    fprintf(output, "\n  ],\n  \"failures\": %d\n}\n", failures);
+    if (output != stdout) {
+        GUARD(fclose(output));
+    }
+    output = NULL;
+
+    GUARD(s2n_cleanup());
+
+    return failures;
+}
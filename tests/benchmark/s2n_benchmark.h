@@ -0,0 +1,54 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define S2N_BENCH_NAME_LEN 128
+
+/* How long each case runs for, unless S2N_BENCH_MIN_TIME_MS is set */
+#define S2N_BENCH_DEFAULT_MIN_TIME_MS 200
+
+/* One operation of a benchmark case. Returns 0 on success, or -1 with s2n_errno set. */
+typedef int (*s2n_bench_op)(void *ctx);
+
+/* Creates and frees the state each thread of a concurrent case works on. A setup that fails
+ * should either leave *ctx NULL or leave something teardown can free.
+ */
+typedef int (*s2n_bench_setup)(void *arg, void **ctx);
+typedef int (*s2n_bench_teardown)(void *ctx);
+
+/* Parses the command line ([-o output.json] [-t threads] [name filter]) and starts the JSON document */
+extern int s2n_bench_begin(int argc, char **argv, const char *suite);
+
+/* Times op(ctx) and writes one entry of the "results" array. A failing op is recorded
+ * as an error entry rather than stopping the suite, so the other cases still run.
+ * bytes_per_op is 0 for operations that don't process a buffer.
+ */
+extern int s2n_bench_run(const char *name, uint32_t bytes_per_op, s2n_bench_op op, void *ctx);
+
+/* Runs op on as many threads as -t asked for, each with its own ctx from setup, for the
+ * minimum time. Every operation is timed, so the entry also has latency percentiles and a
+ * histogram. ops_per_sec is the total across threads.
+ */
+extern int s2n_bench_run_concurrent(const char *name, uint32_t bytes_per_op, void *arg,
+                                    s2n_bench_setup setup, s2n_bench_op op, s2n_bench_teardown teardown);
+
+/* Records name as failed with the current s2n_errno, for cases whose setup failed */
+extern int s2n_bench_error(const char *name);
+
+/* Finishes the JSON document. Returns the number of cases that failed. */
+extern int s2n_bench_end(void);
@@ -0,0 +1,747 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <s2n.h>
+
+#include "testlib/s2n_testlib.h"
+
+#include "crypto/s2n_certificate.h"
+#include "crypto/s2n_cipher.h"
+#include "crypto/s2n_drbg.h"
+#include "crypto/s2n_ecc.h"
+#include "crypto/s2n_hash.h"
+#include "crypto/s2n_hmac.h"
+#include "crypto/s2n_pkey.h"
+
+#include "tls/s2n_cipher_preferences.h"
+#include "tls/s2n_cipher_suites.h"
+#include "tls/s2n_connection.h"
+#include "tls/s2n_kem.h"
+#include "tls/s2n_prf.h"
+#include "tls/s2n_record.h"
+#include "tls/s2n_tls_parameters.h"
+
+#include "utils/s2n_random.h"
+#include "utils/s2n_safety.h"
+
+static const uint32_t buffer_sizes[] = { 16, 1024, S2N_TLS_MAXIMUM_FRAGMENT_LENGTH };
+static const uint32_t record_sizes[] = { 1024, S2N_TLS_MAXIMUM_FRAGMENT_LENGTH };
+
+#define BUFFER_SIZES_COUNT (sizeof(buffer_sizes) / sizeof(buffer_sizes[0]))
+#define RECORD_SIZES_COUNT (sizeof(record_sizes) / sizeof(record_sizes[0]))
+
+static uint8_t plaintext[S2N_TLS_MAXIMUM_FRAGMENT_LENGTH];
+
+static const struct {
+    s2n_hash_algorithm alg;
+    const char *name;
+} hash_algs[] = {
+    { S2N_HASH_MD5, "md5" },
+    { S2N_HASH_SHA1, "sha1" },
+    { S2N_HASH_SHA224, "sha224" },
+    { S2N_HASH_SHA256, "sha256" },
+    { S2N_HASH_SHA384, "sha384" },
+    { S2N_HASH_SHA512, "sha512" },
+    { S2N_HASH_MD5_SHA1, "md5_sha1" },
+};
+
+static const struct {
+    s2n_hmac_algorithm alg;
+    const char *name;
+} hmac_algs[] = {
+    { S2N_HMAC_MD5, "md5" },
+    { S2N_HMAC_SHA1, "sha1" },
+    { S2N_HMAC_SHA224, "sha224" },
+    { S2N_HMAC_SHA256, "sha256" },
+    { S2N_HMAC_SHA384, "sha384" },
+    { S2N_HMAC_SHA512, "sha512" },
+    { S2N_HMAC_SSLv3_MD5, "sslv3_md5" },
+    { S2N_HMAC_SSLv3_SHA1, "sslv3_sha1" },
+};
+
+struct hash_bench {
+    struct s2n_hash_state state;
+    uint32_t size;
+    uint8_t digest_size;
+    uint8_t digest[S2N_MAX_DIGEST_LEN];
+};
+
+static int hash_op(void *ctx)
+{
+    struct hash_bench *bench = ctx;
+
+    GUARD(s2n_hash_reset(&bench->state));
+    GUARD(s2n_hash_update(&bench->state, plaintext, bench->size));
+    GUARD(s2n_hash_digest(&bench->state, bench->digest, bench->digest_size));
+
+    return 0;
+}
+
+static int bench_hash(void)
+{
+    char name[S2N_BENCH_NAME_LEN];
+    struct hash_bench bench;
+
+    for (int i = 0; i < sizeof(hash_algs) / sizeof(hash_algs[0]); i++) {
+        if (!s2n_hash_is_available(hash_algs[i].alg)) {
+            continue;
+        }
+
+        GUARD(s2n_hash_new(&bench.state));
+        GUARD(s2n_hash_init(&bench.state, hash_algs[i].alg));
+        GUARD(s2n_hash_digest_size(hash_algs[i].alg, &bench.digest_size));
+
+        for (int j = 0; j < BUFFER_SIZES_COUNT; j++) {
+            bench.size = buffer_sizes[j];
+            snprintf(name, sizeof(name), "hash/%s/%u", hash_algs[i].name, bench.size);
+            GUARD(s2n_bench_run(name, bench.size, hash_op, &bench));
+        }
+
+        GUARD(s2n_hash_free(&bench.state));
+    }
+
+    return 0;
+}
+
+struct hmac_bench {
+    struct s2n_hmac_state state;
+    uint32_t size;
+    uint8_t digest_size;
+    uint8_t digest[S2N_MAX_DIGEST_LEN];
+};
+
+static int hmac_op(void *ctx)
+{
+    struct hmac_bench *bench = ctx;
+
+    GUARD(s2n_hmac_reset(&bench->state));
+    GUARD(s2n_hmac_update(&bench->state, plaintext, bench->size));
+    GUARD(s2n_hmac_digest(&bench->state, bench->digest, bench->digest_size));
+
+    return 0;
+}
+
+/* The constant time variant used when verifying CBC records */
+static int hmac_two_rounds_op(void *ctx)
+{
+    struct hmac_bench *bench = ctx;
+
+    GUARD(s2n_hmac_reset(&bench->state));
+    GUARD(s2n_hmac_update(&bench->state, plaintext, bench->size));
+    GUARD(s2n_hmac_digest_two_compression_rounds(&bench->state, bench->digest, bench->digest_size));
+
+    return 0;
+}
+
+static int bench_hmac(void)
+{
+    char name[S2N_BENCH_NAME_LEN];
+    uint8_t key[SHA256_DIGEST_LENGTH] = { 0 };
+    struct hmac_bench bench;
+
+    for (int i = 0; i < sizeof(hmac_algs) / sizeof(hmac_algs[0]); i++) {
+        if (!s2n_hmac_is_available(hmac_algs[i].alg)) {
+            continue;
+        }
+
+        GUARD(s2n_hmac_new(&bench.state));
+        GUARD(s2n_hmac_init(&bench.state, hmac_algs[i].alg, key, sizeof(key)));
+        GUARD(s2n_hmac_digest_size(hmac_algs[i].alg, &bench.digest_size));
+
+        for (int j = 0; j < BUFFER_SIZES_COUNT; j++) {
+            bench.size = buffer_sizes[j];
+            snprintf(name, sizeof(name), "hmac/%s/%u", hmac_algs[i].name, bench.size);
+            GUARD(s2n_bench_run(name, bench.size, hmac_op, &bench));
+            snprintf(name, sizeof(name), "hmac/%s/%u/two_compression_rounds", hmac_algs[i].name, bench.size);
+            GUARD(s2n_bench_run(name, bench.size, hmac_two_rounds_op, &bench));
+        }
+
+        GUARD(s2n_hmac_free(&bench.state));
+    }
+
+    return 0;
+}
+
+/* A server connection seals records and a client connection with the same keys opens them */
+struct record_bench {
+    struct s2n_connection *server;
+    struct s2n_connection *client;
+    struct s2n_blob in;
+    struct s2n_stuffer record;
+    uint8_t sequence_number[S2N_TLS_SEQUENCE_NUM_LEN];
+};
+
+static int record_seal_op(void *ctx)
+{
+    struct record_bench *bench = ctx;
+
+    GUARD(s2n_stuffer_wipe(&bench->server->out));
+    GUARD(s2n_record_write(bench->server, TLS_APPLICATION_DATA, &bench->in));
+
+    return 0;
+}
+
+static int record_open_op(void *ctx)
+{
+    struct record_bench *bench = ctx;
+    struct s2n_connection *conn = bench->client;
+    uint8_t content_type;
+    uint16_t fragment_length;
+
+    /* Opening the same record again needs the sequence number it was sealed with */
+    memcpy_check(conn->secure.server_sequence_number, bench->sequence_number, S2N_TLS_SEQUENCE_NUM_LEN);
+
+    GUARD(s2n_stuffer_reread(&bench->record));
+    GUARD(s2n_stuffer_wipe(&conn->header_in));
+    GUARD(s2n_stuffer_wipe(&conn->in));
+    GUARD(s2n_stuffer_copy(&bench->record, &conn->header_in, S2N_TLS_RECORD_HEADER_LENGTH));
+    GUARD(s2n_stuffer_copy(&bench->record, &conn->in, s2n_stuffer_data_available(&bench->record)));
+
+    GUARD(s2n_record_header_parse(conn, &content_type, &fragment_length));
+    GUARD(s2n_record_parse(conn));
+
+    return 0;
+}
+
+static int record_connection_init(struct s2n_connection *conn, struct s2n_cipher_suite *suite)
+{
+    uint8_t master_secret[S2N_TLS_SECRET_LEN] = { 0 };
+
+    conn->actual_protocol_version = S2N_TLS12;
+    conn->max_outgoing_fragment_length = S2N_TLS_MAXIMUM_FRAGMENT_LENGTH;
+    conn->secure.cipher_suite = suite;
+    memcpy_check(conn->secure.master_secret, master_secret, sizeof(master_secret));
+    GUARD(s2n_prf_key_expansion(conn));
+    conn->client = &conn->secure;
+    conn->server = &conn->secure;
+
+    return 0;
+}
+
+static int bench_record_sizes(struct record_bench *bench, const char *prefix)
+{
+    char name[S2N_BENCH_NAME_LEN];
+
+    for (int i = 0; i < RECORD_SIZES_COUNT; i++) {
+        bench->in.data = plaintext;
+        bench->in.size = record_sizes[i];
+
+        /* Seal one record up front, both to open it below and to learn how much of the
+         * plaintext fits in a record once the MAC, padding and IV are accounted for.
+         */
+        memcpy_check(bench->sequence_number, bench->server->secure.server_sequence_number, S2N_TLS_SEQUENCE_NUM_LEN);
+        GUARD(s2n_stuffer_wipe(&bench->server->out));
+        int written = s2n_record_write(bench->server, TLS_APPLICATION_DATA, &bench->in);
+        GUARD(written);
+        GUARD(s2n_stuffer_wipe(&bench->record));
+        GUARD(s2n_stuffer_copy(&bench->server->out, &bench->record, s2n_stuffer_data_available(&bench->server->out)));
+        bench->in.size = written;
+
+        snprintf(name, sizeof(name), "%s/%u/seal", prefix, record_sizes[i]);
+        GUARD(s2n_bench_run(name, written, record_seal_op, bench));
+        snprintf(name, sizeof(name), "%s/%u/open", prefix, record_sizes[i]);
+        GUARD(s2n_bench_run(name, written, record_open_op, bench));
+    }
+
+    return 0;
+}
+
+static int bench_record_alg(struct s2n_cipher_suite *base, const struct s2n_record_algorithm *record_alg)
+{
+    char prefix[S2N_BENCH_NAME_LEN / 2];
+    struct record_bench bench = { 0 };
+    struct s2n_cipher_suite suite = *base;
+    suite.record_alg = record_alg;
+
+    snprintf(prefix, sizeof(prefix), "record/%s%s", base->name, record_alg->cipher->type == S2N_COMPOSITE ? "/composite" : "");
+
+    notnull_check(bench.server = s2n_connection_new(S2N_SERVER));
+    notnull_check(bench.client = s2n_connection_new(S2N_CLIENT));
+    GUARD(s2n_stuffer_growable_alloc(&bench.record, S2N_TLS_MAXIMUM_RECORD_LENGTH));
+
+    /* Some libcrypto builds advertise ciphers that then fail to initialize */
+    if (record_connection_init(bench.server, &suite) < 0 || record_connection_init(bench.client, &suite) < 0
+            || bench_record_sizes(&bench, prefix) < 0) {
+        GUARD(s2n_bench_error(prefix));
+    }
+
+    GUARD(s2n_stuffer_free(&bench.record));
+    GUARD(s2n_connection_free(bench.server));
+    GUARD(s2n_connection_free(bench.client));
+
+    return 0;
+}
+
+/* Every record algorithm any TLS 1.2 suite can use, named after the first suite using it */
+static int bench_record(void)
+{
+    const struct s2n_cipher_preferences *preferences = &cipher_preferences_test_all;
+    const struct s2n_record_algorithm *seen[S2N_CIPHER_SUITE_COUNT * S2N_MAX_POSSIBLE_RECORD_ALGS];
+    int seen_count = 0;
+
+    for (int i = 0; i < preferences->count; i++) {
+        struct s2n_cipher_suite *suite = preferences->suites[i];
+        if (suite->minimum_required_tls_version > S2N_TLS12) {
+            continue;
+        }
+
+        for (int j = 0; j < suite->num_record_algs; j++) {
+            const struct s2n_record_algorithm *record_alg = suite->all_record_algs[j];
+            int known = record_alg->cipher == &s2n_null_cipher || !record_alg->cipher->is_available();
+            for (int k = 0; k < seen_count && !known; k++) {
+                known = seen[k] == record_alg;
+            }
+            if (known) {
+                continue;
+            }
+            seen[seen_count++] = record_alg;
+
+            GUARD(bench_record_alg(suite, record_alg));
+        }
+    }
+
+    return 0;
+}
+
+struct drbg_bench {
+    struct s2n_drbg drbg;
+    struct s2n_blob out;
+};
+
+static int drbg_op(void *ctx)
+{
+    struct drbg_bench *bench = ctx;
+
+    GUARD(s2n_drbg_generate(&bench->drbg, &bench->out));
+
+    return 0;
+}
+
+static int bench_drbg(void)
+{
+    const struct {
+        s2n_drbg_mode mode;
+        const char *name;
+    } modes[] = {
+        { S2N_AES_128_CTR_NO_DF_PR, "aes128_ctr_no_df_pr" },
+        { S2N_AES_256_CTR_NO_DF_PR, "aes256_ctr_no_df_pr" },
+    };
+    const uint32_t sizes[] = { 32, 1024, S2N_DRBG_GENERATE_LIMIT };
+    char name[S2N_BENCH_NAME_LEN];
+    uint8_t personalization_data[] = "s2n benchmark";
+    struct s2n_blob personalization = { .data = personalization_data, .size = sizeof(personalization_data) };
+    uint8_t out[S2N_DRBG_GENERATE_LIMIT];
+    struct drbg_bench bench = { 0 };
+
+    for (int i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        GUARD(s2n_drbg_instantiate(&bench.drbg, &personalization, modes[i].mode));
+
+        for (int j = 0; j < sizeof(sizes) / sizeof(sizes[0]); j++) {
+            bench.out.data = out;
+            bench.out.size = sizes[j];
+            snprintf(name, sizeof(name), "drbg/%s/%u", modes[i].name, sizes[j]);
+            GUARD(s2n_bench_run(name, sizes[j], drbg_op, &bench));
+        }
+
+        GUARD(s2n_drbg_wipe(&bench.drbg));
+    }
+
+    return 0;
+}
+
+static int prf_key_expansion_op(void *ctx)
+{
+    GUARD(s2n_prf_key_expansion(ctx));
+
+    return 0;
+}
+
+static int bench_prf(void)
+{
+    const struct {
+        struct s2n_cipher_suite *suite;
+        uint8_t protocol_version;
+        const char *name;
+    } prfs[] = {
+        { &s2n_ecdhe_rsa_with_aes_128_cbc_sha, S2N_TLS10, "tls10" },
+        { &s2n_ecdhe_rsa_with_aes_128_gcm_sha256, S2N_TLS12, "tls12_sha256" },
+        { &s2n_ecdhe_rsa_with_aes_256_gcm_sha384, S2N_TLS12, "tls12_sha384" },
+    };
+    char name[S2N_BENCH_NAME_LEN];
+    struct s2n_connection *conn;
+
+    for (int i = 0; i < sizeof(prfs) / sizeof(prfs[0]); i++) {
+        if (!prfs[i].suite->available) {
+            continue;
+        }
+
+        notnull_check(conn = s2n_connection_new(S2N_SERVER));
+        conn->actual_protocol_version = prfs[i].protocol_version;
+        conn->secure.cipher_suite = prfs[i].suite;
+
+        snprintf(name, sizeof(name), "prf/key_expansion/%s/%s", prfs[i].name, prfs[i].suite->name);
+        GUARD(s2n_bench_run(name, 0, prf_key_expansion_op, conn));
+
+        GUARD(s2n_connection_free(conn));
+    }
+
+    return 0;
+}
+
+struct ecdhe_bench {
+    struct s2n_ecc_params server_params;
+    struct s2n_stuffer client_share;
+    struct s2n_blob shared_secret;
+};
+
+static int ecdhe_keygen_op(void *ctx)
+{
+    struct ecdhe_bench *bench = ctx;
+    struct s2n_ecc_params params = { .negotiated_curve = bench->server_params.negotiated_curve };
+
+    GUARD(s2n_ecc_generate_ephemeral_key(&params));
+    GUARD(s2n_ecc_params_free(&params));
+
+    return 0;
+}
+
+/* Generates the client key and computes the shared secret */
+static int ecdhe_client_op(void *ctx)
+{
+    struct ecdhe_bench *bench = ctx;
+
+    GUARD(s2n_stuffer_wipe(&bench->client_share));
+    GUARD(s2n_ecc_compute_shared_secret_as_client(&bench->server_params, &bench->client_share, &bench->shared_secret));
+    GUARD(s2n_free(&bench->shared_secret));
+
+    return 0;
+}
+
+/* Parses the client key and computes the shared secret */
+static int ecdhe_server_op(void *ctx)
+{
+    struct ecdhe_bench *bench = ctx;
+
+    GUARD(s2n_stuffer_reread(&bench->client_share));
+    GUARD(s2n_ecc_compute_shared_secret_as_server(&bench->server_params, &bench->client_share, &bench->shared_secret));
+    GUARD(s2n_free(&bench->shared_secret));
+
+    return 0;
+}
+
+static int bench_ecdhe(void)
+{
+    char name[S2N_BENCH_NAME_LEN];
+    struct ecdhe_bench bench = { { 0 } };
+
+    for (int i = 0; i < S2N_ECC_SUPPORTED_CURVES_COUNT; i++) {
+        const struct s2n_ecc_named_curve *curve = &s2n_ecc_supported_curves[i];
+
+        bench.server_params.negotiated_curve = curve;
+        GUARD(s2n_ecc_generate_ephemeral_key(&bench.server_params));
+        GUARD(s2n_stuffer_growable_alloc(&bench.client_share, 1024));
+        GUARD(ecdhe_client_op(&bench));
+
+        snprintf(name, sizeof(name), "ecdhe/%s/keygen", curve->name);
+        GUARD(s2n_bench_run(name, 0, ecdhe_keygen_op, &bench));
+        snprintf(name, sizeof(name), "ecdhe/%s/server_shared_secret", curve->name);
+        GUARD(s2n_bench_run(name, 0, ecdhe_server_op, &bench));
+        /* Last, as it overwrites the client share */
+        snprintf(name, sizeof(name), "ecdhe/%s/client_shared_secret", curve->name);
+        GUARD(s2n_bench_run(name, 0, ecdhe_client_op, &bench));
+
+        GUARD(s2n_stuffer_free(&bench.client_share));
+        GUARD(s2n_ecc_params_free(&bench.server_params));
+    }
+
+    return 0;
+}
+
+struct pkey_bench {
+    const struct s2n_pkey *private_key;
+    struct s2n_pkey public_key;
+    struct s2n_hash_state digest;
+    struct s2n_blob signature;
+    uint32_t signature_size;
+    struct s2n_blob encrypted;
+    struct s2n_blob decrypted;
+};
+
+static int pkey_sign_op(void *ctx)
+{
+    struct pkey_bench *bench = ctx;
+
+    GUARD(s2n_hash_reset(&bench->digest));
+    GUARD(s2n_hash_update(&bench->digest, plaintext, SHA256_DIGEST_LENGTH));
+    bench->signature.size = bench->signature_size;
+    GUARD(s2n_pkey_sign(bench->private_key, &bench->digest, &bench->signature));
+
+    return 0;
+}
+
+/* Verifies the signature left by the last pkey_sign_op */
+static int pkey_verify_op(void *ctx)
+{
+    struct pkey_bench *bench = ctx;
+
+    GUARD(s2n_hash_reset(&bench->digest));
+    GUARD(s2n_hash_update(&bench->digest, plaintext, SHA256_DIGEST_LENGTH));
+    GUARD(s2n_pkey_verify(&bench->public_key, &bench->digest, &bench->signature));
+
+    return 0;
+}
+
+/* Decrypts an RSA key exchange premaster secret */
+static int pkey_decrypt_op(void *ctx)
+{
+    struct pkey_bench *bench = ctx;
+
+    GUARD(s2n_pkey_decrypt(bench->private_key, &bench->encrypted, &bench->decrypted));
+
+    return 0;
+}
+
+static int bench_pkey(const char *key_name, const char *cert_chain_path, const char *private_key_path, s2n_hash_algorithm hash_alg)
+{
+    char name[S2N_BENCH_NAME_LEN];
+    char *cert_chain_pem, *private_key_pem;
+    struct s2n_cert_chain_and_key *chain_and_key;
+    s2n_cert_type cert_type;
+    struct pkey_bench bench = { 0 };
+
+    notnull_check(cert_chain_pem = malloc(S2N_MAX_TEST_PEM_SIZE));
+    notnull_check(private_key_pem = malloc(S2N_MAX_TEST_PEM_SIZE));
+    GUARD(s2n_read_test_pem(cert_chain_path, cert_chain_pem, S2N_MAX_TEST_PEM_SIZE));
+    GUARD(s2n_read_test_pem(private_key_path, private_key_pem, S2N_MAX_TEST_PEM_SIZE));
+    notnull_check(chain_and_key = s2n_cert_chain_and_key_new());
+    GUARD(s2n_cert_chain_and_key_load_pem(chain_and_key, cert_chain_pem, private_key_pem));
+
+    bench.private_key = chain_and_key->private_key;
+    GUARD(s2n_asn1der_to_public_key_and_type(&bench.public_key, &cert_type, &chain_and_key->cert_chain->head->raw));
+    GUARD(s2n_hash_new(&bench.digest));
+    GUARD(s2n_hash_init(&bench.digest, hash_alg));
+    GUARD(bench.signature_size = s2n_pkey_size(&bench.public_key));
+    GUARD(s2n_alloc(&bench.signature, bench.signature_size));
+
+    snprintf(name, sizeof(name), "pkey/%s/sign", key_name);
+    GUARD(s2n_bench_run(name, 0, pkey_sign_op, &bench));
+    snprintf(name, sizeof(name), "pkey/%s/verify", key_name);
+    GUARD(s2n_bench_run(name, 0, pkey_verify_op, &bench));
+
+    if (cert_type == S2N_CERT_TYPE_RSA_SIGN) {
+        uint8_t premaster_secret[S2N_TLS_SECRET_LEN] = { 0 };
+        struct s2n_blob premaster = { .data = premaster_secret, .size = sizeof(premaster_secret) };
+
+        GUARD(s2n_alloc(&bench.encrypted, bench.signature_size));
+        GUARD(s2n_alloc(&bench.decrypted, sizeof(premaster_secret)));
+        GUARD(s2n_pkey_encrypt(&bench.public_key, &premaster, &bench.encrypted));
+
+        snprintf(name, sizeof(name), "pkey/%s/decrypt", key_name);
+        GUARD(s2n_bench_run(name, 0, pkey_decrypt_op, &bench));
+
+        GUARD(s2n_free(&bench.encrypted));
+        GUARD(s2n_free(&bench.decrypted));
+    }
+
+    GUARD(s2n_free(&bench.signature));
+    GUARD(s2n_hash_free(&bench.digest));
+    GUARD(s2n_pkey_free(&bench.public_key));
+    GUARD(s2n_cert_chain_and_key_free(chain_and_key));
+    free(cert_chain_pem);
+    free(private_key_pem);
+
+    return 0;
+}
+
+struct kem_bench {
+    const struct s2n_kem *kem;
+    uint8_t *public_key;
+    uint8_t *private_key;
+    uint8_t *ciphertext;
+    uint8_t *shared_secret;
+};
+
+static int kem_keygen_op(void *ctx)
+{
+    struct kem_bench *bench = ctx;
+
+    GUARD(bench->kem->generate_keypair(bench->public_key, bench->private_key));
+
+    return 0;
+}
+
+static int kem_encapsulate_op(void *ctx)
+{
+    struct kem_bench *bench = ctx;
+
+    GUARD(bench->kem->encapsulate(bench->ciphertext, bench->shared_secret, bench->public_key));
+
+    return 0;
+}
+
+static int kem_decapsulate_op(void *ctx)
+{
+    struct kem_bench *bench = ctx;
+
+    GUARD(bench->kem->decapsulate(bench->shared_secret, bench->ciphertext, bench->private_key));
+
+    return 0;
+}
+
+static int bench_kem(void)
+{
+    const struct s2n_kem *kems[] = { &s2n_bike_1_level_1_r1, &s2n_sike_p503_r1 };
+    char name[S2N_BENCH_NAME_LEN];
+    struct kem_bench bench;
+
+    for (int i = 0; i < sizeof(kems) / sizeof(kems[0]); i++) {
+        bench.kem = kems[i];
+        notnull_check(bench.public_key = malloc(bench.kem->public_key_length));
+        notnull_check(bench.private_key = malloc(bench.kem->private_key_length));
+        notnull_check(bench.ciphertext = malloc(bench.kem->ciphertext_length));
+        notnull_check(bench.shared_secret = malloc(bench.kem->shared_secret_key_length));
+
+        snprintf(name, sizeof(name), "kem/%s/keygen", bench.kem->name);
+        GUARD(s2n_bench_run(name, 0, kem_keygen_op, &bench));
+        snprintf(name, sizeof(name), "kem/%s/encapsulate", bench.kem->name);
+        GUARD(s2n_bench_run(name, 0, kem_encapsulate_op, &bench));
+        snprintf(name, sizeof(name), "kem/%s/decapsulate", bench.kem->name);
+        GUARD(s2n_bench_run(name, 0, kem_decapsulate_op, &bench));
+
+        free(bench.public_key);
+        free(bench.private_key);
+        free(bench.ciphertext);
+        free(bench.shared_secret);
+    }
+
+    return 0;
+}
+
+struct cipher_select_bench {
+    struct s2n_connection *conn;
+    uint8_t *wire;
+    uint16_t count;
+};
+
+static int cipher_select_op(void *ctx)
+{
+    struct cipher_select_bench *bench = ctx;
+
+    GUARD(s2n_set_cipher_and_cert_as_tls_server(bench->conn, bench->wire, bench->count));
+
+    return 0;
+}
+
+/* Server cipher suite selection against a typical browser list and against
+ * a long list that is mostly GREASE and unknown values.
+ */
+static int bench_cipher_select(void)
+{
+    uint8_t browser_wire[] = {
+        TLS_AES_128_GCM_SHA256, TLS_AES_256_GCM_SHA384, TLS_CHACHA20_POLY1305_SHA256,
+        TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256, TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+        TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384, TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384,
+        TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256, TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256,
+        TLS_ECDHE_RSA_WITH_AES_128_CBC_SHA, TLS_ECDHE_RSA_WITH_AES_256_CBC_SHA,
+        TLS_RSA_WITH_AES_128_GCM_SHA256, TLS_RSA_WITH_AES_256_GCM_SHA384,
+        TLS_RSA_WITH_AES_128_CBC_SHA, TLS_RSA_WITH_AES_256_CBC_SHA, TLS_EMPTY_RENEGOTIATION_INFO_SCSV,
+    };
+    uint8_t long_wire[S2N_TLS_CIPHER_SUITE_LEN * 200];
+    const uint8_t shared_suite[] = { TLS_RSA_WITH_AES_128_GCM_SHA256 };
+    const uint8_t renegotiation_info_scsv[] = { TLS_EMPTY_RENEGOTIATION_INFO_SCSV };
+    char *cert_chain_pem, *private_key_pem;
+    struct s2n_cert_chain_and_key *chain_and_key;
+    struct s2n_config *config;
+    struct cipher_select_bench bench;
+
+    for (int i = 0; i < sizeof(long_wire) / S2N_TLS_CIPHER_SUITE_LEN; i++) {
+        /* GREASE values (RFC 8701) alternating with unassigned suites */
+        long_wire[i * 2] = (i % 2) ? 0x0A + (i % 16) * 0x10 : 0xEE;
+        long_wire[i * 2 + 1] = (i % 2) ? 0x0A + (i % 16) * 0x10 : i;
+    }
+    memcpy_check(long_wire + 2 * 20, renegotiation_info_scsv, S2N_TLS_CIPHER_SUITE_LEN);
+    memcpy_check(long_wire + 2 * 199, shared_suite, S2N_TLS_CIPHER_SUITE_LEN);
+
+    notnull_check(cert_chain_pem = malloc(S2N_MAX_TEST_PEM_SIZE));
+    notnull_check(private_key_pem = malloc(S2N_MAX_TEST_PEM_SIZE));
+    GUARD(s2n_read_test_pem(S2N_DEFAULT_TEST_CERT_CHAIN, cert_chain_pem, S2N_MAX_TEST_PEM_SIZE));
+    GUARD(s2n_read_test_pem(S2N_DEFAULT_TEST_PRIVATE_KEY, private_key_pem, S2N_MAX_TEST_PEM_SIZE));
+    notnull_check(chain_and_key = s2n_cert_chain_and_key_new());
+    GUARD(s2n_cert_chain_and_key_load_pem(chain_and_key, cert_chain_pem, private_key_pem));
+    notnull_check(config = s2n_config_new());
+    GUARD(s2n_config_add_cert_chain_and_key_to_store(config, chain_and_key));
+
+    notnull_check(bench.conn = s2n_connection_new(S2N_SERVER));
+    GUARD(s2n_connection_set_config(bench.conn, config));
+    GUARD(s2n_connection_set_cipher_preferences(bench.conn, "default"));
+    bench.conn->client_protocol_version = S2N_TLS12;
+    bench.conn->actual_protocol_version = S2N_TLS12;
+    bench.conn->secure.server_ecc_params.negotiated_curve = &s2n_ecc_supported_curves[0];
+
+    bench.wire = browser_wire;
+    bench.count = sizeof(browser_wire) / S2N_TLS_CIPHER_SUITE_LEN;
+    GUARD(s2n_bench_run("cipher_select/browser_list", 0, cipher_select_op, &bench));
+
+    bench.wire = long_wire;
+    bench.count = sizeof(long_wire) / S2N_TLS_CIPHER_SUITE_LEN;
+    GUARD(s2n_bench_run("cipher_select/200_unknown_suites", 0, cipher_select_op, &bench));
+
+    GUARD(s2n_connection_free(bench.conn));
+    GUARD(s2n_config_free(config));
+    GUARD(s2n_cert_chain_and_key_free(chain_and_key));
+    free(cert_chain_pem);
+    free(private_key_pem);
+
+    return 0;
+}
+
+/* The DRBG generates at most S2N_DRBG_GENERATE_LIMIT bytes per call */
+static int random_plaintext(void)
+{
+    for (uint32_t offset = 0; offset < sizeof(plaintext); offset += S2N_DRBG_GENERATE_LIMIT) {
+        uint32_t left = sizeof(plaintext) - offset;
+        struct s2n_blob data = { .data = plaintext + offset, .size = left < S2N_DRBG_GENERATE_LIMIT ? left : S2N_DRBG_GENERATE_LIMIT };
+        GUARD(s2n_get_public_random_data(&data));
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (s2n_bench_begin(argc, argv, "crypto") < 0
+            || random_plaintext() < 0
+            || bench_hash() < 0
+            || bench_hmac() < 0
+            || bench_record() < 0
+            || bench_drbg() < 0
+            || bench_prf() < 0
+            || bench_ecdhe() < 0
+            || bench_pkey("rsa_2048", S2N_RSA_2048_PKCS1_CERT_CHAIN, S2N_RSA_2048_PKCS1_KEY, S2N_HASH_SHA256) < 0
+            || bench_pkey("ecdsa_p384", S2N_ECDSA_P384_PKCS1_CERT_CHAIN, S2N_ECDSA_P384_PKCS1_KEY, S2N_HASH_SHA384) < 0
+            || bench_kem() < 0
+            || bench_cipher_select() < 0) {
+        fprintf(stderr, "Benchmark setup failed: %s\n", s2n_strerror(s2n_errno, "EN"));
+        return 1;
+    }
+
+    return s2n_bench_end() == 0 ? 0 : 1;
+}
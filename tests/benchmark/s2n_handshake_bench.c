@@ -0,0 +1,500 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_benchmark.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include <unistd.h>
+
+#include <s2n.h>
+
+#include "testlib/s2n_testlib.h"
+
+#include "crypto/s2n_certificate.h"
+#include "crypto/s2n_ecc.h"
+
+#include "tls/s2n_cipher_preferences.h"
+#include "tls/s2n_cipher_suites.h"
+#include "tls/s2n_client_hello.h"
+#include "tls/s2n_connection.h"
+#include "tls/s2n_resume.h"
+#include "tls/s2n_tls_parameters.h"
+
+#include "utils/s2n_safety.h"
+
+/* Bytes the client sends to the server in one throughput operation */
+#define TRANSFER_SIZE (256 * 1024)
+
+#define SESSION_STATE_MAX_LEN 512
+#define SESSION_ID_MAX_LEN 32
+
+typedef enum { FULL, RESUME_SESSION_ID, RESUME_SESSION_TICKET } handshake_type;
+
+static const char *handshake_type_names[] = {
+    [FULL] = "full",
+    [RESUME_SESSION_ID] = "session_id",
+    [RESUME_SESSION_TICKET] = "session_ticket",
+};
+
+/* The record size knobs applications have */
+static const struct {
+    const char *name;
+    int (*set)(struct s2n_connection *conn);
+} record_sizes[] = {
+    { "low_latency", s2n_connection_prefer_low_latency },
+    { "throughput", s2n_connection_prefer_throughput },
+};
+
+struct cert {
+    const char *name;
+    const char *cert_chain_path;
+    const char *private_key_path;
+    struct s2n_cert_chain_and_key *chain_and_key;
+};
+
+static struct cert certs[] = {
+    { "rsa_2048", S2N_RSA_2048_PKCS1_CERT_CHAIN, S2N_RSA_2048_PKCS1_KEY },
+    { "ecdsa_p384", S2N_ECDSA_P384_PKCS1_CERT_CHAIN, S2N_ECDSA_P384_PKCS1_KEY },
+};
+
+#define CERTS_COUNT (sizeof(certs) / sizeof(certs[0]))
+
+static char *dhparams_pem;
+
+/* One benchmark case. The configs are shared by all threads, as they would be in a server. */
+struct handshake_bench {
+    const char *version;
+    const struct cert *cert;
+    handshake_type type;
+    /* When set, the server negotiates this curve rather than its preferred one */
+    const struct s2n_ecc_named_curve *curve;
+    /* When set, the case measures application data transfer on an established connection */
+    int (*record_size)(struct s2n_connection *conn);
+
+    struct s2n_config *server_config;
+    struct s2n_config *client_config;
+};
+
+/* A client and a server connection talking over a pair of pipes, owned by one thread */
+struct connection_pair {
+    const struct handshake_bench *bench;
+    int server_to_client[2];
+    int client_to_server[2];
+    struct s2n_connection *server_conn;
+    struct s2n_connection *client_conn;
+
+    /* The client's session, and the server's session cache with room for that one session */
+    uint8_t session[SESSION_STATE_MAX_LEN];
+    int session_len;
+    uint8_t cache_key[SESSION_ID_MAX_LEN];
+    uint64_t cache_key_len;
+    uint8_t cache_value[SESSION_STATE_MAX_LEN];
+    uint64_t cache_value_len;
+
+    uint8_t *send_buffer;
+    uint8_t *recv_buffer;
+};
+
+/* The cache callbacks find the session cache through the connection's context, which
+ * keeps threads from sharing a cache and evicting each other's sessions.
+ */
+static int cache_store(struct s2n_connection *conn, void *ctx, uint64_t ttl, const void *key, uint64_t key_size,
+                       const void *value, uint64_t value_size)
+{
+    struct connection_pair *pair = s2n_connection_get_ctx(conn);
+
+    if (key_size > sizeof(pair->cache_key) || value_size > sizeof(pair->cache_value)) {
+        return -1;
+    }
+
+    memcpy(pair->cache_key, key, key_size);
+    memcpy(pair->cache_value, value, value_size);
+    pair->cache_key_len = key_size;
+    pair->cache_value_len = value_size;
+
+    return 0;
+}
+
+static int cache_retrieve(struct s2n_connection *conn, void *ctx, const void *key, uint64_t key_size, void *value,
+                          uint64_t *value_size)
+{
+    struct connection_pair *pair = s2n_connection_get_ctx(conn);
+
+    if (key_size != pair->cache_key_len || memcmp(key, pair->cache_key, key_size) || *value_size < pair->cache_value_len) {
+        return -1;
+    }
+
+    memcpy(value, pair->cache_value, pair->cache_value_len);
+    *value_size = pair->cache_value_len;
+
+    return 0;
+}
+
+static int cache_delete(struct s2n_connection *conn, void *ctx, const void *key, uint64_t key_size)
+{
+    struct connection_pair *pair = s2n_connection_get_ctx(conn);
+
+    pair->cache_key_len = 0;
+    pair->cache_value_len = 0;
+
+    return 0;
+}
+
+/* The client offers every curve s2n supports and the server always picks its favourite.
+ * To measure another curve, cut the client's supported_groups down to that curve before
+ * the server reads it.
+ */
+static int offer_one_curve(struct s2n_connection *conn, void *ctx)
+{
+    const struct handshake_bench *bench = ctx;
+    int index = s2n_supported_extension_index(TLS_EXTENSION_SUPPORTED_GROUPS);
+    GUARD(index);
+
+    struct s2n_blob *supported_groups = &conn->client_hello.parsed_extensions[index];
+    struct s2n_stuffer rewrite = { 0 };
+    GUARD(s2n_stuffer_init(&rewrite, supported_groups));
+    GUARD(s2n_stuffer_write_uint16(&rewrite, 2));
+    GUARD(s2n_stuffer_write_uint16(&rewrite, bench->curve->iana_id));
+    supported_groups->size = s2n_stuffer_data_available(&rewrite);
+
+    return 0;
+}
+
+static int handshake_bench_init(struct handshake_bench *bench)
+{
+    uint8_t ticket_key_name[S2N_TICKET_KEY_NAME_LEN] = "bench";
+    uint8_t ticket_key[S2N_AES256_KEY_LEN] = { 0 };
+
+    notnull_check(bench->server_config = s2n_config_new());
+    GUARD(s2n_config_set_cipher_preferences(bench->server_config, bench->version));
+    GUARD(s2n_config_add_cert_chain_and_key_to_store(bench->server_config, bench->cert->chain_and_key));
+    GUARD(s2n_config_add_dhparams(bench->server_config, dhparams_pem));
+
+    notnull_check(bench->client_config = s2n_config_new());
+    GUARD(s2n_config_set_cipher_preferences(bench->client_config, bench->version));
+    GUARD(s2n_config_disable_x509_verification(bench->client_config));
+
+    switch (bench->type) {
+        case FULL:
+            break;
+        case RESUME_SESSION_ID:
+            GUARD(s2n_config_set_cache_store_callback(bench->server_config, cache_store, NULL));
+            GUARD(s2n_config_set_cache_retrieve_callback(bench->server_config, cache_retrieve, NULL));
+            GUARD(s2n_config_set_cache_delete_callback(bench->server_config, cache_delete, NULL));
+            break;
+        case RESUME_SESSION_TICKET:
+            GUARD(s2n_config_set_session_tickets_onoff(bench->server_config, 1));
+            GUARD(s2n_config_set_session_tickets_onoff(bench->client_config, 1));
+            GUARD(s2n_config_add_ticket_crypto_key(bench->server_config, ticket_key_name, strlen((char *) ticket_key_name),
+                                                   ticket_key, sizeof(ticket_key), 0));
+            break;
+    }
+
+    if (bench->curve) {
+        GUARD(s2n_config_set_client_hello_cb(bench->server_config, offer_one_curve, bench));
+    }
+
+    return 0;
+}
+
+static int handshake_bench_free(struct handshake_bench *bench)
+{
+    if (bench->server_config) {
+        GUARD(s2n_config_free(bench->server_config));
+    }
+    if (bench->client_config) {
+        GUARD(s2n_config_free(bench->client_config));
+    }
+
+    return 0;
+}
+
+/* Reuses both connections for a new handshake, as a server reuses connections with s2n_connection_wipe */
+static int connection_pair_negotiate(struct connection_pair *pair)
+{
+    GUARD(s2n_connection_wipe(pair->server_conn));
+    GUARD(s2n_connection_wipe(pair->client_conn));
+
+    GUARD(s2n_connection_set_read_fd(pair->server_conn, pair->client_to_server[0]));
+    GUARD(s2n_connection_set_write_fd(pair->server_conn, pair->server_to_client[1]));
+    GUARD(s2n_connection_set_read_fd(pair->client_conn, pair->server_to_client[0]));
+    GUARD(s2n_connection_set_write_fd(pair->client_conn, pair->client_to_server[1]));
+    GUARD(s2n_connection_set_ctx(pair->server_conn, pair));
+
+    /* A failed handshake shouldn't stall the benchmark for the blinding delay */
+    GUARD(s2n_connection_set_blinding(pair->server_conn, S2N_SELF_SERVICE_BLINDING));
+    GUARD(s2n_connection_set_blinding(pair->client_conn, S2N_SELF_SERVICE_BLINDING));
+
+    if (pair->session_len) {
+        GUARD(s2n_connection_set_session(pair->client_conn, pair->session, pair->session_len));
+    }
+
+    GUARD(s2n_negotiate_test_server_and_client(pair->server_conn, pair->client_conn));
+
+    return 0;
+}
+
+static int connection_pair_teardown(void *ctx)
+{
+    struct connection_pair *pair = ctx;
+
+    if (pair->server_conn) {
+        GUARD(s2n_connection_free(pair->server_conn));
+    }
+    if (pair->client_conn) {
+        GUARD(s2n_connection_free(pair->client_conn));
+    }
+    for (int i = 0; i < 2; i++) {
+        if (pair->server_to_client[i] >= 0) {
+            close(pair->server_to_client[i]);
+        }
+        if (pair->client_to_server[i] >= 0) {
+            close(pair->client_to_server[i]);
+        }
+    }
+    free(pair->send_buffer);
+    free(pair->recv_buffer);
+    free(pair);
+
+    return 0;
+}
+
+static int connection_pair_setup(void *arg, void **ctx)
+{
+    const struct handshake_bench *bench = arg;
+    struct connection_pair *pair;
+
+    notnull_check(pair = calloc(1, sizeof(struct connection_pair)));
+    pair->bench = bench;
+    for (int i = 0; i < 2; i++) {
+        pair->server_to_client[i] = -1;
+        pair->client_to_server[i] = -1;
+    }
+    *ctx = pair;
+
+    GUARD(pipe(pair->server_to_client));
+    GUARD(pipe(pair->client_to_server));
+    for (int i = 0; i < 2; i++) {
+        GUARD(fcntl(pair->server_to_client[i], F_SETFL, fcntl(pair->server_to_client[i], F_GETFL) | O_NONBLOCK));
+        GUARD(fcntl(pair->client_to_server[i], F_SETFL, fcntl(pair->client_to_server[i], F_GETFL) | O_NONBLOCK));
+    }
+
+    notnull_check(pair->server_conn = s2n_connection_new(S2N_SERVER));
+    notnull_check(pair->client_conn = s2n_connection_new(S2N_CLIENT));
+    GUARD(s2n_connection_set_config(pair->server_conn, bench->server_config));
+    GUARD(s2n_connection_set_config(pair->client_conn, bench->client_config));
+
+    GUARD(connection_pair_negotiate(pair));
+
+    if (bench->type != FULL) {
+        GUARD(pair->session_len = s2n_connection_get_session_length(pair->client_conn));
+        S2N_ERROR_IF(pair->session_len > sizeof(pair->session), S2N_ERR_SERIALIZED_SESSION_STATE_TOO_LONG);
+        GUARD(s2n_connection_get_session(pair->client_conn, pair->session, pair->session_len));
+
+        /* Make sure the cases named for resumption actually measure it */
+        GUARD(connection_pair_negotiate(pair));
+        S2N_ERROR_IF(!s2n_connection_is_session_resumed(pair->server_conn), S2N_ERR_INVALID_SERIALIZED_SESSION_STATE);
+    }
+
+    if (bench->record_size) {
+        GUARD(bench->record_size(pair->client_conn));
+        notnull_check(pair->send_buffer = calloc(1, TRANSFER_SIZE));
+        notnull_check(pair->recv_buffer = malloc(TRANSFER_SIZE));
+    }
+
+    return 0;
+}
+
+static int handshake_op(void *ctx)
+{
+    return connection_pair_negotiate(ctx);
+}
+
+/* Sends TRANSFER_SIZE bytes from the client, reading them on the server as they arrive */
+static int transfer_op(void *ctx)
+{
+    struct connection_pair *pair = ctx;
+    s2n_blocked_status blocked;
+    uint32_t sent = 0, received = 0;
+
+    while (received < TRANSFER_SIZE) {
+        if (sent < TRANSFER_SIZE) {
+            ssize_t n = s2n_send(pair->client_conn, pair->send_buffer + sent, TRANSFER_SIZE - sent, &blocked);
+            if (n < 0 && s2n_error_get_type(s2n_errno) != S2N_ERR_T_BLOCKED) {
+                return -1;
+            }
+            sent += MAX(n, 0);
+        }
+
+        ssize_t n = s2n_recv(pair->server_conn, pair->recv_buffer, TRANSFER_SIZE - received, &blocked);
+        if (n < 0 && s2n_error_get_type(s2n_errno) != S2N_ERR_T_BLOCKED) {
+            return -1;
+        }
+        S2N_ERROR_IF(n == 0, S2N_ERR_CLOSED);
+        received += MAX(n, 0);
+    }
+
+    return 0;
+}
+
+static int run_bench(const char *name, struct handshake_bench *bench)
+{
+    if (handshake_bench_init(bench) < 0) {
+        GUARD(s2n_bench_error(name));
+    } else if (bench->record_size) {
+        GUARD(s2n_bench_run_concurrent(name, TRANSFER_SIZE, bench, connection_pair_setup, transfer_op, connection_pair_teardown));
+    } else {
+        GUARD(s2n_bench_run_concurrent(name, 0, bench, connection_pair_setup, handshake_op, connection_pair_teardown));
+    }
+
+    GUARD(handshake_bench_free(bench));
+
+    return 0;
+}
+
+/* Whether a TLS 1.2 handshake with the preferences can use the certificate */
+static int cert_usable(const struct s2n_cipher_preferences *preferences, const struct cert *cert)
+{
+    s2n_authentication_method auth_method = s2n_cert_chain_and_key_get_auth_method(cert->chain_and_key);
+
+    for (int i = 0; i < preferences->count; i++) {
+        struct s2n_cipher_suite *suite = preferences->suites[i];
+        if (suite->available && suite->auth_method == auth_method && suite->minimum_required_tls_version <= S2N_TLS12) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static int bench_handshakes(void)
+{
+    char name[S2N_BENCH_NAME_LEN];
+    const char *version;
+
+    for (int i = 0; (version = s2n_cipher_preferences_version_at(i)) != NULL; i++) {
+        const struct s2n_cipher_preferences *preferences;
+        GUARD(s2n_find_cipher_pref_from_version(version, &preferences));
+
+        for (int j = 0; j < CERTS_COUNT; j++) {
+            if (!cert_usable(preferences, &certs[j])) {
+                continue;
+            }
+
+            for (handshake_type type = FULL; type <= RESUME_SESSION_TICKET; type++) {
+                struct handshake_bench bench = { .version = version, .cert = &certs[j], .type = type };
+                snprintf(name, sizeof(name), "handshake/%s/%s/%s", version, certs[j].name, handshake_type_names[type]);
+                GUARD(run_bench(name, &bench));
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int bench_curves(void)
+{
+    char name[S2N_BENCH_NAME_LEN];
+
+    for (int i = 0; i < S2N_ECC_SUPPORTED_CURVES_COUNT; i++) {
+        const struct s2n_ecc_named_curve *curve = &s2n_ecc_supported_curves[i];
+        struct handshake_bench bench = { .version = "default", .cert = &certs[0], .type = FULL, .curve = curve };
+        snprintf(name, sizeof(name), "handshake/curve/%s/%s/full", curve->name, certs[0].name);
+        GUARD(run_bench(name, &bench));
+    }
+
+    return 0;
+}
+
+static int bench_throughput(void)
+{
+    char name[S2N_BENCH_NAME_LEN];
+    const char *version;
+
+    for (int i = 0; (version = s2n_cipher_preferences_version_at(i)) != NULL; i++) {
+        const struct s2n_cipher_preferences *preferences;
+        GUARD(s2n_find_cipher_pref_from_version(version, &preferences));
+
+        /* The negotiated cipher is what matters here, so use the first certificate that works */
+        const struct cert *cert = NULL;
+        for (int j = 0; j < CERTS_COUNT && cert == NULL; j++) {
+            if (cert_usable(preferences, &certs[j])) {
+                cert = &certs[j];
+            }
+        }
+        if (cert == NULL) {
+            continue;
+        }
+
+        for (int j = 0; j < s2n_array_len(record_sizes); j++) {
+            struct handshake_bench bench = { .version = version, .cert = cert, .type = FULL, .record_size = record_sizes[j].set };
+            snprintf(name, sizeof(name), "throughput/%s/%s", version, record_sizes[j].name);
+            GUARD(run_bench(name, &bench));
+        }
+    }
+
+    return 0;
+}
+
+static int load_certs(void)
+{
+    char *cert_chain_pem, *private_key_pem;
+
+    notnull_check(cert_chain_pem = malloc(S2N_MAX_TEST_PEM_SIZE));
+    notnull_check(private_key_pem = malloc(S2N_MAX_TEST_PEM_SIZE));
+    notnull_check(dhparams_pem = malloc(S2N_MAX_TEST_PEM_SIZE));
+
+    for (int i = 0; i < CERTS_COUNT; i++) {
+        GUARD(s2n_read_test_pem(certs[i].cert_chain_path, cert_chain_pem, S2N_MAX_TEST_PEM_SIZE));
+        GUARD(s2n_read_test_pem(certs[i].private_key_path, private_key_pem, S2N_MAX_TEST_PEM_SIZE));
+        notnull_check(certs[i].chain_and_key = s2n_cert_chain_and_key_new());
+        GUARD(s2n_cert_chain_and_key_load_pem(certs[i].chain_and_key, cert_chain_pem, private_key_pem));
+    }
+    GUARD(s2n_read_test_pem(S2N_DEFAULT_TEST_DHPARAMS, dhparams_pem, S2N_MAX_TEST_PEM_SIZE));
+
+    free(cert_chain_pem);
+    free(private_key_pem);
+
+    return 0;
+}
+
+static int free_certs(void)
+{
+    for (int i = 0; i < CERTS_COUNT; i++) {
+        GUARD(s2n_cert_chain_and_key_free(certs[i].chain_and_key));
+    }
+    free(dhparams_pem);
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (s2n_bench_begin(argc, argv, "handshake") < 0
+            || load_certs() < 0
+            || bench_handshakes() < 0
+            || bench_curves() < 0
+            || bench_throughput() < 0
+            || free_certs() < 0) {
+        fprintf(stderr, "Benchmark setup failed: %s\n", s2n_strerror(s2n_errno, "EN"));
+        return 1;
+    }
+
+    return s2n_bench_end() == 0 ? 0 : 1;
+}
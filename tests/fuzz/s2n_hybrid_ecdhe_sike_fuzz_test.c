@@ -25,6 +25,7 @@
 #include "tls/s2n_kex.h"
 #include "tls/s2n_kem.h"
 #include "tls/s2n_tls.h"
+#include "tls/s2n_tls_parameters.h"
 #include "utils/s2n_random.h"
 #include "utils/s2n_safety.h"
 #include "utils/s2n_safety.h"
@@ -40,7 +41,12 @@ static struct s2n_kem_keypair server_kem_keys = {.negotiated_kem = &s2n_sike_p50
 static int setup_connection(struct s2n_connection *server_conn)
 {
     server_conn->actual_protocol_version = S2N_TLS12;
-    server_conn->secure.server_ecc_params.negotiated_curve = &s2n_ecc_supported_curves[0];
+    /* The fuzz corpus was generated with secp256r1 */
+    for (int i = 0; i < S2N_ECC_SUPPORTED_CURVES_COUNT; i++) {
+        if (s2n_ecc_supported_curves[i].iana_id == TLS_EC_CURVE_SECP_256_R1) {
+            server_conn->secure.server_ecc_params.negotiated_curve = &s2n_ecc_supported_curves[i];
+        }
+    }
     server_conn->secure.s2n_kem_keys.negotiated_kem = &s2n_sike_p503_r1;
     server_conn->secure.cipher_suite = &s2n_ecdhe_sike_rsa_with_aes_256_gcm_sha384;
     server_conn->secure.conn_hash_alg = S2N_HASH_SHA384;
@@ -13,8 +13,29 @@
  * permissions and limitations under the License.
  */
 
+#include <string.h>
+
 #include "testlib/s2n_testlib.h"
 
+#include "error/s2n_errno.h"
+#include "utils/s2n_safety.h"
+
+int s2n_new_test_server_and_client(struct s2n_connection **server_conn, struct s2n_connection **client_conn,
+        struct s2n_config *server_config, struct s2n_config *client_config, int server_to_client[2], int client_to_server[2])
+{
+    notnull_check(*server_conn = s2n_connection_new(S2N_SERVER));
+    GUARD(s2n_connection_set_config(*server_conn, server_config));
+    GUARD(s2n_connection_set_read_fd(*server_conn, client_to_server[0]));
+    GUARD(s2n_connection_set_write_fd(*server_conn, server_to_client[1]));
+
+    notnull_check(*client_conn = s2n_connection_new(S2N_CLIENT));
+    GUARD(s2n_connection_set_config(*client_conn, client_config));
+    GUARD(s2n_connection_set_read_fd(*client_conn, server_to_client[0]));
+    GUARD(s2n_connection_set_write_fd(*client_conn, client_to_server[1]));
+
+    return 0;
+}
+
 int s2n_negotiate_test_server_and_client(struct s2n_connection *server_conn, struct s2n_connection *client_conn)
 {
     int server_rc = -1;
@@ -23,11 +44,16 @@ int s2n_negotiate_test_server_and_client(struct s2n_connection *server_conn, str
     s2n_blocked_status client_blocked;
     int server_done = 0;
     int client_done = 0;
+    /* The peer of the side that failed often reports being blocked after it, so keep the first error */
+    int error = S2N_ERR_OK;
 
     do {
         if (!server_done) {
             s2n_errno = S2N_ERR_T_OK;
             server_rc = s2n_negotiate(server_conn, &server_blocked);
+            if (server_rc < 0 && error == S2N_ERR_OK && s2n_error_get_type(s2n_errno) != S2N_ERR_T_BLOCKED) {
+                error = s2n_errno;
+            }
 
             if (s2n_error_get_type(s2n_errno) != S2N_ERR_T_BLOCKED || client_done) {
                 /* Success, fatal error, or the peer is done and we're still blocked. */
@@ -37,6 +63,9 @@ int s2n_negotiate_test_server_and_client(struct s2n_connection *server_conn, str
         if (!client_done) {
             s2n_errno = S2N_ERR_T_OK;
             client_rc = s2n_negotiate(client_conn, &client_blocked);
+            if (client_rc < 0 && error == S2N_ERR_OK && s2n_error_get_type(s2n_errno) != S2N_ERR_T_BLOCKED) {
+                error = s2n_errno;
+            }
 
             if (s2n_error_get_type(s2n_errno) != S2N_ERR_T_BLOCKED || server_done) {
                 /* Success, fatal error, or the peer is done and we're still blocked. */
@@ -46,6 +75,9 @@ int s2n_negotiate_test_server_and_client(struct s2n_connection *server_conn, str
     } while (!client_done || !server_done);
 
     int rc = (server_rc == 0 && client_rc == 0) ? 0 : -1;
+    if (rc < 0 && error != S2N_ERR_OK) {
+        s2n_errno = error;
+    }
     return rc;
 }
 
@@ -83,3 +115,25 @@ int s2n_shutdown_test_server_and_client(struct s2n_connection *server_conn, stru
     int rc = (server_rc == 0 && client_rc == 0) ? 0 : -1;
     return rc;
 }
+
+int s2n_send_and_recv_test_message(struct s2n_connection *sender, struct s2n_connection *receiver, const char *message)
+{
+    s2n_blocked_status blocked;
+    char buffer[256] = { 0 };
+    ssize_t len = strlen(message);
+    lte_check(len, sizeof(buffer));
+
+    eq_check(s2n_send(sender, message, len, &blocked), len);
+
+    /* TLS1.0 CBC splits writes into 1/n-1 records, so one recv may not return everything */
+    ssize_t received = 0;
+    while (received < len) {
+        ssize_t r = s2n_recv(receiver, buffer + received, sizeof(buffer) - received, &blocked);
+        gt_check(r, 0);
+        received += r;
+    }
+    eq_check(received, len);
+    eq_check(memcmp(buffer, message, len), 0);
+
+    return 0;
+}
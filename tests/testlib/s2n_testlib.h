@@ -100,7 +100,12 @@ void s2n_print_connection(struct s2n_connection *conn, const char *marker);
 /* Read a cert given a path into pem_out */
 int s2n_read_test_pem(const char *pem_path, char *pem_out, long int max_size);
 
+/* Create a server and a client connection talking over the given pipes, without negotiating */
+int s2n_new_test_server_and_client(struct s2n_connection **server_conn, struct s2n_connection **client_conn,
+        struct s2n_config *server_config, struct s2n_config *client_config, int server_to_client[2], int client_to_server[2]);
 int s2n_negotiate_test_server_and_client(struct s2n_connection *server_conn, struct s2n_connection *client_conn);
 int s2n_shutdown_test_server_and_client(struct s2n_connection *server_conn, struct s2n_connection *client_conn);
+/* Send a short message from one connection and check that the other receives it */
+int s2n_send_and_recv_test_message(struct s2n_connection *sender, struct s2n_connection *receiver, const char *message);
 
 int s2n_test_kem_with_kat(const struct s2n_kem *kem, const char *kat_file);
@@ -43,6 +43,8 @@ int main(int argc, char **argv)
     struct s2n_blob aes128 = {.data = aes128_key,.size = sizeof(aes128_key) };
     struct s2n_blob aes256 = {.data = aes256_key,.size = sizeof(aes256_key) };
     struct s2n_blob r = {.data = random_data, .size = sizeof(random_data)};
+    static uint8_t multiblock_data[8 * S2N_LARGE_FRAGMENT_LENGTH];
+    struct s2n_blob m = {.data = multiblock_data, .size = sizeof(multiblock_data)};
 
     BEGIN_TEST();
 
@@ -56,6 +58,7 @@ int main(int argc, char **argv)
 
     EXPECT_NOT_NULL(conn = s2n_connection_new(S2N_SERVER));
     EXPECT_SUCCESS(s2n_get_urandom_data(&r));
+    EXPECT_SUCCESS(s2n_get_urandom_data(&m));
 
     /* Peer and we are in sync */
     conn->server = &conn->initial;
@@ -64,6 +67,70 @@ int main(int argc, char **argv)
     int max_aligned_fragment = S2N_DEFAULT_FRAGMENT_LENGTH - (S2N_DEFAULT_FRAGMENT_LENGTH % 16);
     uint8_t proto_versions[3] = { S2N_TLS10, S2N_TLS11, S2N_TLS12 };
 
+    /* Multi-block encryption writes 4 or 8 full records that decrypt one at a time */
+    {
+        const struct s2n_record_algorithm *record_algs[] = { &s2n_record_alg_aes128_sha_composite, &s2n_record_alg_aes256_sha_composite,
+                                                             &s2n_record_alg_aes128_sha256_composite, &s2n_record_alg_aes256_sha256_composite };
+        struct s2n_blob *keys[] = { &aes128, &aes256, &aes128, &aes256 };
+        uint8_t *mac_keys[] = { mac_key_sha, mac_key_sha, mac_key_sha256, mac_key_sha256 };
+        uint8_t mac_key_sizes[] = { sizeof(mac_key_sha), sizeof(mac_key_sha), sizeof(mac_key_sha256), sizeof(mac_key_sha256) };
+        uint8_t records[] = { 4, 8 };
+
+        for (int k = 0; k < 4; k++) {
+            conn->initial.cipher_suite->record_alg = record_algs[k];
+            for (int j = 1; j < 3; j++) {
+                for (int n = 0; n < 2; n++) {
+                    EXPECT_SUCCESS(s2n_connection_wipe(conn));
+                    EXPECT_SUCCESS(s2n_connection_prefer_throughput(conn));
+                    conn->actual_protocol_version = proto_versions[j];
+
+                    EXPECT_SUCCESS(conn->initial.cipher_suite->record_alg->cipher->set_encryption_key(&conn->initial.server_key, keys[k]));
+                    EXPECT_SUCCESS(conn->initial.cipher_suite->record_alg->cipher->set_decryption_key(&conn->initial.client_key, keys[k]));
+                    EXPECT_SUCCESS(conn->initial.cipher_suite->record_alg->cipher->io.comp.set_mac_write_key(&conn->initial.server_key, mac_keys[k], mac_key_sizes[k]));
+                    EXPECT_SUCCESS(conn->initial.cipher_suite->record_alg->cipher->io.comp.set_mac_write_key(&conn->initial.client_key, mac_keys[k], mac_key_sizes[k]));
+
+                    int payload_size = s2n_record_max_write_payload_size(conn);
+                    struct s2n_blob in = {.data = multiblock_data,.size = records[n] * payload_size };
+                    int bytes_written;
+                    EXPECT_SUCCESS(bytes_written = s2n_record_write_multiblock(conn, TLS_APPLICATION_DATA, &in, records[n]));
+
+                    /* Not every libcrypto build can interleave records */
+                    if (bytes_written == 0) {
+                        EXPECT_EQUAL(s2n_stuffer_data_available(&conn->out), 0);
+                        continue;
+                    }
+                    /* libcrypto may interleave fewer records than it was offered, but never fewer than four */
+                    EXPECT_EQUAL(bytes_written % payload_size, 0);
+                    int records_written = bytes_written / payload_size;
+                    EXPECT_TRUE(records_written == 4 || records_written == 8);
+                    EXPECT_TRUE(records_written <= records[n]);
+                    EXPECT_EQUAL(conn->initial.server_sequence_number[S2N_TLS_SEQUENCE_NUM_LEN - 1], records_written);
+
+                    for (int r = 0; r < records_written; r++) {
+                        uint8_t content_type;
+                        uint16_t fragment_length;
+                        EXPECT_SUCCESS(s2n_stuffer_wipe(&conn->header_in));
+                        EXPECT_SUCCESS(s2n_stuffer_wipe(&conn->in));
+                        EXPECT_SUCCESS(s2n_stuffer_copy(&conn->out, &conn->header_in, S2N_TLS_RECORD_HEADER_LENGTH));
+                        EXPECT_SUCCESS(s2n_record_header_parse(conn, &content_type, &fragment_length));
+                        EXPECT_EQUAL(content_type, TLS_APPLICATION_DATA);
+                        EXPECT_SUCCESS(s2n_stuffer_copy(&conn->out, &conn->in, fragment_length));
+                        EXPECT_SUCCESS(s2n_record_parse(conn));
+
+                        EXPECT_EQUAL(s2n_stuffer_data_available(&conn->in), payload_size);
+                        EXPECT_EQUAL(memcmp(s2n_stuffer_raw_read(&conn->in, payload_size), multiblock_data + r * payload_size, payload_size), 0);
+                    }
+                    EXPECT_EQUAL(s2n_stuffer_data_available(&conn->out), 0);
+                    EXPECT_EQUAL(conn->initial.client_sequence_number[S2N_TLS_SEQUENCE_NUM_LEN - 1], records_written);
+                }
+            }
+        }
+
+        EXPECT_SUCCESS(s2n_stuffer_wipe(&conn->header_in));
+        EXPECT_SUCCESS(s2n_stuffer_wipe(&conn->in));
+    }
+
+
     /* test the composite AES128_SHA1 cipher  */
     conn->initial.cipher_suite->record_alg = &s2n_record_alg_aes128_sha_composite;
 
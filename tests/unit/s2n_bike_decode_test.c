@@ -0,0 +1,155 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+
+#include <string.h>
+
+/* The BIKE sources define FAIL as a return code */
+#undef FAIL
+#include "pq-crypto/bike/decode_internal.h"
+
+#include "utils/s2n_random.h"
+#include "utils/s2n_safety.h"
+
+#define RANDOM_ROUNDS 10
+
+static syndrome_t s;
+static compressed_idx_dv_ar_t inv_h;
+static uint8_t upc1[N_BITS], upc2[N_BITS];
+static red_r_t row, col1, col2;
+static e_t e1, e2, black1, black2, gray1, gray2, pos_e;
+
+/* The DRBG generates at most S2N_DRBG_GENERATE_LIMIT bytes per call */
+static int random_bytes(void *data, uint32_t size)
+{
+    uint8_t *bytes = data;
+    while (size > 0) {
+        struct s2n_blob blob = { .data = bytes, .size = size < 4096 ? size : 4096 };
+        GUARD(s2n_get_public_random_data(&blob));
+        bytes += blob.size;
+        size -= blob.size;
+    }
+    return 0;
+}
+
+/* Random counters between 0 and FAKE_DV, like the real UPC */
+static int random_upc(uint8_t *upc)
+{
+    GUARD(random_bytes(upc, N_BITS));
+    for (int i = 0; i < N_BITS; i++) {
+        upc[i] %= (FAKE_DV + 1);
+    }
+    return 0;
+}
+
+static int random_inputs(void)
+{
+    GUARD(random_bytes(&s, sizeof(s)));
+    for (int i = 0; i < sizeof(s); i++) {
+        s.u.raw[i] &= 1;
+    }
+
+    GUARD(random_bytes(&inv_h, sizeof(inv_h)));
+    for (int k = 0; k < N0; k++) {
+        for (int j = 0; j < FAKE_DV; j++) {
+            inv_h[k].val[j].val %= (R_BITS + 1);
+            inv_h[k].val[j].used = (inv_h[k].val[j].used & 1) ? -1U : 0;
+        }
+    }
+
+    GUARD(random_bytes(&row, sizeof(row)));
+    GUARD(random_bytes(&e1, sizeof(e1)));
+    GUARD(random_bytes(&pos_e, sizeof(pos_e)));
+    e2 = e1;
+
+    return 0;
+}
+
+static int compare_kernels(const decode_kernels_t *kernels)
+{
+    const uint32_t thresholds[] = { 0, 1, 20, 36, FAKE_DV, 255, 256, 1000 };
+
+    for (int i = 0; i < RANDOM_ROUNDS; i++) {
+        GUARD(random_inputs());
+
+        decode_kernels_portable.compute_counter_of_unsat(upc1, s.u.raw, &inv_h[0], &inv_h[1]);
+        kernels->compute_counter_of_unsat(upc2, s.u.raw, &inv_h[0], &inv_h[1]);
+        S2N_ERROR_IF(memcmp(upc1, upc2, N_BITS), S2N_ERR_SAFETY);
+
+        decode_kernels_portable.transpose(&col1, &row);
+        kernels->transpose(&col2, &row);
+        S2N_ERROR_IF(memcmp(&col1, &col2, sizeof(col1)), S2N_ERR_SAFETY);
+
+        GUARD(random_upc(upc1));
+        for (int t = 0; t < sizeof(thresholds) / sizeof(thresholds[0]); t++) {
+            const uint32_t black_th = thresholds[t];
+            const uint32_t gray_th = thresholds[(t + i) % (sizeof(thresholds) / sizeof(thresholds[0]))];
+
+            decode_kernels_portable.find_error1(&e1, &black1, &gray1, upc1, black_th, gray_th);
+            kernels->find_error1(&e2, &black2, &gray2, upc1, black_th, gray_th);
+            S2N_ERROR_IF(memcmp(&e1, &e2, sizeof(e1)), S2N_ERR_SAFETY);
+            S2N_ERROR_IF(memcmp(&black1, &black2, sizeof(black1)), S2N_ERR_SAFETY);
+            S2N_ERROR_IF(memcmp(&gray1, &gray2, sizeof(gray1)), S2N_ERR_SAFETY);
+
+            decode_kernels_portable.find_error2(&e1, &pos_e, upc1, black_th);
+            kernels->find_error2(&e2, &pos_e, upc1, black_th);
+            S2N_ERROR_IF(memcmp(&e1, &e2, sizeof(e1)), S2N_ERR_SAFETY);
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    BEGIN_TEST();
+
+    /* The dispatcher picks one of the kernel sets */
+    const decode_kernels_t *selected = decode_kernels();
+    EXPECT_NOT_NULL(selected);
+    EXPECT_EQUAL(selected, decode_kernels());
+
+    /* The portable kernels transpose as col[i] = row[-i mod r] */
+    EXPECT_SUCCESS(random_inputs());
+    decode_kernels_portable.transpose(&col1, &row);
+    EXPECT_EQUAL(col1.raw[0], row.raw[0]);
+    EXPECT_EQUAL(col1.raw[1], row.raw[R_BITS - 1]);
+    EXPECT_EQUAL(col1.raw[R_BITS - 1], row.raw[1]);
+
+    /* A threshold above any counter flips nothing, a zero threshold flips everything */
+    EXPECT_SUCCESS(random_upc(upc1));
+    memset(&e1, 0, sizeof(e1));
+    decode_kernels_portable.find_error1(&e1, &black1, &gray1, upc1, FAKE_DV + 1, FAKE_DV + 1);
+    EXPECT_TRUE(iszero(e1.raw, sizeof(e1)));
+    EXPECT_TRUE(iszero(gray1.raw, sizeof(gray1)));
+    memset(&pos_e, 0xff, sizeof(pos_e));
+    decode_kernels_portable.find_error2(&e1, &pos_e, upc1, 0);
+    EXPECT_EQUAL(count_ones(e1.raw, sizeof(e1)), N_BITS);
+
+    /* Every vectorised implementation the CPU supports matches the portable one */
+#if DECODE_AVX2_AVAILABLE
+    if (decode_avx2_supported()) {
+        EXPECT_SUCCESS(compare_kernels(&decode_kernels_avx2));
+    }
+#endif
+#if DECODE_AVX512_AVAILABLE
+    if (decode_avx512_supported()) {
+        EXPECT_SUCCESS(compare_kernels(&decode_kernels_avx512));
+    }
+#endif
+
+    END_TEST();
+}
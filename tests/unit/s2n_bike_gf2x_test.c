@@ -0,0 +1,145 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+
+#include <string.h>
+
+#include "pq-crypto/bike/gf2x_internal.h"
+
+#include "utils/s2n_random.h"
+#include "utils/s2n_safety.h"
+
+#define RANDOM_ROUNDS 100
+
+/* Operands are padded to R_PADDED_QW qwords, products need twice that */
+static uint64_t a[R_PADDED_QW], b[R_PADDED_QW], one[R_PADDED_QW], x[R_PADDED_QW];
+static uint64_t res1[2 * R_PADDED_QW], res2[2 * R_PADDED_QW];
+
+static int random_r(uint64_t *r)
+{
+    struct s2n_blob blob = { .data = (uint8_t *) r, .size = R_SIZE };
+    memset(r, 0, R_PADDED_QW * sizeof(uint64_t));
+    GUARD(s2n_get_public_random_data(&blob));
+    r[R_QW - 1] &= LAST_R_QW_MASK;
+    return 0;
+}
+
+static gf2x_mul_base_t fastest_mul_base(void)
+{
+#if GF2X_PCLMUL_AVAILABLE
+    if (gf2x_pclmul_supported()) {
+        return gf2x_mul_base_pclmul;
+    }
+#endif
+    return gf2x_mul_base_portable;
+}
+
+/* Multiply two 64 bit values with a base multiplication */
+static void mul_1x1(gf2x_mul_base_t mul_base, uint64_t c[2], uint64_t a0, uint64_t b0)
+{
+    uint64_t a_base[GF2X_BASE_QW] = { a0 };
+    uint64_t b_base[GF2X_BASE_QW] = { b0 };
+    uint64_t c_base[2 * GF2X_BASE_QW];
+
+    mul_base(c_base, a_base, b_base);
+    c[0] = c_base[0];
+    c[1] = c_base[1];
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t c1[2 * GF2X_BASE_QW], c2[2 * GF2X_BASE_QW];
+    gf2x_mul_base_t mul_base = fastest_mul_base();
+
+    BEGIN_TEST();
+
+    /* 64x64 bit products with known results, for every base multiplication */
+    gf2x_mul_base_t bases[] = { gf2x_mul_base_portable, mul_base };
+    for (int i = 0; i < 2; i++) {
+        mul_1x1(bases[i], c1, 3, 3);
+        EXPECT_EQUAL(c1[0], 5);
+        EXPECT_EQUAL(c1[1], 0);
+        mul_1x1(bases[i], c1, 1ULL << 63, 1ULL << 63);
+        EXPECT_EQUAL(c1[0], 0);
+        EXPECT_EQUAL(c1[1], 1ULL << 62);
+        mul_1x1(bases[i], c1, UINT64_MAX, 1);
+        EXPECT_EQUAL(c1[0], UINT64_MAX);
+        EXPECT_EQUAL(c1[1], 0);
+        mul_1x1(bases[i], c1, UINT64_MAX, UINT64_MAX);
+        EXPECT_EQUAL(c1[0], 0x5555555555555555ULL);
+        EXPECT_EQUAL(c1[1], 0x5555555555555555ULL);
+    }
+
+#if GF2X_PCLMUL_AVAILABLE
+    /* The PCLMUL kernel agrees with the portable one */
+    if (gf2x_pclmul_supported()) {
+        for (int i = 0; i < RANDOM_ROUNDS; i++) {
+            uint64_t operands[2 * GF2X_BASE_QW];
+            struct s2n_blob blob = { .data = (uint8_t *) operands, .size = sizeof(operands) };
+            EXPECT_SUCCESS(s2n_get_public_random_data(&blob));
+
+            gf2x_mul_base_portable(c1, operands, operands + GF2X_BASE_QW);
+            gf2x_mul_base_pclmul(c2, operands, operands + GF2X_BASE_QW);
+            EXPECT_BYTEARRAY_EQUAL(c1, c2, sizeof(c1));
+        }
+
+        for (int i = 0; i < 10; i++) {
+            EXPECT_SUCCESS(random_r(a));
+            EXPECT_SUCCESS(random_r(b));
+            gf2x_mod_mul_with_base(res1, a, b, gf2x_mul_base_portable);
+            gf2x_mod_mul_with_base(res2, a, b, gf2x_mul_base_pclmul);
+            EXPECT_BYTEARRAY_EQUAL(res1, res2, R_SIZE);
+        }
+    }
+#endif
+
+    /* a * 1 = a */
+    one[0] = 1;
+    EXPECT_SUCCESS(random_r(a));
+    gf2x_mod_mul_with_base(res1, a, one, mul_base);
+    EXPECT_BYTEARRAY_EQUAL(res1, a, R_SIZE);
+
+    /* x^(r-1) * x = x^r = 1 mod (x^r - 1) */
+    memset(a, 0, sizeof(a));
+    memset(x, 0, sizeof(x));
+    a[(R_BITS - 1) / 64] = 1ULL << ((R_BITS - 1) % 64);
+    x[0] = 2;
+    gf2x_mod_mul_with_base(res1, a, x, mul_base);
+    EXPECT_BYTEARRAY_EQUAL(res1, one, R_SIZE);
+
+    /* Commutativity, and the padding beyond r bits is ignored */
+    EXPECT_SUCCESS(random_r(a));
+    EXPECT_SUCCESS(random_r(b));
+    gf2x_mod_mul_with_base(res1, a, b, mul_base);
+    memset((uint8_t *) a + R_SIZE, 0xff, sizeof(a) - R_SIZE);
+    gf2x_mod_mul_with_base(res2, b, a, mul_base);
+    EXPECT_BYTEARRAY_EQUAL(res1, res2, R_SIZE);
+    EXPECT_EQUAL(res1[R_QW - 1] & ~LAST_R_QW_MASK, 0);
+
+    /* Distributivity: a*(b + x) = a*b + a*x */
+    memset((uint8_t *) a + R_SIZE, 0, sizeof(a) - R_SIZE);
+    EXPECT_SUCCESS(random_r(x));
+    gf2x_mod_mul_with_base(res1, a, b, mul_base);
+    gf2x_mod_mul_with_base(res2, a, x, mul_base);
+    for (int i = 0; i < R_QW; i++) {
+        res1[i] ^= res2[i];
+        b[i] ^= x[i];
+    }
+    gf2x_mod_mul_with_base(res2, a, b, mul_base);
+    EXPECT_BYTEARRAY_EQUAL(res1, res2, R_SIZE);
+
+    END_TEST();
+}
@@ -148,6 +148,45 @@ int main(int argc, char **argv)
     /* Emulate TLS1.2 */
     conn->actual_protocol_version = S2N_TLS12;
 
+    /* Every padding length is accepted when the padding is right, and rejected when any one byte of it is wrong */
+    {
+        const s2n_hmac_algorithm hmac_algs[] = { S2N_HMAC_SHA1, S2N_HMAC_SHA256, S2N_HMAC_SHA384 };
+        const int payload_length = 100;
+        uint8_t record[100 + S2N_MAX_DIGEST_LEN + 256];
+
+        for (int a = 0; a < s2n_array_len(hmac_algs); a++) {
+            uint8_t mac_size;
+            EXPECT_SUCCESS(s2n_hmac_digest_size(hmac_algs[a], &mac_size));
+
+            for (int padding_length = 0; padding_length < 256; padding_length++) {
+                int size = payload_length + mac_size + padding_length + 1;
+                struct s2n_blob decrypted = { .data = record, .size = size };
+
+                memcpy(record, random_data, payload_length);
+                EXPECT_SUCCESS(s2n_hmac_init(&record_mac, hmac_algs[a], mac_key, sizeof(mac_key)));
+                EXPECT_SUCCESS(s2n_hmac_update(&record_mac, record, payload_length));
+                EXPECT_SUCCESS(s2n_hmac_digest(&record_mac, record + payload_length, mac_size));
+                memset(record + payload_length + mac_size, padding_length, padding_length + 1);
+
+                EXPECT_SUCCESS(s2n_hmac_init(&check_mac, hmac_algs[a], mac_key, sizeof(mac_key)));
+                EXPECT_SUCCESS(s2n_verify_cbc(conn, &check_mac, &decrypted));
+
+                for (int j = payload_length + mac_size; j < size - 1; j++) {
+                    record[j] ^= 0x01;
+                    EXPECT_SUCCESS(s2n_hmac_init(&check_mac, hmac_algs[a], mac_key, sizeof(mac_key)));
+                    EXPECT_FAILURE_WITH_ERRNO(s2n_verify_cbc(conn, &check_mac, &decrypted), S2N_ERR_CBC_VERIFY);
+                    record[j] ^= 0x01;
+                }
+            }
+
+            /* Padding that claims more bytes than the record has */
+            memset(record, 200, mac_size + 10);
+            struct s2n_blob decrypted = { .data = record, .size = mac_size + 10 };
+            EXPECT_SUCCESS(s2n_hmac_init(&check_mac, hmac_algs[a], mac_key, sizeof(mac_key)));
+            EXPECT_FAILURE_WITH_ERRNO(s2n_verify_cbc(conn, &check_mac, &decrypted), S2N_ERR_CBC_VERIFY);
+        }
+    }
+
     /* Try every 16 bytes to simulate block alignments */
     for (int i = 288; i < S2N_SMALL_FRAGMENT_LENGTH; i += 16) {
 
@@ -19,9 +19,11 @@
 
 #include <fcntl.h>
 #include <errno.h>
+#include <pthread.h>
 
 #include <s2n.h>
 
+#include "crypto/s2n_certificate.h"
 #include "crypto/s2n_fips.h"
 #include "utils/s2n_safety.h"
 
@@ -42,6 +44,11 @@ struct s2n_connection *create_conn(s2n_mode mode, struct s2n_config *config, int
     return conn;
 }
 
+static void *get_thread_private_key(void *chain_and_key)
+{
+    return s2n_cert_chain_and_key_get_private_key(chain_and_key);
+}
+
 static int num_times_cb_executed = 0;
 static struct s2n_cert_chain_and_key *test_cert_tiebreak_cb(struct s2n_cert_chain_and_key *cert1,
         struct s2n_cert_chain_and_key *cert2,
@@ -136,6 +143,72 @@ int main(int argc, char **argv)
         EXPECT_SUCCESS(s2n_config_free(server_config));
     }
 
+    /* Spread threads across copies of the private key */
+    {
+        struct s2n_cert_chain_and_key *chain_and_key;
+        const uint8_t copies = 4;
+        s2n_cert_private_key *thread_keys[5] = { NULL };
+
+        /* Copies can't be made before the key is loaded */
+        EXPECT_NOT_NULL(chain_and_key = s2n_cert_chain_and_key_new());
+        EXPECT_FAILURE(s2n_cert_chain_and_key_set_private_key_copies(chain_and_key, copies));
+        EXPECT_NULL(chain_and_key->private_key_copies);
+        EXPECT_EQUAL(chain_and_key->private_key_copies_count, 0);
+
+        /* Without copies every thread uses the original key */
+        EXPECT_SUCCESS(s2n_cert_chain_and_key_load_pem(chain_and_key, cert_chain, private_key));
+        EXPECT_EQUAL(s2n_cert_chain_and_key_get_private_key(chain_and_key), chain_and_key->private_key);
+
+        EXPECT_SUCCESS(s2n_cert_chain_and_key_set_private_key_copies(chain_and_key, copies));
+        EXPECT_NOT_NULL(chain_and_key->private_key_copies);
+        EXPECT_EQUAL(chain_and_key->private_key_copies_count, copies);
+
+        /* Every copy is a separate libcrypto object for the same key */
+        DEFER_CLEANUP(struct s2n_pkey public_key = {0}, s2n_pkey_free);
+        s2n_cert_type cert_type;
+        EXPECT_SUCCESS(s2n_asn1der_to_public_key_and_type(&public_key, &cert_type, &chain_and_key->cert_chain->head->raw));
+        for (int i = 0; i < copies; i++) {
+            EXPECT_NOT_EQUAL(chain_and_key->private_key_copies[i].key.rsa_key.rsa, chain_and_key->private_key->key.rsa_key.rsa);
+            EXPECT_SUCCESS(s2n_pkey_match(&public_key, &chain_and_key->private_key_copies[i]));
+        }
+
+        /* Consecutive threads are given different keys, and a thread keeps its key */
+        for (int i = 0; i < copies + 1; i++) {
+            pthread_t thread;
+            EXPECT_SUCCESS(pthread_create(&thread, NULL, get_thread_private_key, chain_and_key));
+            EXPECT_SUCCESS(pthread_join(thread, (void **) &thread_keys[i]));
+            EXPECT_NOT_NULL(thread_keys[i]);
+            for (int j = 0; j < i; j++) {
+                EXPECT_NOT_EQUAL(thread_keys[i], thread_keys[j]);
+            }
+        }
+        EXPECT_EQUAL(s2n_cert_chain_and_key_get_private_key(chain_and_key), s2n_cert_chain_and_key_get_private_key(chain_and_key));
+
+        /* Handshakes work with whichever key this thread is given */
+        EXPECT_NOT_NULL(server_config = s2n_config_new());
+        EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key_to_store(server_config, chain_and_key));
+
+        EXPECT_NOT_NULL(server_conn = create_conn(S2N_SERVER, server_config, server_to_client, client_to_server));
+        EXPECT_NOT_NULL(client_conn = create_conn(S2N_CLIENT, client_config, server_to_client, client_to_server));
+
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+        EXPECT_TRUE(IS_FULL_HANDSHAKE(server_conn->handshake.handshake_type));
+        EXPECT_SUCCESS(s2n_shutdown_test_server_and_client(server_conn, client_conn));
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+        EXPECT_SUCCESS(s2n_config_free(server_config));
+
+        /* Setting zero copies frees them */
+        EXPECT_SUCCESS(s2n_cert_chain_and_key_set_private_key_copies(chain_and_key, 0));
+        EXPECT_NULL(chain_and_key->private_key_copies);
+        EXPECT_EQUAL(chain_and_key->private_key_copies_count, 0);
+        EXPECT_EQUAL(s2n_cert_chain_and_key_get_private_key(chain_and_key), chain_and_key->private_key);
+
+        EXPECT_SUCCESS(s2n_cert_chain_and_key_set_private_key_copies(chain_and_key, 2));
+        EXPECT_SUCCESS(s2n_cert_chain_and_key_free(chain_and_key));
+    }
+
     /* Create config with deprecated s2n_config_add_cert_chain_and_key API */
     {
         EXPECT_NOT_NULL(server_config = s2n_config_new());
@@ -55,6 +55,33 @@ int main(int argc, char **argv)
         EXPECT_FALSE(s2n_pq_kem_extension_required(preferences));
     }
 
+    /* Test that every listed version can be found */
+    {
+        int count = 0;
+        const char *version = NULL;
+        while ((version = s2n_cipher_preferences_version_at(count)) != NULL) {
+            preferences = NULL;
+            EXPECT_SUCCESS(s2n_find_cipher_pref_from_version(version, &preferences));
+            EXPECT_NOT_NULL(preferences);
+            count++;
+        }
+
+        EXPECT_STRING_EQUAL(s2n_cipher_preferences_version_at(0), "default");
+        EXPECT_TRUE(count > 1);
+        EXPECT_NULL(s2n_cipher_preferences_version_at(-1));
+    }
+
+    /* Test that every group of equally preferred suites ends within its policy */
+    {
+        const char *version = NULL;
+        for (int i = 0; (version = s2n_cipher_preferences_version_at(i)) != NULL; i++) {
+            EXPECT_SUCCESS(s2n_find_cipher_pref_from_version(version, &preferences));
+            if (preferences->in_group_flags) {
+                EXPECT_EQUAL(preferences->in_group_flags[preferences->count - 1], 0);
+            }
+        }
+    }
+
     /* Test that null fails */
     {
         preferences = NULL;
@@ -52,6 +52,14 @@ int main(int argc, char **argv)
 
         EXPECT_EQUAL(count, S2N_CIPHER_SUITE_COUNT);
 
+        /* Every suite knows its position in the table, which is in order of IANA value */
+        for (int i = 0; i < cipher_preferences_test_all.count; i++) {
+            struct s2n_cipher_suite *suite = cipher_preferences_test_all.suites[i];
+            EXPECT_EQUAL(suite->index, i);
+            EXPECT_EQUAL(s2n_cipher_suite_from_wire(suite->iana_value), suite);
+            EXPECT_EQUAL(suite->sslv3_cipher_suite->index, i);
+        }
+
         EXPECT_SUCCESS(s2n_connection_free(conn));
         free(private_key);
         free(cert_chain);
@@ -263,6 +271,56 @@ int main(int argc, char **argv)
             EXPECT_SUCCESS(s2n_connection_wipe(conn));
         }
 
+        /* Test that the client's order wins within a group of equally preferred suites */
+        {
+            uint8_t chacha_first[] = {
+                TLS_ECDHE_RSA_WITH_AES_128_CBC_SHA,
+                TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256,
+                TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+                TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384,
+            };
+            uint8_t aes_first[] = {
+                TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384,
+                TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256,
+                TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+            };
+            const uint8_t expected_chacha_wire_choice[] = { TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256 };
+            const uint8_t expected_aes128_wire_choice[] = { TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256 };
+            const uint8_t expected_aes256_wire_choice[] = { TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384 };
+            struct s2n_cipher_suite *expected_chacha = s2n_cipher_suite_from_wire(expected_chacha_wire_choice);
+            if (!expected_chacha->available) {
+                /* Without a ChaCha20 implementation the next suite in the client's order is chosen */
+                expected_chacha = s2n_cipher_suite_from_wire(expected_aes128_wire_choice);
+            }
+
+            /* The CBC suite the client prefers is in a less preferred group */
+            EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(conn, "20191016"));
+            conn->secure.server_ecc_params.negotiated_curve = &s2n_ecc_supported_curves[0];
+            EXPECT_SUCCESS(s2n_set_cipher_and_cert_as_tls_server(conn, chacha_first, sizeof(chacha_first) / S2N_TLS_CIPHER_SUITE_LEN));
+            EXPECT_EQUAL(conn->secure.cipher_suite, expected_chacha);
+            EXPECT_SUCCESS(s2n_connection_wipe(conn));
+
+            EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(conn, "20191016"));
+            conn->secure.server_ecc_params.negotiated_curve = &s2n_ecc_supported_curves[0];
+            EXPECT_SUCCESS(s2n_set_cipher_and_cert_as_tls_server(conn, aes_first, sizeof(aes_first) / S2N_TLS_CIPHER_SUITE_LEN));
+            EXPECT_EQUAL(conn->secure.cipher_suite, s2n_cipher_suite_from_wire(expected_aes256_wire_choice));
+            EXPECT_SUCCESS(s2n_connection_wipe(conn));
+
+            /* The same suites without groups are chosen in server order */
+            EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(conn, "20170210"));
+            conn->secure.server_ecc_params.negotiated_curve = &s2n_ecc_supported_curves[0];
+            EXPECT_SUCCESS(s2n_set_cipher_and_cert_as_tls_server(conn, chacha_first, sizeof(chacha_first) / S2N_TLS_CIPHER_SUITE_LEN));
+            EXPECT_EQUAL(conn->secure.cipher_suite, s2n_cipher_suite_from_wire(expected_aes128_wire_choice));
+            EXPECT_SUCCESS(s2n_connection_wipe(conn));
+
+            /* A client that lists AES-128-GCM first gets it */
+            EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(conn, "20191016"));
+            conn->secure.server_ecc_params.negotiated_curve = &s2n_ecc_supported_curves[0];
+            EXPECT_SUCCESS(s2n_set_cipher_and_cert_as_tls_server(conn, wire_ciphers, cipher_count));
+            EXPECT_EQUAL(conn->secure.cipher_suite, s2n_cipher_suite_from_wire(expected_aes128_wire_choice));
+            EXPECT_SUCCESS(s2n_connection_wipe(conn));
+        }
+
         /* Clean+free to setup for ECDSA tests */
         EXPECT_SUCCESS(s2n_config_free(server_config));
 
@@ -515,6 +573,49 @@ int main(int argc, char **argv)
             EXPECT_SUCCESS(s2n_connection_wipe(conn));
         }
 
+        /* Client sends a long list of unknown and GREASE values, with the SCSVs and our only
+         * shared suites buried in it. Server order still decides between the shared suites.
+         */
+        {
+            const uint8_t expected_wire_choice[] = { TLS_RSA_WITH_AES_128_GCM_SHA256 };
+            uint8_t wire_ciphers_long[S2N_TLS_CIPHER_SUITE_LEN * 200];
+            const uint32_t cipher_count_long = sizeof(wire_ciphers_long) / S2N_TLS_CIPHER_SUITE_LEN;
+            for (int i = 0; i < cipher_count_long; i++) {
+                /* GREASE values (RFC 8701) alternating with unassigned suites */
+                wire_ciphers_long[i * 2] = (i % 2) ? 0x0A + (i % 16) * 0x10 : 0xEE;
+                wire_ciphers_long[i * 2 + 1] = (i % 2) ? 0x0A + (i % 16) * 0x10 : i;
+            }
+            const uint8_t renegotiation_info_scsv[] = { TLS_EMPTY_RENEGOTIATION_INFO_SCSV };
+            const uint8_t ecdhe_rsa_cbc[] = { TLS_ECDHE_RSA_WITH_AES_128_CBC_SHA };
+            memcpy(wire_ciphers_long + 2 * 20, renegotiation_info_scsv, S2N_TLS_CIPHER_SUITE_LEN);
+            memcpy(wire_ciphers_long + 2 * 50, ecdhe_rsa_cbc, S2N_TLS_CIPHER_SUITE_LEN);
+            memcpy(wire_ciphers_long + 2 * 199, expected_wire_choice, S2N_TLS_CIPHER_SUITE_LEN);
+
+            s2n_connection_set_cipher_preferences(conn, "test_all");
+            conn->secure.server_ecc_params.negotiated_curve = &s2n_ecc_supported_curves[0];
+            EXPECT_SUCCESS(s2n_connection_set_config(conn, server_config));
+            EXPECT_SUCCESS(s2n_set_cipher_and_cert_as_tls_server(conn, wire_ciphers_long, cipher_count_long));
+            EXPECT_EQUAL(conn->secure_renegotiation, 1);
+            EXPECT_EQUAL(conn->secure.cipher_suite, s2n_cipher_suite_from_wire(expected_wire_choice));
+            EXPECT_SUCCESS(s2n_connection_wipe(conn));
+
+            /* Without any shared suite, negotiation fails */
+            memset(wire_ciphers_long + 2 * 50, 0xEE, S2N_TLS_CIPHER_SUITE_LEN);
+            memset(wire_ciphers_long + 2 * 199, 0xEE, S2N_TLS_CIPHER_SUITE_LEN);
+            s2n_connection_set_cipher_preferences(conn, "test_all");
+            EXPECT_FAILURE_WITH_ERRNO(s2n_set_cipher_and_cert_as_tls_server(conn, wire_ciphers_long, cipher_count_long),
+                    S2N_ERR_CIPHER_NOT_SUPPORTED);
+            EXPECT_SUCCESS(s2n_connection_wipe(conn));
+
+            /* The fallback SCSV is found anywhere in the list */
+            const uint8_t fallback_scsv[] = { TLS_FALLBACK_SCSV };
+            memcpy(wire_ciphers_long + 2 * 120, fallback_scsv, S2N_TLS_CIPHER_SUITE_LEN);
+            conn->client_protocol_version = S2N_TLS11;
+            EXPECT_FAILURE_WITH_ERRNO(s2n_set_cipher_and_cert_as_tls_server(conn, wire_ciphers_long, cipher_count_long),
+                    S2N_ERR_FALLBACK_DETECTED);
+            EXPECT_SUCCESS(s2n_connection_wipe(conn));
+        }
+
         EXPECT_SUCCESS(s2n_config_free(server_config));
         EXPECT_SUCCESS(s2n_cert_chain_and_key_free(rsa_cert));
         EXPECT_SUCCESS(s2n_cert_chain_and_key_free(ecdsa_cert));
@@ -49,6 +49,23 @@ int main(int argc, char **argv)
     EXPECT_NOT_NULL(private_key = malloc(S2N_MAX_TEST_PEM_SIZE));
     EXPECT_SUCCESS(setenv("S2N_DONT_MLOCK", "1", 0));
 
+    /* The supported extension table must be sorted for s2n_supported_extension_index */
+    {
+        for (int i = 1; i < S2N_SUPPORTED_EXTENSIONS_COUNT; i++) {
+            EXPECT_TRUE(s2n_supported_extensions[i - 1] < s2n_supported_extensions[i]);
+        }
+
+        for (int i = 0; i < S2N_SUPPORTED_EXTENSIONS_COUNT; i++) {
+            EXPECT_EQUAL(s2n_supported_extension_index(s2n_supported_extensions[i]), i);
+        }
+
+        EXPECT_EQUAL(s2n_supported_extension_index(TLS_EXTENSION_SERVER_NAME), 0);
+        EXPECT_EQUAL(s2n_supported_extension_index(TLS_EXTENSION_RENEGOTIATION_INFO), S2N_SUPPORTED_EXTENSIONS_COUNT - 1);
+        EXPECT_EQUAL(s2n_supported_extension_index(2), -1);
+        EXPECT_EQUAL(s2n_supported_extension_index(0x0A0A), -1);
+        EXPECT_EQUAL(s2n_supported_extension_index(0xFFFF), -1);
+    }
+
     /* Test cipher suites list */
     {
         /* When TLS 1.3 NOT supported */
@@ -381,6 +398,21 @@ int main(int argc, char **argv)
         free(ext_data);
         ext_data = NULL;
 
+        /* Verify the zero-copy accessor points at the same bytes that get_extension_by_id copies out */
+        const uint8_t *ext_ptr = NULL;
+        EXPECT_EQUAL(s2n_client_hello_get_extension_ptr(client_hello, S2N_EXTENSION_SERVER_NAME, &ext_ptr), server_name_extension_len);
+        EXPECT_NOT_NULL(ext_ptr);
+        EXPECT_SUCCESS(memcmp(ext_ptr, server_name_extension, server_name_extension_len));
+        EXPECT_TRUE(ext_ptr >= client_hello->raw_message.blob.data);
+        EXPECT_TRUE(ext_ptr + server_name_extension_len <= client_hello->raw_message.blob.data + client_hello->raw_message.blob.size);
+
+        /* Verify the zero-copy accessor for absent and unparsed extension types */
+        EXPECT_EQUAL(s2n_client_hello_get_extension_ptr(client_hello, S2N_EXTENSION_CERTIFICATE_TRANSPARENCY, &ext_ptr), 0);
+        EXPECT_NULL(ext_ptr);
+        EXPECT_EQUAL(s2n_client_hello_get_extension_ptr(client_hello, 0x1234, &ext_ptr), 0);
+        EXPECT_NULL(ext_ptr);
+        EXPECT_FAILURE(s2n_client_hello_get_extension_ptr(client_hello, S2N_EXTENSION_SERVER_NAME, NULL));
+
         /* Free all handshake data */
         EXPECT_SUCCESS(s2n_connection_free_handshake(server_conn));
 
@@ -407,8 +439,11 @@ int main(int argc, char **argv)
         EXPECT_EQUAL(client_hello->extensions.size, 0);
         EXPECT_NULL(client_hello->extensions.data);
 
-        /* Verify parsed extesions array in client hello is cleared */
-        EXPECT_NULL(client_hello->parsed_extensions);
+        /* Verify parsed extensions table in client hello is cleared */
+        for (int i = 0; i < S2N_SUPPORTED_EXTENSIONS_COUNT; i++) {
+            EXPECT_NULL(client_hello->parsed_extensions[i].data);
+            EXPECT_EQUAL(client_hello->parsed_extensions[i].size, 0);
+        }
 
         /* Verify the connection is successfully reused after connection_wipe */
 
@@ -479,6 +514,7 @@ int main(int argc, char **argv)
         EXPECT_FAILURE(s2n_client_hello_get_extensions(NULL, out, len));
         EXPECT_FAILURE(s2n_client_hello_get_extension_length(NULL, S2N_EXTENSION_SERVER_NAME));
         EXPECT_FAILURE(s2n_client_hello_get_extension_by_id(NULL, S2N_EXTENSION_SERVER_NAME, out, len));
+        EXPECT_FAILURE(s2n_client_hello_get_extension_ptr(NULL, S2N_EXTENSION_SERVER_NAME, (const uint8_t **) &out));
         free(out);
         out = NULL;
     }
@@ -82,7 +82,7 @@ int main(int argc, char **argv)
             for (int i = 0; i < S2N_ECC_SUPPORTED_CURVES_COUNT; i++) {
                 struct s2n_ecc_params *ecc_params = &conn->secure.client_ecc_params[i];
                 EXPECT_EQUAL(ecc_params->negotiated_curve, &s2n_ecc_supported_curves[i]);
-                EXPECT_NOT_NULL(ecc_params->ec_key);
+                EXPECT_NOT_NULL(ecc_params->evp_pkey);
             }
 
             EXPECT_SUCCESS(s2n_stuffer_free(&key_share_extension));
@@ -159,7 +159,7 @@ int main(int argc, char **argv)
                 client_ecc_params = &client_conn->secure.client_ecc_params[i];
 
                 EXPECT_NOT_NULL(server_ecc_params->negotiated_curve);
-                EXPECT_NOT_NULL(server_ecc_params->ec_key);
+                EXPECT_NOT_NULL(server_ecc_params->evp_pkey);
                 EXPECT_TRUE(s2n_public_ecc_keys_are_equal(server_ecc_params, client_ecc_params));
             }
 
@@ -224,14 +224,14 @@ int main(int argc, char **argv)
             /* should have initialized first curve */
             struct s2n_ecc_params *ecc_params = &conn->secure.client_ecc_params[0];
             EXPECT_NOT_NULL(ecc_params->negotiated_curve);
-            EXPECT_NOT_NULL(ecc_params->ec_key);
+            EXPECT_NOT_NULL(ecc_params->evp_pkey);
             EXPECT_EQUAL(ecc_params->negotiated_curve, &s2n_ecc_supported_curves[0]);
 
             /* should not have initialized any other curves */
             for (int i = 1; i < S2N_ECC_SUPPORTED_CURVES_COUNT; i++) {
                 ecc_params = &conn->secure.client_ecc_params[i];
                 EXPECT_NULL(ecc_params->negotiated_curve);
-                EXPECT_NULL(ecc_params->ec_key);
+                EXPECT_NULL(ecc_params->evp_pkey);
             }
 
             EXPECT_SUCCESS(s2n_stuffer_free(&key_share_extension));
@@ -253,7 +253,7 @@ int main(int argc, char **argv)
             for (int i = 1; i < S2N_ECC_SUPPORTED_CURVES_COUNT; i++) {
                 struct s2n_ecc_params *ecc_params = &server_conn->secure.client_ecc_params[i];
                 EXPECT_NULL(ecc_params->negotiated_curve);
-                EXPECT_NULL(ecc_params->ec_key);
+                EXPECT_NULL(ecc_params->evp_pkey);
             }
 
             EXPECT_SUCCESS(s2n_stuffer_free(&key_share_extension));
@@ -288,7 +288,7 @@ int main(int argc, char **argv)
             for (int i = 0; i < S2N_ECC_SUPPORTED_CURVES_COUNT; i++) {
                 struct s2n_ecc_params *ecc_params = &conn->secure.client_ecc_params[i];
                 EXPECT_NULL(ecc_params->negotiated_curve);
-                EXPECT_NULL(ecc_params->ec_key);
+                EXPECT_NULL(ecc_params->evp_pkey);
             }
 
             EXPECT_SUCCESS(s2n_stuffer_free(&key_share_extension));
@@ -317,7 +317,7 @@ int main(int argc, char **argv)
             for (int i = 0; i < S2N_ECC_SUPPORTED_CURVES_COUNT; i++) {
                 struct s2n_ecc_params *ecc_params = &conn->secure.client_ecc_params[i];
                 EXPECT_NULL(ecc_params->negotiated_curve);
-                EXPECT_NULL(ecc_params->ec_key);
+                EXPECT_NULL(ecc_params->evp_pkey);
             }
 
             EXPECT_SUCCESS(s2n_stuffer_free(&key_share_extension));
@@ -386,7 +386,7 @@ int main(int argc, char **argv)
             for (int i = 1; i < S2N_ECC_SUPPORTED_CURVES_COUNT; i++) {
                 struct s2n_ecc_params *ecc_params = &conn->secure.client_ecc_params[i];
                 EXPECT_NULL(ecc_params->negotiated_curve);
-                EXPECT_NULL(ecc_params->ec_key);
+                EXPECT_NULL(ecc_params->evp_pkey);
             }
 
             EXPECT_SUCCESS(s2n_stuffer_free(&key_share_extension));
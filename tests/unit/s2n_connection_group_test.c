@@ -0,0 +1,363 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+
+#include "testlib/s2n_testlib.h"
+
+#include <fcntl.h>
+#include <string.h>
+
+#include <s2n.h>
+
+#include "tls/s2n_connection.h"
+#include "tls/s2n_connection_group.h"
+#include "utils/s2n_random.h"
+#include "utils/s2n_safety.h"
+
+#define PAIRS 2
+
+static int recv_exactly(struct s2n_connection *conn, uint8_t *buf, ssize_t size)
+{
+    s2n_blocked_status blocked;
+    ssize_t received = 0;
+    while (received < size) {
+        ssize_t n = s2n_recv(conn, buf + received, size - received, &blocked);
+        if (n < 0 && s2n_errno == S2N_ERR_BLOCKED) {
+            return received;
+        }
+        GUARD(n);
+        received += n;
+    }
+
+    return received;
+}
+
+int main(int argc, char **argv)
+{
+    struct s2n_config *server_config;
+    struct s2n_config *client_config;
+    struct s2n_connection *server_conn[PAIRS];
+    struct s2n_connection *client_conn[PAIRS];
+    int server_to_client[PAIRS][2];
+    int client_to_server[PAIRS][2];
+    const char *cipher_prefs[PAIRS] = { "default", "20190122" };
+    char *cert_chain;
+    char *private_key;
+    uint32_t blocked;
+    struct s2n_connection *failed;
+
+    static uint8_t data[200000];
+    static uint8_t received[200000];
+    struct s2n_blob data_blob = {.data = data,.size = sizeof(data) };
+
+    BEGIN_TEST();
+
+    EXPECT_SUCCESS(s2n_get_urandom_data(&data_blob));
+
+    EXPECT_NOT_NULL(cert_chain = malloc(S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_NOT_NULL(private_key = malloc(S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_SUCCESS(s2n_read_test_pem(S2N_DEFAULT_TEST_CERT_CHAIN, cert_chain, S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_SUCCESS(s2n_read_test_pem(S2N_DEFAULT_TEST_PRIVATE_KEY, private_key, S2N_MAX_TEST_PEM_SIZE));
+
+    EXPECT_NOT_NULL(server_config = s2n_config_new());
+    EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key(server_config, cert_chain, private_key));
+    EXPECT_NOT_NULL(client_config = s2n_config_new());
+    EXPECT_SUCCESS(s2n_config_disable_x509_verification(client_config));
+
+    for (int i = 0; i < PAIRS; i++) {
+        EXPECT_SUCCESS(pipe(server_to_client[i]));
+        EXPECT_SUCCESS(pipe(client_to_server[i]));
+        for (int j = 0; j < 2; j++) {
+            EXPECT_NOT_EQUAL(fcntl(server_to_client[i][j], F_SETFL, fcntl(server_to_client[i][j], F_GETFL) | O_NONBLOCK), -1);
+            EXPECT_NOT_EQUAL(fcntl(client_to_server[i][j], F_SETFL, fcntl(client_to_server[i][j], F_GETFL) | O_NONBLOCK), -1);
+        }
+        EXPECT_SUCCESS(s2n_new_test_server_and_client(&server_conn[i], &client_conn[i], server_config, client_config,
+                                                      server_to_client[i], client_to_server[i]));
+        EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(server_conn[i], cipher_prefs[i]));
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn[i], client_conn[i]));
+    }
+
+    /* Group membership is checked */
+    {
+        struct s2n_connection_group *group;
+        struct s2n_connection_group *other_group;
+        EXPECT_NOT_NULL(group = s2n_connection_group_new());
+        EXPECT_NOT_NULL(other_group = s2n_connection_group_new());
+
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_group_send(group, server_conn[0], data, 10), S2N_ERR_NOT_IN_CONNECTION_GROUP);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_group_remove(group, server_conn[0]), S2N_ERR_NOT_IN_CONNECTION_GROUP);
+
+        EXPECT_SUCCESS(s2n_connection_group_add(group, server_conn[0]));
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_group_add(group, server_conn[0]), S2N_ERR_ALREADY_IN_CONNECTION_GROUP);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_group_add(other_group, server_conn[0]), S2N_ERR_ALREADY_IN_CONNECTION_GROUP);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_group_send(other_group, server_conn[0], data, 10), S2N_ERR_NOT_IN_CONNECTION_GROUP);
+
+        /* Removing a connection drops the data queued for it */
+        EXPECT_SUCCESS(s2n_connection_group_send(group, server_conn[0], data, 10));
+        EXPECT_SUCCESS(s2n_connection_group_remove(group, server_conn[0]));
+        EXPECT_NULL(server_conn[0]->group);
+        EXPECT_EQUAL(s2n_array_num_elements(group->writes), 0);
+
+        /* Freeing the group releases its connections */
+        EXPECT_SUCCESS(s2n_connection_group_add(group, server_conn[0]));
+        EXPECT_SUCCESS(s2n_connection_group_free(group));
+        EXPECT_NULL(server_conn[0]->group);
+        EXPECT_SUCCESS(s2n_connection_group_free(other_group));
+
+        /* Only connections that finished the handshake can send application data */
+        struct s2n_connection *new_conn;
+        EXPECT_NOT_NULL(new_conn = s2n_connection_new(S2N_SERVER));
+        EXPECT_NOT_NULL(group = s2n_connection_group_new());
+        EXPECT_SUCCESS(s2n_connection_group_add(group, new_conn));
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_group_send(group, new_conn, data, 10), S2N_ERR_HANDSHAKE_NOT_COMPLETE);
+
+        /* Freeing a connection takes it out of its group */
+        EXPECT_SUCCESS(s2n_connection_free(new_conn));
+        EXPECT_EQUAL(s2n_array_num_elements(group->members), 0);
+        EXPECT_SUCCESS(s2n_connection_group_free(group));
+    }
+
+    /* Data queued for several connections with different ciphers arrives in order */
+    {
+        struct s2n_connection_group *group;
+        EXPECT_NOT_NULL(group = s2n_connection_group_new());
+        for (int i = 0; i < PAIRS; i++) {
+            EXPECT_SUCCESS(s2n_connection_group_add(group, server_conn[i]));
+        }
+
+        /* Nothing queued */
+        EXPECT_SUCCESS(s2n_connection_group_flush(group, &blocked, &failed));
+        EXPECT_EQUAL(blocked, 0);
+
+        /* Small writes, interleaved between the connections, and a write spanning several records */
+        uint32_t sizes[] = { 1, 100, 0, 5000, 20000 };
+        for (int i = 0; i < PAIRS; i++) {
+            uint32_t offset = 0;
+            for (int j = 0; j < s2n_array_len(sizes); j++) {
+                EXPECT_SUCCESS(s2n_connection_group_send(group, server_conn[(i + j) % PAIRS], data + offset, sizes[j]));
+                offset += sizes[j];
+            }
+        }
+        EXPECT_SUCCESS(s2n_connection_group_flush(group, &blocked, &failed));
+        EXPECT_EQUAL(blocked, 0);
+        EXPECT_NULL(failed);
+        EXPECT_EQUAL(s2n_array_num_elements(group->writes), 0);
+
+        for (int i = 0; i < PAIRS; i++) {
+            /* Each connection was sent every size once */
+            uint32_t total = 1 + 100 + 0 + 5000 + 20000;
+            EXPECT_EQUAL(recv_exactly(client_conn[i], received, total), total);
+
+            /* Each connection got every write in the order they were queued */
+            uint32_t received_offset = 0;
+            for (int k = 0; k < PAIRS; k++) {
+                uint32_t offset = 0;
+                for (int j = 0; j < s2n_array_len(sizes); j++) {
+                    if ((k + j) % PAIRS == i) {
+                        EXPECT_EQUAL(memcmp(received + received_offset, data + offset, sizes[j]), 0);
+                        received_offset += sizes[j];
+                    }
+                    offset += sizes[j];
+                }
+            }
+            EXPECT_EQUAL(received_offset, total);
+        }
+
+        /* More than the pipe holds blocks the connection, which catches up on a later flush */
+        EXPECT_SUCCESS(s2n_connection_group_send(group, server_conn[0], data, sizeof(data)));
+        EXPECT_SUCCESS(s2n_connection_group_send(group, server_conn[1], data, 10));
+        EXPECT_SUCCESS(s2n_connection_group_flush(group, &blocked, &failed));
+        EXPECT_EQUAL(blocked, 1);
+        EXPECT_EQUAL(recv_exactly(client_conn[1], received, 10), 10);
+        EXPECT_EQUAL(memcmp(received, data, 10), 0);
+
+        uint32_t received_len = 0;
+        while (received_len < sizeof(data)) {
+            int n;
+            EXPECT_SUCCESS(n = recv_exactly(client_conn[0], received + received_len, sizeof(data) - received_len));
+            received_len += n;
+            EXPECT_SUCCESS(s2n_connection_group_flush(group, &blocked, &failed));
+        }
+        EXPECT_EQUAL(blocked, 0);
+        EXPECT_EQUAL(memcmp(received, data, sizeof(data)), 0);
+
+        /* Connections can still use s2n_send alongside the group */
+        s2n_blocked_status send_blocked;
+        EXPECT_EQUAL(s2n_send(server_conn[1], data, 10, &send_blocked), 10);
+        EXPECT_SUCCESS(s2n_connection_group_send(group, server_conn[1], data + 10, 10));
+        EXPECT_SUCCESS(s2n_connection_group_flush(group, &blocked, &failed));
+        EXPECT_EQUAL(recv_exactly(client_conn[1], received, 20), 20);
+        EXPECT_EQUAL(memcmp(received, data, 20), 0);
+
+        EXPECT_SUCCESS(s2n_connection_group_free(group));
+    }
+
+    /* Records a blocked flush leaves behind go out before anything the connection writes itself */
+    {
+        struct s2n_connection_group *group;
+        struct s2n_connection_group_member *member;
+        s2n_blocked_status send_blocked;
+        uint32_t queued = sizeof(data) / 2;
+        uint32_t received_len;
+        ssize_t sent;
+
+        EXPECT_NOT_NULL(group = s2n_connection_group_new());
+        EXPECT_SUCCESS(s2n_connection_group_add(group, server_conn[0]));
+        EXPECT_NOT_NULL(member = s2n_array_get(group->members, 0));
+
+        /* s2n_send blocks until the group's records are written */
+        EXPECT_SUCCESS(s2n_connection_group_send(group, server_conn[0], data, queued));
+        EXPECT_SUCCESS(s2n_connection_group_flush(group, &blocked, &failed));
+        EXPECT_EQUAL(blocked, 1);
+        EXPECT_NOT_EQUAL(s2n_stuffer_data_available(&member->out), 0);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_send(server_conn[0], data + queued, 10, &send_blocked), S2N_ERR_BLOCKED);
+
+        received_len = 0;
+        while ((sent = s2n_send(server_conn[0], data + queued, 10, &send_blocked)) < 0) {
+            EXPECT_EQUAL(s2n_errno, S2N_ERR_BLOCKED);
+            received_len += recv_exactly(client_conn[0], received + received_len, queued - received_len);
+        }
+        EXPECT_EQUAL(sent, 10);
+        EXPECT_EQUAL(recv_exactly(client_conn[0], received + received_len, queued + 10 - received_len), queued + 10 - received_len);
+        EXPECT_EQUAL(memcmp(received, data, queued + 10), 0);
+
+        /* Removing the connection hands the records back to it, ahead of what it already had queued */
+        EXPECT_SUCCESS(s2n_connection_group_send(group, server_conn[0], data, queued));
+        EXPECT_SUCCESS(s2n_connection_group_flush(group, &blocked, &failed));
+        EXPECT_EQUAL(blocked, 1);
+        EXPECT_SUCCESS(s2n_connection_group_remove(group, server_conn[0]));
+        EXPECT_NOT_EQUAL(s2n_stuffer_data_available(&server_conn[0]->out), 0);
+
+        received_len = 0;
+        while ((sent = s2n_send(server_conn[0], data + queued, 10, &send_blocked)) < 0) {
+            EXPECT_EQUAL(s2n_errno, S2N_ERR_BLOCKED);
+            received_len += recv_exactly(client_conn[0], received + received_len, queued - received_len);
+        }
+        EXPECT_EQUAL(sent, 10);
+        EXPECT_EQUAL(recv_exactly(client_conn[0], received + received_len, queued + 10 - received_len), queued + 10 - received_len);
+        EXPECT_EQUAL(memcmp(received, data, queued + 10), 0);
+
+        /* So does freeing the group */
+        EXPECT_SUCCESS(s2n_connection_group_add(group, server_conn[0]));
+        EXPECT_SUCCESS(s2n_connection_group_send(group, server_conn[0], data, queued));
+        EXPECT_SUCCESS(s2n_connection_group_flush(group, &blocked, &failed));
+        EXPECT_EQUAL(blocked, 1);
+        EXPECT_SUCCESS(s2n_connection_group_free(group));
+        EXPECT_NULL(server_conn[0]->group);
+
+        received_len = 0;
+        while ((sent = s2n_send(server_conn[0], data + queued, 10, &send_blocked)) < 0) {
+            EXPECT_EQUAL(s2n_errno, S2N_ERR_BLOCKED);
+            received_len += recv_exactly(client_conn[0], received + received_len, queued - received_len);
+        }
+        EXPECT_EQUAL(sent, 10);
+        EXPECT_EQUAL(recv_exactly(client_conn[0], received + received_len, queued + 10 - received_len), queued + 10 - received_len);
+        EXPECT_EQUAL(memcmp(received, data, queued + 10), 0);
+
+        /* s2n_shutdown writes the group's records before the close_notify */
+        EXPECT_NOT_NULL(group = s2n_connection_group_new());
+        EXPECT_SUCCESS(s2n_connection_group_add(group, server_conn[0]));
+        EXPECT_SUCCESS(s2n_connection_group_send(group, server_conn[0], data, queued));
+        EXPECT_SUCCESS(s2n_connection_group_flush(group, &blocked, &failed));
+        EXPECT_EQUAL(blocked, 1);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_shutdown(server_conn[0], &send_blocked), S2N_ERR_BLOCKED);
+        EXPECT_EQUAL(send_blocked, S2N_BLOCKED_ON_WRITE);
+
+        received_len = 0;
+        while (s2n_shutdown(server_conn[0], &send_blocked) < 0 && send_blocked == S2N_BLOCKED_ON_WRITE) {
+            EXPECT_EQUAL(s2n_errno, S2N_ERR_BLOCKED);
+            received_len += recv_exactly(client_conn[0], received + received_len, queued - received_len);
+        }
+        EXPECT_EQUAL(send_blocked, S2N_BLOCKED_ON_READ);
+        EXPECT_EQUAL(recv_exactly(client_conn[0], received + received_len, queued - received_len), queued - received_len);
+        EXPECT_EQUAL(memcmp(received, data, queued), 0);
+        EXPECT_SUCCESS(s2n_connection_group_free(group));
+    }
+
+    /* A connection that fails partway through encrypting is killed, and none of its data is sent later */
+    {
+        struct s2n_connection *killed_server_conn;
+        struct s2n_connection *killed_client_conn;
+        int killed_server_to_client[2];
+        int killed_client_to_server[2];
+
+        EXPECT_SUCCESS(pipe(killed_server_to_client));
+        EXPECT_SUCCESS(pipe(killed_client_to_server));
+        for (int j = 0; j < 2; j++) {
+            EXPECT_NOT_EQUAL(fcntl(killed_server_to_client[j], F_SETFL, fcntl(killed_server_to_client[j], F_GETFL) | O_NONBLOCK), -1);
+            EXPECT_NOT_EQUAL(fcntl(killed_client_to_server[j], F_SETFL, fcntl(killed_client_to_server[j], F_GETFL) | O_NONBLOCK), -1);
+        }
+        EXPECT_SUCCESS(s2n_new_test_server_and_client(&killed_server_conn, &killed_client_conn, server_config, client_config,
+                                                      killed_server_to_client, killed_client_to_server));
+        EXPECT_SUCCESS(s2n_connection_set_blinding(killed_server_conn, S2N_SELF_SERVICE_BLINDING));
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(killed_server_conn, killed_client_conn));
+
+        struct s2n_connection_group *group;
+        EXPECT_NOT_NULL(group = s2n_connection_group_new());
+        EXPECT_SUCCESS(s2n_connection_group_add(group, killed_server_conn));
+        EXPECT_SUCCESS(s2n_connection_group_add(group, server_conn[1]));
+
+        /* The first record takes the last sequence number, so the second one can't be encrypted */
+        memset(killed_server_conn->server->server_sequence_number, 0xff, S2N_TLS_SEQUENCE_NUM_LEN);
+        killed_server_conn->server->server_sequence_number[S2N_TLS_SEQUENCE_NUM_LEN - 1] = 0xfe;
+
+        EXPECT_SUCCESS(s2n_connection_group_send(group, killed_server_conn, data, 20000));
+        EXPECT_SUCCESS(s2n_connection_group_send(group, killed_server_conn, data + 20000, 10));
+        EXPECT_SUCCESS(s2n_connection_group_send(group, server_conn[1], data, 100));
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_group_flush(group, &blocked, &failed), S2N_ERR_RECORD_LIMIT);
+        EXPECT_EQUAL(failed, killed_server_conn);
+        EXPECT_TRUE(killed_server_conn->closed);
+        EXPECT_NOT_EQUAL(s2n_connection_get_delay(killed_server_conn), 0);
+
+        /* Removing it hands nothing back, and the other connection's data still goes out */
+        EXPECT_SUCCESS(s2n_connection_group_remove(group, killed_server_conn));
+        EXPECT_EQUAL(s2n_stuffer_data_available(&killed_server_conn->out), 0);
+        for (uint32_t i = 0; i < s2n_array_num_elements(group->writes); i++) {
+            struct s2n_connection_group_write *write = s2n_array_get(group->writes, i);
+            EXPECT_EQUAL(write->member, server_conn[1]->group_index);
+        }
+
+        EXPECT_SUCCESS(s2n_connection_group_flush(group, &blocked, &failed));
+        EXPECT_EQUAL(blocked, 0);
+        EXPECT_EQUAL(recv_exactly(client_conn[1], received, 100), 100);
+        EXPECT_EQUAL(memcmp(received, data, 100), 0);
+        EXPECT_SUCCESS(s2n_connection_group_free(group));
+
+        EXPECT_SUCCESS(s2n_connection_free(killed_server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(killed_client_conn));
+        for (int j = 0; j < 2; j++) {
+            EXPECT_SUCCESS(close(killed_server_to_client[j]));
+            EXPECT_SUCCESS(close(killed_client_to_server[j]));
+        }
+    }
+
+    for (int i = 0; i < PAIRS; i++) {
+        EXPECT_SUCCESS(s2n_shutdown_test_server_and_client(server_conn[i], client_conn[i]));
+        EXPECT_SUCCESS(s2n_connection_free(server_conn[i]));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn[i]));
+        for (int j = 0; j < 2; j++) {
+            EXPECT_SUCCESS(close(server_to_client[i][j]));
+            EXPECT_SUCCESS(close(client_to_server[i][j]));
+        }
+    }
+
+    EXPECT_SUCCESS(s2n_config_free(server_config));
+    EXPECT_SUCCESS(s2n_config_free(client_config));
+    free(cert_chain);
+    free(private_key);
+
+    END_TEST();
+}
@@ -0,0 +1,192 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+
+#include "testlib/s2n_testlib.h"
+
+#include <fcntl.h>
+#include <errno.h>
+
+#include <s2n.h>
+
+#include "tls/s2n_connection.h"
+#include "tls/s2n_cipher_preferences.h"
+#include "tls/s2n_cipher_suites.h"
+#include "utils/s2n_safety.h"
+
+int main(int argc, char **argv)
+{
+    struct s2n_config *server_config;
+    struct s2n_config *client_config;
+    struct s2n_connection *server_conn;
+    struct s2n_connection *client_conn;
+    int server_to_client[2];
+    int client_to_server[2];
+    char *cert_chain;
+    char *private_key;
+    s2n_blocked_status blocked;
+
+    BEGIN_TEST();
+
+    EXPECT_SUCCESS(setenv("S2N_DONT_MLOCK", "1", 0));
+
+    EXPECT_NOT_NULL(cert_chain = malloc(S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_NOT_NULL(private_key = malloc(S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_SUCCESS(s2n_read_test_pem(S2N_DEFAULT_TEST_CERT_CHAIN, cert_chain, S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_SUCCESS(s2n_read_test_pem(S2N_DEFAULT_TEST_PRIVATE_KEY, private_key, S2N_MAX_TEST_PEM_SIZE));
+
+    EXPECT_NOT_NULL(server_config = s2n_config_new());
+    EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key(server_config, cert_chain, private_key));
+    EXPECT_NOT_NULL(client_config = s2n_config_new());
+    EXPECT_SUCCESS(s2n_config_disable_x509_verification(client_config));
+
+    /* Create nonblocking pipes */
+    EXPECT_SUCCESS(pipe(server_to_client));
+    EXPECT_SUCCESS(pipe(client_to_server));
+    for (int i = 0; i < 2; i++) {
+        EXPECT_NOT_EQUAL(fcntl(server_to_client[i], F_SETFL, fcntl(server_to_client[i], F_GETFL) | O_NONBLOCK), -1);
+        EXPECT_NOT_EQUAL(fcntl(client_to_server[i], F_SETFL, fcntl(client_to_server[i], F_GETFL) | O_NONBLOCK), -1);
+    }
+
+    /* Hibernation requires a completed handshake */
+    {
+        EXPECT_SUCCESS(s2n_new_test_server_and_client(&server_conn, &client_conn, server_config, client_config, server_to_client, client_to_server));
+
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_hibernate(server_conn), S2N_ERR_HANDSHAKE_NOT_COMPLETE);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_hibernate(client_conn), S2N_ERR_HANDSHAKE_NOT_COMPLETE);
+
+        /* Waking a connection that isn't hibernating is a no-op */
+        EXPECT_SUCCESS(s2n_connection_wake(server_conn));
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+    }
+
+    /* CBC suites keep separate HMAC state, and TLS1.0 chains the IV from the previous record */
+    struct {
+        struct s2n_cipher_suite *cipher_suite;
+        uint8_t protocol_version;
+    } test_cases[] = {
+        { &s2n_ecdhe_rsa_with_aes_128_gcm_sha256, S2N_TLS12 },
+        { &s2n_ecdhe_rsa_with_aes_256_gcm_sha384, S2N_TLS12 },
+        { &s2n_ecdhe_rsa_with_chacha20_poly1305_sha256, S2N_TLS12 },
+        { &s2n_ecdhe_rsa_with_aes_128_cbc_sha256, S2N_TLS12 },
+        { &s2n_ecdhe_rsa_with_aes_128_cbc_sha, S2N_TLS12 },
+        { &s2n_rsa_with_aes_128_cbc_sha, S2N_TLS10 },
+    };
+
+    for (int i = 0; i < sizeof(test_cases) / sizeof(test_cases[0]); i++) {
+        if (!test_cases[i].cipher_suite->available) {
+            continue;
+        }
+
+        struct s2n_cipher_preferences server_cipher_preferences;
+        memcpy(&server_cipher_preferences, &cipher_preferences_test_all, sizeof(server_cipher_preferences));
+        server_cipher_preferences.count = 1;
+        server_cipher_preferences.suites = &test_cases[i].cipher_suite;
+
+        EXPECT_SUCCESS(s2n_new_test_server_and_client(&server_conn, &client_conn, server_config, client_config, server_to_client, client_to_server));
+        server_conn->cipher_pref_override = &server_cipher_preferences;
+        client_conn->client_protocol_version = test_cases[i].protocol_version;
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+        /* CBC suites negotiate encrypt-then-MAC, which swaps in a variant of the suite */
+        EXPECT_BYTEARRAY_EQUAL(server_conn->secure.cipher_suite->iana_value, test_cases[i].cipher_suite->iana_value, S2N_TLS_CIPHER_SUITE_LEN);
+        EXPECT_EQUAL(server_conn->actual_protocol_version, test_cases[i].protocol_version);
+
+        EXPECT_SUCCESS(s2n_send_and_recv_test_message(client_conn, server_conn, "before hibernation"));
+
+        /* Buffered plaintext prevents hibernation. TLS1.0 CBC sends the first byte in a record of its own. */
+        char pending[7];
+        int pending_read = 0;
+        EXPECT_EQUAL(s2n_send(client_conn, "pending", sizeof(pending), &blocked), sizeof(pending));
+        while (s2n_peek(server_conn) == 0) {
+            EXPECT_EQUAL(s2n_recv(server_conn, pending + pending_read, 1, &blocked), 1);
+            pending_read++;
+        }
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_hibernate(server_conn), S2N_ERR_HIBERNATE_PENDING_DATA);
+        EXPECT_EQUAL(s2n_recv(server_conn, pending + pending_read, sizeof(pending) - pending_read, &blocked), sizeof(pending) - pending_read);
+
+        /* TLS1.3 connections can't hibernate */
+        uint8_t actual_protocol_version = server_conn->actual_protocol_version;
+        server_conn->actual_protocol_version = S2N_TLS13;
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_hibernate(server_conn), S2N_ERR_HIBERNATE_UNSUPPORTED_CIPHER);
+        server_conn->actual_protocol_version = actual_protocol_version;
+
+        /* Hibernate releases the crypto state and buffers */
+        EXPECT_SUCCESS(s2n_connection_hibernate(server_conn));
+        EXPECT_SUCCESS(s2n_connection_hibernate(client_conn));
+        EXPECT_SUCCESS(s2n_connection_hibernate(server_conn));
+        EXPECT_TRUE(server_conn->hibernating);
+        EXPECT_NULL(server_conn->secure.server_key.evp_cipher_ctx);
+        EXPECT_NULL(server_conn->secure.client_key.evp_cipher_ctx);
+        EXPECT_NULL(server_conn->in.blob.data);
+        EXPECT_NULL(server_conn->out.blob.data);
+        EXPECT_NULL(server_conn->handshake.io.blob.data);
+
+        /* I/O wakes the connection with the same keys and sequence numbers */
+        EXPECT_SUCCESS(s2n_send_and_recv_test_message(client_conn, server_conn, "woken by the client"));
+        EXPECT_FALSE(server_conn->hibernating);
+        EXPECT_FALSE(client_conn->hibernating);
+        EXPECT_SUCCESS(s2n_send_and_recv_test_message(server_conn, client_conn, "and answered by the server"));
+
+        /* Explicit wake, and several hibernation cycles */
+        for (int j = 0; j < 3; j++) {
+            EXPECT_SUCCESS(s2n_connection_hibernate(server_conn));
+            EXPECT_SUCCESS(s2n_connection_hibernate(client_conn));
+            EXPECT_SUCCESS(s2n_connection_wake(client_conn));
+            EXPECT_FALSE(client_conn->hibernating);
+            EXPECT_SUCCESS(s2n_send_and_recv_test_message(server_conn, client_conn, "server to client"));
+            EXPECT_SUCCESS(s2n_send_and_recv_test_message(client_conn, server_conn, "client to server"));
+        }
+
+        /* Shutdown wakes the connection too */
+        EXPECT_SUCCESS(s2n_connection_hibernate(server_conn));
+        EXPECT_SUCCESS(s2n_connection_hibernate(client_conn));
+        EXPECT_SUCCESS(s2n_shutdown_test_server_and_client(server_conn, client_conn));
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+    }
+
+    /* Hibernating connections can be wiped and freed directly */
+    {
+        EXPECT_SUCCESS(s2n_new_test_server_and_client(&server_conn, &client_conn, server_config, client_config, server_to_client, client_to_server));
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+
+        EXPECT_SUCCESS(s2n_connection_hibernate(server_conn));
+        EXPECT_SUCCESS(s2n_connection_hibernate(client_conn));
+
+        EXPECT_SUCCESS(s2n_connection_wipe(server_conn));
+        EXPECT_FALSE(server_conn->hibernating);
+        EXPECT_NOT_NULL(server_conn->secure.server_key.evp_cipher_ctx);
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+    }
+
+    for (int i = 0; i < 2; i++) {
+        EXPECT_SUCCESS(close(server_to_client[i]));
+        EXPECT_SUCCESS(close(client_to_server[i]));
+    }
+
+    EXPECT_SUCCESS(s2n_config_free(server_config));
+    EXPECT_SUCCESS(s2n_config_free(client_config));
+    free(cert_chain);
+    free(private_key);
+
+    END_TEST();
+    return 0;
+}
@@ -0,0 +1,226 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+
+#include "testlib/s2n_testlib.h"
+
+#include <fcntl.h>
+#include <errno.h>
+
+#include <s2n.h>
+
+#include "tls/s2n_connection.h"
+#include "tls/s2n_connection_serialize.h"
+#include "tls/s2n_cipher_preferences.h"
+#include "tls/s2n_cipher_suites.h"
+#include "utils/s2n_safety.h"
+
+/* Serialize a connection, free it, and load the state into a new connection using the same fds */
+static int hand_over(struct s2n_connection **conn, struct s2n_config *config, int read_fd, int write_fd)
+{
+    uint8_t buffer[S2N_LARGE_FRAGMENT_LENGTH + 1024];
+    int length = s2n_connection_get_serialized_length(*conn);
+    gte_check(length, S2N_SERIALIZED_CONNECTION_MIN_SIZE);
+
+    eq_check(s2n_connection_serialize(*conn, buffer, sizeof(buffer)), length);
+    s2n_mode mode = (*conn)->mode;
+    GUARD(s2n_connection_free(*conn));
+
+    notnull_check(*conn = s2n_connection_new(mode));
+    GUARD(s2n_connection_set_config(*conn, config));
+    GUARD(s2n_connection_set_read_fd(*conn, read_fd));
+    GUARD(s2n_connection_set_write_fd(*conn, write_fd));
+    GUARD(s2n_connection_deserialize(*conn, buffer, length));
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    struct s2n_config *server_config;
+    struct s2n_config *client_config;
+    struct s2n_connection *server_conn;
+    struct s2n_connection *client_conn;
+    int server_to_client[2];
+    int client_to_server[2];
+    char *cert_chain;
+    char *private_key;
+    s2n_blocked_status blocked;
+    const char *protocols[] = { "h2", "http/1.1" };
+    uint8_t buffer[S2N_LARGE_FRAGMENT_LENGTH + 1024];
+
+    BEGIN_TEST();
+
+    EXPECT_SUCCESS(setenv("S2N_DONT_MLOCK", "1", 0));
+
+    EXPECT_NOT_NULL(cert_chain = malloc(S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_NOT_NULL(private_key = malloc(S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_SUCCESS(s2n_read_test_pem(S2N_DEFAULT_TEST_CERT_CHAIN, cert_chain, S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_SUCCESS(s2n_read_test_pem(S2N_DEFAULT_TEST_PRIVATE_KEY, private_key, S2N_MAX_TEST_PEM_SIZE));
+
+    EXPECT_NOT_NULL(server_config = s2n_config_new());
+    EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key(server_config, cert_chain, private_key));
+    EXPECT_SUCCESS(s2n_config_set_protocol_preferences(server_config, protocols, 2));
+    EXPECT_NOT_NULL(client_config = s2n_config_new());
+    EXPECT_SUCCESS(s2n_config_disable_x509_verification(client_config));
+    EXPECT_SUCCESS(s2n_config_set_protocol_preferences(client_config, protocols, 2));
+
+    /* Create nonblocking pipes */
+    EXPECT_SUCCESS(pipe(server_to_client));
+    EXPECT_SUCCESS(pipe(client_to_server));
+    for (int i = 0; i < 2; i++) {
+        EXPECT_NOT_EQUAL(fcntl(server_to_client[i], F_SETFL, fcntl(server_to_client[i], F_GETFL) | O_NONBLOCK), -1);
+        EXPECT_NOT_EQUAL(fcntl(client_to_server[i], F_SETFL, fcntl(client_to_server[i], F_GETFL) | O_NONBLOCK), -1);
+    }
+
+    /* Serialization requires a completed handshake, and a new connection to load into */
+    {
+        EXPECT_SUCCESS(s2n_new_test_server_and_client(&server_conn, &client_conn, server_config, client_config, server_to_client, client_to_server));
+
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_serialize(server_conn, buffer, sizeof(buffer)), S2N_ERR_HANDSHAKE_NOT_COMPLETE);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_deserialize(server_conn, buffer, 10), S2N_ERR_INVALID_SERIALIZED_CONNECTION);
+
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_serialize(server_conn, buffer, 10), S2N_ERR_SERIALIZED_CONNECTION_TOO_LONG);
+
+        int length = s2n_connection_serialize(server_conn, buffer, sizeof(buffer));
+        EXPECT_EQUAL(length, s2n_connection_get_serialized_length(server_conn));
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_deserialize(server_conn, buffer, length), S2N_ERR_DESERIALIZE_INTO_USED_CONNECTION);
+
+        /* Wrong mode, truncated, trailing data and unknown format version */
+        struct s2n_connection *conn;
+        EXPECT_NOT_NULL(conn = s2n_connection_new(S2N_CLIENT));
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_deserialize(conn, buffer, length), S2N_ERR_INVALID_SERIALIZED_CONNECTION);
+        EXPECT_SUCCESS(s2n_connection_free(conn));
+
+        EXPECT_NOT_NULL(conn = s2n_connection_new(S2N_SERVER));
+        EXPECT_FAILURE(s2n_connection_deserialize(conn, buffer, length - 1));
+        EXPECT_SUCCESS(s2n_connection_free(conn));
+
+        EXPECT_NOT_NULL(conn = s2n_connection_new(S2N_SERVER));
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_deserialize(conn, buffer, length + 1), S2N_ERR_INVALID_SERIALIZED_CONNECTION);
+        EXPECT_SUCCESS(s2n_connection_free(conn));
+
+        buffer[0] = S2N_SERIALIZED_CONNECTION_FORMAT_VERSION + 1;
+        EXPECT_NOT_NULL(conn = s2n_connection_new(S2N_SERVER));
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_deserialize(conn, buffer, length), S2N_ERR_INVALID_SERIALIZED_CONNECTION);
+        EXPECT_SUCCESS(s2n_connection_free(conn));
+
+        /* Unsent records must be flushed first */
+        EXPECT_SUCCESS(s2n_stuffer_write_uint8(&server_conn->out, 0));
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_serialize(server_conn, buffer, sizeof(buffer)), S2N_ERR_SERIALIZE_PENDING_DATA);
+        EXPECT_SUCCESS(s2n_stuffer_wipe(&server_conn->out));
+
+        /* TLS1.3 connections can't be serialized */
+        uint8_t actual_protocol_version = server_conn->actual_protocol_version;
+        server_conn->actual_protocol_version = S2N_TLS13;
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_serialize(server_conn, buffer, sizeof(buffer)), S2N_ERR_SERIALIZE_UNSUPPORTED_CIPHER);
+        server_conn->actual_protocol_version = actual_protocol_version;
+
+        EXPECT_SUCCESS(s2n_shutdown_test_server_and_client(server_conn, client_conn));
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_serialize(server_conn, buffer, sizeof(buffer)), S2N_ERR_CLOSED);
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+    }
+
+    struct s2n_cipher_suite *test_suites[] = {
+        &s2n_ecdhe_rsa_with_aes_128_gcm_sha256,
+        &s2n_ecdhe_rsa_with_aes_256_gcm_sha384,
+        &s2n_ecdhe_rsa_with_chacha20_poly1305_sha256,
+    };
+
+    for (int i = 0; i < sizeof(test_suites) / sizeof(test_suites[0]); i++) {
+        if (!test_suites[i]->available) {
+            continue;
+        }
+
+        struct s2n_cipher_preferences server_cipher_preferences;
+        memcpy(&server_cipher_preferences, &cipher_preferences_test_all, sizeof(server_cipher_preferences));
+        server_cipher_preferences.count = 1;
+        server_cipher_preferences.suites = &test_suites[i];
+
+        EXPECT_SUCCESS(s2n_new_test_server_and_client(&server_conn, &client_conn, server_config, client_config, server_to_client, client_to_server));
+        server_conn->cipher_pref_override = &server_cipher_preferences;
+        EXPECT_SUCCESS(s2n_set_server_name(client_conn, "www.example.com"));
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+        EXPECT_EQUAL(server_conn->secure.cipher_suite, test_suites[i]);
+
+        EXPECT_SUCCESS(s2n_send_and_recv_test_message(client_conn, server_conn, "before the handover"));
+
+        /* Both ends can be handed over, with the negotiated parameters intact */
+        EXPECT_SUCCESS(hand_over(&server_conn, server_config, client_to_server[0], server_to_client[1]));
+        EXPECT_SUCCESS(hand_over(&client_conn, client_config, server_to_client[0], client_to_server[1]));
+        EXPECT_STRING_EQUAL(s2n_connection_get_cipher(server_conn), test_suites[i]->name);
+        EXPECT_STRING_EQUAL(s2n_get_server_name(server_conn), "www.example.com");
+        EXPECT_STRING_EQUAL(s2n_get_application_protocol(server_conn), "h2");
+        EXPECT_STRING_EQUAL(s2n_get_application_protocol(client_conn), "h2");
+        EXPECT_SUCCESS(s2n_send_and_recv_test_message(client_conn, server_conn, "client to new server"));
+        EXPECT_SUCCESS(s2n_send_and_recv_test_message(server_conn, client_conn, "new server to client"));
+
+        /* Decrypted data the application hasn't read yet is carried over */
+        EXPECT_EQUAL(s2n_send(client_conn, "pending", 7, &blocked), 7);
+        char byte;
+        EXPECT_EQUAL(s2n_recv(server_conn, &byte, 1, &blocked), 1);
+        EXPECT_EQUAL(byte, 'p');
+        EXPECT_SUCCESS(hand_over(&server_conn, server_config, client_to_server[0], server_to_client[1]));
+        char rest[6];
+        EXPECT_EQUAL(s2n_recv(server_conn, rest, sizeof(rest), &blocked), sizeof(rest));
+        EXPECT_EQUAL(memcmp(rest, "ending", sizeof(rest)), 0);
+
+        /* So is a partially received record, both before and after its header is complete */
+        const char *message = "split across processes";
+        EXPECT_EQUAL(s2n_send(client_conn, message, strlen(message), &blocked), strlen(message));
+        ssize_t record_length = read(client_to_server[0], buffer, sizeof(buffer));
+        EXPECT_TRUE(record_length > S2N_TLS_RECORD_HEADER_LENGTH + 5);
+
+        EXPECT_EQUAL(write(client_to_server[1], buffer, 3), 3);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_recv(server_conn, rest, sizeof(rest), &blocked), S2N_ERR_BLOCKED);
+        EXPECT_SUCCESS(hand_over(&server_conn, server_config, client_to_server[0], server_to_client[1]));
+
+        EXPECT_EQUAL(write(client_to_server[1], buffer + 3, 7), 7);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_recv(server_conn, rest, sizeof(rest), &blocked), S2N_ERR_BLOCKED);
+        EXPECT_SUCCESS(hand_over(&server_conn, server_config, client_to_server[0], server_to_client[1]));
+
+        EXPECT_EQUAL(write(client_to_server[1], buffer + 10, record_length - 10), record_length - 10);
+        char received[64] = { 0 };
+        EXPECT_EQUAL(s2n_recv(server_conn, received, sizeof(received), &blocked), strlen(message));
+        EXPECT_STRING_EQUAL(received, message);
+
+        /* Hibernating connections can be serialized without waking them */
+        EXPECT_SUCCESS(s2n_connection_hibernate(server_conn));
+        EXPECT_SUCCESS(hand_over(&server_conn, server_config, client_to_server[0], server_to_client[1]));
+        EXPECT_SUCCESS(s2n_send_and_recv_test_message(server_conn, client_conn, "after hibernation"));
+
+        EXPECT_SUCCESS(s2n_shutdown_test_server_and_client(server_conn, client_conn));
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+    }
+
+    for (int i = 0; i < 2; i++) {
+        EXPECT_SUCCESS(close(server_to_client[i]));
+        EXPECT_SUCCESS(close(client_to_server[i]));
+    }
+
+    EXPECT_SUCCESS(s2n_config_free(server_config));
+    EXPECT_SUCCESS(s2n_config_free(client_config));
+    free(cert_chain);
+    free(private_key);
+
+    END_TEST();
+    return 0;
+}
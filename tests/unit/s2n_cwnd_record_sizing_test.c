@@ -0,0 +1,172 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+
+#include "testlib/s2n_testlib.h"
+
+#include <fcntl.h>
+#include <string.h>
+
+#include <s2n.h>
+
+#include "tls/s2n_connection.h"
+#include "tls/s2n_tls_parameters.h"
+#include "utils/s2n_safety.h"
+
+#define SEND_SIZE 20000
+
+static int tcp_info_cb(struct s2n_connection *conn, void *ctx, struct s2n_tcp_info *info)
+{
+    struct s2n_tcp_info *sample = ctx;
+    if (sample == NULL) {
+        return -1;
+    }
+
+    *info = *sample;
+    return 0;
+}
+
+/* Send SEND_SIZE bytes and report the smallest and largest record that went on the wire */
+static int send_and_measure(struct s2n_connection *conn, int read_fd, uint32_t *min_record, uint32_t *max_record)
+{
+    static uint8_t data[SEND_SIZE];
+    static uint8_t wire[SEND_SIZE * 2];
+    s2n_blocked_status blocked;
+
+    GUARD(s2n_send(conn, data, sizeof(data), &blocked));
+
+    ssize_t wire_len = read(read_fd, wire, sizeof(wire));
+    S2N_ERROR_IF(wire_len <= 0, S2N_ERR_IO);
+
+    *min_record = UINT32_MAX;
+    *max_record = 0;
+    for (ssize_t offset = 0; offset < wire_len;) {
+        S2N_ERROR_IF(wire[offset] != TLS_APPLICATION_DATA, S2N_ERR_BAD_MESSAGE);
+        uint32_t record_len = S2N_TLS_RECORD_HEADER_LENGTH + ((wire[offset + 3] << 8) | wire[offset + 4]);
+        *min_record = *min_record < record_len ? *min_record : record_len;
+        *max_record = *max_record > record_len ? *max_record : record_len;
+        offset += record_len;
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    struct s2n_config *server_config;
+    struct s2n_config *client_config;
+    struct s2n_connection *server_conn;
+    struct s2n_connection *client_conn;
+    int server_to_client[2];
+    int client_to_server[2];
+    char *cert_chain;
+    char *private_key;
+    uint32_t min_record;
+    uint32_t max_record;
+
+    BEGIN_TEST();
+
+    EXPECT_NOT_NULL(cert_chain = malloc(S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_NOT_NULL(private_key = malloc(S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_SUCCESS(s2n_read_test_pem(S2N_DEFAULT_TEST_CERT_CHAIN, cert_chain, S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_SUCCESS(s2n_read_test_pem(S2N_DEFAULT_TEST_PRIVATE_KEY, private_key, S2N_MAX_TEST_PEM_SIZE));
+
+    EXPECT_NOT_NULL(server_config = s2n_config_new());
+    EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key(server_config, cert_chain, private_key));
+    EXPECT_NOT_NULL(client_config = s2n_config_new());
+    EXPECT_SUCCESS(s2n_config_disable_x509_verification(client_config));
+
+    EXPECT_SUCCESS(pipe(server_to_client));
+    EXPECT_SUCCESS(pipe(client_to_server));
+    for (int i = 0; i < 2; i++) {
+        EXPECT_NOT_EQUAL(fcntl(server_to_client[i], F_SETFL, fcntl(server_to_client[i], F_GETFL) | O_NONBLOCK), -1);
+        EXPECT_NOT_EQUAL(fcntl(client_to_server[i], F_SETFL, fcntl(client_to_server[i], F_GETFL) | O_NONBLOCK), -1);
+    }
+
+    EXPECT_NOT_NULL(server_conn = s2n_connection_new(S2N_SERVER));
+    EXPECT_SUCCESS(s2n_connection_set_config(server_conn, server_config));
+    EXPECT_SUCCESS(s2n_connection_set_read_fd(server_conn, client_to_server[0]));
+    EXPECT_SUCCESS(s2n_connection_set_write_fd(server_conn, server_to_client[1]));
+
+    EXPECT_NOT_NULL(client_conn = s2n_connection_new(S2N_CLIENT));
+    EXPECT_SUCCESS(s2n_connection_set_config(client_conn, client_config));
+    EXPECT_SUCCESS(s2n_connection_set_read_fd(client_conn, server_to_client[0]));
+    EXPECT_SUCCESS(s2n_connection_set_write_fd(client_conn, client_to_server[1]));
+
+    EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+
+    /* Disable the dynamic record threshold so that every record is full size without a sample */
+    EXPECT_SUCCESS(s2n_connection_set_dynamic_record_threshold(server_conn, 0, 0));
+    EXPECT_SUCCESS(send_and_measure(server_conn, server_to_client[0], &min_record, &max_record));
+    uint32_t full_record = max_record;
+    EXPECT_TRUE(full_record > 4000);
+
+    EXPECT_SUCCESS(s2n_connection_use_congestion_window_record_sizing(server_conn));
+
+    /* A pipe has no TCP_INFO, so records stay full size */
+    EXPECT_SUCCESS(send_and_measure(server_conn, server_to_client[0], &min_record, &max_record));
+    EXPECT_EQUAL(max_record, full_record);
+
+    /* A callback that can't report anything leaves record sizes alone too */
+    EXPECT_SUCCESS(s2n_connection_set_tcp_info_cb(server_conn, tcp_info_cb, NULL));
+    EXPECT_SUCCESS(send_and_measure(server_conn, server_to_client[0], &min_record, &max_record));
+    EXPECT_EQUAL(max_record, full_record);
+
+    /* A window with room for a single segment gets records that each fit in one segment */
+    struct s2n_tcp_info sample = {.snd_cwnd = 10,.unacked = 10,.snd_mss = 1000,.rtt = 10000000 };
+    EXPECT_SUCCESS(s2n_connection_set_tcp_info_cb(server_conn, tcp_info_cb, &sample));
+    EXPECT_SUCCESS(send_and_measure(server_conn, server_to_client[0], &min_record, &max_record));
+    EXPECT_TRUE(max_record <= 1000);
+    EXPECT_TRUE(max_record > 900);
+
+    /* The window is sampled at most once a round trip */
+    sample.unacked = 0;
+    EXPECT_SUCCESS(send_and_measure(server_conn, server_to_client[0], &min_record, &max_record));
+    EXPECT_TRUE(max_record <= 1000);
+
+    /* A window with room for four segments gets records that span them */
+    sample.snd_cwnd = 4;
+    EXPECT_SUCCESS(s2n_connection_set_tcp_info_cb(server_conn, tcp_info_cb, &sample));
+    EXPECT_SUCCESS(send_and_measure(server_conn, server_to_client[0], &min_record, &max_record));
+    EXPECT_TRUE(max_record <= 4000);
+    EXPECT_TRUE(max_record > 3900);
+
+    /* A window wider than a record is capped at the maximum record size */
+    sample.snd_cwnd = 100;
+    EXPECT_SUCCESS(s2n_connection_set_tcp_info_cb(server_conn, tcp_info_cb, &sample));
+    EXPECT_SUCCESS(send_and_measure(server_conn, server_to_client[0], &min_record, &max_record));
+    EXPECT_EQUAL(max_record, full_record);
+
+    /* A segment too small to hold a record header is ignored */
+    sample.snd_mss = S2N_TLS_RECORD_HEADER_LENGTH;
+    EXPECT_SUCCESS(s2n_connection_set_tcp_info_cb(server_conn, tcp_info_cb, &sample));
+    EXPECT_SUCCESS(send_and_measure(server_conn, server_to_client[0], &min_record, &max_record));
+    EXPECT_EQUAL(max_record, full_record);
+
+    EXPECT_SUCCESS(s2n_connection_free(server_conn));
+    EXPECT_SUCCESS(s2n_connection_free(client_conn));
+    for (int i = 0; i < 2; i++) {
+        EXPECT_SUCCESS(close(server_to_client[i]));
+        EXPECT_SUCCESS(close(client_to_server[i]));
+    }
+
+    EXPECT_SUCCESS(s2n_config_free(server_config));
+    EXPECT_SUCCESS(s2n_config_free(client_config));
+    free(cert_chain);
+    free(private_key);
+
+    END_TEST();
+}
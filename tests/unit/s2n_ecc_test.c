@@ -17,24 +17,27 @@
 
 #include <s2n.h>
 
+#include "testlib/s2n_testlib.h"
+
 #include "crypto/s2n_ecc.h"
+#include "crypto/s2n_openssl_evp.h"
+#include "tls/s2n_tls_parameters.h"
 #include "utils/s2n_mem.h"
 
-static int s2n_test_compare_ecc_keys(EC_KEY *key1, EC_KEY *key2)
+static int s2n_test_compare_ecc_keys(EVP_PKEY *key1, EVP_PKEY *key2)
 {
-    /* Both EC_cmp functions return 0 on equal, 1 on not equal, and -1 on error */
-
-    if (EC_GROUP_cmp(EC_KEY_get0_group(key1), EC_KEY_get0_group(key2), NULL) != 0) {
-        return 0;
-    }
-
-    if (EC_POINT_cmp(EC_KEY_get0_group(key1), EC_KEY_get0_public_key(key1), EC_KEY_get0_public_key(key2), NULL) != 0) {
-        return 0;
-    }
-
-    return 1;
+    /* EVP_PKEY_cmp compares the public components and returns 1 on equal */
+    return EVP_PKEY_cmp(key1, key2) == 1;
 }
 
+#if S2N_ECC_X25519_SUPPORTED
+/* Test vectors from https://tools.ietf.org/html/rfc7748#section-6.1 */
+#define X25519_ALICE_PRIVATE "77076d0a7318a57d3c16c17251b26645df4c2f87ebc0992ab177fba51db92c2a"
+#define X25519_ALICE_PUBLIC  "8520f0098930a754748b7ddcb43ef75a0dbf3a0d26381af4eba4a98eaa9b4e6a"
+#define X25519_BOB_PUBLIC    "de9edb7d7b7dc1b4d35b61c2ece435373f8343c85b78674dadfc7e146f882b4f"
+#define X25519_SHARED_SECRET "4a5d9d5ba4ce2de1728e3bf480350f25e07e21c947d19e3376f09b3c1e161742"
+#endif
+
 int main(int argc, char **argv)
 {
     BEGIN_TEST();
@@ -57,9 +60,11 @@ int main(int argc, char **argv)
             /* Verify output is of the right length */
             EXPECT_EQUAL(s2n_stuffer_data_available(&wire), s2n_ecc_supported_curves[i].share_size);
 
-            /* Verify output starts with the known legacy form */
-            EXPECT_SUCCESS(s2n_stuffer_read_uint8(&wire, &legacy_form));
-            EXPECT_EQUAL(legacy_form, 4);
+            /* Verify output of the NIST curves starts with the known legacy form */
+            if (s2n_ecc_supported_curves[i].iana_id != TLS_EC_CURVE_ECDH_X25519) {
+                EXPECT_SUCCESS(s2n_stuffer_read_uint8(&wire, &legacy_form));
+                EXPECT_EQUAL(legacy_form, 4);
+            }
 
             EXPECT_SUCCESS(s2n_ecc_params_free(&test_params));
             EXPECT_SUCCESS(s2n_stuffer_free(&wire));
@@ -114,7 +119,7 @@ int main(int argc, char **argv)
             EXPECT_SUCCESS(s2n_ecc_parse_ecc_params_point(&read_params, &point_blob));
 
             /* Check that the point we read is the same we wrote */
-            EXPECT_TRUE(s2n_test_compare_ecc_keys(write_params.ec_key, read_params.ec_key));
+            EXPECT_TRUE(s2n_test_compare_ecc_keys(write_params.evp_pkey, read_params.evp_pkey));
 
             EXPECT_SUCCESS(s2n_ecc_params_free(&write_params));
             EXPECT_SUCCESS(s2n_ecc_params_free(&read_params));
@@ -159,5 +164,78 @@ int main(int argc, char **argv)
         EXPECT_SUCCESS(s2n_ecc_params_free(&client_params));
     }
 
+#if S2N_ECC_X25519_SUPPORTED
+    /* x25519 is the most preferred curve */
+    EXPECT_EQUAL(s2n_ecc_supported_curves[0].iana_id, TLS_EC_CURVE_ECDH_X25519);
+    EXPECT_EQUAL(s2n_ecc_supported_curves[0].share_size, 32);
+
+    /* The server picks x25519 whenever the client offers it, wherever it is in the client's list */
+    {
+        const struct s2n_ecc_named_curve *found = NULL;
+        uint8_t client_curves[] = { 0x00, TLS_EC_CURVE_SECP_256_R1, 0x00, TLS_EC_CURVE_ECDH_X25519 };
+        struct s2n_blob client_curves_blob = { .data = client_curves, .size = sizeof(client_curves) };
+
+        EXPECT_SUCCESS(s2n_ecc_find_supported_curve(&client_curves_blob, &found));
+        EXPECT_EQUAL(found->iana_id, TLS_EC_CURVE_ECDH_X25519);
+
+        /* Clients that don't offer x25519 still get a NIST curve */
+        client_curves_blob.size = 2;
+        EXPECT_SUCCESS(s2n_ecc_find_supported_curve(&client_curves_blob, &found));
+        EXPECT_EQUAL(found->iana_id, TLS_EC_CURVE_SECP_256_R1);
+    }
+
+    /* Known answer test for x25519 */
+    {
+        struct s2n_ecc_params server_params = {0};
+        struct s2n_stuffer alice_private, alice_public, bob_public, expected_secret, wire;
+        struct s2n_blob shared = {0};
+
+        EXPECT_SUCCESS(s2n_stuffer_alloc_ro_from_hex_string(&alice_private, X25519_ALICE_PRIVATE));
+        EXPECT_SUCCESS(s2n_stuffer_alloc_ro_from_hex_string(&alice_public, X25519_ALICE_PUBLIC));
+        EXPECT_SUCCESS(s2n_stuffer_alloc_ro_from_hex_string(&bob_public, X25519_BOB_PUBLIC));
+        EXPECT_SUCCESS(s2n_stuffer_alloc_ro_from_hex_string(&expected_secret, X25519_SHARED_SECRET));
+
+        /* The server is Alice */
+        server_params.negotiated_curve = &s2n_ecc_supported_curves[0];
+        EXPECT_NOT_NULL(server_params.evp_pkey = EVP_PKEY_new_raw_private_key(NID_X25519, NULL,
+                alice_private.blob.data, alice_private.blob.size));
+
+        /* Alice's public share is the raw 32 byte value */
+        EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&wire, 1024));
+        EXPECT_SUCCESS(s2n_ecc_write_ecc_params_point(&server_params, &wire));
+        EXPECT_EQUAL(s2n_stuffer_data_available(&wire), 32);
+        EXPECT_BYTEARRAY_EQUAL(wire.blob.data, alice_public.blob.data, 32);
+
+        /* Bob sends his public share in the ClientKeyExchange */
+        EXPECT_SUCCESS(s2n_stuffer_wipe(&wire));
+        EXPECT_SUCCESS(s2n_stuffer_write_uint8(&wire, 32));
+        EXPECT_SUCCESS(s2n_stuffer_write(&wire, &bob_public.blob));
+        EXPECT_SUCCESS(s2n_ecc_compute_shared_secret_as_server(&server_params, &wire, &shared));
+        EXPECT_EQUAL(shared.size, 32);
+        EXPECT_BYTEARRAY_EQUAL(shared.data, expected_secret.blob.data, 32);
+        EXPECT_SUCCESS(s2n_free(&shared));
+
+        /* Shares of the wrong size are rejected */
+        EXPECT_SUCCESS(s2n_stuffer_wipe(&wire));
+        EXPECT_SUCCESS(s2n_stuffer_write_uint8(&wire, 31));
+        EXPECT_SUCCESS(s2n_stuffer_write_bytes(&wire, bob_public.blob.data, 31));
+        EXPECT_FAILURE(s2n_ecc_compute_shared_secret_as_server(&server_params, &wire, &shared));
+
+        /* A low order point, which gives an all zero shared secret, is rejected */
+        uint8_t zero_point[32] = { 0 };
+        EXPECT_SUCCESS(s2n_stuffer_wipe(&wire));
+        EXPECT_SUCCESS(s2n_stuffer_write_uint8(&wire, sizeof(zero_point)));
+        EXPECT_SUCCESS(s2n_stuffer_write_bytes(&wire, zero_point, sizeof(zero_point)));
+        EXPECT_FAILURE(s2n_ecc_compute_shared_secret_as_server(&server_params, &wire, &shared));
+
+        EXPECT_SUCCESS(s2n_ecc_params_free(&server_params));
+        EXPECT_SUCCESS(s2n_stuffer_free(&wire));
+        EXPECT_SUCCESS(s2n_stuffer_free(&alice_private));
+        EXPECT_SUCCESS(s2n_stuffer_free(&alice_public));
+        EXPECT_SUCCESS(s2n_stuffer_free(&bob_public));
+        EXPECT_SUCCESS(s2n_stuffer_free(&expected_secret));
+    }
+#endif
+
     END_TEST();
 }
@@ -0,0 +1,252 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+
+#include "testlib/s2n_testlib.h"
+
+#include <fcntl.h>
+#include <string.h>
+
+#include <s2n.h>
+
+#include "crypto/s2n_cipher.h"
+#include "crypto/s2n_hmac.h"
+
+#include "stuffer/s2n_stuffer.h"
+
+#include "tls/s2n_cipher_preferences.h"
+#include "tls/s2n_cipher_suites.h"
+#include "tls/s2n_connection.h"
+#include "tls/s2n_record.h"
+#include "tls/s2n_tls.h"
+
+#include "utils/s2n_random.h"
+#include "utils/s2n_safety.h"
+
+static int copy_record(struct s2n_connection *conn)
+{
+    GUARD(s2n_stuffer_wipe(&conn->in));
+    GUARD(s2n_stuffer_wipe(&conn->header_in));
+    GUARD(s2n_stuffer_copy(&conn->out, &conn->header_in, S2N_TLS_RECORD_HEADER_LENGTH));
+    GUARD(s2n_stuffer_copy(&conn->out, &conn->in, s2n_stuffer_data_available(&conn->out)));
+
+    uint8_t content_type;
+    uint16_t fragment_length;
+    GUARD(s2n_record_header_parse(conn, &content_type, &fragment_length));
+
+    return fragment_length;
+}
+
+int main(int argc, char **argv)
+{
+    struct s2n_connection *conn;
+    uint8_t mac_key[] = "sample mac key";
+    uint8_t aes128_key[] = "123456789012345";
+    struct s2n_blob aes128 = {.data = aes128_key,.size = sizeof(aes128_key) };
+    uint8_t random_data[S2N_DEFAULT_FRAGMENT_LENGTH + 1];
+    struct s2n_blob r = {.data = random_data, .size = sizeof(random_data)};
+
+    BEGIN_TEST();
+
+    EXPECT_SUCCESS(setenv("S2N_DONT_MLOCK", "1", 0));
+
+    /* CBC records are MACed after encryption, and tampering is caught before decryption */
+    {
+        EXPECT_NOT_NULL(conn = s2n_connection_new(S2N_SERVER));
+        EXPECT_SUCCESS(s2n_get_urandom_data(&r));
+
+        /* Peer and we are in sync */
+        conn->server = &conn->secure;
+        conn->client = &conn->secure;
+        conn->encrypt_then_mac = 1;
+
+        conn->secure.cipher_suite->record_alg = &s2n_record_alg_aes128_sha;
+        EXPECT_SUCCESS(conn->secure.cipher_suite->record_alg->cipher->init(&conn->secure.server_key));
+        EXPECT_SUCCESS(conn->secure.cipher_suite->record_alg->cipher->init(&conn->secure.client_key));
+        EXPECT_SUCCESS(conn->secure.cipher_suite->record_alg->cipher->set_encryption_key(&conn->secure.server_key, &aes128));
+        EXPECT_SUCCESS(conn->secure.cipher_suite->record_alg->cipher->set_decryption_key(&conn->secure.client_key, &aes128));
+        EXPECT_SUCCESS(s2n_hmac_init(&conn->secure.client_record_mac, S2N_HMAC_SHA1, mac_key, sizeof(mac_key)));
+        EXPECT_SUCCESS(s2n_hmac_init(&conn->secure.server_record_mac, S2N_HMAC_SHA1, mac_key, sizeof(mac_key)));
+
+        uint8_t proto_versions[3] = { S2N_TLS10, S2N_TLS11, S2N_TLS12 };
+        for (int j = 0; j < 3; j++) {
+            conn->actual_protocol_version = proto_versions[j];
+            int explicit_iv_len = proto_versions[j] > S2N_TLS10 ? 16 : 0;
+
+            /* The MAC isn't padded, so full records are a block longer than with MAC-then-encrypt */
+            int max_payload_size = s2n_record_max_write_payload_size(conn);
+            EXPECT_EQUAL((max_payload_size + 1) % 16, 0);
+            EXPECT_EQUAL(explicit_iv_len + max_payload_size + 1 + 20, S2N_DEFAULT_FRAGMENT_LENGTH - ((S2N_DEFAULT_FRAGMENT_LENGTH - 20) % 16));
+
+            for (int i = 0; i <= max_payload_size + 1; i++) {
+                struct s2n_blob in = {.data = random_data,.size = i };
+                int bytes_written;
+
+                EXPECT_SUCCESS(s2n_stuffer_wipe(&conn->out));
+                EXPECT_SUCCESS(bytes_written = s2n_record_write(conn, TLS_APPLICATION_DATA, &in));
+                EXPECT_EQUAL(bytes_written, i < max_payload_size ? i : max_payload_size);
+
+                uint16_t predicted_length = bytes_written + 1;
+                if (predicted_length % 16) {
+                    predicted_length += (16 - (predicted_length % 16));
+                }
+                predicted_length += explicit_iv_len + 20;
+
+                EXPECT_EQUAL(copy_record(conn), predicted_length);
+                EXPECT_SUCCESS(s2n_record_parse(conn));
+                EXPECT_EQUAL(s2n_stuffer_data_available(&conn->in), bytes_written);
+                EXPECT_EQUAL(memcmp(s2n_stuffer_raw_read(&conn->in, bytes_written), random_data, bytes_written), 0);
+            }
+
+            /* Flip a bit in the ciphertext, the padding length byte and the MAC */
+            int offsets[3] = { S2N_TLS_RECORD_HEADER_LENGTH + explicit_iv_len, S2N_TLS_RECORD_HEADER_LENGTH + explicit_iv_len + 15,
+                               S2N_TLS_RECORD_HEADER_LENGTH + explicit_iv_len + 16 };
+            for (int i = 0; i < 3; i++) {
+                struct s2n_blob in = {.data = random_data,.size = 10 };
+                EXPECT_SUCCESS(s2n_stuffer_wipe(&conn->out));
+                EXPECT_SUCCESS(s2n_record_write(conn, TLS_APPLICATION_DATA, &in));
+                conn->out.blob.data[offsets[i]] ^= 1;
+
+                EXPECT_EQUAL(copy_record(conn), explicit_iv_len + 16 + 20);
+                EXPECT_FAILURE_WITH_ERRNO(s2n_record_parse(conn), S2N_ERR_BAD_MESSAGE);
+            }
+        }
+
+        EXPECT_SUCCESS(conn->secure.cipher_suite->record_alg->cipher->destroy_key(&conn->secure.server_key));
+        EXPECT_SUCCESS(conn->secure.cipher_suite->record_alg->cipher->destroy_key(&conn->secure.client_key));
+        conn->secure.cipher_suite->record_alg = &s2n_record_alg_null;
+        EXPECT_SUCCESS(s2n_connection_free(conn));
+    }
+
+    /* Every CBC suite has an Encrypt-then-MAC version that doesn't use a composite cipher */
+    {
+        struct s2n_cipher_suite *cbc_suites[] = { &s2n_rsa_with_aes_128_cbc_sha, &s2n_ecdhe_rsa_with_aes_256_cbc_sha384,
+                                                  &s2n_dhe_rsa_with_aes_256_cbc_sha256, &s2n_rsa_with_3des_ede_cbc_sha };
+        for (int i = 0; i < s2n_array_len(cbc_suites); i++) {
+            EXPECT_NOT_NULL(cbc_suites[i]->etm_cipher_suite);
+            EXPECT_EQUAL(cbc_suites[i]->etm_cipher_suite->record_alg->cipher->type, S2N_CBC);
+            EXPECT_EQUAL(memcmp(cbc_suites[i]->etm_cipher_suite->iana_value, cbc_suites[i]->iana_value, S2N_TLS_CIPHER_SUITE_LEN), 0);
+        }
+
+        EXPECT_NULL(s2n_ecdhe_rsa_with_aes_128_gcm_sha256.etm_cipher_suite);
+        EXPECT_NULL(s2n_rsa_with_rc4_128_sha.etm_cipher_suite);
+    }
+
+    /* The client only accepts Encrypt-then-MAC if it offered it, and for a CBC suite */
+    {
+        uint8_t extension[] = { 0x00, TLS_EXTENSION_ENCRYPT_THEN_MAC, 0x00, 0x00 };
+        struct s2n_blob extension_blob = {.data = extension,.size = sizeof(extension) };
+
+        EXPECT_NOT_NULL(conn = s2n_connection_new(S2N_CLIENT));
+        conn->actual_protocol_version = S2N_TLS12;
+        conn->secure.cipher_suite = &s2n_ecdhe_rsa_with_aes_128_cbc_sha;
+        EXPECT_FAILURE_WITH_ERRNO(s2n_server_extensions_recv(conn, &extension_blob), S2N_ERR_BAD_MESSAGE);
+
+        conn->encrypt_then_mac_requested = 1;
+        conn->secure.cipher_suite = &s2n_ecdhe_rsa_with_aes_128_gcm_sha256;
+        EXPECT_FAILURE_WITH_ERRNO(s2n_server_extensions_recv(conn, &extension_blob), S2N_ERR_ENCRYPT_THEN_MAC_NOT_CBC);
+        EXPECT_EQUAL(conn->encrypt_then_mac, 0);
+
+        conn->secure.cipher_suite = &s2n_ecdhe_rsa_with_aes_128_cbc_sha;
+        EXPECT_SUCCESS(s2n_server_extensions_recv(conn, &extension_blob));
+        EXPECT_EQUAL(conn->encrypt_then_mac, 1);
+        EXPECT_EQUAL(conn->secure.cipher_suite, s2n_ecdhe_rsa_with_aes_128_cbc_sha.etm_cipher_suite);
+
+        EXPECT_SUCCESS(s2n_connection_free(conn));
+    }
+
+    /* Encrypt-then-MAC is negotiated for CBC suites only */
+    {
+        struct s2n_config *server_config;
+        struct s2n_config *client_config;
+        struct s2n_connection *server_conn;
+        struct s2n_connection *client_conn;
+        int server_to_client[2];
+        int client_to_server[2];
+        char *cert_chain;
+        char *private_key;
+        s2n_blocked_status blocked;
+        uint8_t received[sizeof(random_data)];
+
+        EXPECT_NOT_NULL(cert_chain = malloc(S2N_MAX_TEST_PEM_SIZE));
+        EXPECT_NOT_NULL(private_key = malloc(S2N_MAX_TEST_PEM_SIZE));
+        EXPECT_SUCCESS(s2n_read_test_pem(S2N_DEFAULT_TEST_CERT_CHAIN, cert_chain, S2N_MAX_TEST_PEM_SIZE));
+        EXPECT_SUCCESS(s2n_read_test_pem(S2N_DEFAULT_TEST_PRIVATE_KEY, private_key, S2N_MAX_TEST_PEM_SIZE));
+
+        EXPECT_NOT_NULL(server_config = s2n_config_new());
+        EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key(server_config, cert_chain, private_key));
+        EXPECT_NOT_NULL(client_config = s2n_config_new());
+        EXPECT_SUCCESS(s2n_config_disable_x509_verification(client_config));
+
+        EXPECT_SUCCESS(pipe(server_to_client));
+        EXPECT_SUCCESS(pipe(client_to_server));
+        for (int i = 0; i < 2; i++) {
+            EXPECT_NOT_EQUAL(fcntl(server_to_client[i], F_SETFL, fcntl(server_to_client[i], F_GETFL) | O_NONBLOCK), -1);
+            EXPECT_NOT_EQUAL(fcntl(client_to_server[i], F_SETFL, fcntl(client_to_server[i], F_GETFL) | O_NONBLOCK), -1);
+        }
+
+        /* The default preferences pick an AEAD suite */
+        EXPECT_SUCCESS(s2n_new_test_server_and_client(&server_conn, &client_conn, server_config, client_config, server_to_client, client_to_server));
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+        EXPECT_EQUAL(server_conn->encrypt_then_mac_requested, 1);
+        EXPECT_EQUAL(server_conn->encrypt_then_mac, 0);
+        EXPECT_EQUAL(client_conn->encrypt_then_mac, 0);
+        EXPECT_SUCCESS(s2n_shutdown_test_server_and_client(server_conn, client_conn));
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+
+        /* Both sides switch to the plain CBC record algorithm */
+        struct s2n_cipher_suite *cbc_suites[] = { &s2n_ecdhe_rsa_with_aes_128_cbc_sha };
+        const struct s2n_cipher_preferences cbc_preferences = {
+            .count = 1,
+            .suites = cbc_suites,
+            .minimum_protocol_version = S2N_TLS10,
+        };
+        server_config->cipher_preferences = &cbc_preferences;
+
+        EXPECT_SUCCESS(s2n_new_test_server_and_client(&server_conn, &client_conn, server_config, client_config, server_to_client, client_to_server));
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+        EXPECT_EQUAL(server_conn->encrypt_then_mac, 1);
+        EXPECT_EQUAL(client_conn->encrypt_then_mac, 1);
+        EXPECT_EQUAL(server_conn->secure.cipher_suite->record_alg->cipher->type, S2N_CBC);
+        EXPECT_EQUAL(client_conn->secure.cipher_suite->record_alg->cipher->type, S2N_CBC);
+
+        EXPECT_EQUAL(s2n_send(client_conn, random_data, sizeof(random_data), &blocked), sizeof(random_data));
+        int received_len = 0;
+        while (received_len < sizeof(random_data)) {
+            int n;
+            EXPECT_SUCCESS(n = s2n_recv(server_conn, received + received_len, sizeof(received) - received_len, &blocked));
+            received_len += n;
+        }
+        EXPECT_EQUAL(memcmp(received, random_data, sizeof(random_data)), 0);
+
+        EXPECT_SUCCESS(s2n_shutdown_test_server_and_client(server_conn, client_conn));
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+
+        for (int i = 0; i < 2; i++) {
+            EXPECT_SUCCESS(close(server_to_client[i]));
+            EXPECT_SUCCESS(close(client_to_server[i]));
+        }
+
+        EXPECT_SUCCESS(s2n_config_free(server_config));
+        EXPECT_SUCCESS(s2n_config_free(client_config));
+        free(cert_chain);
+        free(private_key);
+    }
+
+    END_TEST();
+}
@@ -0,0 +1,330 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+
+#include "testlib/s2n_testlib.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+
+#include <s2n.h>
+
+#include "pq-crypto/sike/sike_p503_kem.h"
+
+#include "tls/s2n_cipher_preferences.h"
+#include "tls/s2n_cipher_suites.h"
+#include "tls/s2n_config.h"
+#include "tls/s2n_connection.h"
+#include "tls/s2n_ephemeral_key_pool.h"
+#include "tls/s2n_kem.h"
+
+#include "utils/s2n_random.h"
+
+#define POOL_SIZE 4
+
+static void *refill_thread(void *config)
+{
+    int result = s2n_config_refill_ephemeral_key_pool(config);
+
+    /* Key generation seeds this thread's DRBGs */
+    s2n_rand_cleanup_thread();
+
+    return result < 0 ? config : NULL;
+}
+
+int main(int argc, char **argv)
+{
+    struct s2n_config *config;
+    char *cert_chain;
+    char *private_key;
+    char *dhparams;
+    uint64_t hits;
+    uint64_t misses;
+
+    BEGIN_TEST();
+
+    EXPECT_SUCCESS(setenv("S2N_DONT_MLOCK", "1", 0));
+
+    EXPECT_NOT_NULL(cert_chain = malloc(S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_NOT_NULL(private_key = malloc(S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_NOT_NULL(dhparams = malloc(S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_SUCCESS(s2n_read_test_pem(S2N_DEFAULT_TEST_CERT_CHAIN, cert_chain, S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_SUCCESS(s2n_read_test_pem(S2N_DEFAULT_TEST_PRIVATE_KEY, private_key, S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_SUCCESS(s2n_read_test_pem(S2N_DEFAULT_TEST_DHPARAMS, dhparams, S2N_MAX_TEST_PEM_SIZE));
+
+    /* The pool is disabled by default */
+    {
+        EXPECT_NOT_NULL(config = s2n_config_new());
+        EXPECT_NULL(config->ephemeral_key_pool);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_config_refill_ephemeral_key_pool(config), S2N_ERR_EPHEMERAL_KEY_POOL_DISABLED);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_config_get_ephemeral_key_pool_stats(config, &hits, &misses), S2N_ERR_EPHEMERAL_KEY_POOL_DISABLED);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_config_set_ephemeral_key_pool_size(config, S2N_EPHEMERAL_KEY_POOL_MAX_SIZE + 1), S2N_ERR_INVALID_ARGUMENT);
+
+        /* Without a pool keys are still generated */
+        struct s2n_ecc_params ecc_params = { .negotiated_curve = &s2n_ecc_supported_curves[0] };
+        EXPECT_SUCCESS(s2n_ephemeral_key_pool_ecc_generate_ephemeral_key(config, &ecc_params));
+        EXPECT_NOT_NULL(ecc_params.evp_pkey);
+        EXPECT_SUCCESS(s2n_ecc_params_free(&ecc_params));
+
+        EXPECT_SUCCESS(s2n_config_set_ephemeral_key_pool_size(config, POOL_SIZE));
+        EXPECT_NOT_NULL(config->ephemeral_key_pool);
+        EXPECT_SUCCESS(s2n_config_get_ephemeral_key_pool_stats(config, &hits, &misses));
+        EXPECT_EQUAL(hits, 0);
+        EXPECT_EQUAL(misses, 0);
+
+        EXPECT_SUCCESS(s2n_config_set_ephemeral_key_pool_size(config, 0));
+        EXPECT_NULL(config->ephemeral_key_pool);
+        EXPECT_SUCCESS(s2n_config_free(config));
+    }
+
+    /* ECDHE keys are taken from the pool exactly once, then generated inline */
+    {
+        EXPECT_NOT_NULL(config = s2n_config_new());
+        EXPECT_SUCCESS(s2n_config_set_ephemeral_key_pool_size(config, POOL_SIZE));
+        EXPECT_SUCCESS(s2n_config_refill_ephemeral_key_pool(config));
+
+        struct s2n_ephemeral_key_pool *pool = config->ephemeral_key_pool;
+        for (int i = 0; i < S2N_ECC_SUPPORTED_CURVES_COUNT; i++) {
+            EXPECT_EQUAL(pool->ecc_key_count[i], POOL_SIZE);
+        }
+        /* No DH parameters, so no DHE keys */
+        EXPECT_EQUAL(pool->dh_key_count, 0);
+
+        /* Refilling a full pool generates nothing */
+        EVP_PKEY *top = pool->ecc_keys[0][POOL_SIZE - 1].evp_pkey;
+        EXPECT_SUCCESS(s2n_config_refill_ephemeral_key_pool(config));
+        EXPECT_EQUAL(pool->ecc_key_count[0], POOL_SIZE);
+        EXPECT_EQUAL(pool->ecc_keys[0][POOL_SIZE - 1].evp_pkey, top);
+
+        struct s2n_ecc_params taken[POOL_SIZE + 1];
+        for (int i = 0; i <= POOL_SIZE; i++) {
+            taken[i].negotiated_curve = &s2n_ecc_supported_curves[0];
+            taken[i].evp_pkey = NULL;
+            EXPECT_SUCCESS(s2n_ephemeral_key_pool_ecc_generate_ephemeral_key(config, &taken[i]));
+            EXPECT_NOT_NULL(taken[i].evp_pkey);
+            for (int j = 0; j < i; j++) {
+                EXPECT_NOT_EQUAL(taken[i].evp_pkey, taken[j].evp_pkey);
+            }
+        }
+        EXPECT_EQUAL(taken[0].evp_pkey, top);
+        EXPECT_EQUAL(pool->ecc_key_count[0], 0);
+        EXPECT_NULL(pool->ecc_keys[0][0].evp_pkey);
+
+        EXPECT_SUCCESS(s2n_config_get_ephemeral_key_pool_stats(config, &hits, &misses));
+        EXPECT_EQUAL(hits, POOL_SIZE);
+        EXPECT_EQUAL(misses, 1);
+
+        for (int i = 0; i <= POOL_SIZE; i++) {
+            EXPECT_SUCCESS(s2n_ecc_params_free(&taken[i]));
+        }
+
+        /* Other curves are untouched */
+        for (int i = 1; i < S2N_ECC_SUPPORTED_CURVES_COUNT; i++) {
+            EXPECT_EQUAL(pool->ecc_key_count[i], POOL_SIZE);
+        }
+
+        /* Keys generated before a fork are thrown away */
+        pool->pid = 0;
+        struct s2n_ecc_params ecc_params = { .negotiated_curve = &s2n_ecc_supported_curves[1] };
+        EXPECT_SUCCESS(s2n_ephemeral_key_pool_ecc_generate_ephemeral_key(config, &ecc_params));
+        EXPECT_NOT_NULL(ecc_params.evp_pkey);
+        EXPECT_SUCCESS(s2n_ecc_params_free(&ecc_params));
+        for (int i = 0; i < S2N_ECC_SUPPORTED_CURVES_COUNT; i++) {
+            EXPECT_EQUAL(pool->ecc_key_count[i], 0);
+        }
+        EXPECT_SUCCESS(s2n_config_get_ephemeral_key_pool_stats(config, &hits, &misses));
+        EXPECT_EQUAL(hits, POOL_SIZE);
+        EXPECT_EQUAL(misses, 2);
+
+        EXPECT_SUCCESS(s2n_config_free(config));
+    }
+
+    /* DHE keys come from the config's DH parameters */
+    {
+        EXPECT_NOT_NULL(config = s2n_config_new());
+        EXPECT_SUCCESS(s2n_config_add_dhparams(config, dhparams));
+        EXPECT_SUCCESS(s2n_config_set_ephemeral_key_pool_size(config, 1));
+        EXPECT_SUCCESS(s2n_config_refill_ephemeral_key_pool(config));
+
+        struct s2n_ephemeral_key_pool *pool = config->ephemeral_key_pool;
+        EXPECT_EQUAL(pool->dh_key_count, 1);
+        EXPECT_EQUAL(pool->dh_source, config->dhparams);
+
+        struct s2n_dh_params first = {0};
+        struct s2n_dh_params second = {0};
+        EXPECT_SUCCESS(s2n_ephemeral_key_pool_dh_generate_ephemeral_key(config, &first));
+        EXPECT_SUCCESS(s2n_ephemeral_key_pool_dh_generate_ephemeral_key(config, &second));
+        EXPECT_SUCCESS(s2n_dh_params_check(&first));
+        EXPECT_SUCCESS(s2n_dh_params_check(&second));
+        EXPECT_NOT_EQUAL(first.dh, second.dh);
+        EXPECT_EQUAL(pool->dh_key_count, 0);
+
+        EXPECT_SUCCESS(s2n_config_get_ephemeral_key_pool_stats(config, &hits, &misses));
+        EXPECT_EQUAL(hits, 1);
+        EXPECT_EQUAL(misses, 1);
+
+        EXPECT_SUCCESS(s2n_dh_params_free(&first));
+        EXPECT_SUCCESS(s2n_dh_params_free(&second));
+        EXPECT_SUCCESS(s2n_config_free(config));
+    }
+
+    /* KEM keypairs are only pooled for KEMs the cipher preferences can negotiate */
+    {
+        struct s2n_cipher_suite *sike_suites[] = { &s2n_ecdhe_sike_rsa_with_aes_256_gcm_sha384 };
+        const struct s2n_cipher_preferences sike_preferences = {
+            .count = 1,
+            .suites = sike_suites,
+            .minimum_protocol_version = S2N_TLS12,
+        };
+        uint32_t depth;
+
+        EXPECT_NOT_NULL(config = s2n_config_new());
+        EXPECT_SUCCESS(s2n_config_set_ephemeral_key_pool_size(config, 2));
+        EXPECT_SUCCESS(s2n_config_refill_ephemeral_key_pool(config));
+        EXPECT_SUCCESS(s2n_config_get_ephemeral_key_pool_kem_stats(config, s2n_sike_p503_r1.name, &depth, &misses));
+        EXPECT_EQUAL(depth, 0);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_config_get_ephemeral_key_pool_kem_stats(config, "not-a-kem", &depth, &misses),
+                S2N_ERR_KEM_UNSUPPORTED_PARAMS);
+
+        config->cipher_preferences = &sike_preferences;
+        EXPECT_SUCCESS(s2n_config_refill_ephemeral_key_pool(config));
+        EXPECT_SUCCESS(s2n_config_get_ephemeral_key_pool_kem_stats(config, s2n_sike_p503_r1.name, &depth, &misses));
+        EXPECT_EQUAL(depth, 2);
+        EXPECT_EQUAL(misses, 0);
+        EXPECT_SUCCESS(s2n_config_get_ephemeral_key_pool_kem_stats(config, s2n_bike_1_level_1_r1.name, &depth, &misses));
+        EXPECT_EQUAL(depth, 0);
+
+        struct s2n_ephemeral_key_pool *pool = config->ephemeral_key_pool;
+        uint8_t public_keys[3][SIKE_P503_PUBLIC_KEY_BYTES];
+        struct s2n_kem_keypair taken[3];
+        for (int i = 0; i < 3; i++) {
+            memset(&taken[i], 0, sizeof(struct s2n_kem_keypair));
+            taken[i].negotiated_kem = &s2n_sike_p503_r1;
+            taken[i].public_key.data = public_keys[i];
+            taken[i].public_key.size = SIKE_P503_PUBLIC_KEY_BYTES;
+            EXPECT_SUCCESS(s2n_ephemeral_key_pool_kem_generate_keypair(config, &taken[i]));
+            EXPECT_EQUAL(taken[i].private_key.size, SIKE_P503_SECRET_KEY_BYTES);
+            for (int j = 0; j < i; j++) {
+                EXPECT_NOT_EQUAL(memcmp(public_keys[i], public_keys[j], SIKE_P503_PUBLIC_KEY_BYTES), 0);
+            }
+
+            /* The public and private halves still belong together */
+            struct s2n_blob client_secret = {0};
+            struct s2n_blob server_secret = {0};
+            uint8_t ciphertext_data[SIKE_P503_CIPHERTEXT_BYTES];
+            struct s2n_blob ciphertext = { .data = ciphertext_data, .size = sizeof(ciphertext_data) };
+            EXPECT_SUCCESS(s2n_kem_encapsulate(&taken[i], &client_secret, &ciphertext));
+            EXPECT_SUCCESS(s2n_kem_decapsulate(&taken[i], &server_secret, &ciphertext));
+            EXPECT_BYTEARRAY_EQUAL(client_secret.data, server_secret.data, SIKE_P503_SHARED_SECRET_BYTES);
+            EXPECT_SUCCESS(s2n_free(&client_secret));
+            EXPECT_SUCCESS(s2n_free(&server_secret));
+        }
+
+        /* Taken slots are cleared */
+        EXPECT_NULL(pool->kem_keys[1][0].private_key.data);
+        EXPECT_NULL(pool->kem_keys[1][1].private_key.data);
+
+        EXPECT_SUCCESS(s2n_config_get_ephemeral_key_pool_kem_stats(config, s2n_sike_p503_r1.name, &depth, &misses));
+        EXPECT_EQUAL(depth, 0);
+        EXPECT_EQUAL(misses, 1);
+        EXPECT_SUCCESS(s2n_config_get_ephemeral_key_pool_stats(config, &hits, &misses));
+        EXPECT_EQUAL(hits, 2);
+        EXPECT_EQUAL(misses, 1);
+
+        for (int i = 0; i < 3; i++) {
+            EXPECT_SUCCESS(s2n_kem_free(&taken[i]));
+        }
+
+        /* Keypairs left in the pool are wiped and freed with the config */
+        EXPECT_SUCCESS(s2n_config_refill_ephemeral_key_pool(config));
+        EXPECT_SUCCESS(s2n_config_free(config));
+    }
+
+    /* Concurrent refills never overfill the pool */
+    {
+        pthread_t threads[4];
+        void *result;
+
+        EXPECT_NOT_NULL(config = s2n_config_new());
+        EXPECT_SUCCESS(s2n_config_set_ephemeral_key_pool_size(config, POOL_SIZE));
+        for (int i = 0; i < 4; i++) {
+            EXPECT_EQUAL(pthread_create(&threads[i], NULL, refill_thread, config), 0);
+        }
+        for (int i = 0; i < 4; i++) {
+            EXPECT_EQUAL(pthread_join(threads[i], &result), 0);
+            EXPECT_NULL(result);
+        }
+        for (int i = 0; i < S2N_ECC_SUPPORTED_CURVES_COUNT; i++) {
+            EXPECT_EQUAL(config->ephemeral_key_pool->ecc_key_count[i], POOL_SIZE);
+        }
+        EXPECT_SUCCESS(s2n_config_free(config));
+    }
+
+    /* A full handshake takes its server key from the pool */
+    {
+        struct s2n_config *client_config;
+        struct s2n_connection *server_conn;
+        struct s2n_connection *client_conn;
+        int server_to_client[2];
+        int client_to_server[2];
+
+        EXPECT_NOT_NULL(config = s2n_config_new());
+        EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key(config, cert_chain, private_key));
+        EXPECT_SUCCESS(s2n_config_set_ephemeral_key_pool_size(config, POOL_SIZE));
+        EXPECT_SUCCESS(s2n_config_refill_ephemeral_key_pool(config));
+        EXPECT_NOT_NULL(client_config = s2n_config_new());
+        EXPECT_SUCCESS(s2n_config_disable_x509_verification(client_config));
+
+        EXPECT_SUCCESS(pipe(server_to_client));
+        EXPECT_SUCCESS(pipe(client_to_server));
+        for (int i = 0; i < 2; i++) {
+            EXPECT_NOT_EQUAL(fcntl(server_to_client[i], F_SETFL, fcntl(server_to_client[i], F_GETFL) | O_NONBLOCK), -1);
+            EXPECT_NOT_EQUAL(fcntl(client_to_server[i], F_SETFL, fcntl(client_to_server[i], F_GETFL) | O_NONBLOCK), -1);
+        }
+
+        EXPECT_NOT_NULL(server_conn = s2n_connection_new(S2N_SERVER));
+        EXPECT_SUCCESS(s2n_connection_set_config(server_conn, config));
+        EXPECT_SUCCESS(s2n_connection_set_read_fd(server_conn, client_to_server[0]));
+        EXPECT_SUCCESS(s2n_connection_set_write_fd(server_conn, server_to_client[1]));
+        EXPECT_NOT_NULL(client_conn = s2n_connection_new(S2N_CLIENT));
+        EXPECT_SUCCESS(s2n_connection_set_config(client_conn, client_config));
+        EXPECT_SUCCESS(s2n_connection_set_read_fd(client_conn, server_to_client[0]));
+        EXPECT_SUCCESS(s2n_connection_set_write_fd(client_conn, client_to_server[1]));
+
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+        EXPECT_NOT_NULL(server_conn->secure.server_ecc_params.negotiated_curve);
+
+        EXPECT_SUCCESS(s2n_config_get_ephemeral_key_pool_stats(config, &hits, &misses));
+        EXPECT_EQUAL(hits, 1);
+        EXPECT_EQUAL(misses, 0);
+
+        EXPECT_SUCCESS(s2n_shutdown_test_server_and_client(server_conn, client_conn));
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+        EXPECT_SUCCESS(s2n_config_free(config));
+        EXPECT_SUCCESS(s2n_config_free(client_config));
+        for (int i = 0; i < 2; i++) {
+            EXPECT_SUCCESS(close(server_to_client[i]));
+            EXPECT_SUCCESS(close(client_to_server[i]));
+        }
+    }
+
+    free(cert_chain);
+    free(private_key);
+    free(dhparams);
+
+    END_TEST();
+}
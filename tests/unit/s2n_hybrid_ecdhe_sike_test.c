@@ -29,6 +29,7 @@
 #include "tls/s2n_kex.h"
 #include "tls/s2n_kem.h"
 #include "tls/s2n_tls.h"
+#include "tls/s2n_tls_parameters.h"
 
 #include "utils/s2n_random.h"
 #include "utils/s2n_safety.h"
@@ -55,7 +56,12 @@ int s2n_entropy_generator(struct s2n_blob *blob)
 
 int setup_connection(struct s2n_connection *conn) {
     conn->actual_protocol_version = S2N_TLS12;
-    conn->secure.server_ecc_params.negotiated_curve = &s2n_ecc_supported_curves[0];
+    /* The known answers were generated with secp256r1 */
+    for (int i = 0; i < S2N_ECC_SUPPORTED_CURVES_COUNT; i++) {
+        if (s2n_ecc_supported_curves[i].iana_id == TLS_EC_CURVE_SECP_256_R1) {
+            conn->secure.server_ecc_params.negotiated_curve = &s2n_ecc_supported_curves[i];
+        }
+    }
     conn->secure.s2n_kem_keys.negotiated_kem = &s2n_sike_p503_r1;
     conn->secure.cipher_suite = &s2n_ecdhe_sike_rsa_with_aes_256_gcm_sha384;
     conn->secure.conn_hash_alg = S2N_HASH_SHA384;
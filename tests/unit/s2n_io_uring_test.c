@@ -0,0 +1,339 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+
+#include "testlib/s2n_testlib.h"
+
+#include <string.h>
+#include <sys/socket.h>
+
+#include <s2n.h>
+
+#include "tls/s2n_connection.h"
+#include "tls/s2n_handshake.h"
+#include "utils/s2n_random.h"
+#include "utils/s2n_safety.h"
+
+static int is_blocked(int r)
+{
+    return r < 0 && s2n_error_get_type(s2n_errno) == S2N_ERR_T_BLOCKED;
+}
+
+static int negotiate(struct s2n_io_uring *ring, struct s2n_connection *server_conn, struct s2n_connection *client_conn)
+{
+    s2n_blocked_status blocked;
+    struct s2n_connection *ready[2];
+    int server_done = 0;
+    int client_done = 0;
+
+    while (!server_done || !client_done) {
+        if (!client_done) {
+            int r = s2n_negotiate(client_conn, &blocked);
+            S2N_ERROR_IF(r < 0 && !is_blocked(r), S2N_ERR_IO);
+            client_done = r == 0;
+        }
+        if (!server_done) {
+            int r = s2n_negotiate(server_conn, &blocked);
+            S2N_ERROR_IF(r < 0 && !is_blocked(r), S2N_ERR_IO);
+            server_done = r == 0;
+        }
+        GUARD(s2n_io_uring_submit(ring, server_done && client_done ? 0 : 1, ready, 2));
+    }
+
+    return 0;
+}
+
+static int send_and_recv(struct s2n_io_uring *ring, struct s2n_connection *sender, struct s2n_connection *receiver,
+                         uint8_t *data, uint8_t *received, ssize_t size)
+{
+    s2n_blocked_status blocked;
+    struct s2n_connection *ready[2];
+    ssize_t sent = 0;
+    ssize_t recvd = 0;
+
+    while (recvd < size) {
+        if (sent < size) {
+            ssize_t r = s2n_send(sender, data + sent, size - sent, &blocked);
+            S2N_ERROR_IF(r < 0 && !is_blocked(r), S2N_ERR_IO);
+            sent += r > 0 ? r : 0;
+        }
+
+        ssize_t r = s2n_recv(receiver, received + recvd, size - recvd, &blocked);
+        S2N_ERROR_IF(r == 0 || (r < 0 && !is_blocked(r)), S2N_ERR_IO);
+        recvd += r > 0 ? r : 0;
+
+        /* Only wait when the receiver is blocked, since a read that can make progress has nothing in flight */
+        GUARD(s2n_io_uring_submit(ring, r < 0 ? 1 : 0, ready, 2));
+    }
+
+    return 0;
+}
+
+static int shutdown_and_drain(struct s2n_io_uring *ring, struct s2n_connection *server_conn, struct s2n_connection *client_conn)
+{
+    s2n_blocked_status blocked;
+    struct s2n_connection *ready[2];
+    int server_done = 0;
+    int client_done = 0;
+
+    while (!server_done || !client_done) {
+        if (!server_done) {
+            int r = s2n_shutdown(server_conn, &blocked);
+            S2N_ERROR_IF(r < 0 && !is_blocked(r), S2N_ERR_IO);
+            server_done = r == 0;
+        }
+        if (!client_done) {
+            int r = s2n_shutdown(client_conn, &blocked);
+            S2N_ERROR_IF(r < 0 && !is_blocked(r), S2N_ERR_IO);
+            client_done = r == 0;
+        }
+        GUARD(s2n_io_uring_submit(ring, server_done && client_done ? 0 : 1, ready, 2));
+    }
+
+    /* Wait for the close_notify alerts to reach the sockets before letting go of them */
+    while (s2n_connection_io_uring_pending(server_conn) || s2n_connection_io_uring_pending(client_conn)) {
+        GUARD(s2n_io_uring_submit(ring, 1, ready, 2));
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    struct s2n_config *server_config;
+    struct s2n_config *client_config;
+    struct s2n_io_uring *ring;
+    char *cert_chain;
+    char *private_key;
+
+    static uint8_t data[100000];
+    static uint8_t received[100000];
+    struct s2n_blob data_blob = {.data = data,.size = sizeof(data) };
+
+    BEGIN_TEST();
+
+    /* Kernels without io_uring, or sandboxes that block it, have nothing to test */
+    if ((ring = s2n_io_uring_new(2)) == NULL) {
+        EXPECT_EQUAL(s2n_errno, S2N_ERR_IO_URING_UNSUPPORTED);
+        END_TEST();
+    }
+    EXPECT_SUCCESS(s2n_io_uring_free(ring));
+
+    EXPECT_SUCCESS(s2n_get_urandom_data(&data_blob));
+
+    EXPECT_NOT_NULL(cert_chain = malloc(S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_NOT_NULL(private_key = malloc(S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_SUCCESS(s2n_read_test_pem(S2N_DEFAULT_TEST_CERT_CHAIN, cert_chain, S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_SUCCESS(s2n_read_test_pem(S2N_DEFAULT_TEST_PRIVATE_KEY, private_key, S2N_MAX_TEST_PEM_SIZE));
+
+    EXPECT_NOT_NULL(server_config = s2n_config_new());
+    EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key(server_config, cert_chain, private_key));
+    EXPECT_NOT_NULL(client_config = s2n_config_new());
+    EXPECT_SUCCESS(s2n_config_disable_x509_verification(client_config));
+
+    /* Argument checks */
+    {
+        struct s2n_connection *conn;
+        int fds[2];
+
+        EXPECT_NULL(s2n_io_uring_new(0));
+        EXPECT_EQUAL(s2n_errno, S2N_ERR_IO_URING_SIZE);
+
+        EXPECT_NOT_NULL(ring = s2n_io_uring_new(1));
+        EXPECT_SUCCESS(socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+        /* A connection reading and writing its own file descriptors can't also use the ring */
+        EXPECT_NOT_NULL(conn = s2n_connection_new(S2N_SERVER));
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_io_uring_pending(conn), S2N_ERR_IO_URING_NOT_SET);
+        EXPECT_SUCCESS(s2n_connection_set_fd(conn, fds[0]));
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_set_io_uring(conn, ring, fds[0]), S2N_ERR_IO_URING_MANAGED_IO);
+        EXPECT_SUCCESS(s2n_connection_free(conn));
+
+        /* The ring has one slot, which is free again once its connection is */
+        struct s2n_connection *other_conn;
+        EXPECT_NOT_NULL(conn = s2n_connection_new(S2N_SERVER));
+        EXPECT_NOT_NULL(other_conn = s2n_connection_new(S2N_SERVER));
+        EXPECT_SUCCESS(s2n_connection_set_io_uring(conn, ring, fds[0]));
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_set_io_uring(other_conn, ring, fds[0]), S2N_ERR_IO_URING_FULL);
+        EXPECT_SUCCESS(s2n_connection_io_uring_pending(conn));
+        EXPECT_SUCCESS(s2n_connection_free(conn));
+        EXPECT_SUCCESS(s2n_connection_set_io_uring(other_conn, ring, fds[0]));
+
+        /* Freeing the ring detaches its connections */
+        EXPECT_SUCCESS(s2n_io_uring_free(ring));
+        EXPECT_NULL(other_conn->io_uring_slot);
+        EXPECT_SUCCESS(s2n_connection_free(other_conn));
+
+        EXPECT_SUCCESS(close(fds[0]));
+        EXPECT_SUCCESS(close(fds[1]));
+    }
+
+    /* Both ends of several connections are driven through one ring */
+    {
+        struct s2n_connection *server_conn[2];
+        struct s2n_connection *client_conn[2];
+        int fds[2][2];
+
+        EXPECT_NOT_NULL(ring = s2n_io_uring_new(4));
+
+        for (int i = 0; i < 2; i++) {
+            EXPECT_SUCCESS(socketpair(AF_UNIX, SOCK_STREAM, 0, fds[i]));
+
+            EXPECT_NOT_NULL(server_conn[i] = s2n_connection_new(S2N_SERVER));
+            EXPECT_SUCCESS(s2n_connection_set_config(server_conn[i], server_config));
+            EXPECT_SUCCESS(s2n_connection_set_io_uring(server_conn[i], ring, fds[i][0]));
+
+            EXPECT_NOT_NULL(client_conn[i] = s2n_connection_new(S2N_CLIENT));
+            EXPECT_SUCCESS(s2n_connection_set_config(client_conn[i], client_config));
+            EXPECT_SUCCESS(s2n_connection_set_io_uring(client_conn[i], ring, fds[i][1]));
+        }
+
+        for (int i = 0; i < 2; i++) {
+            EXPECT_SUCCESS(negotiate(ring, server_conn[i], client_conn[i]));
+            EXPECT_EQUAL(s2n_conn_get_current_message_type(server_conn[i]), APPLICATION_DATA);
+            EXPECT_EQUAL(s2n_conn_get_current_message_type(client_conn[i]), APPLICATION_DATA);
+        }
+
+        /* Data larger than the slot buffers goes both ways */
+        for (int i = 0; i < 2; i++) {
+            EXPECT_SUCCESS(send_and_recv(ring, server_conn[i], client_conn[i], data, received, sizeof(data)));
+            EXPECT_EQUAL(memcmp(received, data, sizeof(data)), 0);
+            EXPECT_SUCCESS(send_and_recv(ring, client_conn[i], server_conn[i], data, received, sizeof(data)));
+            EXPECT_EQUAL(memcmp(received, data, sizeof(data)), 0);
+        }
+
+        /* Completed reads are reported with the connection they belong to */
+        {
+            s2n_blocked_status blocked;
+            struct s2n_connection *ready[4];
+
+            EXPECT_FAILURE(s2n_recv(server_conn[1], received, 1, &blocked));
+            EXPECT_EQUAL(blocked, S2N_BLOCKED_ON_READ);
+            EXPECT_EQUAL(s2n_send(client_conn[1], data, 1, &blocked), 1);
+
+            int num_ready = 0;
+            int found = 0;
+            while (!found) {
+                EXPECT_SUCCESS(num_ready = s2n_io_uring_submit(ring, 1, ready, 4));
+                for (int i = 0; i < num_ready; i++) {
+                    found |= ready[i] == server_conn[1];
+                }
+            }
+            EXPECT_EQUAL(s2n_recv(server_conn[1], received, 1, &blocked), 1);
+        }
+
+        for (int i = 0; i < 2; i++) {
+            EXPECT_SUCCESS(shutdown_and_drain(ring, server_conn[i], client_conn[i]));
+            EXPECT_SUCCESS(s2n_connection_free(server_conn[i]));
+            EXPECT_SUCCESS(s2n_connection_free(client_conn[i]));
+            EXPECT_SUCCESS(close(fds[i][0]));
+            EXPECT_SUCCESS(close(fds[i][1]));
+        }
+
+        EXPECT_SUCCESS(s2n_io_uring_free(ring));
+    }
+
+    /* The peer closing its socket ends the stream */
+    {
+        struct s2n_connection *server_conn;
+        struct s2n_connection *client_conn;
+        struct s2n_connection *ready[2];
+        s2n_blocked_status blocked;
+        int fds[2];
+
+        EXPECT_NOT_NULL(ring = s2n_io_uring_new(2));
+        EXPECT_SUCCESS(socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+        EXPECT_NOT_NULL(server_conn = s2n_connection_new(S2N_SERVER));
+        EXPECT_SUCCESS(s2n_connection_set_config(server_conn, server_config));
+        EXPECT_SUCCESS(s2n_connection_set_io_uring(server_conn, ring, fds[0]));
+        EXPECT_NOT_NULL(client_conn = s2n_connection_new(S2N_CLIENT));
+        EXPECT_SUCCESS(s2n_connection_set_config(client_conn, client_config));
+        EXPECT_SUCCESS(s2n_connection_set_io_uring(client_conn, ring, fds[1]));
+        EXPECT_SUCCESS(negotiate(ring, server_conn, client_conn));
+
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+        EXPECT_SUCCESS(shutdown(fds[1], SHUT_RDWR));
+
+        int r;
+        while ((r = s2n_recv(server_conn, received, 1, &blocked)) < 0 && blocked == S2N_BLOCKED_ON_READ) {
+            EXPECT_SUCCESS(s2n_io_uring_submit(ring, 1, ready, 2));
+        }
+        EXPECT_EQUAL(r, 0);
+        EXPECT_TRUE(server_conn->closed);
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_io_uring_free(ring));
+        EXPECT_SUCCESS(close(fds[0]));
+        EXPECT_SUCCESS(close(fds[1]));
+    }
+
+    /* Data and a close_notify written before the connection is freed still reach the peer */
+    {
+        struct s2n_connection *server_conn;
+        struct s2n_connection *client_conn;
+        struct s2n_connection *ready[2];
+        s2n_blocked_status blocked;
+        int fds[2];
+
+        EXPECT_NOT_NULL(ring = s2n_io_uring_new(2));
+        EXPECT_SUCCESS(socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+        EXPECT_NOT_NULL(server_conn = s2n_connection_new(S2N_SERVER));
+        EXPECT_SUCCESS(s2n_connection_set_config(server_conn, server_config));
+        EXPECT_SUCCESS(s2n_connection_set_io_uring(server_conn, ring, fds[0]));
+        EXPECT_NOT_NULL(client_conn = s2n_connection_new(S2N_CLIENT));
+        EXPECT_SUCCESS(s2n_connection_set_config(client_conn, client_config));
+        EXPECT_SUCCESS(s2n_connection_set_io_uring(client_conn, ring, fds[1]));
+        EXPECT_SUCCESS(negotiate(ring, server_conn, client_conn));
+
+        /* Nothing is submitted in between, so only the first record is in the queued write */
+        EXPECT_EQUAL(s2n_send(server_conn, data, 1000, &blocked), 1000);
+        EXPECT_EQUAL(s2n_send(server_conn, data + 1000, 1000, &blocked), 1000);
+        EXPECT_FAILURE(s2n_shutdown(server_conn, &blocked));
+        EXPECT_EQUAL(blocked, S2N_BLOCKED_ON_READ);
+        EXPECT_EQUAL(s2n_connection_io_uring_pending(server_conn), 1);
+
+        /* The socket can be closed as soon as the connection is freed */
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(close(fds[0]));
+
+        ssize_t received_len = 0;
+        int r;
+        while ((r = s2n_recv(client_conn, received + received_len, sizeof(received) - received_len, &blocked)) != 0) {
+            if (r < 0) {
+                EXPECT_EQUAL(blocked, S2N_BLOCKED_ON_READ);
+                EXPECT_SUCCESS(s2n_io_uring_submit(ring, 1, ready, 2));
+                continue;
+            }
+            received_len += r;
+        }
+        EXPECT_EQUAL(received_len, 2000);
+        EXPECT_EQUAL(memcmp(received, data, 2000), 0);
+        EXPECT_TRUE(client_conn->closed);
+
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+        EXPECT_SUCCESS(s2n_io_uring_free(ring));
+        EXPECT_SUCCESS(close(fds[1]));
+    }
+
+    EXPECT_SUCCESS(s2n_config_free(server_config));
+    EXPECT_SUCCESS(s2n_config_free(client_config));
+    free(cert_chain);
+    free(private_key);
+
+    END_TEST();
+}
@@ -0,0 +1,202 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+
+#include "testlib/s2n_testlib.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include <s2n.h>
+
+#include "tls/s2n_connection.h"
+#include "utils/s2n_random.h"
+#include "utils/s2n_safety.h"
+#include "utils/s2n_socket.h"
+
+static int recv_exactly(struct s2n_connection *conn, uint8_t *buf, ssize_t size)
+{
+    s2n_blocked_status blocked;
+    ssize_t received = 0;
+    while (received < size) {
+        ssize_t n = s2n_recv(conn, buf + received, size - received, &blocked);
+        if (n < 0 && s2n_errno == S2N_ERR_BLOCKED) {
+            continue;
+        }
+        GUARD(n);
+        received += n;
+    }
+
+    return received;
+}
+
+static int tcp_pair(int *server_fd, int *client_fd)
+{
+    struct sockaddr_in addr = {0};
+    socklen_t addr_len = sizeof(addr);
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    GUARD(listen_fd);
+    GUARD(bind(listen_fd, (struct sockaddr *) &addr, sizeof(addr)));
+    GUARD(listen(listen_fd, 1));
+    GUARD(getsockname(listen_fd, (struct sockaddr *) &addr, &addr_len));
+
+    GUARD((*client_fd = socket(AF_INET, SOCK_STREAM, 0)));
+    GUARD(connect(*client_fd, (struct sockaddr *) &addr, sizeof(addr)));
+    GUARD((*server_fd = accept(listen_fd, NULL, NULL)));
+    GUARD(close(listen_fd));
+
+    GUARD(fcntl(*server_fd, F_SETFL, fcntl(*server_fd, F_GETFL) | O_NONBLOCK));
+    GUARD(fcntl(*client_fd, F_SETFL, fcntl(*client_fd, F_GETFL) | O_NONBLOCK));
+
+    return 0;
+}
+
+static int msg_more_pending(struct s2n_connection *conn)
+{
+    return ((struct s2n_socket_write_io_context *) conn->send_io_context)->msg_more;
+}
+
+int main(int argc, char **argv)
+{
+    struct s2n_config *server_config;
+    struct s2n_config *client_config;
+    char *cert_chain;
+    char *private_key;
+    s2n_blocked_status blocked;
+
+    static uint8_t data[100000];
+    static uint8_t received[100000];
+    struct s2n_blob data_blob = {.data = data,.size = sizeof(data) };
+
+    BEGIN_TEST();
+
+    EXPECT_SUCCESS(s2n_get_urandom_data(&data_blob));
+
+    EXPECT_NOT_NULL(cert_chain = malloc(S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_NOT_NULL(private_key = malloc(S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_SUCCESS(s2n_read_test_pem(S2N_DEFAULT_TEST_CERT_CHAIN, cert_chain, S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_SUCCESS(s2n_read_test_pem(S2N_DEFAULT_TEST_PRIVATE_KEY, private_key, S2N_MAX_TEST_PEM_SIZE));
+
+    EXPECT_NOT_NULL(server_config = s2n_config_new());
+    EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key(server_config, cert_chain, private_key));
+    EXPECT_NOT_NULL(client_config = s2n_config_new());
+    EXPECT_SUCCESS(s2n_config_disable_x509_verification(client_config));
+
+    /* MSG_MORE needs s2n to own the socket */
+    {
+        struct s2n_connection *conn;
+        EXPECT_NOT_NULL(conn = s2n_connection_new(S2N_SERVER));
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_use_msg_more_io(conn), S2N_ERR_MSG_MORE_SET_ON_UNMANAGED);
+        EXPECT_SUCCESS(s2n_connection_free(conn));
+    }
+
+    /* Over TCP, the handshake and application data go through, and the last record of each flush isn't held back */
+    {
+        int server_fd;
+        int client_fd;
+        struct s2n_connection *server_conn;
+        struct s2n_connection *client_conn;
+        EXPECT_SUCCESS(tcp_pair(&server_fd, &client_fd));
+
+        EXPECT_NOT_NULL(server_conn = s2n_connection_new(S2N_SERVER));
+        EXPECT_SUCCESS(s2n_connection_set_config(server_conn, server_config));
+        EXPECT_SUCCESS(s2n_connection_set_fd(server_conn, server_fd));
+        EXPECT_SUCCESS(s2n_connection_use_msg_more_io(server_conn));
+
+        EXPECT_NOT_NULL(client_conn = s2n_connection_new(S2N_CLIENT));
+        EXPECT_SUCCESS(s2n_connection_set_config(client_conn, client_config));
+        EXPECT_SUCCESS(s2n_connection_set_fd(client_conn, client_fd));
+        EXPECT_SUCCESS(s2n_connection_use_msg_more_io(client_conn));
+
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+        EXPECT_FALSE(msg_more_pending(server_conn));
+        EXPECT_FALSE(msg_more_pending(client_conn));
+
+        /* Many records in one call */
+        EXPECT_EQUAL(s2n_send(server_conn, data, sizeof(data), &blocked), sizeof(data));
+        EXPECT_FALSE(msg_more_pending(server_conn));
+        EXPECT_EQUAL(recv_exactly(client_conn, received, sizeof(data)), sizeof(data));
+        EXPECT_EQUAL(memcmp(received, data, sizeof(data)), 0);
+
+        /* A single small record is readable right away */
+        struct pollfd pfd = {.fd = server_fd,.events = POLLIN };
+        EXPECT_EQUAL(s2n_send(client_conn, data, 100, &blocked), 100);
+        EXPECT_EQUAL(poll(&pfd, 1, 100), 1);
+        EXPECT_EQUAL(recv_exactly(server_conn, received, 100), 100);
+        EXPECT_EQUAL(memcmp(received, data, 100), 0);
+
+        EXPECT_SUCCESS(s2n_shutdown_test_server_and_client(server_conn, client_conn));
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+        EXPECT_SUCCESS(close(server_fd));
+        EXPECT_SUCCESS(close(client_fd));
+    }
+
+    /* Pipes can't take MSG_MORE, so s2n falls back to plain writes */
+    {
+        int server_to_client[2];
+        int client_to_server[2];
+        struct s2n_connection *server_conn;
+        struct s2n_connection *client_conn;
+
+        EXPECT_SUCCESS(pipe(server_to_client));
+        EXPECT_SUCCESS(pipe(client_to_server));
+        for (int i = 0; i < 2; i++) {
+            EXPECT_NOT_EQUAL(fcntl(server_to_client[i], F_SETFL, fcntl(server_to_client[i], F_GETFL) | O_NONBLOCK), -1);
+            EXPECT_NOT_EQUAL(fcntl(client_to_server[i], F_SETFL, fcntl(client_to_server[i], F_GETFL) | O_NONBLOCK), -1);
+        }
+
+        EXPECT_NOT_NULL(server_conn = s2n_connection_new(S2N_SERVER));
+        EXPECT_SUCCESS(s2n_connection_set_config(server_conn, server_config));
+        EXPECT_SUCCESS(s2n_connection_set_read_fd(server_conn, client_to_server[0]));
+        EXPECT_SUCCESS(s2n_connection_set_write_fd(server_conn, server_to_client[1]));
+        EXPECT_SUCCESS(s2n_connection_use_msg_more_io(server_conn));
+
+        EXPECT_NOT_NULL(client_conn = s2n_connection_new(S2N_CLIENT));
+        EXPECT_SUCCESS(s2n_connection_set_config(client_conn, client_config));
+        EXPECT_SUCCESS(s2n_connection_set_read_fd(client_conn, server_to_client[0]));
+        EXPECT_SUCCESS(s2n_connection_set_write_fd(client_conn, client_to_server[1]));
+        EXPECT_SUCCESS(s2n_connection_use_msg_more_io(client_conn));
+
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+
+        EXPECT_EQUAL(s2n_send(server_conn, data, 20000, &blocked), 20000);
+        EXPECT_EQUAL(recv_exactly(client_conn, received, 20000), 20000);
+        EXPECT_EQUAL(memcmp(received, data, 20000), 0);
+
+        EXPECT_SUCCESS(s2n_shutdown_test_server_and_client(server_conn, client_conn));
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+        for (int i = 0; i < 2; i++) {
+            EXPECT_SUCCESS(close(server_to_client[i]));
+            EXPECT_SUCCESS(close(client_to_server[i]));
+        }
+    }
+
+    EXPECT_SUCCESS(s2n_config_free(server_config));
+    EXPECT_SUCCESS(s2n_config_free(client_config));
+    free(cert_chain);
+    free(private_key);
+
+    END_TEST();
+}
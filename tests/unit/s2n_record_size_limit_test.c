@@ -0,0 +1,228 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+
+#include "testlib/s2n_testlib.h"
+
+#include <fcntl.h>
+#include <string.h>
+
+#include <s2n.h>
+
+#include "tls/s2n_connection.h"
+#include "tls/s2n_record.h"
+#include "tls/s2n_tls_parameters.h"
+#include "utils/s2n_safety.h"
+
+#define SEND_SIZE 20000
+
+struct test_pair {
+    struct s2n_connection *server_conn;
+    struct s2n_connection *client_conn;
+    int server_to_client[2];
+    int client_to_server[2];
+};
+
+static int test_pair_new(struct test_pair *pair, struct s2n_config *server_config, struct s2n_config *client_config)
+{
+    GUARD(pipe(pair->server_to_client));
+    GUARD(pipe(pair->client_to_server));
+    for (int i = 0; i < 2; i++) {
+        GUARD(fcntl(pair->server_to_client[i], F_SETFL, fcntl(pair->server_to_client[i], F_GETFL) | O_NONBLOCK));
+        GUARD(fcntl(pair->client_to_server[i], F_SETFL, fcntl(pair->client_to_server[i], F_GETFL) | O_NONBLOCK));
+    }
+
+    notnull_check(pair->server_conn = s2n_connection_new(S2N_SERVER));
+    GUARD(s2n_connection_set_config(pair->server_conn, server_config));
+    GUARD(s2n_connection_set_read_fd(pair->server_conn, pair->client_to_server[0]));
+    GUARD(s2n_connection_set_write_fd(pair->server_conn, pair->server_to_client[1]));
+
+    notnull_check(pair->client_conn = s2n_connection_new(S2N_CLIENT));
+    GUARD(s2n_connection_set_config(pair->client_conn, client_config));
+    GUARD(s2n_connection_set_read_fd(pair->client_conn, pair->server_to_client[0]));
+    GUARD(s2n_connection_set_write_fd(pair->client_conn, pair->client_to_server[1]));
+
+    GUARD(s2n_negotiate_test_server_and_client(pair->server_conn, pair->client_conn));
+
+    return 0;
+}
+
+static int test_pair_free(struct test_pair *pair)
+{
+    GUARD(s2n_connection_free(pair->server_conn));
+    GUARD(s2n_connection_free(pair->client_conn));
+    for (int i = 0; i < 2; i++) {
+        GUARD(close(pair->server_to_client[i]));
+        GUARD(close(pair->client_to_server[i]));
+    }
+
+    return 0;
+}
+
+/* Send SEND_SIZE bytes from one end and check they all arrive at the other */
+static int send_and_receive(struct s2n_connection *sender, struct s2n_connection *receiver)
+{
+    static uint8_t data[SEND_SIZE];
+    static uint8_t received[SEND_SIZE];
+    s2n_blocked_status blocked;
+
+    for (int i = 0; i < SEND_SIZE; i++) {
+        data[i] = i;
+    }
+
+    GUARD(s2n_send(sender, data, sizeof(data), &blocked));
+
+    ssize_t total = 0;
+    while (total < SEND_SIZE) {
+        ssize_t n = s2n_recv(receiver, received + total, SEND_SIZE - total, &blocked);
+        GUARD(n);
+        S2N_ERROR_IF(n == 0, S2N_ERR_CLOSED);
+        total += n;
+    }
+
+    S2N_ERROR_IF(memcmp(data, received, SEND_SIZE), S2N_ERR_BAD_MESSAGE);
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    struct s2n_config *server_config;
+    struct s2n_config *client_config;
+    char *cert_chain;
+    char *private_key;
+    struct test_pair pair;
+
+    BEGIN_TEST();
+
+    EXPECT_NOT_NULL(cert_chain = malloc(S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_NOT_NULL(private_key = malloc(S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_SUCCESS(s2n_read_test_pem(S2N_DEFAULT_TEST_CERT_CHAIN, cert_chain, S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_SUCCESS(s2n_read_test_pem(S2N_DEFAULT_TEST_PRIVATE_KEY, private_key, S2N_MAX_TEST_PEM_SIZE));
+
+    EXPECT_NOT_NULL(server_config = s2n_config_new());
+    EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key(server_config, cert_chain, private_key));
+    EXPECT_NOT_NULL(client_config = s2n_config_new());
+    EXPECT_SUCCESS(s2n_config_disable_x509_verification(client_config));
+
+    /* Limits must be between 64 bytes and the maximum fragment length, or 0 to stop sending the extension */
+    EXPECT_FAILURE_WITH_ERRNO(s2n_config_set_record_size_limit(client_config, S2N_TLS_MINIMUM_RECORD_SIZE_LIMIT - 1),
+            S2N_ERR_INVALID_RECORD_SIZE_LIMIT);
+    EXPECT_FAILURE_WITH_ERRNO(s2n_config_set_record_size_limit(client_config, S2N_TLS_MAXIMUM_FRAGMENT_LENGTH + 1),
+            S2N_ERR_INVALID_RECORD_SIZE_LIMIT);
+    EXPECT_SUCCESS(s2n_config_set_record_size_limit(client_config, S2N_TLS_MINIMUM_RECORD_SIZE_LIMIT));
+    EXPECT_SUCCESS(s2n_config_set_record_size_limit(client_config, S2N_TLS_MAXIMUM_FRAGMENT_LENGTH));
+    EXPECT_SUCCESS(s2n_config_set_record_size_limit(client_config, 0));
+
+    /* Without the extension from the client, nothing is negotiated */
+    {
+        EXPECT_SUCCESS(s2n_config_set_record_size_limit(server_config, 1024));
+        EXPECT_SUCCESS(test_pair_new(&pair, server_config, client_config));
+
+        EXPECT_EQUAL(pair.server_conn->peer_record_size_limit, 0);
+        EXPECT_EQUAL(pair.client_conn->peer_record_size_limit, 0);
+        EXPECT_EQUAL(s2n_record_read_buffer_size(pair.server_conn), S2N_LARGE_FRAGMENT_LENGTH);
+        EXPECT_SUCCESS(send_and_receive(pair.client_conn, pair.server_conn));
+
+        EXPECT_SUCCESS(test_pair_free(&pair));
+        EXPECT_SUCCESS(s2n_config_set_record_size_limit(server_config, 0));
+    }
+
+    /* A client limit is honoured by the server, which answers with the protocol maximum */
+    {
+        EXPECT_SUCCESS(s2n_config_set_record_size_limit(client_config, 512));
+        EXPECT_SUCCESS(test_pair_new(&pair, server_config, client_config));
+
+        EXPECT_EQUAL(pair.server_conn->peer_record_size_limit, 512);
+        EXPECT_EQUAL(pair.server_conn->record_size_limit, S2N_TLS_MAXIMUM_FRAGMENT_LENGTH);
+        EXPECT_EQUAL(pair.client_conn->peer_record_size_limit, S2N_TLS_MAXIMUM_FRAGMENT_LENGTH);
+        EXPECT_EQUAL(pair.client_conn->record_size_limit, 512);
+
+        EXPECT_SUCCESS(s2n_connection_prefer_throughput(pair.server_conn));
+        EXPECT_TRUE(s2n_record_max_write_payload_size(pair.server_conn) <= 512);
+        EXPECT_TRUE(s2n_record_max_write_payload_size(pair.server_conn) > 400);
+
+        /* The client's buffers shrank to what a 512 byte record can need */
+        EXPECT_EQUAL(s2n_record_read_buffer_size(pair.client_conn), 512 + S2N_TLS_MAXIMUM_RECORD_EXPANSION);
+        EXPECT_TRUE(pair.client_conn->in.blob.size <= 512 + S2N_TLS_MAXIMUM_RECORD_EXPANSION);
+        EXPECT_EQUAL(s2n_record_write_buffer_size(pair.server_conn),
+                S2N_TLS_RECORD_HEADER_LENGTH + 512 + S2N_TLS_MAXIMUM_RECORD_EXPANSION);
+
+        EXPECT_SUCCESS(send_and_receive(pair.server_conn, pair.client_conn));
+        EXPECT_TRUE(pair.client_conn->in.blob.size <= 512 + S2N_TLS_MAXIMUM_RECORD_EXPANSION);
+        EXPECT_TRUE(pair.server_conn->out.blob.size <= S2N_TLS_RECORD_HEADER_LENGTH + 512 + S2N_TLS_MAXIMUM_RECORD_EXPANSION);
+        EXPECT_SUCCESS(send_and_receive(pair.client_conn, pair.server_conn));
+
+        EXPECT_SUCCESS(test_pair_free(&pair));
+    }
+
+    /* A server limit is honoured by the client */
+    {
+        EXPECT_SUCCESS(s2n_config_set_record_size_limit(client_config, S2N_TLS_MAXIMUM_FRAGMENT_LENGTH));
+        EXPECT_SUCCESS(s2n_config_set_record_size_limit(server_config, 1024));
+        EXPECT_SUCCESS(test_pair_new(&pair, server_config, client_config));
+
+        EXPECT_EQUAL(pair.client_conn->peer_record_size_limit, 1024);
+        EXPECT_EQUAL(pair.server_conn->peer_record_size_limit, S2N_TLS_MAXIMUM_FRAGMENT_LENGTH);
+        EXPECT_TRUE(s2n_record_max_write_payload_size(pair.client_conn) <= 1024);
+        EXPECT_TRUE(pair.server_conn->in.blob.size <= 1024 + S2N_TLS_MAXIMUM_RECORD_EXPANSION);
+
+        EXPECT_SUCCESS(send_and_receive(pair.client_conn, pair.server_conn));
+        EXPECT_SUCCESS(send_and_receive(pair.server_conn, pair.client_conn));
+
+        EXPECT_SUCCESS(test_pair_free(&pair));
+        EXPECT_SUCCESS(s2n_config_set_record_size_limit(server_config, 0));
+    }
+
+    /* A server that negotiates record_size_limit ignores max_fragment_length */
+    {
+        EXPECT_SUCCESS(s2n_config_set_record_size_limit(client_config, 2048));
+        EXPECT_SUCCESS(s2n_config_send_max_fragment_length(client_config, S2N_TLS_MAX_FRAG_LEN_512));
+        EXPECT_SUCCESS(s2n_config_accept_max_fragment_length(server_config));
+        EXPECT_SUCCESS(test_pair_new(&pair, server_config, client_config));
+
+        EXPECT_EQUAL(pair.server_conn->mfl_code, S2N_TLS_MAX_FRAG_LEN_EXT_NONE);
+        EXPECT_EQUAL(pair.server_conn->peer_record_size_limit, 2048);
+        EXPECT_SUCCESS(s2n_connection_prefer_throughput(pair.server_conn));
+        EXPECT_TRUE(s2n_record_max_write_payload_size(pair.server_conn) <= 2048);
+        EXPECT_TRUE(s2n_record_max_write_payload_size(pair.server_conn) > 1024);
+
+        EXPECT_SUCCESS(send_and_receive(pair.server_conn, pair.client_conn));
+
+        EXPECT_SUCCESS(test_pair_free(&pair));
+        EXPECT_SUCCESS(s2n_config_send_max_fragment_length(client_config, S2N_TLS_MAX_FRAG_LEN_EXT_NONE));
+    }
+
+    /* Records over the negotiated limit are rejected */
+    {
+        EXPECT_SUCCESS(s2n_config_set_record_size_limit(client_config, 512));
+        EXPECT_SUCCESS(test_pair_new(&pair, server_config, client_config));
+
+        /* Make the server forget the limit, as a misbehaving peer would */
+        pair.server_conn->peer_record_size_limit = 0;
+        EXPECT_SUCCESS(s2n_connection_prefer_throughput(pair.server_conn));
+        EXPECT_FAILURE_WITH_ERRNO(send_and_receive(pair.server_conn, pair.client_conn), S2N_ERR_RECORD_SIZE_LIMIT_EXCEEDED);
+
+        EXPECT_SUCCESS(test_pair_free(&pair));
+    }
+
+    EXPECT_SUCCESS(s2n_config_free(server_config));
+    EXPECT_SUCCESS(s2n_config_free(client_config));
+    free(cert_chain);
+    free(private_key);
+
+    END_TEST();
+}
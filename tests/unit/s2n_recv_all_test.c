@@ -0,0 +1,175 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+
+#include "testlib/s2n_testlib.h"
+
+#include <fcntl.h>
+#include <errno.h>
+
+#include <s2n.h>
+
+#include "tls/s2n_alerts.h"
+#include "tls/s2n_connection.h"
+#include "tls/s2n_tls.h"
+#include "utils/s2n_safety.h"
+
+#define MESSAGE_SIZE 50000
+
+int main(int argc, char **argv)
+{
+    struct s2n_config *server_config;
+    struct s2n_config *client_config;
+    struct s2n_connection *server_conn;
+    struct s2n_connection *client_conn;
+    int server_to_client[2];
+    int client_to_server[2];
+    char *cert_chain;
+    char *private_key;
+    s2n_blocked_status blocked;
+    uint8_t *message;
+    uint8_t *received;
+
+    BEGIN_TEST();
+
+    EXPECT_SUCCESS(setenv("S2N_DONT_MLOCK", "1", 0));
+
+    EXPECT_NOT_NULL(cert_chain = malloc(S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_NOT_NULL(private_key = malloc(S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_SUCCESS(s2n_read_test_pem(S2N_DEFAULT_TEST_CERT_CHAIN, cert_chain, S2N_MAX_TEST_PEM_SIZE));
+    EXPECT_SUCCESS(s2n_read_test_pem(S2N_DEFAULT_TEST_PRIVATE_KEY, private_key, S2N_MAX_TEST_PEM_SIZE));
+
+    EXPECT_NOT_NULL(server_config = s2n_config_new());
+    EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key(server_config, cert_chain, private_key));
+    EXPECT_NOT_NULL(client_config = s2n_config_new());
+    EXPECT_SUCCESS(s2n_config_disable_x509_verification(client_config));
+
+    EXPECT_NOT_NULL(message = malloc(MESSAGE_SIZE));
+    EXPECT_NOT_NULL(received = malloc(MESSAGE_SIZE * 2));
+    for (int i = 0; i < MESSAGE_SIZE; i++) {
+        message[i] = i * 7;
+    }
+
+    /* Create nonblocking pipes, large enough to hold the whole message */
+    EXPECT_SUCCESS(pipe(server_to_client));
+    EXPECT_SUCCESS(pipe(client_to_server));
+    for (int i = 0; i < 2; i++) {
+        EXPECT_NOT_EQUAL(fcntl(server_to_client[i], F_SETFL, fcntl(server_to_client[i], F_GETFL) | O_NONBLOCK), -1);
+        EXPECT_NOT_EQUAL(fcntl(client_to_server[i], F_SETFL, fcntl(client_to_server[i], F_GETFL) | O_NONBLOCK), -1);
+    }
+
+    /* s2n_recv returns a record at a time, s2n_recv_all returns every record available */
+    {
+        EXPECT_SUCCESS(s2n_new_test_server_and_client(&server_conn, &client_conn, server_config, client_config, server_to_client, client_to_server));
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+        EXPECT_SUCCESS(s2n_connection_prefer_throughput(client_conn));
+
+        EXPECT_EQUAL(s2n_send(client_conn, message, MESSAGE_SIZE, &blocked), MESSAGE_SIZE);
+        ssize_t first = s2n_recv(server_conn, received, MESSAGE_SIZE * 2, &blocked);
+        EXPECT_TRUE(first > 0);
+        EXPECT_TRUE(first <= S2N_LARGE_FRAGMENT_LENGTH);
+
+        EXPECT_EQUAL(s2n_recv_all(server_conn, received + first, MESSAGE_SIZE * 2 - first, &blocked), MESSAGE_SIZE - first);
+        EXPECT_EQUAL(memcmp(received, message, MESSAGE_SIZE), 0);
+
+        /* Nothing left to read */
+        EXPECT_FAILURE_WITH_ERRNO(s2n_recv_all(server_conn, received, MESSAGE_SIZE, &blocked), S2N_ERR_BLOCKED);
+        EXPECT_EQUAL(blocked, S2N_BLOCKED_ON_READ);
+
+        EXPECT_SUCCESS(s2n_shutdown_test_server_and_client(server_conn, client_conn));
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+    }
+
+    /* s2n_recv_all stops when the buffer is full, partway through a record */
+    {
+        EXPECT_SUCCESS(s2n_new_test_server_and_client(&server_conn, &client_conn, server_config, client_config, server_to_client, client_to_server));
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+
+        EXPECT_EQUAL(s2n_send(client_conn, message, MESSAGE_SIZE, &blocked), MESSAGE_SIZE);
+        EXPECT_EQUAL(s2n_recv_all(server_conn, received, 20000, &blocked), 20000);
+        EXPECT_EQUAL(s2n_recv_all(server_conn, received + 20000, 1, &blocked), 1);
+        EXPECT_EQUAL(s2n_recv_all(server_conn, received + 20001, MESSAGE_SIZE, &blocked), MESSAGE_SIZE - 20001);
+        EXPECT_EQUAL(memcmp(received, message, MESSAGE_SIZE), 0);
+
+        EXPECT_SUCCESS(s2n_shutdown_test_server_and_client(server_conn, client_conn));
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+    }
+
+    /* Data followed by a close_notify is returned, then the closure */
+    {
+        EXPECT_SUCCESS(s2n_new_test_server_and_client(&server_conn, &client_conn, server_config, client_config, server_to_client, client_to_server));
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+
+        EXPECT_EQUAL(s2n_send(client_conn, message, 1000, &blocked), 1000);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_shutdown(client_conn, &blocked), S2N_ERR_BLOCKED);
+
+        EXPECT_EQUAL(s2n_recv_all(server_conn, received, MESSAGE_SIZE, &blocked), 1000);
+        EXPECT_EQUAL(memcmp(received, message, 1000), 0);
+        EXPECT_EQUAL(s2n_recv_all(server_conn, received, MESSAGE_SIZE, &blocked), 0);
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+    }
+
+    /* Data followed by a fatal alert is returned, then the closure, and the alert is kept */
+    {
+        EXPECT_SUCCESS(s2n_new_test_server_and_client(&server_conn, &client_conn, server_config, client_config, server_to_client, client_to_server));
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+
+        EXPECT_EQUAL(s2n_send(client_conn, message, 1000, &blocked), 1000);
+        EXPECT_SUCCESS(s2n_queue_reader_handshake_failure_alert(client_conn));
+        EXPECT_SUCCESS(s2n_flush(client_conn, &blocked));
+
+        EXPECT_EQUAL(s2n_recv_all(server_conn, received, MESSAGE_SIZE, &blocked), 1000);
+        EXPECT_EQUAL(memcmp(received, message, 1000), 0);
+        EXPECT_EQUAL(s2n_recv_all(server_conn, received, MESSAGE_SIZE, &blocked), 0);
+        EXPECT_EQUAL(s2n_connection_get_alert(server_conn), 40);
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+    }
+
+    /* A fatal alert with no data before it is still an error */
+    {
+        EXPECT_SUCCESS(s2n_new_test_server_and_client(&server_conn, &client_conn, server_config, client_config, server_to_client, client_to_server));
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+
+        EXPECT_SUCCESS(s2n_queue_reader_handshake_failure_alert(client_conn));
+        EXPECT_SUCCESS(s2n_flush(client_conn, &blocked));
+
+        EXPECT_FAILURE_WITH_ERRNO(s2n_recv_all(server_conn, received, MESSAGE_SIZE, &blocked), S2N_ERR_ALERT);
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+    }
+
+    for (int i = 0; i < 2; i++) {
+        EXPECT_SUCCESS(close(server_to_client[i]));
+        EXPECT_SUCCESS(close(client_to_server[i]));
+    }
+
+    EXPECT_SUCCESS(s2n_config_free(server_config));
+    EXPECT_SUCCESS(s2n_config_free(client_config));
+    free(message);
+    free(received);
+    free(cert_chain);
+    free(private_key);
+
+    END_TEST();
+    return 0;
+}
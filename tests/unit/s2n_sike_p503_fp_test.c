@@ -0,0 +1,111 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+
+#include <string.h>
+
+#include "pq-crypto/sike/P503_internal.h"
+
+#include "utils/s2n_random.h"
+#include "utils/s2n_safety.h"
+
+#define RANDOM_ROUNDS 1000
+
+extern const uint64_t p503x2[NWORDS64_FIELD];
+extern const uint64_t Montgomery_one[NWORDS64_FIELD];
+
+/* A random element in [0, p503-1] */
+static int random_felm(felm_t a)
+{
+    struct s2n_blob blob = { .data = (uint8_t *) a, .size = sizeof(felm_t) };
+    GUARD(s2n_get_public_random_data(&blob));
+    a[NWORDS_FIELD - 1] &= 0x003FFFFFFFFFFFFF;
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    felm_t a, b, c, d, max, zero = { 0 };
+
+    BEGIN_TEST();
+
+    /* 2*p503 - 1, the largest allowed input */
+    memcpy(max, p503x2, sizeof(max));
+    max[0] -= 1;
+
+    /* (2^256 - 1)^2 = 2^512 - 2^257 + 1, with the half size multiplication used for MUL128 */
+    {
+        digit_t ones[NWORDS_FIELD / 2], square[NWORDS_FIELD];
+        memset(ones, 0xff, sizeof(ones));
+        mp_mul(ones, ones, square, NWORDS_FIELD / 2);
+        EXPECT_EQUAL(square[0], 1);
+        EXPECT_EQUAL(square[1], 0);
+        EXPECT_EQUAL(square[2], 0);
+        EXPECT_EQUAL(square[3], 0);
+        EXPECT_EQUAL(square[4], 0xFFFFFFFFFFFFFFFE);
+        EXPECT_EQUAL(square[5], UINT64_MAX);
+        EXPECT_EQUAL(square[6], UINT64_MAX);
+        EXPECT_EQUAL(square[7], UINT64_MAX);
+    }
+
+    for (int i = 0; i < RANDOM_ROUNDS; i++) {
+        EXPECT_SUCCESS(random_felm(a));
+        EXPECT_SUCCESS(random_felm(b));
+        if (i == 0) {
+            memcpy(a, max, sizeof(a));
+            memcpy(b, max, sizeof(b));
+        }
+
+        /* a*1 = a in Montgomery representation */
+        fpmul503_mont(a, Montgomery_one, c);
+        memcpy(d, a, sizeof(d));
+        fpcorrection503(c);
+        fpcorrection503(d);
+        EXPECT_BYTEARRAY_EQUAL(c, d, sizeof(c));
+
+        /* (a + b) - b = a */
+        fpadd503(a, b, c);
+        fpsub503(c, b, c);
+        fpcorrection503(c);
+        EXPECT_BYTEARRAY_EQUAL(c, d, sizeof(c));
+
+        /* a - a = 0 */
+        fpsub503(a, a, c);
+        fpcorrection503(c);
+        EXPECT_BYTEARRAY_EQUAL(c, zero, sizeof(c));
+
+        /* a*b = b*a */
+        fpmul503_mont(a, b, c);
+        fpmul503_mont(b, a, d);
+        EXPECT_BYTEARRAY_EQUAL(c, d, sizeof(c));
+
+#if defined(SIKE_P503_X64)
+        /* The MULX/ADX implementation matches the 64-bit one */
+        if (fp_x64_mulx_supported()) {
+            dfelm_t ab1, ab2;
+            mul503_x64(a, b, ab1);
+            mul503_asm(a, b, ab2);
+            EXPECT_BYTEARRAY_EQUAL(ab1, ab2, sizeof(ab1));
+
+            rdc503_x64(ab1, c);
+            rdc503_asm(ab1, d);
+            EXPECT_BYTEARRAY_EQUAL(c, d, sizeof(c));
+        }
+#endif
+    }
+
+    END_TEST();
+}
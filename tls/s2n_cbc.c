@@ -25,6 +25,40 @@
 
 #include "tls/s2n_record.h"
 
+/* The padding check works on this many bytes at a time */
+#define S2N_CBC_PADDING_LANES 16
+
+/* Compare the check bytes at the end of the record before the padding length byte with the
+ * padding length, ignoring the first cutoff of them. Every byte is compared, whatever the padding
+ * length, and the mask is computed arithmetically: (i - cutoff) is negative, so has its top byte
+ * set, exactly when byte i precedes the padding. The inner loop over a fixed number of lanes
+ * has no branches, which lets the compiler turn it into 16 byte vector operations.
+ */
+static uint8_t s2n_cbc_padding_mismatches(const uint8_t *window, int check, int cutoff, uint8_t padding_length)
+{
+    uint8_t lanes[S2N_CBC_PADDING_LANES] = { 0 };
+
+    int i = 0;
+    for (; i + S2N_CBC_PADDING_LANES <= check; i += S2N_CBC_PADDING_LANES) {
+        for (int k = 0; k < S2N_CBC_PADDING_LANES; k++) {
+            uint8_t mask = ~((uint32_t) (i + k - cutoff) >> 24);
+            lanes[k] |= (window[i + k] ^ padding_length) & mask;
+        }
+    }
+
+    uint8_t mismatches = 0;
+    for (; i < check; i++) {
+        uint8_t mask = ~((uint32_t) (i - cutoff) >> 24);
+        mismatches |= (window[i] ^ padding_length) & mask;
+    }
+
+    for (int k = 0; k < S2N_CBC_PADDING_LANES; k++) {
+        mismatches |= lanes[k];
+    }
+
+    return mismatches;
+}
+
 /* A TLS CBC record looks like ..
  *
  * [ Payload data ] [ HMAC ] [ Padding ] [ Padding length byte ]
@@ -67,9 +101,11 @@ int s2n_verify_cbc(struct s2n_connection *conn, struct s2n_hmac_state *hmac, str
 
     int payload_length = MAX(payload_and_padding_size - padding_length - 1, 0);
 
-    /* Update the MAC */
+    /* Update the MAC. Only the inner hash is updated, so it is all the copy needs to repeat the
+     * hashing that the padding length saved us.
+     */
     GUARD(s2n_hmac_update(hmac, decrypted->data, payload_length));
-    GUARD(s2n_hmac_copy(copy, hmac));
+    GUARD(s2n_hash_copy(&copy->inner, &hmac->inner));
 
     /* Check the MAC */
     uint8_t check_digest[S2N_MAX_DIGEST_LEN];
@@ -78,8 +114,8 @@ int s2n_verify_cbc(struct s2n_connection *conn, struct s2n_hmac_state *hmac, str
 
     int mismatches = s2n_constant_time_equals(decrypted->data + payload_length, check_digest, mac_digest_size) ^ 1;
 
-    /* Compute a MAC on the rest of the data so that we perform the same number of hash operations */
-    GUARD(s2n_hmac_update(copy, decrypted->data + payload_length + mac_digest_size, decrypted->size - payload_length - mac_digest_size - 1));
+    /* Hash the rest of the data so that we perform the same number of hash operations */
+    GUARD(s2n_hash_update(&copy->inner, decrypted->data + payload_length + mac_digest_size, decrypted->size - payload_length - mac_digest_size - 1));
 
     /* SSLv3 doesn't specify what the padding should actually be */
     if (conn->actual_protocol_version == S2N_SSLv3) {
@@ -90,12 +126,9 @@ int s2n_verify_cbc(struct s2n_connection *conn, struct s2n_hmac_state *hmac, str
     int check = MIN(255, (payload_and_padding_size - 1));
 
     int cutoff = check - padding_length;
-    for (int i = 0, j = decrypted->size - 1 - check; i < check && j < decrypted->size; i++, j++) {
-        uint8_t mask = ~(0xff << ((i >= cutoff) * 8));
-        mismatches |= (decrypted->data[j] ^ padding_length) & mask;
-    }
+    mismatches |= s2n_cbc_padding_mismatches(decrypted->data + decrypted->size - 1 - check, check, cutoff, padding_length);
 
-    GUARD(s2n_hmac_reset(copy));
+    GUARD(s2n_hash_reset(&copy->inner));
 
     S2N_ERROR_IF(mismatches, S2N_ERR_CBC_VERIFY);
 
@@ -318,6 +318,43 @@ const struct s2n_cipher_preferences cipher_preferences_20190214 = {
     .minimum_protocol_version = S2N_TLS10,
 };
 
+/* An in_group_flags array needs an entry for every suite of its policy. Fails to compile otherwise. */
+#define S2N_IN_GROUP_FLAGS_MATCH_SUITES(flags, suites) \
+    typedef char flags##_matches_suites[(sizeof(flags) == sizeof(suites) / sizeof(suites[0])) ? 1 : -1]
+
+/* Same as 20170210, but ECDHE AES-GCM and ChaCha20 are equally preferred so that clients
+ * without AES hardware support can choose ChaCha20.
+ */
+static const uint8_t in_group_flags_20191016[] = {
+    1, 1, 0,
+    0, 0, 0,
+    0, 0, 0
+};
+S2N_IN_GROUP_FLAGS_MATCH_SUITES(in_group_flags_20191016, cipher_suites_20170210);
+
+const struct s2n_cipher_preferences cipher_preferences_20191016 = {
+    .count = sizeof(cipher_suites_20170210) / sizeof(cipher_suites_20170210[0]),
+    .suites = cipher_suites_20170210,
+    .minimum_protocol_version = S2N_TLS10,
+    .in_group_flags = in_group_flags_20191016,
+};
+
+/* Same as 20190801, with the same equal-preference groups for TLS1.3 and TLS1.2 AEAD suites */
+static const uint8_t in_group_flags_20191016_tls13[] = {
+    1, 1, 0,
+    1, 1, 0,
+    0, 0, 0,
+    0, 0, 0
+};
+S2N_IN_GROUP_FLAGS_MATCH_SUITES(in_group_flags_20191016_tls13, cipher_suites_20190801);
+
+const struct s2n_cipher_preferences cipher_preferences_20191016_tls13 = {
+    .count = sizeof(cipher_suites_20190801) / sizeof(cipher_suites_20190801[0]),
+    .suites = cipher_suites_20190801,
+    .minimum_protocol_version = S2N_TLS10,
+    .in_group_flags = in_group_flags_20191016_tls13,
+};
+
 struct s2n_cipher_suite *cipher_suites_null[] = {
     &s2n_null_cipher_suite
 };
@@ -849,6 +886,8 @@ struct {
     { .version="20170210", .preferences=&cipher_preferences_20170210, .ecc_extension_required=0, .pq_kem_extension_required=0},
     { .version="20170328", .preferences=&cipher_preferences_20170328, .ecc_extension_required=0, .pq_kem_extension_required=0},
     { .version="20190214", .preferences=&cipher_preferences_20190214, .ecc_extension_required=0, .pq_kem_extension_required=0},
+    { .version="20191016", .preferences=&cipher_preferences_20191016, .ecc_extension_required=0, .pq_kem_extension_required=0},
+    { .version="20191016_tls13", .preferences=&cipher_preferences_20191016_tls13, .ecc_extension_required=0, .pq_kem_extension_required=0},
     { .version="20170405", .preferences=&cipher_preferences_20170405, .ecc_extension_required=0, .pq_kem_extension_required=0},
     { .version="20170718", .preferences=&cipher_preferences_20170718, .ecc_extension_required=0, .pq_kem_extension_required=0},
     { .version="20190120", .preferences=&cipher_preferences_20190120, .ecc_extension_required=0, .pq_kem_extension_required=0},
@@ -877,6 +916,17 @@ int s2n_find_cipher_pref_from_version(const char *version, const struct s2n_ciph
     S2N_ERROR(S2N_ERR_INVALID_CIPHER_PREFERENCES);
 }
 
+const char *s2n_cipher_preferences_version_at(int index)
+{
+    for (int i = 0; selection[i].version != NULL; i++) {
+        if (i == index) {
+            return selection[i].version;
+        }
+    }
+
+    return NULL;
+}
+
 int s2n_config_set_cipher_preferences(struct s2n_config *config, const char *version)
 {
     GUARD(s2n_find_cipher_pref_from_version(version, &config->cipher_preferences));
@@ -960,3 +1010,14 @@ int s2n_pq_kem_extension_required(const struct s2n_cipher_preferences *preferenc
     }
     S2N_ERROR(S2N_ERR_INVALID_CIPHER_PREFERENCES);
 }
+
+int s2n_encrypt_then_mac_extension_required(const struct s2n_cipher_preferences *preferences)
+{
+    notnull_check(preferences);
+    for (int i = 0; i < preferences->count; i++) {
+        if (preferences->suites[i]->available && preferences->suites[i]->etm_cipher_suite) {
+            return 1;
+        }
+    }
+    return 0;
+}
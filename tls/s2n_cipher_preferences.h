@@ -23,6 +23,11 @@ struct s2n_cipher_preferences {
     uint8_t count;
     struct s2n_cipher_suite **suites;
     int minimum_protocol_version;
+    /* Optional, one entry per suite. A non-zero entry puts suites[i] in the same equal-preference
+     * group as suites[i + 1]. Within a group the server follows the client's order, so clients
+     * can pick the cipher that is fastest on their hardware. NULL means strict server order.
+     */
+    const uint8_t *in_group_flags;
 };
 
 extern const struct s2n_cipher_preferences cipher_preferences_20140601;
@@ -38,6 +43,8 @@ extern const struct s2n_cipher_preferences cipher_preferences_20170328;
 extern const struct s2n_cipher_preferences cipher_preferences_20170405;
 extern const struct s2n_cipher_preferences cipher_preferences_20170718;
 extern const struct s2n_cipher_preferences cipher_preferences_20190214;
+extern const struct s2n_cipher_preferences cipher_preferences_20191016;
+extern const struct s2n_cipher_preferences cipher_preferences_20191016_tls13;
 extern const struct s2n_cipher_preferences cipher_preferences_test_all;
 extern const struct s2n_cipher_preferences cipher_preferences_test_all_fips;
 extern const struct s2n_cipher_preferences cipher_preferences_test_all_ecdsa;
@@ -57,6 +64,9 @@ extern const struct s2n_cipher_preferences elb_security_policy_fs_1_2_res_2019_0
 
 extern int s2n_cipher_preferences_init();
 extern int s2n_find_cipher_pref_from_version(const char *version, const struct s2n_cipher_preferences **cipher_preferences);
+/* Lists the versions s2n_find_cipher_pref_from_version accepts. Returns NULL past the last one. */
+extern const char *s2n_cipher_preferences_version_at(int index);
 extern int s2n_config_set_cipher_preferences(struct s2n_config *config, const char *version);
 extern int s2n_ecc_extension_required(const struct s2n_cipher_preferences *preferences);
 extern int s2n_pq_kem_extension_required(const struct s2n_cipher_preferences *preferences);
+extern int s2n_encrypt_then_mac_extension_required(const struct s2n_cipher_preferences *preferences);
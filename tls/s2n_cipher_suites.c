@@ -852,10 +852,13 @@ const struct s2n_cipher_preferences cipher_preferences_test_ecdsa_priority = {
 int s2n_cipher_suites_init(void)
 {
     const int num_cipher_suites = sizeof(s2n_all_cipher_suites) / sizeof(s2n_all_cipher_suites[0]);
+    lte_check(num_cipher_suites, S2N_CIPHER_SUITE_COUNT);
+
     for (int i = 0; i < num_cipher_suites; i++) {
         struct s2n_cipher_suite *cur_suite = s2n_all_cipher_suites[i];
         cur_suite->available = 0;
         cur_suite->record_alg = NULL;
+        cur_suite->index = i;
 
         /* Find the highest priority supported record algorithm */
         for (int j = 0; j < cur_suite->num_record_algs; j++) {
@@ -883,6 +886,28 @@ int s2n_cipher_suites_init(void)
         } else {
             cur_suite->sslv3_cipher_suite = cur_suite;
         }
+
+        /* Initialize the Encrypt-then-MAC cipher suite from the highest priority plain CBC record algorithm */
+        cur_suite->etm_cipher_suite = NULL;
+        for (int j = 0; j < cur_suite->num_record_algs; j++) {
+            const struct s2n_record_algorithm *record_alg = cur_suite->all_record_algs[j];
+            if (record_alg->cipher->type != S2N_CBC || !record_alg->cipher->is_available()) {
+                continue;
+            }
+
+            if (record_alg == cur_suite->record_alg) {
+                cur_suite->etm_cipher_suite = cur_suite;
+            } else {
+                struct s2n_blob cur_suite_mem = {.data = (uint8_t *) cur_suite, .size = sizeof(struct s2n_cipher_suite)};
+                struct s2n_blob new_suite_mem = {0};
+                GUARD(s2n_dup(&cur_suite_mem, &new_suite_mem));
+
+                struct s2n_cipher_suite *new_suite = (struct s2n_cipher_suite *)(void *) new_suite_mem.data;
+                new_suite->record_alg = record_alg;
+                cur_suite->etm_cipher_suite = new_suite;
+            }
+            break;
+        }
     }
 
 #if !S2N_OPENSSL_VERSION_AT_LEAST(1, 1, 0)
@@ -909,6 +934,12 @@ int s2n_cipher_suites_cleanup(void)
             GUARD(s2n_free_object((uint8_t **)&cur_suite->sslv3_cipher_suite, sizeof(struct s2n_cipher_suite)));
         }
         cur_suite->sslv3_cipher_suite = NULL;
+
+        /* Release custom Encrypt-then-MAC cipher suites */
+        if (cur_suite->etm_cipher_suite && cur_suite->etm_cipher_suite != cur_suite) {
+            GUARD(s2n_free_object((uint8_t **)&cur_suite->etm_cipher_suite, sizeof(struct s2n_cipher_suite)));
+        }
+        cur_suite->etm_cipher_suite = NULL;
     }
 
 #if !S2N_OPENSSL_VERSION_AT_LEAST(1, 1, 0)
@@ -922,7 +953,7 @@ int s2n_cipher_suites_cleanup(void)
     return 0;
 }
 
-struct s2n_cipher_suite *s2n_cipher_suite_from_wire(const uint8_t cipher_suite[S2N_TLS_CIPHER_SUITE_LEN])
+static int s2n_cipher_suite_index_from_wire(const uint8_t cipher_suite[S2N_TLS_CIPHER_SUITE_LEN])
 {
     int low = 0;
     int top = (sizeof(s2n_all_cipher_suites) / sizeof(struct s2n_cipher_suite*)) - 1;
@@ -934,7 +965,7 @@ struct s2n_cipher_suite *s2n_cipher_suite_from_wire(const uint8_t cipher_suite[S
         int m = memcmp(s2n_all_cipher_suites[mid]->iana_value, cipher_suite, 2);
 
         if (m == 0) {
-            return s2n_all_cipher_suites[mid];
+            return mid;
         } else if (m > 0) {
             top = mid - 1;
         } else if (m < 0) {
@@ -942,7 +973,17 @@ struct s2n_cipher_suite *s2n_cipher_suite_from_wire(const uint8_t cipher_suite[S
         }
     }
 
-    return NULL;
+    return -1;
+}
+
+struct s2n_cipher_suite *s2n_cipher_suite_from_wire(const uint8_t cipher_suite[S2N_TLS_CIPHER_SUITE_LEN])
+{
+    int index = s2n_cipher_suite_index_from_wire(cipher_suite);
+    if (index < 0) {
+        return NULL;
+    }
+
+    return s2n_all_cipher_suites[index];
 }
 
 int s2n_set_cipher_as_client(struct s2n_connection *conn, uint8_t wire[S2N_TLS_CIPHER_SUITE_LEN])
@@ -960,13 +1001,95 @@ int s2n_set_cipher_as_client(struct s2n_connection *conn, uint8_t wire[S2N_TLS_C
     return 0;
 }
 
-static int s2n_wire_ciphers_contain(const uint8_t * match, const uint8_t * wire, uint32_t count, uint32_t cipher_suite_len)
+/* Switch the negotiated CBC cipher suite to the record algorithm used with Encrypt-then-MAC */
+int s2n_set_cipher_encrypt_then_mac(struct s2n_connection *conn)
+{
+    S2N_ERROR_IF(conn->actual_protocol_version < S2N_TLS10 || conn->actual_protocol_version >= S2N_TLS13, S2N_ERR_ENCRYPT_THEN_MAC_NOT_CBC);
+    S2N_ERROR_IF(conn->secure.cipher_suite->etm_cipher_suite == NULL, S2N_ERR_ENCRYPT_THEN_MAC_NOT_CBC);
+
+    conn->secure.cipher_suite = conn->secure.cipher_suite->etm_cipher_suite;
+    conn->encrypt_then_mac = 1;
+
+    return 0;
+}
+
+/* Parse the client's cipher suite list in a single pass. Every suite we know about is recorded
+ * in a bitmap indexed like s2n_all_cipher_suites, along with its position in the client's list,
+ * so that matching it against our preferences doesn't need to scan the list again. Unknown
+ * values, including GREASE, are ignored.
+ */
+static int s2n_wire_ciphers_to_bitmap(const uint8_t * wire, uint32_t count, uint32_t cipher_suite_len,
+        uint64_t offered[S2N_CIPHER_SUITE_BITMAP_LEN], uint32_t client_position[S2N_CIPHER_SUITE_COUNT],
+        uint8_t *fallback_scsv, uint8_t *renegotiation_info_scsv)
 {
+    const uint8_t fallback[S2N_TLS_CIPHER_SUITE_LEN] = { TLS_FALLBACK_SCSV };
+    const uint8_t renegotiation_info[S2N_TLS_CIPHER_SUITE_LEN] = { TLS_EMPTY_RENEGOTIATION_INFO_SCSV };
+
+    memset_check(offered, 0, S2N_CIPHER_SUITE_BITMAP_LEN * sizeof(uint64_t));
+    *fallback_scsv = 0;
+    *renegotiation_info_scsv = 0;
+
+    /* Suites the client didn't offer sort after every suite it did */
+    for (int i = 0; i < S2N_CIPHER_SUITE_COUNT; i++) {
+        client_position[i] = count;
+    }
+
     for (int i = 0; i < count; i++) {
         const uint8_t *theirs = wire + (i * cipher_suite_len) + (cipher_suite_len - S2N_TLS_CIPHER_SUITE_LEN);
 
-        if (!memcmp(match, theirs, S2N_TLS_CIPHER_SUITE_LEN)) {
-            return 1;
+        int index = s2n_cipher_suite_index_from_wire(theirs);
+        if (index >= 0) {
+            /* A repeated suite keeps its first position */
+            if (client_position[index] == count) {
+                client_position[index] = i;
+            }
+            offered[index / 64] |= (uint64_t) 1 << (index % 64);
+        } else if (!memcmp(theirs, fallback, S2N_TLS_CIPHER_SUITE_LEN)) {
+            *fallback_scsv = 1;
+        } else if (!memcmp(theirs, renegotiation_info, S2N_TLS_CIPHER_SUITE_LEN)) {
+            *renegotiation_info_scsv = 1;
+        }
+    }
+
+    return 0;
+}
+
+static int s2n_wire_ciphers_bitmap_contains(const uint64_t offered[S2N_CIPHER_SUITE_BITMAP_LEN], uint8_t index)
+{
+    return (offered[index / 64] >> (index % 64)) & 1;
+}
+
+/* Work out the order in which to try our cipher suites. Groups of equally preferred suites keep
+ * their place in our list, but the suites within a group are tried in the client's order.
+ */
+static int s2n_cipher_preferences_negotiation_order(const struct s2n_cipher_preferences *cipher_preferences,
+        const uint32_t client_position[S2N_CIPHER_SUITE_COUNT], uint8_t order[UINT8_MAX])
+{
+    for (int i = 0; i < cipher_preferences->count; i++) {
+        order[i] = i;
+    }
+
+    if (cipher_preferences->in_group_flags == NULL) {
+        return 0;
+    }
+
+    int group_start = 0;
+    for (int i = 0; i < cipher_preferences->count; i++) {
+        /* Insertion sort keeps suites the client ranks equally (i.e. didn't offer) in our order */
+        for (int j = i; j > group_start; j--) {
+            uint8_t previous = cipher_preferences->suites[order[j - 1]]->index;
+            uint8_t current = cipher_preferences->suites[order[j]]->index;
+            if (client_position[previous] <= client_position[current]) {
+                break;
+            }
+
+            uint8_t swap = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = swap;
+        }
+
+        if (!cipher_preferences->in_group_flags[i]) {
+            group_start = i + 1;
         }
     }
 
@@ -993,38 +1116,43 @@ static struct s2n_cert_chain_and_key *s2n_conn_get_compatible_cert_chain_and_key
 
 static int s2n_set_cipher_and_cert_as_server(struct s2n_connection *conn, uint8_t * wire, uint32_t count, uint32_t cipher_suite_len)
 {
-    uint8_t renegotiation_info_scsv[S2N_TLS_CIPHER_SUITE_LEN] = { TLS_EMPTY_RENEGOTIATION_INFO_SCSV };
     struct s2n_cipher_suite *higher_vers_match = NULL;
     struct s2n_cert_chain_and_key *higher_vers_cert = NULL;
 
+    uint64_t offered[S2N_CIPHER_SUITE_BITMAP_LEN];
+    uint32_t client_position[S2N_CIPHER_SUITE_COUNT];
+    uint8_t fallback_scsv;
+    uint8_t renegotiation_info_scsv;
+    GUARD(s2n_wire_ciphers_to_bitmap(wire, count, cipher_suite_len, offered, client_position, &fallback_scsv, &renegotiation_info_scsv));
+
     /* RFC 7507 - If client is attempting to negotiate a TLS Version that is lower than the highest supported server
      * version, and the client cipher list contains TLS_FALLBACK_SCSV, then the server must abort the connection since
      * TLS_FALLBACK_SCSV should only be present when the client previously failed to negotiate a higher TLS version.
      */
-    if (conn->client_protocol_version < s2n_highest_protocol_version) {
-        uint8_t fallback_scsv[S2N_TLS_CIPHER_SUITE_LEN] = { TLS_FALLBACK_SCSV };
-        if (s2n_wire_ciphers_contain(fallback_scsv, wire, count, cipher_suite_len)) {
-            conn->closed = 1;
-            S2N_ERROR(S2N_ERR_FALLBACK_DETECTED);
-        }
+    if (conn->client_protocol_version < s2n_highest_protocol_version && fallback_scsv) {
+        conn->closed = 1;
+        S2N_ERROR(S2N_ERR_FALLBACK_DETECTED);
     }
 
     /* RFC5746 Section 3.6: A server must check if TLS_EMPTY_RENEGOTIATION_INFO_SCSV is included */
-    if (s2n_wire_ciphers_contain(renegotiation_info_scsv, wire, count, cipher_suite_len)) {
+    if (renegotiation_info_scsv) {
         conn->secure_renegotiation = 1;
     }
 
     const struct s2n_cipher_preferences *cipher_preferences;
     GUARD(s2n_connection_get_cipher_preferences(conn, &cipher_preferences));
 
-    /* s2n supports only server order */
+    /* Server order, except within groups of equally preferred suites */
+    uint8_t order[UINT8_MAX];
+    GUARD(s2n_cipher_preferences_negotiation_order(cipher_preferences, client_position, order));
+
     for (int i = 0; i < cipher_preferences->count; i++) {
         conn->handshake_params.our_chain_and_key = NULL;
-        const uint8_t *ours = cipher_preferences->suites[i]->iana_value;
+        const uint8_t index = cipher_preferences->suites[order[i]]->index;
 
-        if (s2n_wire_ciphers_contain(ours, wire, count, cipher_suite_len)) {
+        if (s2n_wire_ciphers_bitmap_contains(offered, index)) {
             /* We have a match */
-            struct s2n_cipher_suite *match = s2n_cipher_suite_from_wire(ours);
+            struct s2n_cipher_suite *match = s2n_all_cipher_suites[index];
 
             /* If connection is for SSLv3, use SSLv3 version of suites */
             if (conn->client_protocol_version == S2N_SSLv3) {
@@ -33,6 +33,9 @@
 #define S2N_MAX_POSSIBLE_RECORD_ALGS    2
 #define S2N_CIPHER_SUITE_COUNT          38 /* Kept up-to-date by s2n_cipher_suite_match_test */
 
+/* One bit per cipher suite s2n knows about, used to match the client's offered suites */
+#define S2N_CIPHER_SUITE_BITMAP_LEN     ((S2N_CIPHER_SUITE_COUNT + 63) / 64)
+
 /* Record algorithm flags that can be OR'ed */
 #define S2N_TLS12_AES_GCM_AEAD_NONCE     0x01
 #define S2N_TLS12_CHACHA_POLY_AEAD_NONCE 0x02
@@ -65,6 +68,9 @@ struct s2n_cipher_suite {
     /* Is there an implementation available? Set in s2n_cipher_suites_init() */
     unsigned int available:1;
 
+    /* Position in the table of all cipher suites, in order of IANA value. Set in s2n_cipher_suites_init() */
+    uint8_t index;
+
     /* Cipher name in Openssl format */
     const char *name;
     const uint8_t iana_value[S2N_TLS_CIPHER_SUITE_LEN];
@@ -84,6 +90,11 @@ struct s2n_cipher_suite {
     const struct s2n_record_algorithm *sslv3_record_alg;
     struct s2n_cipher_suite *sslv3_cipher_suite;
 
+    /* Encrypt-then-MAC (RFC7366) needs the MAC kept apart from the CBC cipher, so composite
+     * record algorithms can't be used. NULL if the suite isn't a CBC suite.
+     */
+    struct s2n_cipher_suite *etm_cipher_suite;
+
     /* RFC 5426(TLS1.2) allows cipher suite defined PRFs. Cipher suites defined in and before TLS1.2 will use
      * P_hash with SHA256 when TLS1.2 is negotiated.
      */
@@ -138,5 +149,6 @@ extern int s2n_cipher_suites_init(void);
 extern int s2n_cipher_suites_cleanup(void);
 extern struct s2n_cipher_suite *s2n_cipher_suite_from_wire(const uint8_t cipher_suite[S2N_TLS_CIPHER_SUITE_LEN]);
 extern int s2n_set_cipher_as_client(struct s2n_connection *conn, uint8_t wire[S2N_TLS_CIPHER_SUITE_LEN]);
+extern int s2n_set_cipher_encrypt_then_mac(struct s2n_connection *conn);
 extern int s2n_set_cipher_and_cert_as_sslv2_server(struct s2n_connection *conn, uint8_t * wire, uint16_t count);
 extern int s2n_set_cipher_and_cert_as_tls_server(struct s2n_connection *conn, uint8_t * wire, uint16_t count);
@@ -15,6 +15,7 @@
 
 #include <stdint.h>
 #include <string.h>
+#include <sys/param.h>
 
 #include "error/s2n_errno.h"
 
@@ -45,6 +46,8 @@ static int s2n_recv_client_sct_list(struct s2n_connection *conn, struct s2n_stuf
 static int s2n_recv_client_max_frag_len(struct s2n_connection *conn, struct s2n_stuffer *extension);
 static int s2n_recv_client_session_ticket_ext(struct s2n_connection *conn, struct s2n_stuffer *extension);
 static int s2n_recv_pq_kem_extension(struct s2n_connection *conn, struct s2n_stuffer *extension);
+static int s2n_recv_client_encrypt_then_mac(struct s2n_connection *conn, struct s2n_stuffer *extension);
+static int s2n_recv_client_record_size_limit(struct s2n_connection *conn, struct s2n_stuffer *extension);
 
 static int s2n_send_client_signature_algorithms_extension(struct s2n_connection *conn, struct s2n_stuffer *out)
 {
@@ -99,6 +102,9 @@ int s2n_client_extensions_send(struct s2n_connection *conn, struct s2n_stuffer *
     if (conn->config->mfl_code != S2N_TLS_MAX_FRAG_LEN_EXT_NONE) {
         total_size += 5;
     }
+    if (conn->config->record_size_limit) {
+        total_size += 6;
+    }
     if (conn->config->use_tickets) {
         total_size += 4 + client_ticket_len;
     }
@@ -113,6 +119,12 @@ int s2n_client_extensions_send(struct s2n_connection *conn, struct s2n_stuffer *
         total_size += 12 + ec_curves_count * 2;
     }
 
+    /* RFC7366: Offer Encrypt-then-MAC if we might negotiate a CBC suite */
+    const uint8_t encrypt_then_mac_extension_required = s2n_encrypt_then_mac_extension_required(cipher_preferences);
+    if (encrypt_then_mac_extension_required) {
+        total_size += 4;
+    }
+
     const uint8_t pq_kem_extension_required = s2n_pq_kem_extension_required(cipher_preferences);
     if (pq_kem_extension_required) {
         for (int i = 0; i < cipher_preferences->count; i++) {
@@ -193,6 +205,14 @@ int s2n_client_extensions_send(struct s2n_connection *conn, struct s2n_stuffer *
         GUARD(s2n_stuffer_write_uint8(out, conn->config->mfl_code));
     }
 
+    /* Write Record Size Limit extension */
+    if (conn->config->record_size_limit) {
+        GUARD(s2n_stuffer_write_uint16(out, TLS_EXTENSION_RECORD_SIZE_LIMIT));
+        GUARD(s2n_stuffer_write_uint16(out, sizeof(uint16_t)));
+        GUARD(s2n_stuffer_write_uint16(out, conn->config->record_size_limit));
+        conn->record_size_limit = conn->config->record_size_limit;
+    }
+
     /* Write Session Tickets extension */
     if (conn->config->use_tickets) {
         GUARD(s2n_stuffer_write_uint16(out, TLS_EXTENSION_SESSION_TICKET));
@@ -200,6 +220,13 @@ int s2n_client_extensions_send(struct s2n_connection *conn, struct s2n_stuffer *
         GUARD(s2n_stuffer_write(out, &conn->client_ticket));
     }
 
+    /* Write Encrypt-then-MAC extension */
+    if (encrypt_then_mac_extension_required) {
+        GUARD(s2n_stuffer_write_uint16(out, TLS_EXTENSION_ENCRYPT_THEN_MAC));
+        GUARD(s2n_stuffer_write_uint16(out, 0));
+        conn->encrypt_then_mac_requested = 1;
+    }
+
     /*
      * RFC 4492: Clients SHOULD send both the Supported Elliptic Curves Extension (renamed
      * Supported Groups in TLS 1.3 RFC 8446) and the Supported Point Formats Extension.
@@ -244,17 +271,19 @@ int s2n_client_extensions_send(struct s2n_connection *conn, struct s2n_stuffer *
     return 0;
 }
 
-int s2n_client_extensions_recv(struct s2n_connection *conn, struct s2n_array *parsed_extensions)
+int s2n_client_extensions_recv(struct s2n_connection *conn, struct s2n_blob *parsed_extensions)
 {
-    for (int i = 0; i < parsed_extensions->num_of_elements; i++) {
-        struct s2n_client_hello_parsed_extension *parsed_extension = s2n_array_get(parsed_extensions, i);
-        notnull_check(parsed_extension);
+    /* Process the extensions the client sent, in order of extension type */
+    for (int i = 0; i < S2N_SUPPORTED_EXTENSIONS_COUNT; i++) {
+        if (parsed_extensions[i].data == NULL) {
+            continue;
+        }
 
         struct s2n_stuffer extension = {0};
-        GUARD(s2n_stuffer_init(&extension, &parsed_extension->extension));
-        GUARD(s2n_stuffer_write(&extension, &parsed_extension->extension));
+        GUARD(s2n_stuffer_init(&extension, &parsed_extensions[i]));
+        GUARD(s2n_stuffer_write(&extension, &parsed_extensions[i]));
 
-        switch (parsed_extension->extension_type) {
+        switch (s2n_supported_extensions[i]) {
         case TLS_EXTENSION_SERVER_NAME:
             GUARD(s2n_parse_client_hello_server_name(conn, &extension));
             break;
@@ -285,6 +314,12 @@ int s2n_client_extensions_recv(struct s2n_connection *conn, struct s2n_array *pa
         case TLS_EXTENSION_SESSION_TICKET:
             GUARD(s2n_recv_client_session_ticket_ext(conn, &extension));
             break;
+        case TLS_EXTENSION_ENCRYPT_THEN_MAC:
+            GUARD(s2n_recv_client_encrypt_then_mac(conn, &extension));
+            break;
+        case TLS_EXTENSION_RECORD_SIZE_LIMIT:
+            GUARD(s2n_recv_client_record_size_limit(conn, &extension));
+            break;
         case TLS_EXTENSION_PQ_KEM_PARAMETERS:
             GUARD(s2n_recv_pq_kem_extension(conn, &extension));
             break;
@@ -297,6 +332,12 @@ int s2n_client_extensions_recv(struct s2n_connection *conn, struct s2n_array *pa
         }
     }
 
+    /* RFC8449 Section 5: a server that negotiates record_size_limit ignores max_fragment_length */
+    if (conn->peer_record_size_limit && conn->mfl_code) {
+        conn->mfl_code = S2N_TLS_MAX_FRAG_LEN_EXT_NONE;
+        conn->max_outgoing_fragment_length = S2N_DEFAULT_FRAGMENT_LENGTH;
+    }
+
     return 0;
 }
 
@@ -515,6 +556,31 @@ static int s2n_recv_client_session_ticket_ext(struct s2n_connection *conn, struc
 
     return 0;
 }
+
+static int s2n_recv_client_encrypt_then_mac(struct s2n_connection *conn, struct s2n_stuffer *extension)
+{
+    /* RFC7366 Section 2: The extension_data field is empty */
+    if (s2n_stuffer_data_available(extension)) {
+        /* Malformed extension, ignore it */
+        return 0;
+    }
+
+    conn->encrypt_then_mac_requested = 1;
+    return 0;
+}
+
+static int s2n_recv_client_record_size_limit(struct s2n_connection *conn, struct s2n_stuffer *extension)
+{
+    uint16_t record_size_limit;
+    S2N_ERROR_IF(s2n_stuffer_data_available(extension) != sizeof(record_size_limit), S2N_ERR_BAD_MESSAGE);
+    GUARD(s2n_stuffer_read_uint16(extension, &record_size_limit));
+    S2N_ERROR_IF(record_size_limit < S2N_TLS_MINIMUM_RECORD_SIZE_LIMIT, S2N_ERR_INVALID_RECORD_SIZE_LIMIT);
+
+    /* TLS 1.3 clients may count the inner content type and ask for one byte more than the maximum fragment */
+    conn->peer_record_size_limit = MIN(record_size_limit, S2N_TLS_MAXIMUM_FRAGMENT_LENGTH);
+    return 0;
+}
+
 static int s2n_recv_pq_kem_extension(struct s2n_connection *conn, struct s2n_stuffer *extension)
 {
     uint16_t size_of_all;
@@ -25,7 +25,6 @@ struct s2n_client_hello_parsed_extension {
 	struct s2n_blob extension;
 };
 
-extern int s2n_client_hello_get_parsed_extension(struct s2n_array *parsed_extensions, s2n_tls_extension_type extension_type,
+extern int s2n_client_hello_get_parsed_extension(struct s2n_client_hello *ch, s2n_tls_extension_type extension_type,
         struct s2n_client_hello_parsed_extension *parsed_extension);
 extern int s2n_parse_client_hello_server_name(struct s2n_connection *conn, struct s2n_stuffer *extension);
-extern void s2n_register_extension(uint16_t ext_type);
@@ -42,10 +42,44 @@
 
 typedef char s2n_tls_extension_mask[8192];
 
-static s2n_tls_extension_mask s2n_suported_extensions = { 0 };
+/* New extensions MUST be added here, IN ORDER, and S2N_SUPPORTED_EXTENSIONS_COUNT updated */
+const uint16_t s2n_supported_extensions[S2N_SUPPORTED_EXTENSIONS_COUNT] = {
+    TLS_EXTENSION_SERVER_NAME,
+    TLS_EXTENSION_MAX_FRAG_LEN,
+    TLS_EXTENSION_STATUS_REQUEST,
+    TLS_EXTENSION_SUPPORTED_GROUPS,
+    TLS_EXTENSION_EC_POINT_FORMATS,
+    TLS_EXTENSION_SIGNATURE_ALGORITHMS,
+    TLS_EXTENSION_ALPN,
+    TLS_EXTENSION_SCT_LIST,
+    TLS_EXTENSION_ENCRYPT_THEN_MAC,
+    TLS_EXTENSION_RECORD_SIZE_LIMIT,
+    TLS_EXTENSION_SESSION_TICKET,
+    TLS_EXTENSION_SUPPORTED_VERSIONS,
+    TLS_EXTENSION_KEY_SHARE,
+    TLS_EXTENSION_PQ_KEM_PARAMETERS,
+    TLS_EXTENSION_RENEGOTIATION_INFO,
+};
+
+/* Returns the position of extension_type in s2n_supported_extensions, or -1 if s2n doesn't parse it */
+int s2n_supported_extension_index(uint16_t extension_type)
+{
+    int low = 0;
+    int top = S2N_SUPPORTED_EXTENSIONS_COUNT - 1;
+
+    while (low <= top) {
+        int mid = low + ((top - low) / 2);
+
+        if (s2n_supported_extensions[mid] == extension_type) {
+            return mid;
+        } else if (s2n_supported_extensions[mid] > extension_type) {
+            top = mid - 1;
+        } else {
+            low = mid + 1;
+        }
+    }
 
-void s2n_register_extension(uint16_t ext_type) {
-    S2N_CBIT_SET(s2n_suported_extensions, ext_type);
+    return -1;
 }
 
 struct s2n_client_hello *s2n_connection_get_client_hello(struct s2n_connection *conn) {
@@ -136,9 +170,10 @@ int s2n_client_hello_free(struct s2n_client_hello *client_hello)
 int s2n_client_hello_free_parsed_extensions(struct s2n_client_hello *client_hello)
 {
     notnull_check(client_hello);
-    if (client_hello->parsed_extensions != NULL) {
-        GUARD(s2n_array_free_p(&client_hello->parsed_extensions));
-    }
+
+    /* The parsed extensions point into raw_message, so there is nothing to free */
+    memset_check(&client_hello->parsed_extensions, 0, sizeof(client_hello->parsed_extensions));
+
     return 0;
 }
 
@@ -218,9 +253,7 @@ static int s2n_process_client_hello(struct s2n_connection *conn)
 {
     struct s2n_client_hello *client_hello = &conn->client_hello;
 
-    if (client_hello->parsed_extensions != NULL && client_hello->parsed_extensions->num_of_elements > 0) {
-        GUARD(s2n_client_extensions_recv(conn, client_hello->parsed_extensions));
-    }
+    GUARD(s2n_client_extensions_recv(conn, client_hello->parsed_extensions));
 
     const struct s2n_cipher_preferences *cipher_preferences;
     GUARD(s2n_connection_get_cipher_preferences(conn, &cipher_preferences));
@@ -236,6 +269,12 @@ static int s2n_process_client_hello(struct s2n_connection *conn)
     /* Now choose the ciphers and the cert chain. */
     GUARD(s2n_set_cipher_and_cert_as_tls_server(conn, client_hello->cipher_suites.data, client_hello->cipher_suites.size / 2));
 
+    /* Protect CBC records with Encrypt-then-MAC if the client offered it */
+    if (conn->encrypt_then_mac_requested && conn->secure.cipher_suite->etm_cipher_suite
+            && conn->actual_protocol_version >= S2N_TLS10 && conn->actual_protocol_version < S2N_TLS13) {
+        GUARD(s2n_set_cipher_encrypt_then_mac(conn));
+    }
+
     /* And set the signature and hash algorithm used for key exchange signatures */
     GUARD(s2n_set_signature_hash_pair_from_preference_list(conn, &conn->handshake_params.client_sig_hash_algs, &conn->secure.conn_hash_alg, &conn->secure.conn_sig_alg));
     /* Set the handshake type */
@@ -247,25 +286,15 @@ static int s2n_process_client_hello(struct s2n_connection *conn)
     return 0;
 }
 
-static int s2n_parsed_extensions_compare(const void *p, const void *q)
-{
-    const struct s2n_client_hello_parsed_extension *left = (const struct s2n_client_hello_parsed_extension *) p;
-    const struct s2n_client_hello_parsed_extension *right = (const struct s2n_client_hello_parsed_extension *) q;
-
-    return (int)left->extension_type - (int)right->extension_type;
-}
-
 static int s2n_populate_client_hello_extensions(struct s2n_client_hello *ch)
 {
+    GUARD(s2n_client_hello_free_parsed_extensions(ch));
+
     if (ch->extensions.size == 0) {
         /* Client hello with no extensions, might be SSLv3, exit early */
         return 0;
     }
 
-    if (ch->parsed_extensions == NULL) {
-        notnull_check(ch->parsed_extensions = s2n_array_new(sizeof(struct s2n_client_hello_parsed_extension)));
-    }
-
     struct s2n_stuffer in = {0};
 
     GUARD(s2n_stuffer_init(&in, &ch->extensions));
@@ -286,25 +315,18 @@ static int s2n_populate_client_hello_extensions(struct s2n_client_hello *ch)
         S2N_ERROR_IF(S2N_CBIT_TEST(parsed_extensions_mask, ext_type), S2N_ERR_BAD_MESSAGE);
         S2N_CBIT_SET(parsed_extensions_mask, ext_type);
 
-        /* Skip invalid/unknown extensions */
-        if (!S2N_CBIT_TEST(s2n_suported_extensions, ext_type)) {
-            s2n_stuffer_skip_read(&in, ext_size);
+        /* Record where supported extensions are, and skip invalid/unknown ones */
+        int index = s2n_supported_extension_index(ext_type);
+        if (index < 0) {
+            GUARD(s2n_stuffer_skip_read(&in, ext_size));
             continue;
         }
 
-        struct s2n_client_hello_parsed_extension *parsed_extension = s2n_array_add(ch->parsed_extensions);
-        notnull_check(parsed_extension);
-
-        parsed_extension->extension_type = ext_type;
-        parsed_extension->extension.size = ext_size;
-
-        parsed_extension->extension.data = s2n_stuffer_raw_read(&in, ext_size);
-        notnull_check(parsed_extension->extension.data);
+        ch->parsed_extensions[index].size = ext_size;
+        ch->parsed_extensions[index].data = s2n_stuffer_raw_read(&in, ext_size);
+        notnull_check(ch->parsed_extensions[index].data);
     }
 
-    /* Sort extensions by extension type */
-    qsort(ch->parsed_extensions->elements, ch->parsed_extensions->num_of_elements, ch->parsed_extensions->element_size, s2n_parsed_extensions_compare);
-
     return 0;
 }
 
@@ -476,35 +498,46 @@ int s2n_sslv2_client_hello_recv(struct s2n_connection *conn)
     return 0;
 }
 
-int s2n_client_hello_get_parsed_extension(struct s2n_array *parsed_extensions, s2n_tls_extension_type extension_type,
+int s2n_client_hello_get_parsed_extension(struct s2n_client_hello *ch, s2n_tls_extension_type extension_type,
         struct s2n_client_hello_parsed_extension *parsed_extension)
 {
-    notnull_check(parsed_extensions);
-
-    struct s2n_client_hello_parsed_extension search = {0};
-    search.extension_type = extension_type;
-
-    struct s2n_client_hello_parsed_extension *result_extension = bsearch(&search, parsed_extensions->elements, parsed_extensions->num_of_elements,
-            parsed_extensions->element_size, s2n_parsed_extensions_compare);
+    notnull_check(ch);
 
-    notnull_check(result_extension);
+    int index = s2n_supported_extension_index(extension_type);
+    gte_check(index, 0);
+    notnull_check(ch->parsed_extensions[index].data);
 
-    parsed_extension->extension_type = result_extension->extension_type;
-    parsed_extension->extension = result_extension->extension;
+    parsed_extension->extension_type = extension_type;
+    parsed_extension->extension = ch->parsed_extensions[index];
     return 0;
 }
 
 ssize_t s2n_client_hello_get_extension_length(struct s2n_client_hello *ch, s2n_tls_extension_type extension_type)
 {
     notnull_check(ch);
-    notnull_check(ch->parsed_extensions);
 
     struct s2n_client_hello_parsed_extension parsed_extension = {0};
 
-    if (s2n_client_hello_get_parsed_extension(ch->parsed_extensions, extension_type, &parsed_extension)) {
+    if (s2n_client_hello_get_parsed_extension(ch, extension_type, &parsed_extension)) {
+        return 0;
+    }
+
+    return parsed_extension.extension.size;
+}
+
+ssize_t s2n_client_hello_get_extension_ptr(struct s2n_client_hello *ch, s2n_tls_extension_type extension_type, const uint8_t **out)
+{
+    notnull_check(ch);
+    notnull_check(out);
+
+    struct s2n_client_hello_parsed_extension parsed_extension = {0};
+
+    *out = NULL;
+    if (s2n_client_hello_get_parsed_extension(ch, extension_type, &parsed_extension)) {
         return 0;
     }
 
+    *out = parsed_extension.extension.data;
     return parsed_extension.extension.size;
 }
 
@@ -512,11 +545,10 @@ ssize_t s2n_client_hello_get_extension_by_id(struct s2n_client_hello *ch, s2n_tl
 {
     notnull_check(ch);
     notnull_check(out);
-    notnull_check(ch->parsed_extensions);
 
     struct s2n_client_hello_parsed_extension parsed_extension = {0};
 
-    if (s2n_client_hello_get_parsed_extension(ch->parsed_extensions, extension_type, &parsed_extension)) {
+    if (s2n_client_hello_get_parsed_extension(ch, extension_type, &parsed_extension)) {
         return 0;
     }
 
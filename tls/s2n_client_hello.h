@@ -20,7 +20,10 @@
 
 #include "stuffer/s2n_stuffer.h"
 
-#include "utils/s2n_array.h"
+#include "utils/s2n_blob.h"
+
+/* Number of extensions in s2n_supported_extensions */
+#define S2N_SUPPORTED_EXTENSIONS_COUNT  15
 
 struct s2n_client_hello {
     struct s2n_stuffer raw_message;
@@ -31,11 +34,19 @@ struct s2n_client_hello {
      */
     struct s2n_blob cipher_suites;
     struct s2n_blob extensions;
-    struct s2n_array *parsed_extensions;
+
+    /* The supported extensions sent by the client, indexed like s2n_supported_extensions.
+     * Extensions the client didn't send have a NULL data pointer.
+     */
+    struct s2n_blob parsed_extensions[S2N_SUPPORTED_EXTENSIONS_COUNT];
 
     unsigned int parsed:1;
 };
 
+/* The extensions s2n parses from a ClientHello, in order of extension type */
+extern const uint16_t s2n_supported_extensions[S2N_SUPPORTED_EXTENSIONS_COUNT];
+extern int s2n_supported_extension_index(uint16_t extension_type);
+
 int s2n_client_hello_free(struct s2n_client_hello *client_hello);
 int s2n_client_hello_free_parsed_extensions(struct s2n_client_hello *client_hello);
 
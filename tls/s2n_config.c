@@ -80,6 +80,7 @@ static int s2n_config_init(struct s2n_config *config)
 {
     config->cert_allocated = 0;
     config->dhparams = NULL;
+    config->ephemeral_key_pool = NULL;
     memset(&config->application_protocols, 0, sizeof(config->application_protocols));
     config->status_request_type = S2N_STATUS_REQUEST_NONE;
     config->wall_clock = wall_clock;
@@ -98,6 +99,7 @@ static int s2n_config_init(struct s2n_config *config)
     config->mfl_code = S2N_TLS_MAX_FRAG_LEN_EXT_NONE;
     config->alert_behavior = S2N_ALERT_FAIL_ON_WARNINGS;
     config->accept_mfl = 0;
+    config->record_size_limit = 0;
     config->session_state_lifetime_in_nanos = S2N_STATE_LIFETIME_IN_NANOS;
     config->use_tickets = 0;
     config->ticket_keys = NULL;
@@ -144,6 +146,7 @@ static int s2n_config_cleanup(struct s2n_config *config)
     GUARD(s2n_config_free_session_ticket_keys(config));
     GUARD(s2n_config_free_cert_chain_and_key(config));
     GUARD(s2n_config_free_dhparams(config));
+    GUARD(s2n_ephemeral_key_pool_free(&config->ephemeral_key_pool));
     GUARD(s2n_free(&config->application_protocols));
     GUARD(s2n_map_free(config->domain_name_to_cert_map));
 
@@ -680,6 +683,18 @@ int s2n_config_accept_max_fragment_length(struct s2n_config *config)
     return 0;
 }
 
+int s2n_config_set_record_size_limit(struct s2n_config *config, uint16_t limit)
+{
+    notnull_check(config);
+
+    S2N_ERROR_IF(limit != 0 && (limit < S2N_TLS_MINIMUM_RECORD_SIZE_LIMIT || limit > S2N_TLS_MAXIMUM_FRAGMENT_LENGTH),
+            S2N_ERR_INVALID_RECORD_SIZE_LIMIT);
+
+    config->record_size_limit = limit;
+
+    return 0;
+}
+
 int s2n_config_set_session_state_lifetime(struct s2n_config *config,
                                           uint64_t lifetime_in_secs)
 {
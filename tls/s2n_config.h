@@ -18,9 +18,11 @@
 #include "crypto/s2n_certificate.h"
 #include "crypto/s2n_dhe.h"
 
+#include "utils/s2n_array.h"
 #include "utils/s2n_blob.h"
 #include "api/s2n.h"
 
+#include "tls/s2n_ephemeral_key_pool.h"
 #include "tls/s2n_x509_validator.h"
 #include "tls/s2n_resume.h"
 
@@ -31,6 +33,7 @@ struct s2n_cipher_preferences;
 
 struct s2n_config {
     struct s2n_dh_params *dhparams;
+    struct s2n_ephemeral_key_pool *ephemeral_key_pool;
     /* Needed until we can deprecate s2n_config_add_cert_chain_and_key. This is
      * used to release memory allocated only in the deprecated API that the application 
      * does not have a reference to. */
@@ -87,6 +90,11 @@ struct s2n_config {
     /* if this is FALSE, server will ignore client's Maximum Fragment Length request */
     int accept_mfl;
 
+    /* RFC8449 record_size_limit: the largest plaintext we accept in a record. Clients only
+     * send the extension when this is set, servers echo it, or the protocol maximum, when asked.
+     */
+    uint16_t record_size_limit;
+
     struct s2n_x509_trust_store trust_store;
     uint8_t check_ocsp;
     uint8_t disable_x509_validation;
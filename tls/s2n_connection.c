@@ -44,6 +44,7 @@
 #include "crypto/s2n_cipher.h"
 
 #include "utils/s2n_compiler.h"
+#include "utils/s2n_io_uring.h"
 #include "utils/s2n_random.h"
 #include "utils/s2n_safety.h"
 #include "utils/s2n_socket.h"
@@ -178,6 +179,7 @@ struct s2n_connection *s2n_connection_new(s2n_mode mode)
     conn->recv_io_context = NULL;
     conn->managed_io = 0;
     conn->corked_io = 0;
+    conn->msg_more_io = 0;
     conn->context = NULL;
     conn->cipher_pref_override = NULL;
     conn->ticket_lifetime_hint = 0;
@@ -246,6 +248,27 @@ static int s2n_connection_free_keys(struct s2n_connection *conn)
     return 0;
 }
 
+static int s2n_connection_alloc_crypto_state(struct s2n_connection *conn)
+{
+    /* Reallocate everything that s2n_connection_hibernate released */
+    GUARD(s2n_session_key_alloc(&conn->secure.client_key));
+    GUARD(s2n_session_key_alloc(&conn->secure.server_key));
+    GUARD(s2n_session_key_alloc(&conn->initial.client_key));
+    GUARD(s2n_session_key_alloc(&conn->initial.server_key));
+
+    GUARD(s2n_prf_new(conn));
+
+    GUARD(s2n_connection_new_hashes(conn));
+    GUARD(s2n_connection_init_hashes(conn));
+
+    GUARD(s2n_connection_new_hmacs(conn));
+    GUARD(s2n_connection_init_hmacs(conn));
+
+    conn->hibernating = 0;
+
+    return 0;
+}
+
 static int s2n_connection_zero(struct s2n_connection *conn, int mode, struct s2n_config *config)
 {
     /* Zero the whole connection structure */
@@ -358,6 +381,8 @@ static int s2n_connection_free_io_contexts(struct s2n_connection *conn)
 
 static int s2n_connection_wipe_io(struct s2n_connection *conn)
 {
+    GUARD(s2n_io_uring_release(conn));
+
     if (s2n_connection_is_managed_corked(conn) && conn->recv){
         GUARD(s2n_socket_read_restore(conn));
     }
@@ -409,6 +434,29 @@ static int s2n_connection_free_hmacs(struct s2n_connection *conn)
     return 0;
 }
 
+static int s2n_connection_release_crypto_state(struct s2n_connection *conn)
+{
+    /* Undo a partial s2n_connection_alloc_crypto_state: only free what was allocated */
+    struct s2n_session_key *keys[] = {
+        &conn->secure.client_key, &conn->secure.server_key,
+        &conn->initial.client_key, &conn->initial.server_key
+    };
+    for (int i = 0; i < s2n_array_len(keys); i++) {
+        if (keys[i]->evp_cipher_ctx) {
+            GUARD(s2n_session_key_free(keys[i]));
+        }
+    }
+
+    /* The EVP p_hash free refuses a NULL context; the others are no-ops on released state */
+    if (!s2n_is_in_fips_mode() || conn->prf_space.tls.p_hash.evp_hmac.evp_digest.ctx) {
+        GUARD(s2n_prf_free(conn));
+    }
+    GUARD(s2n_connection_free_hashes(conn));
+    GUARD(s2n_connection_free_hmacs(conn));
+
+    return 0;
+}
+
 static uint8_t s2n_default_verify_host(const char *host_name, size_t len, void *data)
 {
     /* if present, match server_name of the connection using rules
@@ -445,6 +493,15 @@ static uint8_t s2n_default_verify_host(const char *host_name, size_t len, void *
 
 int s2n_connection_free(struct s2n_connection *conn)
 {
+    if (conn->group) {
+        GUARD(s2n_connection_group_remove(conn->group, conn));
+    }
+
+    /* A hibernating connection has released the state freed below */
+    if (conn->hibernating) {
+        GUARD(s2n_connection_alloc_crypto_state(conn));
+    }
+
     GUARD(s2n_connection_wipe_keys(conn));
     GUARD(s2n_connection_free_keys(conn));
 
@@ -457,6 +514,7 @@ int s2n_connection_free(struct s2n_connection *conn)
     GUARD(s2n_connection_free_hmacs(conn));
 
     GUARD(s2n_connection_free_io_contexts(conn));
+    GUARD(s2n_io_uring_release(conn));
 
     GUARD(s2n_free(&conn->client_ticket));
     GUARD(s2n_free(&conn->status_response));
@@ -538,6 +596,29 @@ int s2n_connection_release_buffers(struct s2n_connection *conn)
     return 0;
 }
 
+static int s2n_connection_resize_if_drained(struct s2n_stuffer *stuffer, uint32_t size)
+{
+    if (stuffer->blob.data == NULL || stuffer->blob.size <= size || s2n_stuffer_data_available(stuffer)) {
+        return 0;
+    }
+
+    GUARD(s2n_stuffer_wipe(stuffer));
+    GUARD(s2n_stuffer_resize(stuffer, size));
+
+    return 0;
+}
+
+int s2n_connection_resize_record_buffers(struct s2n_connection *conn)
+{
+    notnull_check(conn);
+
+    /* The handshake may have grown the record buffers beyond what the negotiated limits need */
+    GUARD(s2n_connection_resize_if_drained(&conn->out, s2n_record_write_buffer_size(conn)));
+    GUARD(s2n_connection_resize_if_drained(&conn->in, s2n_record_read_buffer_size(conn)));
+
+    return 0;
+}
+
 int s2n_connection_free_handshake(struct s2n_connection *conn)
 {
     /* We are done with the handshake */
@@ -572,8 +653,104 @@ int s2n_connection_free_handshake(struct s2n_connection *conn)
     return 0;
 }
 
+int s2n_connection_hibernate(struct s2n_connection *conn)
+{
+    notnull_check(conn);
+
+    if (conn->hibernating) {
+        return 0;
+    }
+
+    S2N_ERROR_IF(!is_handshake_complete(conn), S2N_ERR_HANDSHAKE_NOT_COMPLETE);
+
+    /* The record keys are re-derived from the master secret on wake. Stream ciphers carry
+     * keystream state that can't be re-derived that way, and TLS1.3 uses a different key schedule.
+     */
+    S2N_ERROR_IF(conn->actual_protocol_version >= S2N_TLS13, S2N_ERR_HIBERNATE_UNSUPPORTED_CIPHER);
+    S2N_ERROR_IF(conn->secure.cipher_suite->record_alg->cipher->type == S2N_STREAM, S2N_ERR_HIBERNATE_UNSUPPORTED_CIPHER);
+
+    /* Partial records live in the buffers we are about to release */
+    S2N_ERROR_IF(s2n_stuffer_data_available(&conn->header_in)
+            || s2n_stuffer_data_available(&conn->in)
+            || s2n_stuffer_data_available(&conn->out)
+            || s2n_stuffer_data_available(&conn->reader_alert_out)
+            || s2n_stuffer_data_available(&conn->writer_alert_out), S2N_ERR_HIBERNATE_PENDING_DATA);
+
+    GUARD(s2n_connection_free_handshake(conn));
+    GUARD(s2n_connection_release_buffers(conn));
+
+    /* Ephemeral key exchange state and the peer's keys are only needed during the handshake */
+    GUARD(s2n_pkey_free(&conn->secure.server_public_key));
+    GUARD(s2n_pkey_zero_init(&conn->secure.server_public_key));
+    GUARD(s2n_pkey_free(&conn->secure.client_public_key));
+    GUARD(s2n_pkey_zero_init(&conn->secure.client_public_key));
+    GUARD(s2n_dh_params_free(&conn->secure.server_dh_params));
+    GUARD(s2n_ecc_params_free(&conn->secure.server_ecc_params));
+    for (int i = 0; i < S2N_ECC_SUPPORTED_CURVES_COUNT; i++) {
+        GUARD(s2n_ecc_params_free(&conn->secure.client_ecc_params[i]));
+    }
+    GUARD(s2n_kem_free(&conn->secure.s2n_kem_keys));
+
+    /* So is the peer's parsed certificate chain */
+    if (conn->x509_validator.cert_chain) {
+        sk_X509_pop_free(conn->x509_validator.cert_chain, X509_free);
+        conn->x509_validator.cert_chain = NULL;
+    }
+
+    /* Release the libcrypto contexts. Only the master secret, randoms, implicit IVs
+     * and sequence numbers held in the connection itself survive hibernation.
+     */
+    GUARD(conn->secure.cipher_suite->record_alg->cipher->destroy_key(&conn->secure.client_key));
+    GUARD(conn->secure.cipher_suite->record_alg->cipher->destroy_key(&conn->secure.server_key));
+    GUARD(s2n_connection_free_keys(conn));
+
+    GUARD(s2n_prf_free(conn));
+    GUARD(s2n_connection_free_hashes(conn));
+    GUARD(s2n_connection_free_hmacs(conn));
+
+    conn->hibernating = 1;
+
+    return 0;
+}
+
+int s2n_connection_wake(struct s2n_connection *conn)
+{
+    notnull_check(conn);
+
+    if (!conn->hibernating) {
+        return 0;
+    }
+
+    /* Key expansion resets the implicit IVs, but TLS1.0 CBC chains them from the
+     * last record in each direction, so keep the current values.
+     */
+    uint8_t client_implicit_iv[S2N_TLS_MAX_IV_LEN];
+    uint8_t server_implicit_iv[S2N_TLS_MAX_IV_LEN];
+    memcpy_check(client_implicit_iv, conn->secure.client_implicit_iv, S2N_TLS_MAX_IV_LEN);
+    memcpy_check(server_implicit_iv, conn->secure.server_implicit_iv, S2N_TLS_MAX_IV_LEN);
+
+    int woken = s2n_connection_alloc_crypto_state(conn) == 0 && s2n_prf_key_expansion(conn) == 0;
+
+    memcpy_check(conn->secure.client_implicit_iv, client_implicit_iv, S2N_TLS_MAX_IV_LEN);
+    memcpy_check(conn->secure.server_implicit_iv, server_implicit_iv, S2N_TLS_MAX_IV_LEN);
+
+    if (!woken) {
+        /* Leave the connection hibernating, without leaking whatever was allocated before the failure */
+        GUARD(s2n_connection_release_crypto_state(conn));
+        conn->hibernating = 1;
+        return -1;
+    }
+
+    return 0;
+}
+
 int s2n_connection_wipe(struct s2n_connection *conn)
 {
+    /* Queued writes and batched records belong to the session being wiped */
+    if (conn->group) {
+        GUARD(s2n_connection_group_remove(conn->group, conn));
+    }
+
     /* First make a copy of everything we'd like to save, which isn't very much. */
     int mode = conn->mode;
     struct s2n_config *config = conn->config;
@@ -596,6 +773,11 @@ int s2n_connection_wipe(struct s2n_connection *conn)
     struct s2n_connection_hash_handles hash_handles = {0};
     struct s2n_connection_hmac_handles hmac_handles = {0};
 
+    /* A hibernating connection has released the state wiped below */
+    if (conn->hibernating) {
+        GUARD(s2n_connection_alloc_crypto_state(conn));
+    }
+
     /* Wipe all of the sensitive stuff */
     GUARD(s2n_connection_wipe_keys(conn));
     GUARD(s2n_connection_reset_hashes(conn));
@@ -869,6 +1051,17 @@ int s2n_connection_use_corked_io(struct s2n_connection *conn)
     return 0;
 }
 
+int s2n_connection_use_msg_more_io(struct s2n_connection *conn)
+{
+    if (!conn->managed_io) {
+        /* MSG_MORE is a send flag, so s2n has to be the one calling send on the socket */
+        S2N_ERROR(S2N_ERR_MSG_MORE_SET_ON_UNMANAGED);
+    }
+    conn->msg_more_io = 1;
+
+    return 0;
+}
+
 uint64_t s2n_connection_get_wire_bytes_in(struct s2n_connection *conn)
 {
     return conn->wire_bytes_in;
@@ -989,7 +1182,7 @@ const char *s2n_get_server_name(struct s2n_connection *conn)
     /* server name is not yet obtained from client hello, get it now */
     struct s2n_client_hello_parsed_extension parsed_extension = {0};
 
-    GUARD_PTR(s2n_client_hello_get_parsed_extension(conn->client_hello.parsed_extensions, S2N_EXTENSION_SERVER_NAME, &parsed_extension));
+    GUARD_PTR(s2n_client_hello_get_parsed_extension(&conn->client_hello, S2N_EXTENSION_SERVER_NAME, &parsed_extension));
 
     struct s2n_stuffer extension = {0};
     GUARD_PTR(s2n_stuffer_init(&extension, &parsed_extension.extension));
@@ -1131,6 +1324,26 @@ int s2n_connection_set_dynamic_record_threshold(struct s2n_connection *conn, uin
     return 0;
 }
 
+int s2n_connection_use_congestion_window_record_sizing(struct s2n_connection *conn)
+{
+    notnull_check(conn);
+
+    conn->cwnd_record_sizing = 1;
+    conn->cwnd_payload_size = 0;
+    conn->tcp_info_sample_interval = 0;
+    return 0;
+}
+
+int s2n_connection_set_tcp_info_cb(struct s2n_connection *conn, s2n_tcp_info_fn *tcp_info_cb, void *ctx)
+{
+    notnull_check(conn);
+
+    conn->tcp_info_cb = tcp_info_cb;
+    conn->tcp_info_ctx = ctx;
+    conn->tcp_info_sample_interval = 0;
+    return 0;
+}
+
 int s2n_connection_set_verify_host_callback(struct s2n_connection *conn, s2n_verify_host_fn verify_host_fn, void *data) {
     notnull_check(conn);
 
@@ -1199,6 +1412,13 @@ int s2n_connection_is_managed_corked(const struct s2n_connection *s2n_connection
     return (s2n_connection->managed_io && s2n_connection->corked_io);
 }
 
+int s2n_connection_is_managed_msg_more(const struct s2n_connection *s2n_connection)
+{
+    notnull_check(s2n_connection);
+
+    return (s2n_connection->managed_io && s2n_connection->msg_more_io && s2n_connection->send);
+}
+
 const uint8_t *s2n_connection_get_sct_list(struct s2n_connection *conn, uint32_t *length)
 {
     if (!length) {
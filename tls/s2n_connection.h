@@ -73,6 +73,11 @@ struct s2n_connection {
      */
     unsigned corked_io:1;
 
+    /* Is this connection sending every record but the last of a flight with MSG_MORE? Only valid
+     * when the connection is using managed_io
+     */
+    unsigned msg_more_io:1;
+
     /* Session resumption indicator on client side */
     unsigned client_session_resumed:1;
 
@@ -86,6 +91,11 @@ struct s2n_connection {
      * extension is not sent back by the server.
      */
     unsigned secure_renegotiation:1;
+    /* Encrypt-then-MAC (RFC7366). Was the extension offered by the client,
+     * and are CBC records on this connection MACed after encryption?
+     */
+    unsigned encrypt_then_mac_requested:1;
+    unsigned encrypt_then_mac:1;
     /* Was the EC point formats sent by the client */
     unsigned ec_point_formats:1;
 
@@ -98,6 +108,18 @@ struct s2n_connection {
      */
     unsigned server_name_used:1;
 
+    /* Has s2n_connection_hibernate released the connection's crypto state?
+     * The record keys are re-derived from the master secret on wake.
+     */
+    unsigned hibernating:1;
+
+    /* The connection group batching this connection's writes, if any, and our slot in it */
+    struct s2n_connection_group *group;
+    uint32_t group_index;
+
+    /* The io_uring slot that is this connection's I/O context, if it uses one */
+    struct s2n_io_uring_slot *io_uring_slot;
+
     /* Is this connection a client or a server connection */
     s2n_mode mode;
 
@@ -202,6 +224,8 @@ struct s2n_connection {
      *   2. s2n_connection_prefer_throughput is set
      *   3. TLS Maximum Fragment Length extension is negotiated
      *
+     * A negotiated record_size_limit further caps the payload of each record.
+     *
      * Default value: S2N_DEFAULT_FRAGMENT_LENGTH
      */
     uint16_t max_outgoing_fragment_length;
@@ -217,9 +241,25 @@ struct s2n_connection {
     /* number of bytes consumed during application activity */
     uint64_t active_application_bytes_consumed;
 
+    /* Size records to fit the TCP congestion window, sampled from tcp_info_cb or
+     * TCP_INFO at most once a round trip. cwnd_payload_size is 0 until there is a sample.
+     */
+    unsigned cwnd_record_sizing:1;
+    s2n_tcp_info_fn *tcp_info_cb;
+    void *tcp_info_ctx;
+    uint64_t last_tcp_info_sample;
+    uint64_t tcp_info_sample_interval;
+    uint16_t cwnd_payload_size;
+
     /* Negotiated TLS extension Maximum Fragment Length code */
     uint8_t mfl_code;
 
+    /* RFC8449 record_size_limit: the largest plaintext we told the peer we accept, and the
+     * largest plaintext the peer accepts. peer_record_size_limit is 0 unless negotiated.
+     */
+    uint16_t record_size_limit;
+    uint16_t peer_record_size_limit;
+
     /* Keep some accounting on each connection */
     uint64_t wire_bytes_in;
     uint64_t wire_bytes_out;
@@ -284,6 +324,7 @@ struct s2n_connection {
 };
 
 int s2n_connection_is_managed_corked(const struct s2n_connection *s2n_connection);
+int s2n_connection_is_managed_msg_more(const struct s2n_connection *s2n_connection);
 int s2n_connection_is_client_auth_enabled(struct s2n_connection *s2n_connection);
 
 /* Kill a bad connection */
@@ -292,6 +333,8 @@ int s2n_connection_kill(struct s2n_connection *conn);
 /* Send/recv a stuffer to/from a connection */
 int s2n_connection_send_stuffer(struct s2n_stuffer *stuffer, struct s2n_connection *conn, uint32_t len);
 int s2n_connection_recv_stuffer(struct s2n_stuffer *stuffer, struct s2n_connection *conn, uint32_t len);
+/* Shrink drained record buffers to what the negotiated record size limits need */
+int s2n_connection_resize_record_buffers(struct s2n_connection *conn);
 
 extern int s2n_connection_get_cipher_preferences(struct s2n_connection *conn, const struct s2n_cipher_preferences **cipher_preferences);
 extern int s2n_connection_get_protocol_preferences(struct s2n_connection *conn, struct s2n_blob **protocol_preferences);
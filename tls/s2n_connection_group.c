@@ -0,0 +1,403 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <sys/param.h>
+#include <errno.h>
+#include <s2n.h>
+
+#include "error/s2n_errno.h"
+
+#include "stuffer/s2n_stuffer.h"
+
+#include "tls/s2n_cipher_suites.h"
+#include "tls/s2n_connection.h"
+#include "tls/s2n_connection_group.h"
+#include "tls/s2n_tls.h"
+
+#include "utils/s2n_array.h"
+#include "utils/s2n_blob.h"
+#include "utils/s2n_mem.h"
+#include "utils/s2n_safety.h"
+
+struct s2n_connection_group *s2n_connection_group_new(void)
+{
+    struct s2n_blob mem = {0};
+    GUARD_PTR(s2n_alloc(&mem, sizeof(struct s2n_connection_group)));
+    GUARD_PTR(s2n_blob_zero(&mem));
+
+    struct s2n_connection_group *group = (void *) mem.data;
+    group->members = s2n_array_new(sizeof(struct s2n_connection_group_member));
+    group->writes = s2n_array_new(sizeof(struct s2n_connection_group_write));
+    if (group->members == NULL || group->writes == NULL) {
+        s2n_connection_group_free(group);
+        return NULL;
+    }
+
+    return group;
+}
+
+/* Hand the records a flush couldn't write back to the connection, ahead of anything it has
+ * queued itself, so that its own s2n_flush sends them in order once it leaves the group.
+ */
+static int s2n_connection_group_return_records(struct s2n_connection_group_member *member)
+{
+    struct s2n_connection *conn = member->conn;
+
+    if (s2n_stuffer_data_available(&member->out) == 0) {
+        return 0;
+    }
+
+    if (s2n_stuffer_data_available(&conn->out)) {
+        GUARD(s2n_stuffer_copy(&conn->out, &member->out, s2n_stuffer_data_available(&conn->out)));
+    }
+    GUARD(s2n_stuffer_wipe(&conn->out));
+    GUARD(s2n_stuffer_copy(&member->out, &conn->out, s2n_stuffer_data_available(&member->out)));
+
+    return 0;
+}
+
+int s2n_connection_group_free(struct s2n_connection_group *group)
+{
+    notnull_check(group);
+
+    if (group->members) {
+        for (uint32_t i = 0; i < s2n_array_num_elements(group->members); i++) {
+            struct s2n_connection_group_member *member = s2n_array_get(group->members, i);
+            GUARD(s2n_connection_group_return_records(member));
+            member->conn->group = NULL;
+            GUARD(s2n_stuffer_free(&member->out));
+        }
+        GUARD(s2n_array_free(group->members));
+    }
+
+    if (group->writes) {
+        GUARD(s2n_array_free(group->writes));
+    }
+
+    GUARD(s2n_free_object((uint8_t **) &group, sizeof(struct s2n_connection_group)));
+
+    return 0;
+}
+
+int s2n_connection_group_add(struct s2n_connection_group *group, struct s2n_connection *conn)
+{
+    notnull_check(group);
+    notnull_check(conn);
+    S2N_ERROR_IF(conn->group != NULL, S2N_ERR_ALREADY_IN_CONNECTION_GROUP);
+
+    struct s2n_connection_group_member *member = s2n_array_add(group->members);
+    notnull_check(member);
+
+    member->conn = conn;
+    member->held = 0;
+    member->woken = 0;
+    GUARD(s2n_stuffer_growable_alloc(&member->out, 0));
+
+    conn->group = group;
+    conn->group_index = s2n_array_num_elements(group->members) - 1;
+
+    return 0;
+}
+
+int s2n_connection_group_remove(struct s2n_connection_group *group, struct s2n_connection *conn)
+{
+    notnull_check(group);
+    notnull_check(conn);
+    S2N_ERROR_IF(conn->group != group, S2N_ERR_NOT_IN_CONNECTION_GROUP);
+
+    uint32_t index = conn->group_index;
+    uint32_t last = s2n_array_num_elements(group->members) - 1;
+
+    /* Drop the connection's queued writes, and renumber the ones of the member moving into its slot */
+    for (uint32_t i = 0; i < s2n_array_num_elements(group->writes);) {
+        struct s2n_connection_group_write *write = s2n_array_get(group->writes, i);
+        if (write->member == index) {
+            GUARD(s2n_array_remove(group->writes, i));
+            continue;
+        }
+        if (write->member == last) {
+            write->member = index;
+        }
+        i++;
+    }
+
+    struct s2n_connection_group_member *member = s2n_array_get(group->members, index);
+    notnull_check(member);
+    GUARD(s2n_connection_group_return_records(member));
+    GUARD(s2n_stuffer_free(&member->out));
+
+    if (index != last) {
+        struct s2n_connection_group_member *moved = s2n_array_get(group->members, last);
+        notnull_check(moved);
+        *member = *moved;
+        member->conn->group_index = index;
+    }
+    GUARD(s2n_array_remove(group->members, last));
+
+    conn->group = NULL;
+    conn->group_index = 0;
+
+    return 0;
+}
+
+int s2n_connection_group_send(struct s2n_connection_group *group, struct s2n_connection *conn, const void *buf, ssize_t size)
+{
+    notnull_check(group);
+    notnull_check(conn);
+    S2N_ERROR_IF(conn->group != group, S2N_ERR_NOT_IN_CONNECTION_GROUP);
+    S2N_ERROR_IF(conn->closed, S2N_ERR_CLOSED);
+    S2N_ERROR_IF(!is_handshake_complete(conn), S2N_ERR_HANDSHAKE_NOT_COMPLETE);
+    S2N_ERROR_IF(size < 0 || size > UINT32_MAX, S2N_ERR_SEND_SIZE);
+
+    if (size == 0) {
+        return 0;
+    }
+    notnull_check(buf);
+
+    struct s2n_connection_group_write *write = s2n_array_add(group->writes);
+    notnull_check(write);
+
+    write->member = conn->group_index;
+    write->data = buf;
+    write->size = size;
+    write->next = 0;
+    write->encrypted = 0;
+
+    return 0;
+}
+
+static const struct s2n_record_algorithm *s2n_connection_group_record_alg(struct s2n_connection *conn)
+{
+    if (conn->mode == S2N_CLIENT) {
+        return conn->client->cipher_suite->record_alg;
+    }
+
+    return conn->server->cipher_suite->record_alg;
+}
+
+static int s2n_connection_group_encrypt(struct s2n_connection_group_member *member, struct s2n_connection_group_write *write)
+{
+    struct s2n_connection *conn = member->conn;
+
+    /* The records are built in conn->out, which holds one at a time, and then batched */
+    int cbc_hack_used = 0;
+    uint32_t consumed = 0;
+    while (consumed < write->size) {
+        GUARD(s2n_stuffer_rewrite(&conn->out));
+
+        int written;
+        GUARD((written = s2n_send_application_record(conn, write->data + consumed, write->size - consumed, &cbc_hack_used)));
+        GUARD(s2n_stuffer_copy(&conn->out, &member->out, s2n_stuffer_data_available(&conn->out)));
+        consumed += written;
+    }
+    GUARD(s2n_stuffer_rewrite(&conn->out));
+
+    return 0;
+}
+
+static int s2n_connection_group_write_member(struct s2n_connection_group_member *member)
+{
+    struct s2n_connection *conn = member->conn;
+
+    while (s2n_stuffer_data_available(&member->out)) {
+        int w = s2n_connection_send_stuffer(&member->out, conn, s2n_stuffer_data_available(&member->out));
+        if (w < 0) {
+            if (errno == EWOULDBLOCK || errno == EAGAIN) {
+                S2N_ERROR(S2N_ERR_BLOCKED);
+            }
+            S2N_ERROR(S2N_ERR_IO);
+        }
+        conn->wire_bytes_out += w;
+    }
+    GUARD(s2n_stuffer_rewrite(&member->out));
+
+    return 0;
+}
+
+int s2n_connection_group_write_pending(struct s2n_connection *conn)
+{
+    notnull_check(conn);
+
+    if (conn->group == NULL) {
+        return 0;
+    }
+
+    struct s2n_connection_group_member *member = s2n_array_get(conn->group->members, conn->group_index);
+    notnull_check(member);
+
+    return s2n_connection_group_write_member(member);
+}
+
+/* Forget the writes that have been encrypted, keeping the rest in order */
+static int s2n_connection_group_remove_encrypted(struct s2n_connection_group *group)
+{
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < s2n_array_num_elements(group->writes); i++) {
+        struct s2n_connection_group_write *write = s2n_array_get(group->writes, i);
+        if (write->encrypted) {
+            continue;
+        }
+        if (kept != i) {
+            *(struct s2n_connection_group_write *) s2n_array_get(group->writes, kept) = *write;
+        }
+        kept++;
+    }
+
+    while (s2n_array_num_elements(group->writes) > kept) {
+        GUARD(s2n_array_remove(group->writes, s2n_array_num_elements(group->writes) - 1));
+    }
+
+    return 0;
+}
+
+/* A connection that failed partway through encrypting its writes has records out that the
+ * peer will never see, and its sequence number has moved on. Nothing more can be sent on it,
+ * so drop everything it has queued and kill it.
+ */
+static int s2n_connection_group_kill_member(struct s2n_connection_group *group, uint32_t index)
+{
+    struct s2n_connection_group_member *member = s2n_array_get(group->members, index);
+    notnull_check(member);
+
+    for (uint32_t i = 0; i < s2n_array_num_elements(group->writes); i++) {
+        struct s2n_connection_group_write *write = s2n_array_get(group->writes, i);
+        if (write->member == index) {
+            write->encrypted = 1;
+        }
+    }
+    GUARD(s2n_connection_group_remove_encrypted(group));
+
+    GUARD(s2n_stuffer_wipe(&member->out));
+    GUARD(s2n_stuffer_wipe(&member->conn->out));
+    GUARD(s2n_connection_kill(member->conn));
+
+    return 0;
+}
+
+/* The number of record algorithms a flush keeps apart. Any beyond that share the last bucket. */
+#define S2N_CONNECTION_GROUP_BUCKETS 16
+
+struct s2n_connection_group_bucket {
+    const struct s2n_record_algorithm *record_alg;
+    uint32_t head;
+    uint32_t tail;
+};
+
+int s2n_connection_group_flush(struct s2n_connection_group *group, uint32_t *blocked, struct s2n_connection **failed)
+{
+    notnull_check(group);
+    notnull_check(blocked);
+    notnull_check(failed);
+
+    *blocked = 0;
+    *failed = NULL;
+
+    uint32_t num_members = s2n_array_num_elements(group->members);
+    uint32_t num_writes = s2n_array_num_elements(group->writes);
+
+    /* A connection that s2n_send left with unsent records has to get those out first */
+    for (uint32_t i = 0; i < num_members; i++) {
+        struct s2n_connection_group_member *member = s2n_array_get(group->members, i);
+        s2n_blocked_status conn_blocked;
+
+        member->held = 0;
+        member->woken = 0;
+        if (s2n_stuffer_data_available(&member->conn->out) && s2n_flush(member->conn, &conn_blocked) < 0) {
+            if (s2n_errno != S2N_ERR_BLOCKED) {
+                *failed = member->conn;
+                return -1;
+            }
+            member->held = 1;
+        }
+    }
+
+    /* Chain the writes into a bucket per record algorithm, in the order they were queued */
+    struct s2n_connection_group_bucket buckets[S2N_CONNECTION_GROUP_BUCKETS];
+    uint32_t num_buckets = 0;
+    for (uint32_t i = 0; i < num_writes; i++) {
+        struct s2n_connection_group_write *write = s2n_array_get(group->writes, i);
+        struct s2n_connection_group_member *member = s2n_array_get(group->members, write->member);
+        if (member->held) {
+            continue;
+        }
+
+        if (!member->woken) {
+            if (s2n_connection_wake(member->conn) < 0) {
+                *failed = member->conn;
+                return -1;
+            }
+            member->woken = 1;
+        }
+
+        const struct s2n_record_algorithm *record_alg = s2n_connection_group_record_alg(member->conn);
+        uint32_t b = 0;
+        while (b < num_buckets && buckets[b].record_alg != record_alg) {
+            b++;
+        }
+
+        if (b == num_buckets && num_buckets < S2N_CONNECTION_GROUP_BUCKETS) {
+            buckets[b].record_alg = record_alg;
+            buckets[b].head = i;
+            num_buckets++;
+        } else {
+            b = MIN(b, num_buckets - 1);
+            struct s2n_connection_group_write *tail = s2n_array_get(group->writes, buckets[b].tail);
+            tail->next = i;
+        }
+        buckets[b].tail = i;
+        write->next = num_writes;
+    }
+
+    /* Encrypt a bucket at a time, so that the same cipher code and key schedule layout stay
+     * hot in the cache for the whole pass. A connection has one record algorithm, so its
+     * writes are still encrypted in the order they were queued.
+     */
+    for (uint32_t b = 0; b < num_buckets; b++) {
+        for (uint32_t i = buckets[b].head; i < num_writes;) {
+            struct s2n_connection_group_write *write = s2n_array_get(group->writes, i);
+            struct s2n_connection_group_member *member = s2n_array_get(group->members, write->member);
+
+            if (s2n_connection_group_encrypt(member, write) < 0) {
+                *failed = member->conn;
+                GUARD(s2n_connection_group_kill_member(group, write->member));
+                return -1;
+            }
+            write->encrypted = 1;
+            i = write->next;
+        }
+    }
+    GUARD(s2n_connection_group_remove_encrypted(group));
+
+    /* Write everything each connection has batched up, including records a blocked
+     * connection couldn't send during an earlier flush.
+     */
+    for (uint32_t i = 0; i < num_members; i++) {
+        struct s2n_connection_group_member *member = s2n_array_get(group->members, i);
+        if (member->held) {
+            *blocked += 1;
+            continue;
+        }
+
+        if (s2n_connection_group_write_member(member) < 0) {
+            if (s2n_errno != S2N_ERR_BLOCKED) {
+                *failed = member->conn;
+                return -1;
+            }
+            *blocked += 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "stuffer/s2n_stuffer.h"
+
+#include "utils/s2n_array.h"
+
+struct s2n_connection_group_member {
+    struct s2n_connection *conn;
+
+    /* Records encrypted by a flush that haven't been written to the connection yet */
+    struct s2n_stuffer out;
+
+    /* Set for the rest of a flush when the connection still had unsent data of its own */
+    unsigned held:1;
+
+    /* Set once a flush has woken the connection from hibernation */
+    unsigned woken:1;
+};
+
+/* Application data queued by s2n_connection_group_send. The data isn't copied, so it has to
+ * stay valid until the flush that encrypts it returns.
+ */
+struct s2n_connection_group_write {
+    uint32_t member;
+    const uint8_t *data;
+    uint32_t size;
+
+    /* The next write with the same record algorithm, while a flush is encrypting */
+    uint32_t next;
+    unsigned encrypted:1;
+};
+
+/* Connections whose application data is encrypted together, one record algorithm at a time,
+ * and then written with a single send per connection.
+ */
+struct s2n_connection_group {
+    struct s2n_array *members;
+    struct s2n_array *writes;
+};
+
+/* Writes the records a group flush encrypted for the connection but couldn't send yet. These
+ * precede anything in conn->out, so s2n_flush calls this first.
+ */
+extern int s2n_connection_group_write_pending(struct s2n_connection *conn);
@@ -0,0 +1,285 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <string.h>
+
+#include <s2n.h>
+
+#include "error/s2n_errno.h"
+
+#include "stuffer/s2n_stuffer.h"
+
+#include "tls/s2n_cipher_suites.h"
+#include "tls/s2n_connection.h"
+#include "tls/s2n_connection_serialize.h"
+#include "tls/s2n_crypto.h"
+#include "tls/s2n_prf.h"
+
+#include "utils/s2n_blob.h"
+#include "utils/s2n_safety.h"
+
+static int s2n_connection_check_serializable(struct s2n_connection *conn)
+{
+    S2N_ERROR_IF(conn->closing || conn->closed, S2N_ERR_CLOSED);
+    S2N_ERROR_IF(!is_handshake_complete(conn), S2N_ERR_HANDSHAKE_NOT_COMPLETE);
+
+    /* The receiving process re-derives the record keys from the master secret, which
+     * doesn't work for stream cipher state or the TLS1.3 key schedule.
+     */
+    S2N_ERROR_IF(conn->actual_protocol_version >= S2N_TLS13, S2N_ERR_SERIALIZE_UNSUPPORTED_CIPHER);
+    S2N_ERROR_IF(conn->secure.cipher_suite->record_alg->cipher->type == S2N_STREAM, S2N_ERR_SERIALIZE_UNSUPPORTED_CIPHER);
+
+    /* Partially received records are carried over, but anything still waiting to
+     * be written has to be flushed by the sending process first.
+     */
+    S2N_ERROR_IF(s2n_stuffer_data_available(&conn->out)
+            || s2n_stuffer_data_available(&conn->alert_in)
+            || s2n_stuffer_data_available(&conn->reader_alert_out)
+            || s2n_stuffer_data_available(&conn->writer_alert_out), S2N_ERR_SERIALIZE_PENDING_DATA);
+
+    return 0;
+}
+
+static int s2n_write_stuffer_contents(struct s2n_stuffer *to, struct s2n_stuffer *from)
+{
+    uint32_t len = s2n_stuffer_data_available(from);
+    if (len == 0) {
+        return 0;
+    }
+
+    GUARD(s2n_stuffer_write_bytes(to, from->blob.data + from->read_cursor, len));
+
+    return 0;
+}
+
+static int s2n_connection_serialize_state(struct s2n_connection *conn, struct s2n_stuffer *to)
+{
+    GUARD(s2n_stuffer_write_uint8(to, S2N_SERIALIZED_CONNECTION_FORMAT_VERSION));
+    GUARD(s2n_stuffer_write_uint8(to, conn->mode));
+    GUARD(s2n_stuffer_write_uint8(to, conn->client_hello_version));
+    GUARD(s2n_stuffer_write_uint8(to, conn->client_protocol_version));
+    GUARD(s2n_stuffer_write_uint8(to, conn->server_protocol_version));
+    GUARD(s2n_stuffer_write_uint8(to, conn->actual_protocol_version));
+    GUARD(s2n_stuffer_write_bytes(to, conn->secure.cipher_suite->iana_value, S2N_TLS_CIPHER_SUITE_LEN));
+    GUARD(s2n_stuffer_write_uint8(to, conn->encrypt_then_mac));
+    GUARD(s2n_stuffer_write_uint8(to, conn->handshake.handshake_type));
+    GUARD(s2n_stuffer_write_uint8(to, conn->handshake.message_number));
+
+    GUARD(s2n_stuffer_write_bytes(to, conn->secure.master_secret, S2N_TLS_SECRET_LEN));
+    GUARD(s2n_stuffer_write_bytes(to, conn->secure.client_random, S2N_TLS_RANDOM_DATA_LEN));
+    GUARD(s2n_stuffer_write_bytes(to, conn->secure.server_random, S2N_TLS_RANDOM_DATA_LEN));
+    GUARD(s2n_stuffer_write_bytes(to, conn->secure.client_implicit_iv, S2N_TLS_MAX_IV_LEN));
+    GUARD(s2n_stuffer_write_bytes(to, conn->secure.server_implicit_iv, S2N_TLS_MAX_IV_LEN));
+    GUARD(s2n_stuffer_write_bytes(to, conn->secure.client_sequence_number, S2N_TLS_SEQUENCE_NUM_LEN));
+    GUARD(s2n_stuffer_write_bytes(to, conn->secure.server_sequence_number, S2N_TLS_SEQUENCE_NUM_LEN));
+
+    GUARD(s2n_stuffer_write_uint8(to, conn->mfl_code));
+    GUARD(s2n_stuffer_write_uint16(to, conn->max_outgoing_fragment_length));
+    GUARD(s2n_stuffer_write_uint16(to, conn->record_size_limit));
+    GUARD(s2n_stuffer_write_uint16(to, conn->peer_record_size_limit));
+    GUARD(s2n_stuffer_write_uint64(to, conn->wire_bytes_in));
+    GUARD(s2n_stuffer_write_uint64(to, conn->wire_bytes_out));
+
+    GUARD(s2n_stuffer_write_uint8(to, conn->session_id_len));
+    GUARD(s2n_stuffer_write_bytes(to, conn->session_id, conn->session_id_len));
+
+    uint8_t server_name_len = strlen(conn->server_name);
+    GUARD(s2n_stuffer_write_uint8(to, server_name_len));
+    GUARD(s2n_stuffer_write_bytes(to, (uint8_t *) conn->server_name, server_name_len));
+
+    uint8_t application_protocol_len = strlen(conn->application_protocol);
+    GUARD(s2n_stuffer_write_uint8(to, application_protocol_len));
+    GUARD(s2n_stuffer_write_bytes(to, (uint8_t *) conn->application_protocol, application_protocol_len));
+
+    /* Any partially read record, or decrypted data the application hasn't read yet */
+    GUARD(s2n_stuffer_write_uint8(to, conn->in_status));
+    GUARD(s2n_stuffer_write_uint8(to, s2n_stuffer_data_available(&conn->header_in)));
+    GUARD(s2n_write_stuffer_contents(to, &conn->header_in));
+    GUARD(s2n_stuffer_write_uint32(to, s2n_stuffer_data_available(&conn->in)));
+    GUARD(s2n_write_stuffer_contents(to, &conn->in));
+
+    return 0;
+}
+
+static int s2n_read_stuffer_contents(struct s2n_stuffer *from, struct s2n_stuffer *to, uint32_t len)
+{
+    S2N_ERROR_IF(len > s2n_stuffer_data_available(from), S2N_ERR_INVALID_SERIALIZED_CONNECTION);
+    if (len == 0) {
+        return 0;
+    }
+
+    uint8_t *data = s2n_stuffer_raw_read(from, len);
+    notnull_check(data);
+    GUARD(s2n_stuffer_write_bytes(to, data, len));
+
+    return 0;
+}
+
+static int s2n_connection_deserialize_state(struct s2n_connection *conn, struct s2n_stuffer *from)
+{
+    uint8_t format;
+    GUARD(s2n_stuffer_read_uint8(from, &format));
+    S2N_ERROR_IF(format != S2N_SERIALIZED_CONNECTION_FORMAT_VERSION, S2N_ERR_INVALID_SERIALIZED_CONNECTION);
+
+    uint8_t mode;
+    GUARD(s2n_stuffer_read_uint8(from, &mode));
+    S2N_ERROR_IF(mode != conn->mode, S2N_ERR_INVALID_SERIALIZED_CONNECTION);
+
+    GUARD(s2n_stuffer_read_uint8(from, &conn->client_hello_version));
+    GUARD(s2n_stuffer_read_uint8(from, &conn->client_protocol_version));
+    GUARD(s2n_stuffer_read_uint8(from, &conn->server_protocol_version));
+    GUARD(s2n_stuffer_read_uint8(from, &conn->actual_protocol_version));
+    S2N_ERROR_IF(conn->actual_protocol_version < S2N_SSLv3, S2N_ERR_INVALID_SERIALIZED_CONNECTION);
+    S2N_ERROR_IF(conn->actual_protocol_version >= S2N_TLS13, S2N_ERR_SERIALIZE_UNSUPPORTED_CIPHER);
+
+    uint8_t *cipher_suite_wire = s2n_stuffer_raw_read(from, S2N_TLS_CIPHER_SUITE_LEN);
+    notnull_check(cipher_suite_wire);
+    struct s2n_cipher_suite *cipher_suite = s2n_cipher_suite_from_wire(cipher_suite_wire);
+    S2N_ERROR_IF(cipher_suite == NULL || !cipher_suite->available, S2N_ERR_CIPHER_NOT_SUPPORTED);
+    S2N_ERROR_IF(cipher_suite->record_alg->cipher->type == S2N_STREAM, S2N_ERR_SERIALIZE_UNSUPPORTED_CIPHER);
+    conn->secure.cipher_suite = cipher_suite;
+
+    uint8_t encrypt_then_mac;
+    GUARD(s2n_stuffer_read_uint8(from, &encrypt_then_mac));
+    S2N_ERROR_IF(encrypt_then_mac > 1, S2N_ERR_INVALID_SERIALIZED_CONNECTION);
+    if (encrypt_then_mac) {
+        GUARD(s2n_set_cipher_encrypt_then_mac(conn));
+    }
+
+    uint8_t handshake_type;
+    uint8_t message_number;
+    GUARD(s2n_stuffer_read_uint8(from, &handshake_type));
+    GUARD(s2n_stuffer_read_uint8(from, &message_number));
+    S2N_ERROR_IF(handshake_type >= S2N_HANDSHAKES_COUNT || message_number >= S2N_MAX_HANDSHAKE_MESSAGES,
+            S2N_ERR_INVALID_SERIALIZED_CONNECTION);
+    conn->handshake.handshake_type = handshake_type;
+    conn->handshake.message_number = message_number;
+    S2N_ERROR_IF(!IS_NEGOTIATED(handshake_type) || !is_handshake_complete(conn), S2N_ERR_INVALID_SERIALIZED_CONNECTION);
+
+    GUARD(s2n_stuffer_read_bytes(from, conn->secure.master_secret, S2N_TLS_SECRET_LEN));
+    GUARD(s2n_stuffer_read_bytes(from, conn->secure.client_random, S2N_TLS_RANDOM_DATA_LEN));
+    GUARD(s2n_stuffer_read_bytes(from, conn->secure.server_random, S2N_TLS_RANDOM_DATA_LEN));
+
+    /* Key expansion also resets the implicit IVs, so restore the transferred ones afterwards */
+    GUARD(s2n_prf_key_expansion(conn));
+    GUARD(s2n_stuffer_read_bytes(from, conn->secure.client_implicit_iv, S2N_TLS_MAX_IV_LEN));
+    GUARD(s2n_stuffer_read_bytes(from, conn->secure.server_implicit_iv, S2N_TLS_MAX_IV_LEN));
+    GUARD(s2n_stuffer_read_bytes(from, conn->secure.client_sequence_number, S2N_TLS_SEQUENCE_NUM_LEN));
+    GUARD(s2n_stuffer_read_bytes(from, conn->secure.server_sequence_number, S2N_TLS_SEQUENCE_NUM_LEN));
+
+    GUARD(s2n_stuffer_read_uint8(from, &conn->mfl_code));
+    GUARD(s2n_stuffer_read_uint16(from, &conn->max_outgoing_fragment_length));
+    GUARD(s2n_stuffer_read_uint16(from, &conn->record_size_limit));
+    GUARD(s2n_stuffer_read_uint16(from, &conn->peer_record_size_limit));
+    S2N_ERROR_IF(conn->peer_record_size_limit > S2N_TLS_MAXIMUM_FRAGMENT_LENGTH || conn->record_size_limit > S2N_TLS_MAXIMUM_FRAGMENT_LENGTH,
+            S2N_ERR_INVALID_SERIALIZED_CONNECTION);
+    GUARD(s2n_stuffer_read_uint64(from, &conn->wire_bytes_in));
+    GUARD(s2n_stuffer_read_uint64(from, &conn->wire_bytes_out));
+
+    GUARD(s2n_stuffer_read_uint8(from, &conn->session_id_len));
+    S2N_ERROR_IF(conn->session_id_len > S2N_TLS_SESSION_ID_MAX_LEN, S2N_ERR_INVALID_SERIALIZED_CONNECTION);
+    GUARD(s2n_stuffer_read_bytes(from, conn->session_id, conn->session_id_len));
+
+    /* Both strings are at most 255 bytes, so always fit with their terminator */
+    uint8_t server_name_len;
+    GUARD(s2n_stuffer_read_uint8(from, &server_name_len));
+    GUARD(s2n_stuffer_read_bytes(from, (uint8_t *) conn->server_name, server_name_len));
+    conn->server_name[server_name_len] = '\0';
+
+    uint8_t application_protocol_len;
+    GUARD(s2n_stuffer_read_uint8(from, &application_protocol_len));
+    GUARD(s2n_stuffer_read_bytes(from, (uint8_t *) conn->application_protocol, application_protocol_len));
+    conn->application_protocol[application_protocol_len] = '\0';
+
+    uint8_t in_status;
+    GUARD(s2n_stuffer_read_uint8(from, &in_status));
+    S2N_ERROR_IF(in_status != ENCRYPTED && in_status != PLAINTEXT, S2N_ERR_INVALID_SERIALIZED_CONNECTION);
+    conn->in_status = in_status;
+
+    uint8_t header_in_len;
+    GUARD(s2n_stuffer_read_uint8(from, &header_in_len));
+    S2N_ERROR_IF(header_in_len > S2N_TLS_RECORD_HEADER_LENGTH, S2N_ERR_INVALID_SERIALIZED_CONNECTION);
+    GUARD(s2n_read_stuffer_contents(from, &conn->header_in, header_in_len));
+
+    uint32_t in_len;
+    GUARD(s2n_stuffer_read_uint32(from, &in_len));
+    GUARD(s2n_read_stuffer_contents(from, &conn->in, in_len));
+
+    S2N_ERROR_IF(s2n_stuffer_data_available(from), S2N_ERR_INVALID_SERIALIZED_CONNECTION);
+
+    /* Both directions are already using the negotiated parameters */
+    conn->actual_protocol_version_established = 1;
+    conn->client = &conn->secure;
+    conn->server = &conn->secure;
+
+    return 0;
+}
+
+int s2n_connection_get_serialized_length(struct s2n_connection *conn)
+{
+    notnull_check(conn);
+
+    return S2N_SERIALIZED_CONNECTION_MIN_SIZE
+            + conn->session_id_len
+            + strlen(conn->server_name)
+            + strlen(conn->application_protocol)
+            + s2n_stuffer_data_available(&conn->header_in)
+            + s2n_stuffer_data_available(&conn->in);
+}
+
+int s2n_connection_serialize(struct s2n_connection *conn, uint8_t *buffer, size_t max_length)
+{
+    notnull_check(conn);
+    notnull_check(buffer);
+
+    GUARD(s2n_connection_check_serializable(conn));
+
+    int len = s2n_connection_get_serialized_length(conn);
+    S2N_ERROR_IF(len > max_length, S2N_ERR_SERIALIZED_CONNECTION_TOO_LONG);
+
+    struct s2n_blob serialized_data = {0};
+    serialized_data.data = buffer;
+    serialized_data.size = len;
+    GUARD(s2n_blob_zero(&serialized_data));
+
+    struct s2n_stuffer to = {0};
+    GUARD(s2n_stuffer_init(&to, &serialized_data));
+    GUARD(s2n_connection_serialize_state(conn, &to));
+
+    return len;
+}
+
+int s2n_connection_deserialize(struct s2n_connection *conn, const uint8_t *buffer, size_t length)
+{
+    notnull_check(conn);
+    notnull_check(buffer);
+
+    /* The connection must not have started a handshake of its own */
+    S2N_ERROR_IF(conn->handshake.handshake_type != INITIAL || conn->handshake.message_number != 0
+            || conn->hibernating, S2N_ERR_DESERIALIZE_INTO_USED_CONNECTION);
+    S2N_ERROR_IF(length < S2N_SERIALIZED_CONNECTION_MIN_SIZE, S2N_ERR_INVALID_SERIALIZED_CONNECTION);
+
+    DEFER_CLEANUP(struct s2n_blob serialized_data = {0}, s2n_free);
+    GUARD(s2n_alloc(&serialized_data, length));
+    memcpy_check(serialized_data.data, buffer, length);
+
+    struct s2n_stuffer from = {0};
+    GUARD(s2n_stuffer_init(&from, &serialized_data));
+    GUARD(s2n_stuffer_write(&from, &serialized_data));
+
+    GUARD(s2n_connection_deserialize_state(conn, &from));
+
+    return 0;
+}
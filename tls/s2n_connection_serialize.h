@@ -0,0 +1,36 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#pragma once
+
+#include "tls/s2n_crypto.h"
+
+#define S2N_SERIALIZED_CONNECTION_FORMAT_VERSION    3
+
+/* format, mode, the four protocol versions, cipher suite, encrypt-then-mac, handshake type and message number */
+#define S2N_SERIALIZED_CONNECTION_HEADER_SIZE       (1 + 1 + 4 + S2N_TLS_CIPHER_SUITE_LEN + 1 + 1 + 1)
+
+/* master secret, randoms, implicit IVs and sequence numbers */
+#define S2N_SERIALIZED_CONNECTION_SECRETS_SIZE      (S2N_TLS_SECRET_LEN + 2 * S2N_TLS_RANDOM_DATA_LEN \
+                                                     + 2 * S2N_TLS_MAX_IV_LEN + 2 * S2N_TLS_SEQUENCE_NUM_LEN)
+
+/* mfl code, max fragment length, record size limits, wire byte counters and the length prefixes of the
+ * session id, server name, application protocol, in_status, header_in and in
+ */
+#define S2N_SERIALIZED_CONNECTION_PARAMS_SIZE       (1 + 2 + 2 + 2 + 8 + 8 + 1 + 1 + 1 + 1 + 1 + 4)
+
+#define S2N_SERIALIZED_CONNECTION_MIN_SIZE          (S2N_SERIALIZED_CONNECTION_HEADER_SIZE \
+                                                     + S2N_SERIALIZED_CONNECTION_SECRETS_SIZE \
+                                                     + S2N_SERIALIZED_CONNECTION_PARAMS_SIZE)
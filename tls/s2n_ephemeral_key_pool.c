@@ -0,0 +1,504 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <string.h>
+#include <unistd.h>
+
+#include "error/s2n_errno.h"
+
+#include "tls/s2n_cipher_preferences.h"
+#include "tls/s2n_cipher_suites.h"
+#include "tls/s2n_config.h"
+#include "tls/s2n_ephemeral_key_pool.h"
+#include "tls/s2n_kem.h"
+#include "tls/s2n_kex.h"
+
+#include "utils/s2n_blob.h"
+#include "utils/s2n_mem.h"
+#include "utils/s2n_safety.h"
+
+static const struct s2n_kem *s2n_ephemeral_key_pool_kems[S2N_EPHEMERAL_KEY_POOL_KEM_COUNT] = {
+    &s2n_bike_1_level_1_r1,
+    &s2n_sike_p503_r1,
+};
+
+static int s2n_ephemeral_key_pool_lock(struct s2n_ephemeral_key_pool *pool)
+{
+    S2N_ERROR_IF(pthread_mutex_lock(&pool->lock) != 0, S2N_ERR_LOCK);
+    return 0;
+}
+
+static int s2n_ephemeral_key_pool_unlock(struct s2n_ephemeral_key_pool *pool)
+{
+    S2N_ERROR_IF(pthread_mutex_unlock(&pool->lock) != 0, S2N_ERR_LOCK);
+    return 0;
+}
+
+static int s2n_ephemeral_key_pool_curve_index(const struct s2n_ecc_named_curve *curve)
+{
+    for (int i = 0; i < S2N_ECC_SUPPORTED_CURVES_COUNT; i++) {
+        if (s2n_ecc_supported_curves[i].iana_id == curve->iana_id) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static int s2n_ephemeral_key_pool_kem_index(const struct s2n_kem *kem)
+{
+    for (int i = 0; i < S2N_EPHEMERAL_KEY_POOL_KEM_COUNT; i++) {
+        if (s2n_ephemeral_key_pool_kems[i]->kem_extension_id == kem->kem_extension_id) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/* Only KEMs reachable through one of the config's hybrid cipher suites are worth generating */
+static int s2n_ephemeral_key_pool_kem_in_use(struct s2n_config *config, const struct s2n_kem *kem)
+{
+    const struct s2n_cipher_preferences *preferences = config->cipher_preferences;
+    for (int i = 0; i < preferences->count; i++) {
+        const struct s2n_cipher_suite *suite = preferences->suites[i];
+        if (suite->key_exchange_alg != &s2n_hybrid_ecdhe_kem) {
+            continue;
+        }
+
+        const struct s2n_iana_to_kem *supported_params = NULL;
+        GUARD(s2n_cipher_suite_to_kem(suite->iana_value, &supported_params));
+        for (int j = 0; j < supported_params->kem_count; j++) {
+            if (supported_params->kems[j]->kem_extension_id == kem->kem_extension_id) {
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/* The flush helpers are called with the lock held and cannot fail */
+static void s2n_ephemeral_key_pool_flush_ecc(struct s2n_ephemeral_key_pool *pool)
+{
+    for (int i = 0; i < S2N_ECC_SUPPORTED_CURVES_COUNT; i++) {
+        while (pool->ecc_key_count[i] > 0) {
+            s2n_ecc_params_free(&pool->ecc_keys[i][--pool->ecc_key_count[i]]);
+        }
+    }
+}
+
+static void s2n_ephemeral_key_pool_flush_dh(struct s2n_ephemeral_key_pool *pool)
+{
+    while (pool->dh_key_count > 0) {
+        s2n_dh_params_free(&pool->dh_keys[--pool->dh_key_count]);
+    }
+    pool->dh_source = NULL;
+}
+
+/* KEM private keys are wiped by s2n_kem_free, and the slot is cleared so it can't be taken twice */
+static void s2n_ephemeral_key_pool_flush_kem(struct s2n_ephemeral_key_pool *pool)
+{
+    for (int i = 0; i < S2N_EPHEMERAL_KEY_POOL_KEM_COUNT; i++) {
+        while (pool->kem_key_count[i] > 0) {
+            struct s2n_kem_keypair *slot = &pool->kem_keys[i][--pool->kem_key_count[i]];
+            s2n_kem_free(slot);
+            memset(slot, 0, sizeof(struct s2n_kem_keypair));
+        }
+    }
+}
+
+/* Keys generated before a fork must not be handed out by both parent and child */
+static void s2n_ephemeral_key_pool_check_fork(struct s2n_ephemeral_key_pool *pool)
+{
+    pid_t pid = getpid();
+    if (pool->pid != pid) {
+        s2n_ephemeral_key_pool_flush_ecc(pool);
+        s2n_ephemeral_key_pool_flush_dh(pool);
+        s2n_ephemeral_key_pool_flush_kem(pool);
+        pool->pid = pid;
+    }
+}
+
+int s2n_ephemeral_key_pool_free(struct s2n_ephemeral_key_pool **pool)
+{
+    notnull_check(pool);
+    if (*pool == NULL) {
+        return 0;
+    }
+
+    struct s2n_ephemeral_key_pool *p = *pool;
+    s2n_ephemeral_key_pool_flush_ecc(p);
+    s2n_ephemeral_key_pool_flush_dh(p);
+    s2n_ephemeral_key_pool_flush_kem(p);
+
+    for (int i = 0; i < S2N_ECC_SUPPORTED_CURVES_COUNT; i++) {
+        GUARD(s2n_free_object((uint8_t **)&p->ecc_keys[i], p->size * sizeof(struct s2n_ecc_params)));
+    }
+    GUARD(s2n_free_object((uint8_t **)&p->dh_keys, p->size * sizeof(struct s2n_dh_params)));
+    for (int i = 0; i < S2N_EPHEMERAL_KEY_POOL_KEM_COUNT; i++) {
+        GUARD(s2n_free_object((uint8_t **)&p->kem_keys[i], p->size * sizeof(struct s2n_kem_keypair)));
+    }
+
+    pthread_mutex_destroy(&p->lock);
+    GUARD(s2n_free_object((uint8_t **)pool, sizeof(struct s2n_ephemeral_key_pool)));
+
+    return 0;
+}
+
+int s2n_config_set_ephemeral_key_pool_size(struct s2n_config *config, uint32_t size)
+{
+    notnull_check(config);
+    S2N_ERROR_IF(size > S2N_EPHEMERAL_KEY_POOL_MAX_SIZE, S2N_ERR_INVALID_ARGUMENT);
+
+    GUARD(s2n_ephemeral_key_pool_free(&config->ephemeral_key_pool));
+    if (size == 0) {
+        return 0;
+    }
+
+    struct s2n_blob mem = {0};
+    GUARD(s2n_alloc(&mem, sizeof(struct s2n_ephemeral_key_pool)));
+    GUARD(s2n_blob_zero(&mem));
+
+    struct s2n_ephemeral_key_pool *pool = (struct s2n_ephemeral_key_pool *)(void *)mem.data;
+    if (pthread_mutex_init(&pool->lock, NULL) != 0) {
+        GUARD(s2n_free(&mem));
+        S2N_ERROR(S2N_ERR_LOCK);
+    }
+    pool->pid = getpid();
+    pool->size = size;
+    config->ephemeral_key_pool = pool;
+
+    for (int i = 0; i < S2N_ECC_SUPPORTED_CURVES_COUNT; i++) {
+        GUARD(s2n_alloc(&mem, size * sizeof(struct s2n_ecc_params)));
+        GUARD(s2n_blob_zero(&mem));
+        pool->ecc_keys[i] = (struct s2n_ecc_params *)(void *)mem.data;
+    }
+
+    GUARD(s2n_alloc(&mem, size * sizeof(struct s2n_dh_params)));
+    GUARD(s2n_blob_zero(&mem));
+    pool->dh_keys = (struct s2n_dh_params *)(void *)mem.data;
+
+    for (int i = 0; i < S2N_EPHEMERAL_KEY_POOL_KEM_COUNT; i++) {
+        GUARD(s2n_alloc(&mem, size * sizeof(struct s2n_kem_keypair)));
+        GUARD(s2n_blob_zero(&mem));
+        pool->kem_keys[i] = (struct s2n_kem_keypair *)(void *)mem.data;
+    }
+
+    return 0;
+}
+
+static int s2n_ephemeral_key_pool_ecc_vacancies(struct s2n_ephemeral_key_pool *pool, int curve)
+{
+    GUARD(s2n_ephemeral_key_pool_lock(pool));
+    s2n_ephemeral_key_pool_check_fork(pool);
+    int vacancies = pool->size - pool->ecc_key_count[curve];
+    GUARD(s2n_ephemeral_key_pool_unlock(pool));
+
+    return vacancies;
+}
+
+static int s2n_ephemeral_key_pool_dh_vacancies(struct s2n_ephemeral_key_pool *pool, const struct s2n_dh_params *dh_source)
+{
+    GUARD(s2n_ephemeral_key_pool_lock(pool));
+    s2n_ephemeral_key_pool_check_fork(pool);
+    int vacancies = pool->size;
+    if (pool->dh_source == dh_source) {
+        vacancies -= pool->dh_key_count;
+    }
+    GUARD(s2n_ephemeral_key_pool_unlock(pool));
+
+    return vacancies;
+}
+
+static int s2n_ephemeral_key_pool_kem_vacancies(struct s2n_ephemeral_key_pool *pool, int kem)
+{
+    GUARD(s2n_ephemeral_key_pool_lock(pool));
+    s2n_ephemeral_key_pool_check_fork(pool);
+    int vacancies = pool->size - pool->kem_key_count[kem];
+    GUARD(s2n_ephemeral_key_pool_unlock(pool));
+
+    return vacancies;
+}
+
+static int s2n_ephemeral_key_pool_add_ecc_key(struct s2n_ephemeral_key_pool *pool, int curve)
+{
+    struct s2n_ecc_params key = {0};
+    key.negotiated_curve = &s2n_ecc_supported_curves[curve];
+
+    /* Key generation is the expensive part, so it happens without holding the lock */
+    GUARD(s2n_ecc_generate_ephemeral_key(&key));
+
+    if (s2n_ephemeral_key_pool_lock(pool) < 0) {
+        s2n_ecc_params_free(&key);
+        return -1;
+    }
+
+    s2n_ephemeral_key_pool_check_fork(pool);
+    if (pool->ecc_key_count[curve] < pool->size) {
+        pool->ecc_keys[curve][pool->ecc_key_count[curve]++] = key;
+        key.evp_pkey = NULL;
+    }
+
+    int result = s2n_ephemeral_key_pool_unlock(pool);
+    GUARD(s2n_ecc_params_free(&key));
+
+    return result;
+}
+
+static int s2n_ephemeral_key_pool_add_dh_key(struct s2n_ephemeral_key_pool *pool, struct s2n_dh_params *dh_source)
+{
+    struct s2n_dh_params key = {0};
+    GUARD(s2n_dh_params_copy(dh_source, &key));
+    if (s2n_dh_generate_ephemeral_key(&key) < 0) {
+        s2n_dh_params_free(&key);
+        return -1;
+    }
+
+    if (s2n_ephemeral_key_pool_lock(pool) < 0) {
+        s2n_dh_params_free(&key);
+        return -1;
+    }
+
+    s2n_ephemeral_key_pool_check_fork(pool);
+    if (pool->dh_source != dh_source) {
+        s2n_ephemeral_key_pool_flush_dh(pool);
+        pool->dh_source = dh_source;
+    }
+    if (pool->dh_key_count < pool->size) {
+        pool->dh_keys[pool->dh_key_count++] = key;
+        key.dh = NULL;
+    }
+
+    int result = s2n_ephemeral_key_pool_unlock(pool);
+    GUARD(s2n_dh_params_free(&key));
+
+    return result;
+}
+
+static int s2n_ephemeral_key_pool_add_kem_key(struct s2n_ephemeral_key_pool *pool, int kem)
+{
+    DEFER_CLEANUP(struct s2n_kem_keypair key = {0}, s2n_kem_free);
+    key.negotiated_kem = s2n_ephemeral_key_pool_kems[kem];
+    GUARD(s2n_alloc(&key.public_key, key.negotiated_kem->public_key_length));
+    GUARD(s2n_kem_generate_keypair(&key));
+
+    GUARD(s2n_ephemeral_key_pool_lock(pool));
+    s2n_ephemeral_key_pool_check_fork(pool);
+    if (pool->kem_key_count[kem] < pool->size) {
+        pool->kem_keys[kem][pool->kem_key_count[kem]++] = key;
+        memset(&key, 0, sizeof(struct s2n_kem_keypair));
+    }
+    GUARD(s2n_ephemeral_key_pool_unlock(pool));
+
+    return 0;
+}
+
+int s2n_config_refill_ephemeral_key_pool(struct s2n_config *config)
+{
+    notnull_check(config);
+    struct s2n_ephemeral_key_pool *pool = config->ephemeral_key_pool;
+    S2N_ERROR_IF(pool == NULL, S2N_ERR_EPHEMERAL_KEY_POOL_DISABLED);
+
+    for (int i = 0; i < S2N_ECC_SUPPORTED_CURVES_COUNT; i++) {
+        int vacancies = s2n_ephemeral_key_pool_ecc_vacancies(pool, i);
+        GUARD(vacancies);
+        for (int j = 0; j < vacancies; j++) {
+            GUARD(s2n_ephemeral_key_pool_add_ecc_key(pool, i));
+        }
+    }
+
+    if (config->dhparams != NULL) {
+        int vacancies = s2n_ephemeral_key_pool_dh_vacancies(pool, config->dhparams);
+        GUARD(vacancies);
+        for (int j = 0; j < vacancies; j++) {
+            GUARD(s2n_ephemeral_key_pool_add_dh_key(pool, config->dhparams));
+        }
+    }
+
+    for (int i = 0; i < S2N_EPHEMERAL_KEY_POOL_KEM_COUNT; i++) {
+        int in_use = s2n_ephemeral_key_pool_kem_in_use(config, s2n_ephemeral_key_pool_kems[i]);
+        GUARD(in_use);
+        if (!in_use) {
+            continue;
+        }
+
+        int vacancies = s2n_ephemeral_key_pool_kem_vacancies(pool, i);
+        GUARD(vacancies);
+        for (int j = 0; j < vacancies; j++) {
+            GUARD(s2n_ephemeral_key_pool_add_kem_key(pool, i));
+        }
+    }
+
+    return 0;
+}
+
+int s2n_config_get_ephemeral_key_pool_stats(struct s2n_config *config, uint64_t *hits, uint64_t *misses)
+{
+    notnull_check(config);
+    notnull_check(hits);
+    notnull_check(misses);
+    struct s2n_ephemeral_key_pool *pool = config->ephemeral_key_pool;
+    S2N_ERROR_IF(pool == NULL, S2N_ERR_EPHEMERAL_KEY_POOL_DISABLED);
+
+    GUARD(s2n_ephemeral_key_pool_lock(pool));
+    *hits = pool->hits;
+    *misses = pool->misses;
+    GUARD(s2n_ephemeral_key_pool_unlock(pool));
+
+    return 0;
+}
+
+int s2n_config_get_ephemeral_key_pool_kem_stats(struct s2n_config *config, const char *kem_name, uint32_t *depth, uint64_t *misses)
+{
+    notnull_check(config);
+    notnull_check(kem_name);
+    notnull_check(depth);
+    notnull_check(misses);
+    struct s2n_ephemeral_key_pool *pool = config->ephemeral_key_pool;
+    S2N_ERROR_IF(pool == NULL, S2N_ERR_EPHEMERAL_KEY_POOL_DISABLED);
+
+    int kem = -1;
+    for (int i = 0; i < S2N_EPHEMERAL_KEY_POOL_KEM_COUNT; i++) {
+        if (strcmp(s2n_ephemeral_key_pool_kems[i]->name, kem_name) == 0) {
+            kem = i;
+        }
+    }
+    S2N_ERROR_IF(kem < 0, S2N_ERR_KEM_UNSUPPORTED_PARAMS);
+
+    GUARD(s2n_ephemeral_key_pool_lock(pool));
+    s2n_ephemeral_key_pool_check_fork(pool);
+    *depth = pool->kem_key_count[kem];
+    *misses = pool->kem_misses[kem];
+    GUARD(s2n_ephemeral_key_pool_unlock(pool));
+
+    return 0;
+}
+
+int s2n_ephemeral_key_pool_ecc_generate_ephemeral_key(struct s2n_config *config, struct s2n_ecc_params *ecc_params)
+{
+    notnull_check(config);
+    notnull_check(ecc_params);
+    notnull_check(ecc_params->negotiated_curve);
+
+    struct s2n_ephemeral_key_pool *pool = config->ephemeral_key_pool;
+    if (pool == NULL) {
+        return s2n_ecc_generate_ephemeral_key(ecc_params);
+    }
+
+    int curve = s2n_ephemeral_key_pool_curve_index(ecc_params->negotiated_curve);
+    int hit = 0;
+
+    GUARD(s2n_ephemeral_key_pool_lock(pool));
+    s2n_ephemeral_key_pool_check_fork(pool);
+    if (curve >= 0 && pool->ecc_key_count[curve] > 0) {
+        /* Move the key out of the pool so that it can never be handed out again */
+        struct s2n_ecc_params *pooled = &pool->ecc_keys[curve][--pool->ecc_key_count[curve]];
+        ecc_params->evp_pkey = pooled->evp_pkey;
+        pooled->evp_pkey = NULL;
+        pool->hits++;
+        hit = 1;
+    } else {
+        pool->misses++;
+    }
+    GUARD(s2n_ephemeral_key_pool_unlock(pool));
+
+    if (!hit) {
+        GUARD(s2n_ecc_generate_ephemeral_key(ecc_params));
+    }
+
+    return 0;
+}
+
+int s2n_ephemeral_key_pool_dh_generate_ephemeral_key(struct s2n_config *config, struct s2n_dh_params *dh_params)
+{
+    notnull_check(config);
+    notnull_check(config->dhparams);
+    notnull_check(dh_params);
+
+    struct s2n_ephemeral_key_pool *pool = config->ephemeral_key_pool;
+    int hit = 0;
+
+    if (pool != NULL) {
+        GUARD(s2n_ephemeral_key_pool_lock(pool));
+        s2n_ephemeral_key_pool_check_fork(pool);
+        if (pool->dh_source != config->dhparams) {
+            s2n_ephemeral_key_pool_flush_dh(pool);
+        }
+        if (pool->dh_key_count > 0) {
+            struct s2n_dh_params *pooled = &pool->dh_keys[--pool->dh_key_count];
+            dh_params->dh = pooled->dh;
+            pooled->dh = NULL;
+            pool->hits++;
+            hit = 1;
+        } else {
+            pool->misses++;
+        }
+        GUARD(s2n_ephemeral_key_pool_unlock(pool));
+    }
+
+    if (!hit) {
+        GUARD(s2n_dh_params_copy(config->dhparams, dh_params));
+        GUARD(s2n_dh_generate_ephemeral_key(dh_params));
+    }
+
+    return 0;
+}
+
+int s2n_ephemeral_key_pool_kem_generate_keypair(struct s2n_config *config, struct s2n_kem_keypair *kem_keys)
+{
+    notnull_check(config);
+    notnull_check(kem_keys);
+    const struct s2n_kem *kem = kem_keys->negotiated_kem;
+    notnull_check(kem);
+
+    struct s2n_ephemeral_key_pool *pool = config->ephemeral_key_pool;
+    if (pool == NULL) {
+        return s2n_kem_generate_keypair(kem_keys);
+    }
+
+    eq_check(kem_keys->public_key.size, kem->public_key_length);
+    notnull_check(kem_keys->public_key.data);
+
+    int index = s2n_ephemeral_key_pool_kem_index(kem);
+    DEFER_CLEANUP(struct s2n_kem_keypair pooled = {0}, s2n_kem_free);
+
+    GUARD(s2n_ephemeral_key_pool_lock(pool));
+    s2n_ephemeral_key_pool_check_fork(pool);
+    if (index >= 0 && pool->kem_key_count[index] > 0) {
+        /* Move the keypair out of the pool so that it can never be handed out again */
+        struct s2n_kem_keypair *slot = &pool->kem_keys[index][--pool->kem_key_count[index]];
+        pooled = *slot;
+        memset(slot, 0, sizeof(struct s2n_kem_keypair));
+        pool->hits++;
+    } else {
+        pool->misses++;
+        if (index >= 0) {
+            pool->kem_misses[index]++;
+        }
+    }
+    GUARD(s2n_ephemeral_key_pool_unlock(pool));
+
+    if (pooled.private_key.data == NULL) {
+        return s2n_kem_generate_keypair(kem_keys);
+    }
+
+    /* The public key goes into the caller's buffer; the private key blob changes owner */
+    memcpy_check(kem_keys->public_key.data, pooled.public_key.data, kem->public_key_length);
+    kem_keys->private_key = pooled.private_key;
+    memset(&pooled.private_key, 0, sizeof(struct s2n_blob));
+
+    return 0;
+}
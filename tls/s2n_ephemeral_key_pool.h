@@ -0,0 +1,64 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#pragma once
+
+#include <pthread.h>
+#include <sys/types.h>
+
+#include "crypto/s2n_dhe.h"
+#include "crypto/s2n_ecc.h"
+
+#define S2N_EPHEMERAL_KEY_POOL_MAX_SIZE 4096
+#define S2N_EPHEMERAL_KEY_POOL_KEM_COUNT 2
+
+struct s2n_config;
+struct s2n_kem_keypair;
+
+/* Single-use server ephemeral keys generated ahead of the handshakes that consume them.
+ * Every key is removed from the pool when it is taken, so no key is ever used twice.
+ */
+struct s2n_ephemeral_key_pool {
+    pthread_mutex_t lock;
+    /* The process the keys were generated in; a forked child throws them away */
+    pid_t pid;
+    uint32_t size;
+
+    /* One stack of keys per entry of s2n_ecc_supported_curves */
+    struct s2n_ecc_params *ecc_keys[S2N_ECC_SUPPORTED_CURVES_COUNT];
+    uint32_t ecc_key_count[S2N_ECC_SUPPORTED_CURVES_COUNT];
+
+    /* DHE keys, valid only while the config still uses dh_source */
+    struct s2n_dh_params *dh_keys;
+    uint32_t dh_key_count;
+    const struct s2n_dh_params *dh_source;
+
+    /* KEM keypairs for the hybrid suites, one stack per KEM. Only filled for KEMs the
+     * config's cipher preferences can negotiate.
+     */
+    struct s2n_kem_keypair *kem_keys[S2N_EPHEMERAL_KEY_POOL_KEM_COUNT];
+    uint32_t kem_key_count[S2N_EPHEMERAL_KEY_POOL_KEM_COUNT];
+    uint64_t kem_misses[S2N_EPHEMERAL_KEY_POOL_KEM_COUNT];
+
+    uint64_t hits;
+    uint64_t misses;
+};
+
+extern int s2n_ephemeral_key_pool_free(struct s2n_ephemeral_key_pool **pool);
+
+/* Fill in the server's ephemeral key from the config's pool, generating one inline on a miss */
+extern int s2n_ephemeral_key_pool_ecc_generate_ephemeral_key(struct s2n_config *config, struct s2n_ecc_params *ecc_params);
+extern int s2n_ephemeral_key_pool_dh_generate_ephemeral_key(struct s2n_config *config, struct s2n_dh_params *dh_params);
+extern int s2n_ephemeral_key_pool_kem_generate_keypair(struct s2n_config *config, struct s2n_kem_keypair *kem_keys);
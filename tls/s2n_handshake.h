@@ -153,6 +153,12 @@ struct s2n_handshake {
 
 #define MAX_HANDSHAKE_TYPE_LEN 128
 
+/* Dimensions of the handshake state machine: every combination of the handshake type
+ * bits above, and the longest message sequence of any of them.
+ */
+#define S2N_HANDSHAKES_COUNT            128
+#define S2N_MAX_HANDSHAKE_MESSAGES      16
+
 extern message_type_t s2n_conn_get_current_message_type(struct s2n_connection *conn);
 extern int s2n_conn_set_handshake_type(struct s2n_connection *conn);
 extern int s2n_conn_set_handshake_no_client_cert(struct s2n_connection *conn);
@@ -108,7 +108,7 @@ static const char *message_names[] = {
 /* We support different ordering of TLS Handshake messages, depending on what is being negotiated. There's also a dummy "INITIAL" handshake
  * that everything starts out as until we know better.
  */
-static message_type_t handshakes[128][16] = {
+static message_type_t handshakes[S2N_HANDSHAKES_COUNT][S2N_MAX_HANDSHAKE_MESSAGES] = {
     [INITIAL] = {
             CLIENT_HELLO,
             SERVER_HELLO
@@ -335,8 +335,11 @@ static const char* handshake_type_names[] = {
 #define ACTIVE_MESSAGE( conn ) handshakes[ (conn)->handshake.handshake_type ][ (conn)->handshake.message_number ]
 #define PREVIOUS_MESSAGE( conn ) handshakes[ (conn)->handshake.handshake_type ][ (conn)->handshake.message_number - 1 ]
 
+#define NEXT_MESSAGE( conn ) handshakes[ (conn)->handshake.handshake_type ][ (conn)->handshake.message_number + 1 ]
+
 #define ACTIVE_STATE( conn ) state_machine[ ACTIVE_MESSAGE( (conn) ) ]
 #define PREVIOUS_STATE( conn ) state_machine[ PREVIOUS_MESSAGE( (conn) ) ]
+#define NEXT_STATE( conn ) state_machine[ NEXT_MESSAGE( (conn) ) ]
 
 #define EXPECTED_MESSAGE_TYPE( conn ) ACTIVE_STATE( conn ).message_type
 
@@ -602,6 +605,12 @@ static int handshake_write_io(struct s2n_connection *conn)
             GUARD(s2n_conn_update_handshake_hashes(conn, &out));
         }
 
+        /* Send every record but the last of our flight with MSG_MORE, so that the flight is packed into full segments */
+        if (s2n_connection_is_managed_msg_more(conn)) {
+            GUARD(s2n_socket_write_more(conn, s2n_stuffer_data_available(&conn->handshake.io) > 0
+                                              || NEXT_STATE(conn).writer == ACTIVE_STATE(conn).writer));
+        }
+
         /* Actually send the record. We could block here. Assume the caller will call flush before coming back. */
         GUARD(s2n_flush(conn, &blocked));
     }
@@ -869,6 +878,7 @@ int s2n_negotiate(struct s2n_connection *conn, s2n_blocked_status * blocked)
         /* If the handshake has just ended, free up memory */
         if (ACTIVE_STATE(conn).writer == 'B') {
             GUARD(s2n_stuffer_resize(&conn->handshake.io, 0));
+            GUARD(s2n_connection_resize_record_buffers(conn));
         }
     }
 
@@ -19,9 +19,13 @@
 
 #include "s2n_connection.h"
 
+extern int s2n_record_rounded_write_payload_size(struct s2n_connection *conn, uint16_t size_without_overhead);
 extern int s2n_record_max_write_payload_size(struct s2n_connection *conn);
 extern int s2n_record_min_write_payload_size(struct s2n_connection *conn);
+extern int s2n_record_write_buffer_size(struct s2n_connection *conn);
+extern int s2n_record_read_buffer_size(struct s2n_connection *conn);
 extern int s2n_record_write(struct s2n_connection *conn, uint8_t content_type, struct s2n_blob *in);
+extern int s2n_record_write_multiblock(struct s2n_connection *conn, uint8_t content_type, struct s2n_blob *in, uint8_t records);
 extern int s2n_record_parse(struct s2n_connection *conn);
 extern int s2n_record_header_parse(struct s2n_connection *conn, uint8_t * content_type, uint16_t * fragment_length);
 extern int s2n_sslv2_record_header_parse(struct s2n_connection *conn, uint8_t * record_type, uint8_t * client_protocol_version, uint16_t * fragment_length);
@@ -13,6 +13,8 @@
  * permissions and limitations under the License.
  */
 
+#include <sys/param.h>
+
 #include "crypto/s2n_sequence.h"
 #include "crypto/s2n_cipher.h"
 #include "crypto/s2n_hmac.h"
@@ -24,6 +26,7 @@
 #include "tls/s2n_cipher_suites.h"
 #include "tls/s2n_connection.h"
 #include "tls/s2n_crypto.h"
+#include "tls/s2n_record.h"
 #include "tls/s2n_record_read.h"
 
 #include "utils/s2n_safety.h"
@@ -89,6 +92,16 @@ int s2n_record_header_parse(
     return 0;
 }
 
+int s2n_record_read_buffer_size(struct s2n_connection *conn)
+{
+    /* Once the peer has agreed to our record_size_limit, no protected record can be larger than this */
+    if (conn->peer_record_size_limit && conn->record_size_limit) {
+        return MIN(S2N_LARGE_FRAGMENT_LENGTH, conn->record_size_limit + S2N_TLS_MAXIMUM_RECORD_EXPANSION);
+    }
+
+    return S2N_LARGE_FRAGMENT_LENGTH;
+}
+
 int s2n_record_parse(struct s2n_connection *conn)
 {
     const struct s2n_cipher_suite *cipher_suite = conn->client->cipher_suite;
@@ -114,7 +127,11 @@ int s2n_record_parse(struct s2n_connection *conn)
         GUARD(s2n_record_parse_aead(cipher_suite, conn, content_type, encrypted_length, implicit_iv, mac, sequence_number, session_key));
         break;
     case S2N_CBC:
-        GUARD(s2n_record_parse_cbc(cipher_suite, conn, content_type, encrypted_length, implicit_iv, mac, sequence_number, session_key));
+        if (conn->encrypt_then_mac) {
+            GUARD(s2n_record_parse_cbc_encrypt_then_mac(cipher_suite, conn, content_type, encrypted_length, implicit_iv, mac, sequence_number, session_key));
+        } else {
+            GUARD(s2n_record_parse_cbc(cipher_suite, conn, content_type, encrypted_length, implicit_iv, mac, sequence_number, session_key));
+        }
         break;
     case S2N_COMPOSITE:
         GUARD(s2n_record_parse_composite(cipher_suite, conn, content_type, encrypted_length, implicit_iv, mac, sequence_number, session_key));
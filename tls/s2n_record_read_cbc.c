@@ -127,3 +127,113 @@ int s2n_record_parse_cbc(
 
     return 0;
 }
+
+/* RFC7366: An Encrypt-then-MAC record looks like ..
+ *
+ * [ IV ] [ Encrypted payload data, padding and padding length byte ] [ HMAC ]
+ *
+ * The MAC covers the header, the IV and the ciphertext, so it is checked before anything
+ * is decrypted. A record that fails the check is rejected without looking at the padding,
+ * so none of the constant-time work in s2n_verify_cbc() is needed.
+ */
+int s2n_record_parse_cbc_encrypt_then_mac(
+    const struct s2n_cipher_suite *cipher_suite,
+    struct s2n_connection *conn,
+    uint8_t content_type,
+    uint16_t encrypted_length,
+    uint8_t * implicit_iv,
+    struct s2n_hmac_state *mac,
+    uint8_t * sequence_number,
+    struct s2n_session_key *session_key)
+{
+    struct s2n_blob iv = {.data = implicit_iv,.size = cipher_suite->record_alg->cipher->io.cbc.record_iv_size };
+    uint8_t ivpad[S2N_TLS_MAX_IV_LEN];
+
+    uint8_t *header = s2n_stuffer_raw_read(&conn->header_in, S2N_TLS_RECORD_HEADER_LENGTH);
+    notnull_check(header);
+
+    lte_check(cipher_suite->record_alg->cipher->io.cbc.record_iv_size, S2N_TLS_MAX_IV_LEN);
+
+    uint8_t mac_digest_size;
+    GUARD(s2n_hmac_digest_size(mac->alg, &mac_digest_size));
+
+    gte_check(encrypted_length, mac_digest_size);
+    uint16_t mac_length = encrypted_length - mac_digest_size;
+
+    /* MAC the header, with the length of everything but the MAC, and the IV and ciphertext */
+    uint8_t *mac_data = s2n_stuffer_raw_read(&conn->in, mac_length);
+    notnull_check(mac_data);
+    uint8_t *record_digest = s2n_stuffer_raw_read(&conn->in, mac_digest_size);
+    notnull_check(record_digest);
+
+    header[3] = (mac_length >> 8);
+    header[4] = mac_length & 0xff;
+    GUARD(s2n_hmac_reset(mac));
+    GUARD(s2n_hmac_update(mac, sequence_number, S2N_TLS_SEQUENCE_NUM_LEN));
+    GUARD(s2n_hmac_update(mac, header, S2N_TLS_RECORD_HEADER_LENGTH));
+    GUARD(s2n_hmac_update(mac, mac_data, mac_length));
+
+    struct s2n_blob seq = {.data = sequence_number,.size = S2N_TLS_SEQUENCE_NUM_LEN };
+    GUARD(s2n_increment_sequence_number(&seq));
+
+    uint8_t check_digest[S2N_MAX_DIGEST_LEN];
+    lte_check(mac_digest_size, sizeof(check_digest));
+    GUARD(s2n_hmac_digest(mac, check_digest, mac_digest_size));
+    GUARD(s2n_hmac_reset(mac));
+
+    if (!s2n_constant_time_equals(record_digest, check_digest, mac_digest_size)) {
+        GUARD(s2n_stuffer_wipe(&conn->in));
+        S2N_ERROR(S2N_ERR_BAD_MESSAGE);
+    }
+
+    /* The record is authentic, now decrypt it */
+    GUARD(s2n_stuffer_reread(&conn->in));
+
+    /* For TLS >= 1.1 the IV is in the packet */
+    if (conn->actual_protocol_version > S2N_TLS10) {
+        GUARD(s2n_stuffer_read(&conn->in, &iv));
+        gte_check(mac_length, iv.size);
+        mac_length -= iv.size;
+    }
+
+    struct s2n_blob en = {.size = mac_length,.data = s2n_stuffer_raw_read(&conn->in, mac_length) };
+    notnull_check(en.data);
+
+    /* Check that we have some data to decrypt, and a multiple of the block size */
+    ne_check(en.size, 0);
+    eq_check(en.size % iv.size, 0);
+
+    /* Copy the last encrypted block to be the next IV */
+    if (conn->actual_protocol_version < S2N_TLS11) {
+        memcpy_check(ivpad, en.data + en.size - iv.size, iv.size);
+    }
+
+    GUARD(cipher_suite->record_alg->cipher->io.cbc.decrypt(session_key, &iv, &en, &en));
+
+    if (conn->actual_protocol_version < S2N_TLS11) {
+        memcpy_check(implicit_iv, ivpad, iv.size);
+    }
+
+    /* The peer's padding can't be forged, but it still has to be well formed */
+    uint8_t padding_length = en.data[en.size - 1];
+    S2N_ERROR_IF(padding_length >= en.size, S2N_ERR_BAD_MESSAGE);
+    for (int i = en.size - 1 - padding_length; i < en.size - 1; i++) {
+        S2N_ERROR_IF(en.data[i] != padding_length, S2N_ERR_BAD_MESSAGE);
+    }
+    uint16_t payload_length = en.size - padding_length - 1;
+
+    /* Align the stuffer for reading the plaintext data */
+    GUARD(s2n_stuffer_reread(&conn->in));
+    GUARD(s2n_stuffer_reread(&conn->header_in));
+
+    /* Skip the IV, if any */
+    if (conn->actual_protocol_version > S2N_TLS10) {
+        GUARD(s2n_stuffer_skip_read(&conn->in, cipher_suite->record_alg->cipher->io.cbc.record_iv_size));
+    }
+
+    /* Truncate and wipe the padding and the MAC */
+    GUARD(s2n_stuffer_wipe_n(&conn->in, s2n_stuffer_data_available(&conn->in) - payload_length));
+    conn->in_status = PLAINTEXT;
+
+    return 0;
+}
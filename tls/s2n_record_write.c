@@ -74,7 +74,12 @@ int s2n_record_rounded_write_payload_size(struct s2n_connection *conn, uint16_t
     }
 
     /* Round the fragment size down to be block aligned */
-    if (active->cipher_suite->record_alg->cipher->type == S2N_CBC) {
+    if (active->cipher_suite->record_alg->cipher->type == S2N_CBC && conn->encrypt_then_mac) {
+        /* With Encrypt-then-MAC the MAC follows the block aligned ciphertext */
+        uint8_t mac_digest_size;
+        GUARD(s2n_hmac_digest_size(active->cipher_suite->record_alg->hmac_alg, &mac_digest_size));
+        max_fragment_size -= (max_fragment_size - mac_digest_size) % active->cipher_suite->record_alg->cipher->io.cbc.block_size;
+    } else if (active->cipher_suite->record_alg->cipher->type == S2N_CBC) {
         max_fragment_size -= max_fragment_size % active->cipher_suite->record_alg->cipher->io.cbc.block_size;
     } else if (active->cipher_suite->record_alg->cipher->type == S2N_COMPOSITE) {
         max_fragment_size -= max_fragment_size % active->cipher_suite->record_alg->cipher->io.comp.block_size;
@@ -84,7 +89,14 @@ int s2n_record_rounded_write_payload_size(struct s2n_connection *conn, uint16_t
         max_fragment_size -= 1;
     }
 
-    return max_fragment_size - overhead(conn);
+    int payload_size = max_fragment_size - overhead(conn);
+
+    /* RFC8449: the peer's record_size_limit caps the plaintext of every record we send */
+    if (conn->peer_record_size_limit) {
+        payload_size = MIN(payload_size, conn->peer_record_size_limit);
+    }
+
+    return payload_size;
 }
 
 int s2n_record_max_write_payload_size(struct s2n_connection *conn)
@@ -92,6 +104,15 @@ int s2n_record_max_write_payload_size(struct s2n_connection *conn)
     return s2n_record_rounded_write_payload_size(conn, conn->max_outgoing_fragment_length);
 }
 
+int s2n_record_write_buffer_size(struct s2n_connection *conn)
+{
+    if (conn->peer_record_size_limit) {
+        return MIN(S2N_LARGE_RECORD_LENGTH, S2N_TLS_RECORD_HEADER_LENGTH + conn->peer_record_size_limit + S2N_TLS_MAXIMUM_RECORD_EXPANSION);
+    }
+
+    return S2N_LARGE_RECORD_LENGTH;
+}
+
 int s2n_record_min_write_payload_size(struct s2n_connection *conn)
 {
     uint16_t min_outgoing_fragement_length = ETH_MTU - (conn->ipv6 ? IP_V6_HEADER_LENGTH : IP_V4_HEADER_LENGTH) 
@@ -119,6 +140,32 @@ int s2n_record_write_protocol_version(struct s2n_connection *conn)
     return 0;
 }
 
+/* RFC7366: MAC the header, explicit IV and ciphertext, then append the digest.
+ * The header is MACed with the length of everything but the MAC.
+ */
+static int s2n_record_write_encrypt_then_mac(struct s2n_connection *conn, struct s2n_hmac_state *mac, uint8_t mac_digest_size,
+                                             uint16_t actual_fragment_length)
+{
+    gte_check(actual_fragment_length, mac_digest_size);
+    uint16_t mac_length = actual_fragment_length - mac_digest_size;
+
+    uint8_t header[S2N_TLS_RECORD_HEADER_LENGTH];
+    memcpy_check(header, conn->out.blob.data, S2N_TLS_RECORD_HEADER_LENGTH);
+    header[3] = mac_length >> 8;
+    header[4] = mac_length & 0xff;
+
+    GUARD(s2n_hmac_update(mac, header, S2N_TLS_RECORD_HEADER_LENGTH));
+    GUARD(s2n_hmac_update(mac, conn->out.blob.data + S2N_TLS_RECORD_HEADER_LENGTH, mac_length));
+
+    uint8_t *digest = s2n_stuffer_raw_write(&conn->out, mac_digest_size);
+    notnull_check(digest);
+
+    GUARD(s2n_hmac_digest(mac, digest, mac_digest_size));
+    GUARD(s2n_hmac_reset(mac));
+
+    return 0;
+}
+
 int s2n_record_write(struct s2n_connection *conn, uint8_t content_type, struct s2n_blob *in)
 {
     struct s2n_blob out, iv, aad;
@@ -146,6 +193,9 @@ int s2n_record_write(struct s2n_connection *conn, uint8_t content_type, struct s
     uint8_t mac_digest_size;
     GUARD(s2n_hmac_digest_size(mac->alg, &mac_digest_size));
 
+    /* RFC7366: CBC records are MACed after they are encrypted */
+    uint8_t encrypt_then_mac = conn->encrypt_then_mac && cipher_suite->record_alg->cipher->type == S2N_CBC;
+
     /* Before we do anything, we need to figure out what the length of the
      * fragment is going to be.
      */
@@ -156,8 +206,14 @@ int s2n_record_write(struct s2n_connection *conn, uint8_t content_type, struct s
     /* If we have padding to worry about, figure that out too */
     if (cipher_suite->record_alg->cipher->type == S2N_CBC) {
         block_size = cipher_suite->record_alg->cipher->io.cbc.block_size;
-        if (((data_bytes_to_take + extra) % block_size)) {
-            padding = block_size - ((data_bytes_to_take + extra) % block_size);
+
+        /* The MAC is only padded when it's encrypted too */
+        uint16_t padded_extra = extra;
+        if (encrypt_then_mac) {
+            padded_extra -= mac_digest_size;
+        }
+        if (((data_bytes_to_take + padded_extra) % block_size)) {
+            padding = block_size - ((data_bytes_to_take + padded_extra) % block_size);
         }
     } else if (cipher_suite->record_alg->cipher->type == S2N_COMPOSITE) {
         block_size = cipher_suite->record_alg->cipher->io.comp.block_size;
@@ -166,7 +222,7 @@ int s2n_record_write(struct s2n_connection *conn, uint8_t content_type, struct s
     /* Start the MAC with the sequence number */
     GUARD(s2n_hmac_update(mac, sequence_number, S2N_TLS_SEQUENCE_NUM_LEN));
 
-    GUARD(s2n_stuffer_resize_if_empty(&conn->out, S2N_LARGE_RECORD_LENGTH));
+    GUARD(s2n_stuffer_resize_if_empty(&conn->out, s2n_record_write_buffer_size(conn)));
 
     /* Now that we know the length, start writing the record */
     GUARD(s2n_stuffer_write_uint8(&conn->out, content_type));
@@ -175,12 +231,15 @@ int s2n_record_write(struct s2n_connection *conn, uint8_t content_type, struct s
     /* First write a header that has the payload length, this is for the MAC */
     GUARD(s2n_stuffer_write_uint16(&conn->out, data_bytes_to_take));
 
-    if (conn->actual_protocol_version > S2N_SSLv3) {
-        GUARD(s2n_hmac_update(mac, conn->out.blob.data, S2N_TLS_RECORD_HEADER_LENGTH));
-    } else {
-        /* SSLv3 doesn't include the protocol version in the MAC */
-        GUARD(s2n_hmac_update(mac, conn->out.blob.data, 1));
-        GUARD(s2n_hmac_update(mac, conn->out.blob.data + 3, 2));
+    /* With Encrypt-then-MAC the header is MACed after encryption, with the ciphertext length */
+    if (!encrypt_then_mac) {
+        if (conn->actual_protocol_version > S2N_SSLv3) {
+            GUARD(s2n_hmac_update(mac, conn->out.blob.data, S2N_TLS_RECORD_HEADER_LENGTH));
+        } else {
+            /* SSLv3 doesn't include the protocol version in the MAC */
+            GUARD(s2n_hmac_update(mac, conn->out.blob.data, 1));
+            GUARD(s2n_hmac_update(mac, conn->out.blob.data + 3, 2));
+        }
     }
 
     /* Compute non-payload parts of the MAC(seq num, type, proto vers, fragment length) for composite ciphers.
@@ -257,14 +316,17 @@ int s2n_record_write(struct s2n_connection *conn, uint8_t content_type, struct s
     out.data = in->data;
     out.size = data_bytes_to_take;
     GUARD(s2n_stuffer_write(&conn->out, &out));
-    GUARD(s2n_hmac_update(mac, out.data, out.size));
 
-    /* Write the digest */
-    uint8_t *digest = s2n_stuffer_raw_write(&conn->out, mac_digest_size);
-    notnull_check(digest);
+    if (!encrypt_then_mac) {
+        GUARD(s2n_hmac_update(mac, out.data, out.size));
 
-    GUARD(s2n_hmac_digest(mac, digest, mac_digest_size));
-    GUARD(s2n_hmac_reset(mac));
+        /* Write the digest */
+        uint8_t *digest = s2n_stuffer_raw_write(&conn->out, mac_digest_size);
+        notnull_check(digest);
+
+        GUARD(s2n_hmac_digest(mac, digest, mac_digest_size));
+        GUARD(s2n_hmac_reset(mac));
+    }
 
     if (cipher_suite->record_alg->cipher->type == S2N_CBC) {
         /* Include padding bytes, each with the value 'p', and
@@ -294,6 +356,11 @@ int s2n_record_write(struct s2n_connection *conn, uint8_t content_type, struct s
             }
             /* Encrypt the padding and the padding length byte too */
             encrypted_length += padding + 1;
+
+            /* The MAC is written after encryption */
+            if (encrypt_then_mac) {
+                encrypted_length -= mac_digest_size;
+            }
             break;
         case S2N_COMPOSITE:
             /* Composite CBC expects a pointer starting at explicit IV: [Explicit IV | fragment | MAC | padding | padding len ]
@@ -323,6 +390,10 @@ int s2n_record_write(struct s2n_connection *conn, uint8_t content_type, struct s
                 gte_check(en.size, block_size);
                 memcpy_check(implicit_iv, en.data + en.size - block_size, block_size);
             }
+
+            if (encrypt_then_mac) {
+                GUARD(s2n_record_write_encrypt_then_mac(conn, mac, mac_digest_size, actual_fragment_length));
+            }
             break;
         case S2N_AEAD:
             GUARD(cipher_suite->record_alg->cipher->io.aead.encrypt(session_key, &iv, &aad, &en, &en));
@@ -343,3 +414,55 @@ int s2n_record_write(struct s2n_connection *conn, uint8_t content_type, struct s
     conn->wire_bytes_out += actual_fragment_length + S2N_TLS_RECORD_HEADER_LENGTH;
     return data_bytes_to_take;
 }
+
+int s2n_record_write_multiblock(struct s2n_connection *conn, uint8_t content_type, struct s2n_blob *in, uint8_t records)
+{
+    uint8_t *sequence_number = conn->server->server_sequence_number;
+    struct s2n_session_key *session_key = &conn->server->server_key;
+    const struct s2n_cipher_suite *cipher_suite = conn->server->cipher_suite;
+    uint8_t *implicit_iv = conn->server->server_implicit_iv;
+
+    if (conn->mode == S2N_CLIENT) {
+        sequence_number = conn->client->client_sequence_number;
+        session_key = &conn->client->client_key;
+        cipher_suite = conn->client->cipher_suite;
+        implicit_iv = conn->client->client_implicit_iv;
+    }
+
+    S2N_ERROR_IF(s2n_stuffer_data_available(&conn->out), S2N_ERR_BAD_MESSAGE);
+
+    /* Each record needs an explicit IV, so TLS1.0 chains them one by one */
+    const struct s2n_cipher *cipher = cipher_suite->record_alg->cipher;
+    if (cipher->type != S2N_COMPOSITE || cipher->io.comp.multiblock_encrypt == NULL || conn->actual_protocol_version < S2N_TLS11) {
+        return 0;
+    }
+
+    /* Every record is full */
+    int max_payload_size;
+    GUARD((max_payload_size = s2n_record_max_write_payload_size(conn)));
+    eq_check(in->size, records * max_payload_size);
+
+    GUARD(s2n_stuffer_resize_if_empty(&conn->out, s2n_record_write_buffer_size(conn)));
+
+    /* libcrypto may interleave fewer records than it was offered */
+    int written;
+    GUARD((written = cipher->io.comp.multiblock_encrypt(session_key, sequence_number, content_type, conn->actual_protocol_version,
+                                                        &records, in, &conn->out)));
+    if (written == 0) {
+        return 0;
+    }
+
+    /* The records used consecutive sequence numbers, starting with ours */
+    struct s2n_blob seq = {.data = sequence_number,.size = S2N_TLS_SEQUENCE_NUM_LEN };
+    for (int i = 0; i < records; i++) {
+        GUARD(s2n_increment_sequence_number(&seq));
+    }
+
+    /* Copy the last encrypted block to be the next IV, as s2n_record_write does */
+    uint8_t block_size = cipher->io.comp.block_size;
+    gte_check(written, block_size);
+    memcpy_check(implicit_iv, conn->out.blob.data + s2n_stuffer_data_available(&conn->out) - block_size, block_size);
+
+    conn->wire_bytes_out += written;
+    return records * max_payload_size;
+}
@@ -24,6 +24,7 @@
 
 #include "error/s2n_errno.h"
 
+#include "tls/s2n_cipher_suites.h"
 #include "tls/s2n_connection.h"
 #include "tls/s2n_handshake.h"
 #include "tls/s2n_record.h"
@@ -37,6 +38,17 @@
 #include "utils/s2n_safety.h"
 #include "utils/s2n_blob.h"
 
+/* RFC8449 Section 4: a negotiated record_size_limit only applies to protected records */
+static int s2n_record_size_limit_applies(struct s2n_connection *conn)
+{
+    const struct s2n_cipher_suite *cipher_suite = conn->client->cipher_suite;
+    if (conn->mode == S2N_CLIENT) {
+        cipher_suite = conn->server->cipher_suite;
+    }
+
+    return conn->peer_record_size_limit && conn->record_size_limit && cipher_suite != &s2n_null_cipher_suite;
+}
+
 int s2n_read_full_record(struct s2n_connection *conn, uint8_t * record_type, int *isSSLv2)
 {
     int r;
@@ -50,7 +62,7 @@ int s2n_read_full_record(struct s2n_connection *conn, uint8_t * record_type, int
         return 0;
     }
 
-    GUARD(s2n_stuffer_resize_if_empty(&conn->in, S2N_LARGE_FRAGMENT_LENGTH));
+    GUARD(s2n_stuffer_resize_if_empty(&conn->in, s2n_record_read_buffer_size(conn)));
 
     /* Read the record until we at least have a header */
     while (s2n_stuffer_data_available(&conn->header_in) < S2N_TLS_RECORD_HEADER_LENGTH) {
@@ -90,6 +102,13 @@ int s2n_read_full_record(struct s2n_connection *conn, uint8_t * record_type, int
         }
     }
 
+    /* Don't buffer a record that can't fit within our limit once decrypted */
+    const int record_size_limit_applies = !*isSSLv2 && s2n_record_size_limit_applies(conn);
+    if (record_size_limit_applies && fragment_length > conn->record_size_limit + S2N_TLS_MAXIMUM_RECORD_EXPANSION) {
+        GUARD(s2n_connection_kill(conn));
+        S2N_ERROR(S2N_ERR_RECORD_SIZE_LIMIT_EXCEEDED);
+    }
+
     /* Read enough to have the whole record */
     while (s2n_stuffer_data_available(&conn->in) < fragment_length) {
         int remaining = fragment_length - s2n_stuffer_data_available(&conn->in);
@@ -123,10 +142,17 @@ int s2n_read_full_record(struct s2n_connection *conn, uint8_t * record_type, int
         return -1;
     }
 
+    if (record_size_limit_applies && s2n_stuffer_data_available(&conn->in) > conn->record_size_limit) {
+        GUARD(s2n_connection_kill(conn));
+        S2N_ERROR(S2N_ERR_RECORD_SIZE_LIMIT_EXCEEDED);
+    }
+
     return 0;
 }
 
-ssize_t s2n_recv(struct s2n_connection * conn, void *buf, ssize_t size, s2n_blocked_status * blocked)
+/* Reads one record's worth of application data, or with drain set, keeps reading records until buf is full, the
+ * connection is closed or reading would block. */
+static ssize_t s2n_recv_records(struct s2n_connection *conn, void *buf, ssize_t size, s2n_blocked_status * blocked, uint8_t drain)
 {
     ssize_t bytes_read = 0;
     struct s2n_blob out = {.data = (uint8_t *) buf };
@@ -135,6 +161,8 @@ ssize_t s2n_recv(struct s2n_connection * conn, void *buf, ssize_t size, s2n_bloc
         return 0;
     }
 
+    GUARD(s2n_connection_wake(conn));
+
     *blocked = S2N_BLOCKED_ON_READ;
 
     while (size && !conn->closed) {
@@ -169,7 +197,16 @@ ssize_t s2n_recv(struct s2n_connection * conn, void *buf, ssize_t size, s2n_bloc
 
         if (record_type != TLS_APPLICATION_DATA) {
             if (record_type == TLS_ALERT) {
-                GUARD(s2n_process_alert_fragment(conn));
+                /* A fatal alert after some data has been read closes the connection. Return the data: the next
+                 * call reports the closure and the alert is available from s2n_connection_get_alert(). */
+                if (s2n_process_alert_fragment(conn) < 0) {
+                    if (bytes_read) {
+                        *blocked = S2N_NOT_BLOCKED;
+                        s2n_errno = S2N_ERR_OK;
+                        return bytes_read;
+                    }
+                    return -1;
+                }
                 GUARD(s2n_flush(conn, blocked));
             }
 
@@ -195,7 +232,7 @@ ssize_t s2n_recv(struct s2n_connection * conn, void *buf, ssize_t size, s2n_bloc
         }
 
         /* If we've read some data, return it */
-        if (bytes_read) {
+        if (bytes_read && !drain) {
             break;
         }
     }
@@ -207,6 +244,16 @@ ssize_t s2n_recv(struct s2n_connection * conn, void *buf, ssize_t size, s2n_bloc
     return bytes_read;
 }
 
+ssize_t s2n_recv(struct s2n_connection * conn, void *buf, ssize_t size, s2n_blocked_status * blocked)
+{
+    return s2n_recv_records(conn, buf, size, blocked, 0);
+}
+
+ssize_t s2n_recv_all(struct s2n_connection * conn, void *buf, ssize_t size, s2n_blocked_status * blocked)
+{
+    return s2n_recv_records(conn, buf, size, blocked, 1);
+}
+
 uint32_t s2n_peek(struct s2n_connection *conn) {
     return s2n_stuffer_data_available(&conn->in);
 }
@@ -21,8 +21,10 @@
 
 #include "tls/s2n_cipher_suites.h"
 #include "tls/s2n_connection.h"
+#include "tls/s2n_connection_group.h"
 #include "tls/s2n_handshake.h"
 #include "tls/s2n_record.h"
+#include "tls/s2n_tls.h"
 
 #include "stuffer/s2n_stuffer.h"
 
@@ -30,6 +32,7 @@
 
 #include "utils/s2n_safety.h"
 #include "utils/s2n_blob.h"
+#include "utils/s2n_socket.h"
 
 int s2n_flush(struct s2n_connection *conn, s2n_blocked_status * blocked)
 {
@@ -37,6 +40,9 @@ int s2n_flush(struct s2n_connection *conn, s2n_blocked_status * blocked)
 
     *blocked = S2N_BLOCKED_ON_WRITE;
 
+    /* Records encrypted by a connection group flush are older than anything in conn->out */
+    GUARD(s2n_connection_group_write_pending(conn));
+
     /* Write any data that's already pending */
   WRITE:
     while (s2n_stuffer_data_available(&conn->out)) {
@@ -50,6 +56,11 @@ int s2n_flush(struct s2n_connection *conn, s2n_blocked_status * blocked)
         conn->wire_bytes_out += w;
     }
 
+    /* Whatever is written next, alerts included, is sent without MSG_MORE unless the caller asks again */
+    if (s2n_connection_is_managed_msg_more(conn)) {
+        GUARD(s2n_socket_write_more(conn, 0));
+    }
+
     if (conn->closing) {
         conn->closed = 1;
     }
@@ -86,13 +97,129 @@ int s2n_flush(struct s2n_connection *conn, s2n_blocked_status * blocked)
     return 0;
 }
 
+/* Size records so that each one fits in the data the congestion window lets TCP send right
+ * away. A record can't be decrypted until all of it has arrived, so a record that has to
+ * wait for ACKs delays everything in it by a round trip. As the window opens records grow
+ * to the maximum, and after a loss or an idle period the window, and the records, shrink.
+ */
+static int s2n_sample_congestion_window(struct s2n_connection *conn)
+{
+    uint64_t elapsed;
+    GUARD(s2n_timer_elapsed(conn->config, &conn->write_timer, &elapsed));
+    if (conn->tcp_info_sample_interval && elapsed - conn->last_tcp_info_sample < conn->tcp_info_sample_interval) {
+        return 0;
+    }
+    conn->last_tcp_info_sample = elapsed;
+    conn->tcp_info_sample_interval = S2N_TCP_INFO_MIN_SAMPLE_INTERVAL_US * (uint64_t) 1000;
+
+    struct s2n_tcp_info info = {0};
+    int sampled = 0;
+    if (conn->tcp_info_cb) {
+        sampled = conn->tcp_info_cb(conn, conn->tcp_info_ctx, &info) == 0;
+    } else {
+        GUARD((sampled = s2n_socket_get_tcp_info(conn, &info)));
+    }
+
+    /* Without a sample, fall back to the dynamic record threshold */
+    if (!sampled || info.snd_mss <= S2N_TLS_RECORD_HEADER_LENGTH) {
+        conn->cwnd_payload_size = 0;
+        return 0;
+    }
+
+    conn->tcp_info_sample_interval = MAX(info.rtt, S2N_TCP_INFO_MIN_SAMPLE_INTERVAL_US) * (uint64_t) 1000;
+
+    /* Never go below one record per segment */
+    uint32_t window = info.snd_mss;
+    if (info.snd_cwnd > info.unacked + 1) {
+        window = (info.snd_cwnd - info.unacked) * info.snd_mss;
+    }
+    window = MIN(window, conn->max_outgoing_fragment_length + S2N_TLS_RECORD_HEADER_LENGTH);
+
+    int payload_size;
+    GUARD((payload_size = s2n_record_rounded_write_payload_size(conn, window - S2N_TLS_RECORD_HEADER_LENGTH)));
+    conn->cwnd_payload_size = MAX(payload_size, 1);
+
+    return 0;
+}
+
+/* Encrypt the next record, or run of records, of the remaining data onto conn->out and
+ * return how many bytes of it were taken.
+ */
+int s2n_send_application_record(struct s2n_connection *conn, const uint8_t *data, ssize_t remaining, int *cbc_hack_used)
+{
+    int max_payload_size;
+    GUARD((max_payload_size = s2n_record_max_write_payload_size(conn)));
+
+    struct s2n_crypto_parameters *writer = conn->server;
+    if (conn->mode == S2N_CLIENT) {
+        writer = conn->client;
+    }
+
+    if (conn->cwnd_record_sizing) {
+        GUARD(s2n_sample_congestion_window(conn));
+    }
+
+    struct s2n_blob in = {.data = (uint8_t *)(uintptr_t) data };
+    in.size = MIN(remaining, max_payload_size);
+    if (conn->cwnd_payload_size) {
+        in.size = MIN(in.size, conn->cwnd_payload_size);
+    } else if (conn->active_application_bytes_consumed < (uint64_t) conn->dynamic_record_resize_threshold) {
+        /* If dynamic record size is enabled,
+         * use small TLS records that fit into a single TCP segment for the threshold bytes of data
+         */
+        int min_payload_size = s2n_record_min_write_payload_size(conn);
+        if (min_payload_size < in.size) {
+            in.size = min_payload_size; 
+        }
+    }
+
+    /* TLS 1.0 and SSLv3 are vulnerable to the so-called Beast attack. Work
+     * around this by splitting messages into one byte records, and then
+     * the remainder can follow as usual.
+     *
+     * Don't split messages in server mode for interoperability with naive clients.
+     * Some clients may have expectations based on the amount of content in the first record.
+     */
+    if (conn->actual_protocol_version < S2N_TLS11 && writer->cipher_suite->record_alg->cipher->type == S2N_CBC && conn->mode != S2N_SERVER) {
+        if (in.size > 1 && *cbc_hack_used == 0) {
+            in.size = 1;
+            *cbc_hack_used = 1;
+        }
+    }
+
+    /* Composite ciphers may be able to encrypt four or eight full records in one pass */
+    uint8_t records = 0;
+    if (in.size == max_payload_size && writer->cipher_suite->record_alg->cipher->type == S2N_COMPOSITE) {
+        if (remaining >= 8 * max_payload_size) {
+            records = 8;
+        } else if (remaining >= 4 * max_payload_size) {
+            records = 4;
+        }
+    }
+
+    int written = 0;
+    if (records) {
+        struct s2n_blob multiblock = {.data = in.data,.size = records * max_payload_size };
+        GUARD((written = s2n_record_write_multiblock(conn, TLS_APPLICATION_DATA, &multiblock, records)));
+    }
+    if (written) {
+        in.size = written;
+    } else {
+        GUARD(s2n_record_write(conn, TLS_APPLICATION_DATA, &in));
+    }
+    conn->active_application_bytes_consumed += in.size;
+
+    return in.size;
+}
+
 ssize_t s2n_send(struct s2n_connection * conn, const void *buf, ssize_t size, s2n_blocked_status * blocked)
 {
     ssize_t user_data_sent;
-    int max_payload_size;
 
     S2N_ERROR_IF(conn->closed, S2N_ERR_CLOSED);
 
+    GUARD(s2n_connection_wake(conn));
+
     /* Flush any pending I/O */
     GUARD(s2n_flush(conn, blocked));
 
@@ -101,19 +228,9 @@ ssize_t s2n_send(struct s2n_connection * conn, const void *buf, ssize_t size, s2
 
     *blocked = S2N_BLOCKED_ON_WRITE;
 
-    GUARD((max_payload_size = s2n_record_max_write_payload_size(conn)));
-
-    /* TLS 1.0 and SSLv3 are vulnerable to the so-called Beast attack. Work
-     * around this by splitting messages into one byte records, and then
-     * the remainder can follow as usual.
-     */
+    /* Only the first record of each call is split to work around the Beast attack */
     int cbcHackUsed = 0;
 
-    struct s2n_crypto_parameters *writer = conn->server;
-    if (conn->mode == S2N_CLIENT) {
-        writer = conn->client;
-    }
-
     /* Defensive check against an invalid retry */
     S2N_ERROR_IF(conn->current_user_data_consumed > size, S2N_ERR_SEND_SIZE);
 
@@ -129,33 +246,18 @@ ssize_t s2n_send(struct s2n_connection * conn, const void *buf, ssize_t size, s2
 
     /* Now write the data we were asked to send this round */
     while (size - conn->current_user_data_consumed) {
-        struct s2n_blob in = {.data = ((uint8_t *)(uintptr_t) buf) + conn->current_user_data_consumed };
-        in.size = MIN(size - conn->current_user_data_consumed, max_payload_size);
-        /* If dynamic record size is enabled,
-         * use small TLS records that fit into a single TCP segment for the threshold bytes of data     
-         */
-        if (conn->active_application_bytes_consumed < (uint64_t) conn->dynamic_record_resize_threshold) {
-            int min_payload_size = s2n_record_min_write_payload_size(conn);
-            if (min_payload_size < in.size) {
-                in.size = min_payload_size; 
-            }
-        }
-
-        /* Don't split messages in server mode for interoperability with naive clients.
-         * Some clients may have expectations based on the amount of content in the first record.
-         */
-        if (conn->actual_protocol_version < S2N_TLS11 && writer->cipher_suite->record_alg->cipher->type == S2N_CBC && conn->mode != S2N_SERVER) {
-            if (in.size > 1 && cbcHackUsed == 0) {
-                in.size = 1;
-                cbcHackUsed = 1;
-            }
-        }
+        const uint8_t *data = ((const uint8_t *) buf) + conn->current_user_data_consumed;
 
         /* Write and encrypt the record */
         GUARD(s2n_stuffer_rewrite(&conn->out));
-        GUARD(s2n_record_write(conn, TLS_APPLICATION_DATA, &in));
-        conn->current_user_data_consumed += in.size;
-        conn->active_application_bytes_consumed += in.size;
+        int written;
+        GUARD((written = s2n_send_application_record(conn, data, size - conn->current_user_data_consumed, &cbcHackUsed)));
+        conn->current_user_data_consumed += written;
+
+        /* Every record but the last can wait for the next one to fill the segment */
+        if (s2n_connection_is_managed_msg_more(conn)) {
+            GUARD(s2n_socket_write_more(conn, size - conn->current_user_data_consumed > 0));
+        }
 
         /* Send it */
         if (s2n_flush(conn, blocked) < 0) {
@@ -15,6 +15,7 @@
 
 #include <stdint.h>
 #include <string.h>
+#include <sys/param.h>
 
 #include "error/s2n_errno.h"
 
@@ -36,6 +37,8 @@ static int s2n_recv_server_status_request(struct s2n_connection *conn, struct s2
 static int s2n_recv_server_sct_list(struct s2n_connection *conn, struct s2n_stuffer *extension);
 static int s2n_recv_server_max_frag_len(struct s2n_connection *conn, struct s2n_stuffer *extension);
 static int s2n_recv_server_session_ticket_ext(struct s2n_connection *conn, struct s2n_stuffer *extension);
+static int s2n_recv_server_encrypt_then_mac(struct s2n_connection *conn, struct s2n_stuffer *extension);
+static int s2n_recv_server_record_size_limit(struct s2n_connection *conn, struct s2n_stuffer *extension);
 
 #define s2n_server_can_send_server_name(conn) ((conn)->server_name_used && \
         !s2n_connection_is_session_resumed((conn)))
@@ -71,6 +74,12 @@ int s2n_server_extensions_send(struct s2n_connection *conn, struct s2n_stuffer *
     if (s2n_server_sending_nst(conn)) {
         total_size += 4;
     }
+    if (conn->encrypt_then_mac) {
+        total_size += 4;
+    }
+    if (conn->peer_record_size_limit) {
+        total_size += 6;
+    }
 
     if (total_size == 0) {
         return 0;
@@ -130,6 +139,20 @@ int s2n_server_extensions_send(struct s2n_connection *conn, struct s2n_stuffer *
         GUARD(s2n_stuffer_write_uint16(out, 0));
     }
 
+    /* Write Encrypt-then-MAC extension */
+    if (conn->encrypt_then_mac) {
+        GUARD(s2n_stuffer_write_uint16(out, TLS_EXTENSION_ENCRYPT_THEN_MAC));
+        GUARD(s2n_stuffer_write_uint16(out, 0));
+    }
+
+    /* Write Record Size Limit extension. Without a configured limit, accept up to the protocol maximum. */
+    if (conn->peer_record_size_limit) {
+        conn->record_size_limit = conn->config->record_size_limit ? conn->config->record_size_limit : S2N_TLS_MAXIMUM_FRAGMENT_LENGTH;
+        GUARD(s2n_stuffer_write_uint16(out, TLS_EXTENSION_RECORD_SIZE_LIMIT));
+        GUARD(s2n_stuffer_write_uint16(out, sizeof(uint16_t)));
+        GUARD(s2n_stuffer_write_uint16(out, conn->record_size_limit));
+    }
+
     return 0;
 }
 
@@ -177,6 +200,12 @@ int s2n_server_extensions_recv(struct s2n_connection *conn, struct s2n_blob *ext
         case TLS_EXTENSION_SESSION_TICKET:
             GUARD(s2n_recv_server_session_ticket_ext(conn, &extension));
             break;
+        case TLS_EXTENSION_ENCRYPT_THEN_MAC:
+            GUARD(s2n_recv_server_encrypt_then_mac(conn, &extension));
+            break;
+        case TLS_EXTENSION_RECORD_SIZE_LIMIT:
+            GUARD(s2n_recv_server_record_size_limit(conn, &extension));
+            break;
         }
     }
 
@@ -260,3 +289,29 @@ int s2n_recv_server_session_ticket_ext(struct s2n_connection *conn, struct s2n_s
 
     return 0;
 }
+
+int s2n_recv_server_encrypt_then_mac(struct s2n_connection *conn, struct s2n_stuffer *extension)
+{
+    /* RFC7366 Section 3: The server may only agree to an extension we offered, and only for a CBC suite */
+    S2N_ERROR_IF(!conn->encrypt_then_mac_requested, S2N_ERR_BAD_MESSAGE);
+    S2N_ERROR_IF(s2n_stuffer_data_available(extension), S2N_ERR_BAD_MESSAGE);
+
+    GUARD(s2n_set_cipher_encrypt_then_mac(conn));
+
+    return 0;
+}
+
+int s2n_recv_server_record_size_limit(struct s2n_connection *conn, struct s2n_stuffer *extension)
+{
+    /* RFC8449 Section 4: the server may only send the extension if we offered it */
+    S2N_ERROR_IF(!conn->record_size_limit, S2N_ERR_BAD_MESSAGE);
+
+    uint16_t record_size_limit;
+    S2N_ERROR_IF(s2n_stuffer_data_available(extension) != sizeof(record_size_limit), S2N_ERR_BAD_MESSAGE);
+    GUARD(s2n_stuffer_read_uint16(extension, &record_size_limit));
+    S2N_ERROR_IF(record_size_limit < S2N_TLS_MINIMUM_RECORD_SIZE_LIMIT, S2N_ERR_INVALID_RECORD_SIZE_LIMIT);
+
+    conn->peer_record_size_limit = MIN(record_size_limit, S2N_TLS_MAXIMUM_FRAGMENT_LENGTH);
+
+    return 0;
+}
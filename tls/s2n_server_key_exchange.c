@@ -22,6 +22,7 @@
 #include "tls/s2n_kex.h"
 #include "tls/s2n_cipher_suites.h"
 #include "tls/s2n_connection.h"
+#include "tls/s2n_ephemeral_key_pool.h"
 #include "tls/s2n_signature_algorithms.h"
 
 #include "stuffer/s2n_stuffer.h"
@@ -238,7 +239,7 @@ int s2n_server_key_send(struct s2n_connection *conn)
     GUARD(s2n_hash_update(signature_hash, data_to_sign.data, data_to_sign.size));
 
     /* Sign and write the signature */
-    GUARD(s2n_write_signature_blob(out, conn->handshake_params.our_chain_and_key->private_key, signature_hash));
+    GUARD(s2n_write_signature_blob(out, s2n_cert_chain_and_key_get_private_key(conn->handshake_params.our_chain_and_key), signature_hash));
     return 0;
 }
 
@@ -246,8 +247,8 @@ int s2n_ecdhe_server_key_send(struct s2n_connection *conn, struct s2n_blob *data
 {
     struct s2n_stuffer *out = &conn->handshake.io;
 
-    /* Generate an ephemeral key and  */
-    GUARD(s2n_ecc_generate_ephemeral_key(&conn->secure.server_ecc_params));
+    /* Take an ephemeral key from the pool, or generate one */
+    GUARD(s2n_ephemeral_key_pool_ecc_generate_ephemeral_key(conn->config, &conn->secure.server_ecc_params));
 
     /* Write it out and calculate the data to sign later */
     GUARD(s2n_ecc_write_ecc_params(&conn->secure.server_ecc_params, out, data_to_sign));
@@ -258,11 +259,8 @@ int s2n_dhe_server_key_send(struct s2n_connection *conn, struct s2n_blob *data_t
 {
     struct s2n_stuffer *out = &conn->handshake.io;
 
-    /* Duplicate the DH key from the config */
-    GUARD(s2n_dh_params_copy(conn->config->dhparams, &conn->secure.server_dh_params));
-
-    /* Generate an ephemeral key */
-    GUARD(s2n_dh_generate_ephemeral_key(&conn->secure.server_dh_params));
+    /* Take an ephemeral key from the pool, or duplicate the DH params from the config and generate one */
+    GUARD(s2n_ephemeral_key_pool_dh_generate_ephemeral_key(conn->config, &conn->secure.server_dh_params));
 
     /* Write it out and calculate the data to sign later */
     GUARD(s2n_dh_params_to_p_g_Ys(&conn->secure.server_dh_params, out, data_to_sign));
@@ -286,7 +284,7 @@ int s2n_kem_server_key_send(struct s2n_connection *conn, struct s2n_blob *data_t
     notnull_check(public_key->data);
     public_key->size = kem->public_key_length;
 
-    GUARD(s2n_kem_generate_keypair(&conn->secure.s2n_kem_keys));
+    GUARD(s2n_ephemeral_key_pool_kem_generate_keypair(conn->config, &conn->secure.s2n_kem_keys));
 
     data_to_sign->size = sizeof(kem_extension_size) + sizeof(kem_public_key_size) +  public_key->size;
     return 0;
@@ -35,6 +35,8 @@ int s2n_shutdown(struct s2n_connection *conn, s2n_blocked_status * more)
     GUARD(s2n_timer_elapsed(conn->config, &conn->write_timer, &elapsed));
     S2N_ERROR_IF(elapsed < conn->delay, S2N_ERR_SHUTDOWN_PAUSED);
 
+    GUARD(s2n_connection_wake(conn));
+
     /* Queue our close notify, once. Use warning level so clients don't give up */
     GUARD(s2n_queue_writer_close_alert_warning(conn));
 
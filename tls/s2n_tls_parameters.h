@@ -85,6 +85,8 @@
 #define TLS_EXTENSION_SIGNATURE_ALGORITHMS 13
 #define TLS_EXTENSION_ALPN                 16
 #define TLS_EXTENSION_SCT_LIST             18
+#define TLS_EXTENSION_ENCRYPT_THEN_MAC     22
+#define TLS_EXTENSION_RECORD_SIZE_LIMIT    28
 #define TLS_EXTENSION_SESSION_TICKET       35
 #define TLS_EXTENSION_RENEGOTIATION_INFO   65281
 
@@ -126,6 +128,7 @@
 /* Elliptic curves from https://www.iana.org/assignments/tls-parameters/tls-parameters.xhtml#tls-parameters-8 */
 #define TLS_EC_CURVE_SECP_256_R1           23
 #define TLS_EC_CURVE_SECP_384_R1           24
+#define TLS_EC_CURVE_ECDH_X25519           29
 
 /* Ethernet maximum transmission unit (MTU)
  * MTU is usually associated with the Ethernet protocol,
@@ -148,6 +151,14 @@
 #define S2N_TLS_MAXIMUM_RECORD_LENGTH   (S2N_TLS_MAXIMUM_FRAGMENT_LENGTH + S2N_TLS_RECORD_HEADER_LENGTH)
 #define S2N_TLS_MAX_FRAG_LEN_EXT_NONE   0
 
+/* RFC8449 Section 4: a record_size_limit below 64 bytes is illegal */
+#define S2N_TLS_MINIMUM_RECORD_SIZE_LIMIT 64
+
+/* The most record protection can add to a fragment with the ciphers s2n supports:
+ * an explicit IV, a SHA384 MAC and up to 256 bytes of CBC padding.
+ */
+#define S2N_TLS_MAXIMUM_RECORD_EXPANSION (16 + 48 + 256)
+
 /* The maximum size of an SSL2 message is 2^14 - 1, as neither of the first two
  * bits in the length field are usable. Per;
  * http://www-archive.mozilla.org/projects/security/pki/nss/ssl/draft02.html
@@ -178,6 +189,9 @@
 /* Cap dynamic record resize threshold to 8M */
 #define S2N_TLS_MAX_RESIZE_THRESHOLD (1024 * 1024 * 8)
 
+/* Congestion window record sizing samples TCP_INFO at most once a round trip, but no more often than this */
+#define S2N_TCP_INFO_MIN_SAMPLE_INTERVAL_US 1000
+
 /* Put a 64k cap on the size of any handshake message */
 #define S2N_MAXIMUM_HANDSHAKE_MESSAGE_LENGTH (64 * 1024)
 
@@ -0,0 +1,725 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+/* Define _DEFAULT_SOURCE to get the syscall() definition from unistd.h */
+#ifndef _DEFAULT_SOURCE
+# define _DEFAULT_SOURCE
+#endif
+
+#include <sys/param.h>
+
+#include <errno.h>
+#include <string.h>
+#include <s2n.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define S2N_HAVE_IO_URING 1
+#endif
+#endif
+
+#if S2N_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include "error/s2n_errno.h"
+
+#include "tls/s2n_connection.h"
+
+#include "utils/s2n_blob.h"
+#include "utils/s2n_io_uring.h"
+#include "utils/s2n_mem.h"
+#include "utils/s2n_safety.h"
+#include "utils/s2n_socket.h"
+
+#if S2N_HAVE_IO_URING
+
+/* The low bits of each request's user_data say what it was, the rest which slot it was for */
+#define S2N_IO_URING_OP_RECV    0
+#define S2N_IO_URING_OP_SEND    1
+#define S2N_IO_URING_OP_CANCEL  2
+#define S2N_IO_URING_OP_BITS    2
+#define S2N_IO_URING_OP_MASK    ((1 << S2N_IO_URING_OP_BITS) - 1)
+
+/* A slot has at most a receive, a send and a cancellation queued at once. Large rings are
+ * capped, since a full submission queue is simply submitted early.
+ */
+#define S2N_IO_URING_SQES_PER_SLOT 4
+#define S2N_IO_URING_MAX_SQ_ENTRIES 4096
+
+struct s2n_io_uring {
+    int fd;
+
+    /* Submission queue, shared with the kernel */
+    void *sq_ring;
+    size_t sq_ring_size;
+    uint32_t *sq_head;
+    uint32_t *sq_tail;
+    uint32_t *sq_array;
+    uint32_t sq_mask;
+    uint32_t sq_entries;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    uint32_t sqe_tail;
+    uint32_t to_submit;
+
+    /* Completion queue, shared with the kernel */
+    void *cq_ring;
+    size_t cq_ring_size;
+    uint32_t *cq_head;
+    uint32_t *cq_tail;
+    uint32_t cq_mask;
+    struct io_uring_cqe *cqes;
+
+    struct s2n_io_uring_slot *slots;
+    uint32_t num_slots;
+
+    /* Unused slots, as a stack of indexes */
+    uint32_t *free_slots;
+    uint32_t num_free;
+
+    /* Slots whose connection can make progress, as a queue of indexes */
+    uint32_t *ready_slots;
+    uint32_t ready_head;
+    uint32_t num_ready;
+
+    /* The receive and send buffers of every slot, registered with the kernel when it allows */
+    uint8_t *buffers;
+    size_t buffers_size;
+    struct iovec *iovecs;
+    unsigned fixed_buffers:1;
+};
+
+static int s2n_io_uring_enter(struct s2n_io_uring *ring, uint32_t min_complete)
+{
+    int r;
+    do {
+        r = syscall(__NR_io_uring_enter, ring->fd, ring->to_submit, min_complete,
+                    min_complete ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    } while (r < 0 && errno == EINTR);
+
+    if (r < 0) {
+        /* The completion queue is full, or the kernel is short of memory. Reaping frees room. */
+        if (errno == EBUSY || errno == EAGAIN) {
+            return 0;
+        }
+        S2N_ERROR(S2N_ERR_IO);
+    }
+    ring->to_submit -= r;
+
+    return 0;
+}
+
+static struct io_uring_sqe *s2n_io_uring_get_sqe(struct s2n_io_uring *ring)
+{
+    if (ring->sqe_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) >= ring->sq_entries) {
+        GUARD_PTR(s2n_io_uring_enter(ring, 0));
+        S2N_ERROR_IF_PTR(ring->sqe_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) >= ring->sq_entries, S2N_ERR_IO_URING_FULL);
+    }
+
+    uint32_t index = ring->sqe_tail & ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_array[index] = index;
+
+    return sqe;
+}
+
+/* Hand the entry from s2n_io_uring_get_sqe to the kernel. It is submitted by the next s2n_io_uring_submit. */
+static void s2n_io_uring_commit_sqe(struct s2n_io_uring *ring)
+{
+    ring->sqe_tail++;
+    ring->to_submit++;
+    __atomic_store_n(ring->sq_tail, ring->sqe_tail, __ATOMIC_RELEASE);
+}
+
+static uint64_t s2n_io_uring_user_data(struct s2n_io_uring *ring, struct s2n_io_uring_slot *slot, uint8_t op)
+{
+    return ((uint64_t) (slot - ring->slots) << S2N_IO_URING_OP_BITS) | op;
+}
+
+static void s2n_io_uring_prep_rw(struct s2n_io_uring *ring, struct io_uring_sqe *sqe, struct s2n_io_uring_slot *slot,
+                                 uint8_t op, uint8_t *buf, uint32_t len)
+{
+    uint32_t index = slot - ring->slots;
+    uint32_t buf_index = 2 * index + op;
+
+    sqe->fd = slot->fd;
+    sqe->off = 0;
+    sqe->user_data = s2n_io_uring_user_data(ring, slot, op);
+
+    if (ring->fixed_buffers) {
+        sqe->opcode = op == S2N_IO_URING_OP_RECV ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+        sqe->addr = (uintptr_t) buf;
+        sqe->len = len;
+        sqe->buf_index = buf_index;
+        return;
+    }
+
+    /* Without registered buffers, use the vectored ops that every io_uring kernel has */
+    ring->iovecs[buf_index].iov_base = buf;
+    ring->iovecs[buf_index].iov_len = len;
+    sqe->opcode = op == S2N_IO_URING_OP_RECV ? IORING_OP_READV : IORING_OP_WRITEV;
+    sqe->addr = (uintptr_t) &ring->iovecs[buf_index];
+    sqe->len = 1;
+}
+
+static int s2n_io_uring_queue_recv(struct s2n_io_uring_slot *slot)
+{
+    struct s2n_io_uring *ring = slot->ring;
+    struct io_uring_sqe *sqe = s2n_io_uring_get_sqe(ring);
+    notnull_check(sqe);
+
+    slot->recv_start = 0;
+    slot->recv_end = 0;
+    s2n_io_uring_prep_rw(ring, sqe, slot, S2N_IO_URING_OP_RECV, slot->recv_buf, S2N_IO_URING_BUFFER_SIZE);
+    s2n_io_uring_commit_sqe(ring);
+    slot->recv_pending = 1;
+
+    return 0;
+}
+
+static int s2n_io_uring_queue_send(struct s2n_io_uring_slot *slot)
+{
+    struct s2n_io_uring *ring = slot->ring;
+    struct io_uring_sqe *sqe = s2n_io_uring_get_sqe(ring);
+    notnull_check(sqe);
+
+    s2n_io_uring_prep_rw(ring, sqe, slot, S2N_IO_URING_OP_SEND, slot->send_buf + slot->send_start, slot->send_end - slot->send_start);
+    s2n_io_uring_commit_sqe(ring);
+    slot->send_pending = 1;
+
+    return 0;
+}
+
+/* A slot is reused once its connection has let go of it and nothing of it is left in the ring */
+static void s2n_io_uring_recycle(struct s2n_io_uring_slot *slot)
+{
+    struct s2n_io_uring *ring = slot->ring;
+
+    if (slot->free || slot->conn || slot->recv_pending || slot->send_pending || slot->ready) {
+        return;
+    }
+
+    ring->free_slots[ring->num_free++] = slot - ring->slots;
+    slot->free = 1;
+}
+
+static void s2n_io_uring_set_ready(struct s2n_io_uring_slot *slot)
+{
+    struct s2n_io_uring *ring = slot->ring;
+
+    if (slot->conn == NULL || slot->ready) {
+        return;
+    }
+
+    ring->ready_slots[(ring->ready_head + ring->num_ready) % ring->num_slots] = slot - ring->slots;
+    ring->num_ready++;
+    slot->ready = 1;
+}
+
+static void s2n_io_uring_complete_recv(struct s2n_io_uring_slot *slot, int32_t res)
+{
+    slot->recv_pending = 0;
+
+    /* Nobody is left to read it */
+    if (slot->conn == NULL) {
+        return;
+    }
+
+    if (res == -EAGAIN || res == -EINTR) {
+        if (s2n_io_uring_queue_recv(slot) == 0) {
+            return;
+        }
+        res = -ENOBUFS;
+    }
+
+    if (res > 0) {
+        slot->recv_start = 0;
+        slot->recv_end = res;
+    } else if (res == 0) {
+        slot->recv_eof = 1;
+    } else {
+        slot->recv_errno = -res;
+    }
+
+    s2n_io_uring_set_ready(slot);
+}
+
+/* A connection that let go of its slot, after s2n_shutdown for example, still gets the rest of
+ * its data written. The slot holds its own descriptor for the socket until then.
+ */
+static void s2n_io_uring_complete_released_send(struct s2n_io_uring_slot *slot, int32_t res)
+{
+    slot->send_start += res > 0 ? res : 0;
+    if ((res >= 0 || res == -EAGAIN || res == -EINTR) && slot->fd >= 0 && slot->send_start < slot->send_end) {
+        if (s2n_io_uring_queue_send(slot) == 0) {
+            return;
+        }
+    }
+
+    if (slot->fd >= 0) {
+        close(slot->fd);
+    }
+    slot->fd = -1;
+    slot->send_start = 0;
+    slot->send_end = 0;
+}
+
+static void s2n_io_uring_complete_send(struct s2n_io_uring_slot *slot, int32_t res)
+{
+    slot->send_pending = 0;
+
+    if (slot->conn == NULL) {
+        s2n_io_uring_complete_released_send(slot, res);
+        return;
+    }
+
+    if (res < 0 && res != -EAGAIN && res != -EINTR) {
+        slot->send_errno = -res;
+        slot->send_start = 0;
+        slot->send_end = 0;
+        s2n_io_uring_set_ready(slot);
+        return;
+    }
+
+    /* Write whatever is left, including anything s2n added while this write was in flight */
+    slot->send_start += res > 0 ? res : 0;
+    if (slot->send_start < slot->send_end) {
+        if (s2n_io_uring_queue_send(slot) < 0) {
+            slot->send_errno = ENOBUFS;
+            s2n_io_uring_set_ready(slot);
+        }
+        return;
+    }
+
+    slot->send_start = 0;
+    slot->send_end = 0;
+    s2n_io_uring_set_ready(slot);
+}
+
+static int s2n_io_uring_reap(struct s2n_io_uring *ring)
+{
+    uint32_t head = *ring->cq_head;
+    uint32_t tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+
+    while (head != tail) {
+        struct io_uring_cqe *cqe = &ring->cqes[head & ring->cq_mask];
+        uint8_t op = cqe->user_data & S2N_IO_URING_OP_MASK;
+        struct s2n_io_uring_slot *slot = &ring->slots[cqe->user_data >> S2N_IO_URING_OP_BITS];
+
+        if (op == S2N_IO_URING_OP_RECV) {
+            s2n_io_uring_complete_recv(slot, cqe->res);
+        } else if (op == S2N_IO_URING_OP_SEND) {
+            s2n_io_uring_complete_send(slot, cqe->res);
+        }
+        s2n_io_uring_recycle(slot);
+
+        head++;
+    }
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+static int s2n_io_uring_map(struct s2n_io_uring *ring, struct io_uring_params *params)
+{
+    ring->sq_ring_size = params->sq_off.array + params->sq_entries * sizeof(uint32_t);
+    ring->cq_ring_size = params->cq_off.cqes + params->cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqes_size = params->sq_entries * sizeof(struct io_uring_sqe);
+
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    S2N_ERROR_IF(ring->sq_ring == MAP_FAILED, S2N_ERR_MMAP);
+    ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    S2N_ERROR_IF(ring->cq_ring == MAP_FAILED, S2N_ERR_MMAP);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    S2N_ERROR_IF(ring->sqes == MAP_FAILED, S2N_ERR_MMAP);
+
+    uint8_t *sq = ring->sq_ring;
+    ring->sq_head = (uint32_t *)(void *)(sq + params->sq_off.head);
+    ring->sq_tail = (uint32_t *)(void *)(sq + params->sq_off.tail);
+    ring->sq_array = (uint32_t *)(void *)(sq + params->sq_off.array);
+    ring->sq_mask = *(uint32_t *)(void *)(sq + params->sq_off.ring_mask);
+    ring->sq_entries = *(uint32_t *)(void *)(sq + params->sq_off.ring_entries);
+    ring->sqe_tail = *ring->sq_tail;
+
+    uint8_t *cq = ring->cq_ring;
+    ring->cq_head = (uint32_t *)(void *)(cq + params->cq_off.head);
+    ring->cq_tail = (uint32_t *)(void *)(cq + params->cq_off.tail);
+    ring->cq_mask = *(uint32_t *)(void *)(cq + params->cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(void *)(cq + params->cq_off.cqes);
+
+    return 0;
+}
+
+static int s2n_io_uring_alloc_slots(struct s2n_io_uring *ring, uint32_t max_connections)
+{
+    struct s2n_blob mem = {0};
+
+    GUARD(s2n_alloc(&mem, max_connections * sizeof(struct s2n_io_uring_slot)));
+    GUARD(s2n_blob_zero(&mem));
+    ring->slots = (void *) mem.data;
+    ring->num_slots = max_connections;
+
+    GUARD(s2n_alloc(&mem, max_connections * sizeof(uint32_t)));
+    ring->free_slots = (void *) mem.data;
+    GUARD(s2n_alloc(&mem, max_connections * sizeof(uint32_t)));
+    ring->ready_slots = (void *) mem.data;
+    GUARD(s2n_alloc(&mem, 2 * max_connections * sizeof(struct iovec)));
+    ring->iovecs = (void *) mem.data;
+
+    /* The buffers can add up to far more than mlock allows, so they are mapped directly */
+    ring->buffers_size = (size_t) 2 * max_connections * S2N_IO_URING_BUFFER_SIZE;
+    ring->buffers = mmap(NULL, ring->buffers_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring->buffers == MAP_FAILED) {
+        ring->buffers = NULL;
+        S2N_ERROR(S2N_ERR_MMAP);
+    }
+
+    for (uint32_t i = 0; i < max_connections; i++) {
+        struct s2n_io_uring_slot *slot = &ring->slots[i];
+        slot->ring = ring;
+        slot->fd = -1;
+        slot->free = 1;
+        slot->recv_buf = ring->buffers + (size_t) 2 * i * S2N_IO_URING_BUFFER_SIZE;
+        slot->send_buf = slot->recv_buf + S2N_IO_URING_BUFFER_SIZE;
+        ring->iovecs[2 * i].iov_base = slot->recv_buf;
+        ring->iovecs[2 * i].iov_len = S2N_IO_URING_BUFFER_SIZE;
+        ring->iovecs[2 * i + 1].iov_base = slot->send_buf;
+        ring->iovecs[2 * i + 1].iov_len = S2N_IO_URING_BUFFER_SIZE;
+
+        /* Hand out the lowest slots first */
+        ring->free_slots[i] = max_connections - 1 - i;
+    }
+    ring->num_free = max_connections;
+
+    /* Registering the buffers saves the kernel mapping them on every read and write, but counts
+     * against RLIMIT_MEMLOCK. Without it the same buffers are passed with every request.
+     */
+    ring->fixed_buffers = syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_BUFFERS, ring->iovecs, 2 * max_connections) == 0;
+
+    return 0;
+}
+
+struct s2n_io_uring *s2n_io_uring_new(uint32_t max_connections)
+{
+    S2N_ERROR_IF_PTR(max_connections == 0 || max_connections > (UINT32_MAX >> S2N_IO_URING_OP_BITS) / S2N_IO_URING_SQES_PER_SLOT, S2N_ERR_IO_URING_SIZE);
+
+    struct s2n_blob mem = {0};
+    GUARD_PTR(s2n_alloc(&mem, sizeof(struct s2n_io_uring)));
+    GUARD_PTR(s2n_blob_zero(&mem));
+
+    struct s2n_io_uring *ring = (void *) mem.data;
+    ring->fd = -1;
+
+    struct io_uring_params params = {0};
+    ring->fd = syscall(__NR_io_uring_setup, MIN(max_connections * S2N_IO_URING_SQES_PER_SLOT, S2N_IO_URING_MAX_SQ_ENTRIES), &params);
+    if (ring->fd < 0 || s2n_io_uring_map(ring, &params) < 0 || s2n_io_uring_alloc_slots(ring, max_connections) < 0) {
+        int failed_with_setup = ring->fd < 0;
+        s2n_io_uring_free(ring);
+        S2N_ERROR_IF_PTR(failed_with_setup, S2N_ERR_IO_URING_UNSUPPORTED);
+        return NULL;
+    }
+
+    return ring;
+}
+
+int s2n_io_uring_free(struct s2n_io_uring *ring)
+{
+    notnull_check(ring);
+
+    if (ring->slots) {
+        for (uint32_t i = 0; i < ring->num_slots; i++) {
+            struct s2n_connection *conn = ring->slots[i].conn;
+            if (conn) {
+                conn->io_uring_slot = NULL;
+                conn->send = NULL;
+                conn->recv = NULL;
+                conn->send_io_context = NULL;
+                conn->recv_io_context = NULL;
+            } else if (ring->slots[i].fd >= 0) {
+                /* Still writing for a connection that was released */
+                close(ring->slots[i].fd);
+            }
+        }
+    }
+
+    /* Closing the ring cancels whatever is still in flight */
+    if (ring->fd >= 0) {
+        close(ring->fd);
+    }
+    if (ring->sq_ring && ring->sq_ring != MAP_FAILED) {
+        munmap(ring->sq_ring, ring->sq_ring_size);
+    }
+    if (ring->cq_ring && ring->cq_ring != MAP_FAILED) {
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    if (ring->sqes && ring->sqes != MAP_FAILED) {
+        munmap(ring->sqes, ring->sqes_size);
+    }
+    if (ring->buffers) {
+        munmap(ring->buffers, ring->buffers_size);
+    }
+
+    GUARD(s2n_free_object((uint8_t **) &ring->slots, ring->num_slots * sizeof(struct s2n_io_uring_slot)));
+    GUARD(s2n_free_object((uint8_t **) &ring->free_slots, ring->num_slots * sizeof(uint32_t)));
+    GUARD(s2n_free_object((uint8_t **) &ring->ready_slots, ring->num_slots * sizeof(uint32_t)));
+    GUARD(s2n_free_object((uint8_t **) &ring->iovecs, 2 * ring->num_slots * sizeof(struct iovec)));
+    GUARD(s2n_free_object((uint8_t **) &ring, sizeof(struct s2n_io_uring)));
+
+    return 0;
+}
+
+int s2n_connection_set_io_uring(struct s2n_connection *conn, struct s2n_io_uring *ring, int fd)
+{
+    notnull_check(conn);
+    notnull_check(ring);
+    S2N_ERROR_IF(conn->managed_io, S2N_ERR_IO_URING_MANAGED_IO);
+
+    if (conn->io_uring_slot) {
+        GUARD(s2n_io_uring_release(conn));
+    }
+
+    /* Completions for a slot nobody uses any more may be waiting to free it up */
+    if (ring->num_free == 0) {
+        GUARD(s2n_io_uring_reap(ring));
+    }
+    S2N_ERROR_IF(ring->num_free == 0, S2N_ERR_IO_URING_FULL);
+
+    struct s2n_io_uring_slot *slot = &ring->slots[ring->free_slots[--ring->num_free]];
+    slot->free = 0;
+    slot->conn = conn;
+    slot->fd = fd;
+    slot->recv_start = 0;
+    slot->recv_end = 0;
+    slot->recv_errno = 0;
+    slot->recv_eof = 0;
+    slot->send_start = 0;
+    slot->send_end = 0;
+    slot->send_errno = 0;
+
+    conn->io_uring_slot = slot;
+    GUARD(s2n_connection_set_recv_cb(conn, s2n_io_uring_read));
+    GUARD(s2n_connection_set_recv_ctx(conn, slot));
+    GUARD(s2n_connection_set_send_cb(conn, s2n_io_uring_write));
+    GUARD(s2n_connection_set_send_ctx(conn, slot));
+
+    uint8_t ipv6;
+    if (0 == s2n_socket_is_ipv6(fd, &ipv6)) {
+        conn->ipv6 = (ipv6 ? 1 : 0);
+    }
+
+    return 0;
+}
+
+int s2n_io_uring_release(struct s2n_connection *conn)
+{
+    struct s2n_io_uring_slot *slot = conn->io_uring_slot;
+    if (slot == NULL) {
+        return 0;
+    }
+
+    struct s2n_io_uring *ring = slot->ring;
+    slot->conn = NULL;
+    conn->io_uring_slot = NULL;
+    conn->send = NULL;
+    conn->recv = NULL;
+    conn->send_io_context = NULL;
+    conn->recv_io_context = NULL;
+
+    /* A read may never complete on its own. Kernels without IORING_OP_ASYNC_CANCEL fail the
+     * cancellation, and the slot is then reused once the read does complete.
+     */
+    if (slot->recv_pending) {
+        struct io_uring_sqe *sqe = s2n_io_uring_get_sqe(ring);
+        if (sqe) {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = -1;
+            sqe->addr = s2n_io_uring_user_data(ring, slot, S2N_IO_URING_OP_RECV);
+            sqe->user_data = s2n_io_uring_user_data(ring, slot, S2N_IO_URING_OP_CANCEL);
+            s2n_io_uring_commit_sqe(ring);
+        }
+    }
+
+    /* Unsent data is written from a descriptor of the slot's own, so that the caller can close
+     * fd once the connection is freed. Submitting now has the kernel take the socket for the
+     * write that is already queued.
+     */
+    if (slot->send_pending) {
+        slot->fd = dup(slot->fd);
+        GUARD(s2n_io_uring_enter(ring, 0));
+    } else {
+        slot->fd = -1;
+        slot->send_start = 0;
+        slot->send_end = 0;
+    }
+
+    s2n_io_uring_recycle(slot);
+
+    return 0;
+}
+
+int s2n_connection_io_uring_pending(struct s2n_connection *conn)
+{
+    notnull_check(conn);
+
+    struct s2n_io_uring_slot *slot = conn->io_uring_slot;
+    S2N_ERROR_IF(slot == NULL, S2N_ERR_IO_URING_NOT_SET);
+
+    return slot->send_pending || slot->send_start < slot->send_end;
+}
+
+int s2n_io_uring_submit(struct s2n_io_uring *ring, uint32_t min_complete, struct s2n_connection **ready, uint32_t max_ready)
+{
+    notnull_check(ring);
+    S2N_ERROR_IF(max_ready && ready == NULL, S2N_ERR_NULL);
+
+    /* Don't wait when connections are already waiting to be driven */
+    GUARD(s2n_io_uring_reap(ring));
+    if (ring->num_ready) {
+        min_complete = 0;
+    }
+
+    GUARD(s2n_io_uring_enter(ring, min_complete));
+    GUARD(s2n_io_uring_reap(ring));
+
+    uint32_t num_ready = 0;
+    while (ring->num_ready && num_ready < max_ready) {
+        struct s2n_io_uring_slot *slot = &ring->slots[ring->ready_slots[ring->ready_head]];
+        ring->ready_head = (ring->ready_head + 1) % ring->num_slots;
+        ring->num_ready--;
+
+        slot->ready = 0;
+        if (slot->conn) {
+            ready[num_ready++] = slot->conn;
+        } else {
+            s2n_io_uring_recycle(slot);
+        }
+    }
+
+    return num_ready;
+}
+
+int s2n_io_uring_read(void *io_context, uint8_t *buf, uint32_t len)
+{
+    struct s2n_io_uring_slot *slot = io_context;
+
+    if (slot->recv_start < slot->recv_end) {
+        uint32_t n = MIN(len, slot->recv_end - slot->recv_start);
+        memcpy(buf, slot->recv_buf + slot->recv_start, n);
+        slot->recv_start += n;
+        return n;
+    }
+
+    if (slot->recv_eof) {
+        return 0;
+    }
+
+    if (slot->recv_errno) {
+        errno = slot->recv_errno;
+        slot->recv_errno = 0;
+        return -1;
+    }
+
+    /* Start the next read. It completes, and wakes the connection, through s2n_io_uring_submit. */
+    if (!slot->recv_pending && s2n_io_uring_queue_recv(slot) < 0) {
+        errno = ENOBUFS;
+        return -1;
+    }
+
+    errno = EAGAIN;
+    return -1;
+}
+
+int s2n_io_uring_write(void *io_context, const uint8_t *buf, uint32_t len)
+{
+    struct s2n_io_uring_slot *slot = io_context;
+
+    if (slot->send_errno) {
+        errno = slot->send_errno;
+        slot->send_errno = 0;
+        return -1;
+    }
+
+    /* The data is taken now and written by the next s2n_io_uring_submit. While a write is in
+     * flight, more can still be added after it.
+     */
+    uint32_t n = MIN(len, S2N_IO_URING_BUFFER_SIZE - slot->send_end);
+    if (n == 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    memcpy(slot->send_buf + slot->send_end, buf, n);
+    slot->send_end += n;
+
+    if (!slot->send_pending && s2n_io_uring_queue_send(slot) < 0) {
+        slot->send_end -= n;
+        errno = ENOBUFS;
+        return -1;
+    }
+
+    return n;
+}
+
+#else
+
+struct s2n_io_uring *s2n_io_uring_new(uint32_t max_connections)
+{
+    S2N_ERROR_PTR(S2N_ERR_IO_URING_UNSUPPORTED);
+}
+
+int s2n_io_uring_free(struct s2n_io_uring *ring)
+{
+    S2N_ERROR(S2N_ERR_IO_URING_UNSUPPORTED);
+}
+
+int s2n_connection_set_io_uring(struct s2n_connection *conn, struct s2n_io_uring *ring, int fd)
+{
+    S2N_ERROR(S2N_ERR_IO_URING_UNSUPPORTED);
+}
+
+int s2n_io_uring_release(struct s2n_connection *conn)
+{
+    return 0;
+}
+
+int s2n_connection_io_uring_pending(struct s2n_connection *conn)
+{
+    S2N_ERROR(S2N_ERR_IO_URING_UNSUPPORTED);
+}
+
+int s2n_io_uring_submit(struct s2n_io_uring *ring, uint32_t min_complete, struct s2n_connection **ready, uint32_t max_ready)
+{
+    S2N_ERROR(S2N_ERR_IO_URING_UNSUPPORTED);
+}
+
+int s2n_io_uring_read(void *io_context, uint8_t *buf, uint32_t len)
+{
+    errno = ENOSYS;
+    return -1;
+}
+
+int s2n_io_uring_write(void *io_context, const uint8_t *buf, uint32_t len)
+{
+    errno = ENOSYS;
+    return -1;
+}
+
+#endif
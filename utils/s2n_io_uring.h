@@ -0,0 +1,58 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "tls/s2n_connection.h"
+#include "tls/s2n_tls_parameters.h"
+
+/* Each connection gets a receive and a send buffer of this size, registered with the ring */
+#define S2N_IO_URING_BUFFER_SIZE S2N_TLS_MAXIMUM_RECORD_LENGTH
+
+/* The I/O context of a connection using an io_uring. The slot and its buffers belong to the
+ * ring, so reads and writes still in flight when the connection lets go of it stay valid.
+ */
+struct s2n_io_uring_slot {
+    struct s2n_io_uring *ring;
+    struct s2n_connection *conn;
+    int fd;
+
+    /* Received data not yet read by s2n is recv_buf[recv_start, recv_end) */
+    uint8_t *recv_buf;
+    uint32_t recv_start;
+    uint32_t recv_end;
+    int recv_errno;
+    unsigned recv_pending:1;
+    unsigned recv_eof:1;
+
+    /* Data accepted from s2n and not yet written is send_buf[send_start, send_end) */
+    uint8_t *send_buf;
+    uint32_t send_start;
+    uint32_t send_end;
+    int send_errno;
+    unsigned send_pending:1;
+
+    /* Queued in the ring's ready list */
+    unsigned ready:1;
+
+    /* On the ring's free list */
+    unsigned free:1;
+};
+
+extern int s2n_io_uring_read(void *io_context, uint8_t *buf, uint32_t len);
+extern int s2n_io_uring_write(void *io_context, const uint8_t *buf, uint32_t len);
+extern int s2n_io_uring_release(struct s2n_connection *conn);
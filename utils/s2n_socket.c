@@ -13,6 +13,11 @@
  * permissions and limitations under the License.
  */
 
+/* Define _DEFAULT_SOURCE to get the struct tcp_info definition from netinet/tcp.h */
+#ifndef _DEFAULT_SOURCE
+# define _DEFAULT_SOURCE
+#endif
+
 #include <tls/s2n_connection.h>
 
 #include <utils/s2n_socket.h>
@@ -167,6 +172,16 @@ int s2n_socket_write_uncork(struct s2n_connection *conn)
     return 0;
 }
 
+int s2n_socket_write_more(struct s2n_connection *conn, uint8_t more)
+{
+    struct s2n_socket_write_io_context *w_io_ctx = (struct s2n_socket_write_io_context *) conn->send_io_context;
+    notnull_check(w_io_ctx);
+
+    w_io_ctx->msg_more = more ? 1 : 0;
+
+    return 0;
+}
+
 int s2n_socket_set_read_size(struct s2n_connection *conn, int size)
 {
 #ifdef SO_RCVLOWAT
@@ -198,7 +213,8 @@ int s2n_socket_read(void *io_context, uint8_t *buf, uint32_t len)
 
 int s2n_socket_write(void *io_context, const uint8_t *buf, uint32_t len)
 {
-    int wfd = ((struct s2n_socket_write_io_context*) io_context)->fd;
+    struct s2n_socket_write_io_context *w_io_ctx = (struct s2n_socket_write_io_context *) io_context;
+    int wfd = w_io_ctx->fd;
     if (wfd < 0) {
         errno = EBADF;
         return -1;
@@ -207,6 +223,21 @@ int s2n_socket_write(void *io_context, const uint8_t *buf, uint32_t len)
     /* On success, the number of bytes written is returned. On failure, -1 is
      * returned and errno is set appropriately. */
     errno = 0;
+#ifdef MSG_MORE
+    /* Let the kernel hold a partial segment back until the rest of the flight is written,
+     * the way TCP_CORK would, without changing the socket options.
+     */
+    if (w_io_ctx->msg_more) {
+        int w = send(wfd, buf, len, MSG_MORE);
+        if (w >= 0 || errno != ENOTSOCK) {
+            return w;
+        }
+
+        /* Not a socket, so there is nothing to hold back */
+        w_io_ctx->msg_more = 0;
+        errno = 0;
+    }
+#endif
     return write(wfd, buf, len);
 }
 
@@ -226,3 +257,35 @@ int s2n_socket_is_ipv6(int fd, uint8_t *ipv6)
             
     return 0;
 }
+
+/* Returns 1 if the connection's socket reported its congestion state, or 0 if it can't,
+ * for example because it isn't a TCP socket or the platform has no TCP_INFO.
+ */
+int s2n_socket_get_tcp_info(struct s2n_connection *conn, struct s2n_tcp_info *info)
+{
+    notnull_check(info);
+
+    if (!conn->managed_io || !conn->send) {
+        return 0;
+    }
+
+#if defined(__linux__) && defined(TCP_INFO)
+    struct s2n_socket_write_io_context *w_io_ctx = (struct s2n_socket_write_io_context *) conn->send_io_context;
+    notnull_check(w_io_ctx);
+
+    struct tcp_info tcp_info = {0};
+    socklen_t len = sizeof(tcp_info);
+    if (getsockopt(w_io_ctx->fd, IPPROTO_TCP, TCP_INFO, &tcp_info, &len) < 0) {
+        return 0;
+    }
+
+    info->snd_cwnd = tcp_info.tcpi_snd_cwnd;
+    info->unacked = tcp_info.tcpi_unacked;
+    info->snd_mss = tcp_info.tcpi_snd_mss;
+    info->rtt = tcp_info.tcpi_rtt;
+
+    return 1;
+#else
+    return 0;
+#endif
+}
@@ -37,6 +37,9 @@ struct s2n_socket_write_io_context {
     /* Original TCP_CORK socket option settings before s2n takes over the fd */
     unsigned int original_cork_is_set:1;
     int original_cork_val;
+
+    /* Send the next writes with MSG_MORE, because more records follow them */
+    unsigned int msg_more:1;
 };
 
 extern int s2n_socket_quickack(struct s2n_connection *conn);
@@ -47,7 +50,9 @@ extern int s2n_socket_write_restore(struct s2n_connection *conn);
 extern int s2n_socket_was_corked(struct s2n_connection *conn);
 extern int s2n_socket_write_cork(struct s2n_connection *conn);
 extern int s2n_socket_write_uncork(struct s2n_connection *conn);
+extern int s2n_socket_write_more(struct s2n_connection *conn, uint8_t more);
 extern int s2n_socket_set_read_size(struct s2n_connection *conn, int size);
 extern int s2n_socket_read(void *io_context, uint8_t *buf, uint32_t len);
 extern int s2n_socket_write(void *io_context, const uint8_t *buf, uint32_t len);
 extern int s2n_socket_is_ipv6(int fd, uint8_t *ipv6);
+extern int s2n_socket_get_tcp_info(struct s2n_connection *conn, struct s2n_tcp_info *info);